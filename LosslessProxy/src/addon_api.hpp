@@ -1,6 +1,10 @@
 #pragma once
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 
 // Forward declaration of ImGui context (if we support UI embedding)
 struct ImGuiContext;
@@ -13,9 +17,143 @@ enum AddonCaps : uint32_t {
                               << 3 // Request host to patch LS1 JMP instructions
 };
 
+// Telemetry sample ring, created by IHost::TelemetryCreateChannel and owned
+// by the host. Exactly one thread may push into a channel; the host drains it
+// on its aggregator thread. Full rings drop samples rather than block.
+struct TelemetryChannel {
+  alignas(64) std::atomic<uint32_t> writeIndex; // Producer
+  std::atomic<uint32_t> dropped;                // Producer
+  alignas(64) std::atomic<uint32_t> readIndex;  // Host
+  alignas(64) uint32_t capacityMask;            // Capacity - 1 (power of two)
+  float *samples;
+};
+
+// Hot-path safe: two atomic loads, one store, no calls into the host
+inline void TelemetryPush(TelemetryChannel *channel, float value) {
+  if (!channel)
+    return;
+  uint32_t write = channel->writeIndex.load(std::memory_order_relaxed);
+  uint32_t read = channel->readIndex.load(std::memory_order_acquire);
+  if (write - read > channel->capacityMask) {
+    channel->dropped.store(channel->dropped.load(std::memory_order_relaxed) +
+                               1,
+                           std::memory_order_relaxed);
+    return;
+  }
+  channel->samples[write & channel->capacityMask] = value;
+  channel->writeIndex.store(write + 1, std::memory_order_release);
+}
+
+// Edit to one of Lossless' resources that the host applies to the original
+// bytes, so an addon can change a constant or an instruction without
+// shipping a whole replacement through AddonInterceptResource. For DXBC
+// shaders the host recomputes the container checksum afterwards.
+enum ShaderPatchKind : uint32_t {
+  SHADER_PATCH_BYTES = 0, // Overwrite size bytes at offset
+  SHADER_PATCH_CHUNK = 1, // Replace the chunk's data; size may differ
+};
+
+struct ShaderPatch {
+  const wchar_t *name; // Resource name or MAKEINTRESOURCEW id
+  const wchar_t *type; // e.g. MAKEINTRESOURCEW(10) for RT_RCDATA
+  uint32_t kind;       // ShaderPatchKind
+  // DXBC chunk FourCC ('SHEX' is 0x58454853), offsets are into its data.
+  // 0 addresses the whole resource (SHADER_PATCH_BYTES only).
+  uint32_t chunk;
+  uint32_t offset;
+  const void *data;
+  uint32_t size;
+  // Optional, SHADER_PATCH_BYTES only: the patch is skipped unless these
+  // size bytes are at offset, so a patch written for one Lossless build
+  // leaves others alone
+  const void *expected;
+};
+
+// Notification for IHost::SubscribeExportCalls: one before and one after
+// each call Lossless makes into one of Lossless_original's exports ("Init",
+// "ApplySettings", ...). Arguments are not captured. Callbacks run on the
+// calling thread, inside the call, so keep them short.
+enum ExportCallPhase : uint32_t {
+  EXPORT_CALL_BEFORE = 0,
+  EXPORT_CALL_AFTER = 1,
+};
+
+struct ExportCallInfo {
+  const char *name; // Export name
+  uint32_t phase;   // ExportCallPhase
+  uint64_t nanos;   // EXPORT_CALL_AFTER: time spent in the original export
+};
+
+typedef void (*ExportCallback_t)(const ExportCallInfo *call, void *user);
+
+// One call Lossless_original makes through a hooked import, as seen by
+// IHost::AddImportCallback callbacks. args[i] points at the i-th argument
+// and result at the return value (null for void functions); both are the
+// dispatcher's own copies, so a pre callback may change the arguments the
+// original gets and a post callback the result Lossless sees. A pre
+// callback can set skipOriginal, after filling in *result, to answer the
+// call itself.
+struct ImportCall {
+  const char *dllName;
+  const char *functionName;
+  void *const *args;
+  uint32_t argCount;
+  void *result;
+  bool skipOriginal;
+};
+
+typedef void (*ImportCallback_t)(ImportCall *call, void *user);
+
+// Handle for one AddonInitializeAsync call, owned by the host
+struct AddonInitTask;
+
 // Interface for the Host (LosslessProxy) to expose services to Addons
 struct IHost {
   virtual void Log(const wchar_t *message) = 0;
+  // Ask the manager window for a new frame. Safe to call from any thread.
+  virtual void RequestRedraw() = 0;
+  // Keep the manager window redrawing at framesPerSecond for durationMs, for
+  // animated settings UI. Safe to call from any thread.
+  virtual void RequestAnimation(float framesPerSecond, uint32_t durationMs) = 0;
+  // Startup timeline spans, recorded only when the host is built with
+  // LOSSLESS_ENABLE_TRACE. Spans nest per thread; the name is copied.
+  virtual void TraceBeginSpan(const char *name) = 0;
+  virtual void TraceEndSpan() = 0;
+  // Named sample stream (e.g. "MyAddon/GPU ms") shown with rolling
+  // p50/p95/p99 in the manager window. Names are unique: creating one that
+  // is already in use returns nullptr, since only one thread may push into a
+  // channel. Channels live until the host unloads; one created from
+  // AddonInitialize is handed back to the same name after the addon is
+  // reloaded.
+  virtual TelemetryChannel *TelemetryCreateChannel(const char *name) = 0;
+  // Register a resource patch; everything is copied. Returns an id for
+  // RemoveShaderPatch, 0 if the patch is malformed. Patches are applied in
+  // registration order the next time Lossless loads the resource, and ones
+  // registered from AddonInitialize or AddonRenderSettings are removed when
+  // the addon unloads.
+  virtual uint32_t RegisterShaderPatch(const ShaderPatch *patch) = 0;
+  virtual void RemoveShaderPatch(uint32_t id) = 0;
+  // Pre/post notifications for Lossless' calls into its exports. Only
+  // proxies built with LOSSLESS_INSTRUMENT_EXPORTS see those calls; others
+  // return 0. Subscriptions made from AddonInitialize or AddonRenderSettings
+  // are removed when the addon unloads.
+  virtual uint32_t SubscribeExportCalls(ExportCallback_t callback,
+                                        void *user) = 0;
+  virtual void UnsubscribeExportCalls(uint32_t id) = 0;
+  // Pre/post callbacks around one of Lossless_original's imports, in
+  // registration order. Only imports the host declares a hook for (see
+  // import_hook.hpp) can be observed; returns 0 for others, or if
+  // Lossless_original doesn't import it. Either callback may be null.
+  // Callbacks registered from AddonInitialize or AddonRenderSettings are
+  // removed when the addon unloads.
+  virtual uint32_t AddImportCallback(const char *dllName,
+                                     const char *functionName,
+                                     ImportCallback_t pre,
+                                     ImportCallback_t post, void *user) = 0;
+  virtual void RemoveImportCallback(uint32_t id) = 0;
+  // Ends the AddonInitializeAsync call the task was passed to. Any thread,
+  // once per task; further calls are ignored.
+  virtual void CompleteInitialize(AddonInitTask *task, bool succeeded) = 0;
   // Add more host services here (e.g. Config access)
 };
 
@@ -29,9 +167,26 @@ struct IHost {
 // GetAddonName(); extern "C" __declspec(dllexport) const char*
 // GetAddonVersion();
 
+// ctx is null when the host runs headless (no manager window)
 typedef void (*AddonInit_t)(IHost *host, ImGuiContext *ctx, void *alloc_func,
                             void *free_func, void *user_data);
 typedef void (*AddonShutdown_t)();
+
+// Alternative to AddonInitialize for addons with slow setup (compiling
+// shaders, reading large assets). Called on the GUI thread with the same
+// arguments; start the work elsewhere, return, and call
+// host->CompleteInitialize(task, succeeded) when it is done. The host starts
+// every async addon's init without waiting and keeps drawing meanwhile. The
+// addon's intercepts, transforms and settings UI stay off until it
+// completes. If it fails, the host still calls AddonShutdown (join the
+// threads you started there) and then unloads the addon. Patches and
+// callbacks registered after AddonInitializeAsync returned are not removed
+// with the addon, since the host can't tell whose they are; register them
+// in the call itself or remove them in AddonShutdown. addon_async.hpp wraps
+// this for C++20 coroutines.
+typedef void (*AddonInitAsync_t)(IHost *host, ImGuiContext *ctx,
+                                 void *alloc_func, void *free_func,
+                                 void *user_data, AddonInitTask *task);
 typedef uint32_t (*GetAddonCaps_t)();
 typedef void (*AddonRenderSettings_t)();
 typedef bool (*AddonInterceptResource_t)(const wchar_t *name,
@@ -40,3 +195,93 @@ typedef bool (*AddonInterceptResource_t)(const wchar_t *name,
                                          uint32_t *outSize);
 typedef const char *(*GetAddonName_t)();
 typedef const char *(*GetAddonVersion_t)();
+
+// Resource transform chain. Unlike AddonInterceptResource, where the first
+// addon to answer wins, every addon exporting AddonTransformResource gets a
+// turn, in [TransformOrder] order from addons_config.ini (lower first). Each
+// stage sees the previous stage's output (the original resource, or an
+// intercepted replacement, for the first). Return false to pass the input
+// through, or true with *outData/*outSize set to replace it; the data must
+// stay valid until the addon's next call.
+typedef bool (*AddonTransformResource_t)(const wchar_t *name,
+                                         const wchar_t *type,
+                                         const void *input, uint32_t inputSize,
+                                         const void **outData,
+                                         uint32_t *outSize);
+// Optional companion: a hash of every setting that affects the addon's
+// transform output. With it the host memoizes the stage by (input,
+// GetAddonVersion, settings hash) and reruns it only when one changes;
+// without it the stage runs on every load.
+typedef uint64_t (*AddonGetSettingsHash_t)();
+
+// Batch form of AddonInterceptResource. The host calls it once after
+// AddonInitialize with every resource in Lossless' resource directory, so the
+// addon can build its replacements together (in parallel, if it likes).
+// Set responses[i] for each request it replaces and leave the rest zeroed;
+// the host copies the data before the call returns. Requests left empty are
+// not asked for again through AddonInterceptResource, and resources outside
+// the list still are. If the answers depend on settings, also export
+// AddonGetSettingsHash: the host asks again when the hash changes after
+// AddonRenderSettings.
+struct ResourceRequest {
+  const wchar_t *name; // Resource name or MAKEINTRESOURCEW id
+  const wchar_t *type;
+};
+
+struct ResourceResponse {
+  const void *data;
+  uint32_t size;
+};
+
+typedef void (*AddonInterceptResourceBatch_t)(const ResourceRequest *requests,
+                                              uint32_t count,
+                                              ResourceResponse *responses);
+
+// All of the above in one export. The host calls
+// GetAddonInterface(ADDON_INTERFACE_VERSION) once per load and takes every
+// entry point from the returned table, instead of looking up each export by
+// name (and guessing AddonInitialize's signature). Null members are
+// functions the addon doesn't have. Return a table of the requested version
+// or a later one, or null to have the host fall back to the named exports.
+// The table must stay valid while the addon is loaded; a static const one
+// will do:
+//
+//   static const AddonInterface g_interface = {
+//       sizeof(AddonInterface), ADDON_INTERFACE_VERSION, ADDON_CAP_NONE, 0,
+//       "1.0", MyInitialize, nullptr, MyShutdown};
+//
+//   extern "C" __declspec(dllexport) const AddonInterface *
+//   GetAddonInterface(uint32_t version) {
+//     return &g_interface;
+//   }
+//
+// Later versions only append members, so a host reads the first size bytes
+// it knows about.
+#define ADDON_INTERFACE_VERSION 1
+
+struct AddonInterface {
+  uint32_t size;         // sizeof(AddonInterface) for the addon's version
+  uint32_t version;      // ADDON_INTERFACE_VERSION the addon was built with
+  uint32_t capabilities; // AddonCaps, as GetAddonCapabilities
+  uint32_t reserved;     // 0
+  const char *addonVersion; // As GetAddonVersion; may be null
+  AddonInit_t initialize;
+  AddonInitAsync_t initializeAsync; // Preferred over initialize
+  AddonShutdown_t shutdown;
+  AddonRenderSettings_t renderSettings;
+  AddonInterceptResource_t interceptResource;
+  AddonInterceptResourceBatch_t interceptResourceBatch;
+  AddonTransformResource_t transformResource;
+  AddonGetSettingsHash_t getSettingsHash;
+};
+
+typedef const AddonInterface *(*GetAddonInterface_t)(uint32_t version);
+
+// Version 1's layout is frozen: addons built against it must keep loading
+static_assert(offsetof(AddonInterface, addonVersion) == 16,
+              "AddonInterface header changed");
+static_assert(offsetof(AddonInterface, getSettingsHash) ==
+                  16 + 8 * sizeof(void *),
+              "AddonInterface version 1 members moved");
+static_assert(sizeof(AddonInterface) == 16 + 9 * sizeof(void *),
+              "new AddonInterface members need a new version");
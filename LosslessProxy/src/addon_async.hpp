@@ -0,0 +1,73 @@
+#pragma once
+#include "addon_api.hpp"
+
+// C++20 coroutines for AddonInitializeAsync, for addons only (the host is
+// C++17). Write the init as a coroutine returning AddonAsync::InitTask,
+// taking the host and the task first, and co_return whether it worked:
+//
+//   static std::thread g_initThread;
+//
+//   static AddonAsync::InitTask Setup(IHost *host, AddonInitTask *task) {
+//     host->RegisterShaderPatch(&patch); // Still inside the export
+//     co_await AddonAsync::ResumeOnThread{g_initThread};
+//     co_return CompileShaders();
+//   }
+//
+//   extern "C" __declspec(dllexport) void AddonInitializeAsync(
+//       IHost *host, ImGuiContext *ctx, void *alloc_func, void *free_func,
+//       void *user_data, AddonInitTask *task) {
+//     ImGui::SetCurrentContext(ctx);
+//     ImGui::SetAllocatorFunctions(...);
+//     Setup(host, task);
+//   }
+//
+//   extern "C" __declspec(dllexport) void AddonShutdown() {
+//     if (g_initThread.joinable())
+//       g_initThread.join();
+//   }
+//
+// The coroutine runs up to its first co_await inside the export, completes
+// the task when it returns (false if it throws) and then frees itself. Its
+// last thread is still in the addon's code after completing, which is why
+// AddonShutdown joins it.
+#if __cplusplus >= 202002L || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+#include <coroutine>
+#include <thread>
+
+namespace AddonAsync {
+
+class InitTask {
+public:
+  struct promise_type {
+    template <typename... Args>
+    promise_type(IHost *host, AddonInitTask *task, Args &&...)
+        : host(host), task(task) {}
+
+    InitTask get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_value(bool succeeded) {
+      host->CompleteInitialize(task, succeeded);
+    }
+    void unhandled_exception() { host->CompleteInitialize(task, false); }
+
+    IHost *host;
+    AddonInitTask *task;
+  };
+};
+
+// Continues the coroutine on a new thread, stored in thread for joining.
+// thread must not be running already.
+struct ResumeOnThread {
+  std::thread &thread;
+
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<> handle) {
+    thread = std::thread([handle]() { handle.resume(); });
+  }
+  void await_resume() const noexcept {}
+};
+
+} // namespace AddonAsync
+
+#endif
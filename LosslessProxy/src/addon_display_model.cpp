@@ -0,0 +1,105 @@
+#include "addon_display_model.hpp"
+#include "gui_frame.hpp"
+#include <cctype>
+
+static std::string ToLowerAscii(const std::string &text) {
+  std::string lower = text;
+  for (char &c : lower) {
+    c = (char)std::tolower((unsigned char)c);
+  }
+  return lower;
+}
+
+const char *AddonDisplayModel::FilterName(Filter filter) {
+  switch (filter) {
+  case Filter::All:
+    return "All";
+  case Filter::Enabled:
+    return "Enabled";
+  case Filter::Disabled:
+    return "Disabled";
+  case Filter::WithSettings:
+    return "With settings";
+  default:
+    return "";
+  }
+}
+
+void AddonDisplayModel::Sync(IGuiHost *host) {
+  uint64_t hostRevision = host->GetRevision();
+  if (synced && hostRevision == revision)
+    return;
+
+  revision = hostRevision;
+  synced = true;
+  Rebuild(host);
+  ApplyFilter();
+}
+
+void AddonDisplayModel::Rebuild(IGuiHost *host) {
+  int count = host->GetAddonCount();
+  rows.clear();
+  rows.reserve(count);
+
+  for (int i = 0; i < count; ++i) {
+    AddonDisplayRow row;
+    row.addonIndex = i;
+    row.name = host->GetAddonName(i);
+    row.searchKey = ToLowerAscii(row.name);
+    // "###" keeps the window ID stable if two addons share a name
+    row.settingsTitle =
+        "Settings: " + row.name + "###AddonSettings" + std::to_string(i);
+    row.enabled = host->IsAddonEnabled(i);
+    row.loaded = host->IsAddonLoaded(i);
+    row.status = host->GetAddonStatus(i);
+    row.hasSettings = host->HasAddonSettings(i);
+    row.showSettings = host->GetShowSettingsFlag(i);
+    row.configPath = host->GetAddonConfigPath(i);
+    rows.push_back(std::move(row));
+  }
+}
+
+void AddonDisplayModel::SetSearch(const std::string &text) {
+  std::string lower = ToLowerAscii(text);
+  if (lower == search)
+    return;
+  search = std::move(lower);
+  ApplyFilter();
+}
+
+void AddonDisplayModel::SetFilter(Filter value) {
+  if (value == filter)
+    return;
+  filter = value;
+  ApplyFilter();
+}
+
+void AddonDisplayModel::ApplyFilter() {
+  visible.clear();
+  for (int i = 0; i < (int)rows.size(); ++i) {
+    const AddonDisplayRow &row = rows[i];
+
+    bool pass = true;
+    switch (filter) {
+    case Filter::Enabled:
+      pass = row.enabled;
+      break;
+    case Filter::Disabled:
+      pass = !row.enabled;
+      break;
+    case Filter::WithSettings:
+      pass = row.hasSettings;
+      break;
+    default:
+      break;
+    }
+
+    if (pass && !search.empty()) {
+      pass = row.searchKey.find(search) != std::string::npos;
+    }
+
+    if (pass) {
+      visible.push_back(i);
+    }
+  }
+}
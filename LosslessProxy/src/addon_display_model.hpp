@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+class IGuiHost;
+
+// Per-addon strings and flags the addons panel draws, converted once per
+// addon list change instead of once per frame.
+struct AddonDisplayRow {
+  int addonIndex = 0;
+  std::string name;          // UTF-8
+  std::string searchKey;     // Lowercased name for filtering
+  std::string settingsTitle; // Unique ImGui window title
+  const char *status = "";
+  std::filesystem::path configPath;
+  bool enabled = false;
+  bool loaded = false;
+  bool hasSettings = false;
+  bool *showSettings = nullptr; // Points into the host's addon list
+};
+
+class AddonDisplayModel {
+public:
+  enum class Filter { All, Enabled, Disabled, WithSettings, Count };
+  static const char *FilterName(Filter filter);
+
+  // Rebuilds the rows if the host's addon list changed since the last call
+  void Sync(IGuiHost *host);
+
+  void SetSearch(const std::string &text);
+  void SetFilter(Filter filter);
+  Filter GetFilter() const { return filter; }
+
+  const std::vector<AddonDisplayRow> &GetRows() const { return rows; }
+  // Indices into GetRows() that pass the search and filter
+  const std::vector<int> &GetVisibleRows() const { return visible; }
+
+private:
+  void Rebuild(IGuiHost *host);
+  void ApplyFilter();
+
+  std::vector<AddonDisplayRow> rows;
+  std::vector<int> visible;
+  uint64_t revision = 0;
+  bool synced = false;
+
+  std::string search; // Lowercased
+  Filter filter = Filter::All;
+};
@@ -1,29 +1,69 @@
 #include "addon_manager.hpp"
-#include "imgui.h"
-#include <filesystem>
+#include "alloc_pool.hpp"
+#include "content_hash.hpp"
+#include "export_profile.hpp"
+#include "import_hook.hpp"
+#include "ini_file.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <sstream>
 
 namespace fs = std::filesystem;
 
-AddonManager::AddonManager() {
-  wchar_t buffer[MAX_PATH];
-  GetModuleFileNameW(NULL, buffer, MAX_PATH);
-  fs::path exePath(buffer);
-  configFilePath =
-      (exePath.parent_path() / "addons" / "addons_config.ini").wstring();
+// Module of the addon whose Init/RenderSettings is running on this thread,
+// to tie the patches, subscriptions and callbacks it registers to its
+// lifetime
+static thread_local HMODULE t_callingAddon = nullptr;
 
-  ScanAddons();
-  LoadConfig();
+struct AddonInitTask {
+  std::mutex lock;
+  std::condition_variable completion;
+  bool completed = false;
+  bool succeeded = false;
+};
+
+static bool IsCompleted(AddonInitTask &task) {
+  std::lock_guard<std::mutex> guard(task.lock);
+  return task.completed;
 }
 
-AddonManager::~AddonManager() { UnloadAddons(); }
+// Whether the hooks may call into the addon: not before its
+// AddonInitialize (or AddonInitializeAsync) has completed
+static bool IsLive(const AddonInfo &addon) {
+  return addon.enabled && addon.hModule &&
+         addon.loadState == AddonLoadState::Ready;
+}
+
+AddonManager::AddonManager()
+    : AddonManager(Platform::GetHostExecutablePath().parent_path() /
+                   "addons") {}
+
+AddonManager::AddonManager(const fs::path &addonsDirectory)
+    : addonsPath(addonsDirectory) {
+  configFilePath = addonsPath / "addons_config.ini";
+
+  {
+    LS_TRACE_SCOPE("ScanAddons");
+    ScanAddons();
+  }
+  {
+    LS_TRACE_SCOPE("LoadConfig");
+    LoadConfig();
+  }
+}
+
+AddonManager::~AddonManager() {
+  loader.Cancel();
+  UnloadAddons();
+  // Whoever still calls in must have stopped before the manager goes
+  delete dispatch.exchange(nullptr);
+}
 
 void AddonManager::ScanAddons() {
   addons.clear();
-
-  wchar_t buffer[MAX_PATH];
-  GetModuleFileNameW(NULL, buffer, MAX_PATH);
-  fs::path exePath(buffer);
-  fs::path addonsPath = exePath.parent_path() / "addons";
+  revision++;
 
   if (!fs::exists(addonsPath)) {
     fs::create_directory(addonsPath);
@@ -41,15 +81,15 @@ void AddonManager::ScanAddons() {
       bool foundDll = false;
 
       // Priority 1: DLL with same name as folder
-      fs::path expectedDll =
-          entry.path() / (entry.path().filename().string() + ".dll");
+      fs::path expectedDll = entry.path() / entry.path().filename();
+      expectedDll += Platform::kModuleExtension;
       if (fs::exists(expectedDll)) {
         info.path = expectedDll.wstring();
         foundDll = true;
       }
 
       for (const auto &subEntry : fs::directory_iterator(entry.path())) {
-        if (subEntry.path().extension() == ".dll") {
+        if (subEntry.path().extension() == Platform::kModuleExtension) {
           // Priority 2: Any DLL (if specific one not found)
           if (!foundDll) {
             info.path = subEntry.path().wstring();
@@ -68,22 +108,118 @@ void AddonManager::ScanAddons() {
 }
 
 void AddonManager::LoadConfig() {
+  IniFile config;
+  config.Load(configFilePath);
   for (auto &addon : addons) {
-    int status = GetPrivateProfileIntW(L"Addons", addon.name.c_str(), 1,
-                                       configFilePath.c_str());
+    std::string name = fs::path(addon.name).u8string();
+    int status = config.GetInt("Addons", name, 1);
     addon.enabled = (status != 0);
+    addon.transformOrder = config.GetInt("TransformOrder", name, 100);
+  }
+  revision++;
+  RebuildTransformChain();
+}
+
+// Enabled, loaded addons that export AddonTransformResource, by
+// [TransformOrder] and then by name so the order never depends on the scan
+void AddonManager::RebuildTransformChain() {
+  std::vector<const AddonInfo *> participants;
+  for (const auto &addon : addons) {
+    if (IsLive(addon) && addon.TransformResourceFunc)
+      participants.push_back(&addon);
+  }
+  std::sort(participants.begin(), participants.end(),
+            [](const AddonInfo *a, const AddonInfo *b) {
+              if (a->transformOrder != b->transformOrder)
+                return a->transformOrder < b->transformOrder;
+              return a->name < b->name;
+            });
+
+  std::vector<TransformChain::Stage> stages;
+  for (const AddonInfo *addon : participants) {
+    stages.push_back({fs::path(addon->name).u8string(), addon->version,
+                      addon->TransformResourceFunc,
+                      addon->GetSettingsHashFunc});
   }
+  transformChain.SetStages(stages);
+}
+
+void AddonManager::AskInterceptBatch(AddonInfo &addon) {
+  if (resourceDirectory.empty() || !addon.InterceptResourceBatchFunc)
+    return;
+  LS_TRACE_SCOPE_DYNAMIC("Batch " + fs::path(addon.name).u8string());
+  auto started = std::chrono::steady_clock::now();
+  addon.batchSettingsHash =
+      addon.GetSettingsHashFunc ? addon.GetSettingsHashFunc() : 0;
+  t_callingAddon = addon.hModule;
+  auto answers = InterceptBatch::Ask(addon.InterceptResourceBatchFunc,
+                                     resourceDirectory);
+  t_callingAddon = nullptr;
+  addon.batchAnswers = answers;
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - started);
+
+  std::wostringstream oss;
+  oss << L"[AddonManager] " << addon.name << L" batch: replaces "
+      << answers->size() << L" of " << resourceDirectory.size()
+      << L" resources (" << elapsed.count() << L" ms)";
+  Log(oss.str().c_str());
+}
+
+uint64_t AddonManager::DispatchScope::InterceptStamp() const {
+  if (!dispatch)
+    return 0;
+  uint64_t stamp = dispatch->generation;
+  for (AddonGetSettingsHash_t settingsHash : dispatch->settingsHashes)
+    stamp = HashMix(stamp, settingsHash());
+  return stamp;
+}
+
+void AddonManager::PublishDispatch() {
+  auto next = std::make_unique<AddonDispatch>();
+  std::vector<std::shared_ptr<const InterceptBatch::Answers>> answers;
+  std::vector<bool> perCall;
+  bool any = false;
+  for (const auto &addon : addons) {
+    if (!IsLive(addon))
+      continue;
+    if (addon.capabilities & ADDON_CAP_PATCH_LS1_LOGIC)
+      next->applyPatches = true;
+    // Compact: only addons the hooks would call or answer from
+    if (!addon.batchAnswers && !addon.InterceptResourceFunc)
+      continue;
+    bool answered = addon.batchAnswers != nullptr;
+    next->intercepts.push_back(answered ? nullptr
+                                        : addon.InterceptResourceFunc);
+    answers.push_back(addon.batchAnswers);
+    perCall.push_back(!answered);
+    if (addon.GetSettingsHashFunc)
+      next->settingsHashes.push_back(addon.GetSettingsHashFunc);
+    any = any || answered;
+  }
+  if (any) {
+    next->batch = std::make_shared<InterceptBatch>(resourceDirectory, answers,
+                                                   perCall);
+  }
+  next->generation = ++dispatchGeneration;
+
+  const AddonDispatch *previous = dispatch.exchange(next.release());
+  if (dispatchRcu.Synchronize())
+    delete previous; // Else leaked: see ProcessExit::SetExiting
 }
 
 void AddonManager::SaveConfig() {
+  IniFile config;
+  config.Load(configFilePath);
   for (const auto &addon : addons) {
-    WritePrivateProfileStringW(L"Addons", addon.name.c_str(),
-                               addon.enabled ? L"1" : L"0",
-                               configFilePath.c_str());
+    config.Set("Addons", fs::path(addon.name).u8string(),
+               addon.enabled ? "1" : "0");
   }
+  config.Save(configFilePath);
 }
 
 void AddonManager::LoadAddons() {
+  LS_TRACE_SCOPE("LoadAddons");
   for (auto &addon : addons) {
     if (addon.enabled && !addon.hModule) {
       LoadAddon(addon);
@@ -100,99 +236,430 @@ void AddonManager::UnloadAddons() {
 }
 
 void AddonManager::ReloadAddons() {
+  loader.Cancel();
   UnloadAddons();
   ScanAddons(); // Rescan in case new files appeared
   LoadConfig();
-  LoadAddons();
+  if (initArgs.valid) {
+    QueueStagedLoad(); // The GUI keeps drawing while they load
+  } else {
+    LoadAddons();
+  }
+  RequestRedraw();
 }
 
 void AddonManager::LoadAddon(AddonInfo &addon) {
-  // Use LoadLibraryEx with LOAD_WITH_ALTERED_SEARCH_PATH to ensure dependencies
-  // in the same directory are found.
-  HMODULE hAddon =
-      LoadLibraryExW(addon.path.c_str(), NULL, LOAD_WITH_ALTERED_SEARCH_PATH);
-  if (!hAddon) {
-    hAddon = LoadLibraryW(addon.path.c_str());
+  LS_TRACE_SCOPE_DYNAMIC("LoadAddon " + fs::path(addon.name).u8string());
+
+  HMODULE hAddon;
+  {
+    LS_TRACE_SCOPE("LoadLibrary");
+    hAddon = Platform::LoadModule(addon.path);
   }
+  AttachModule(addon, hAddon);
+}
 
+// Every version-1 member, the least a table must cover
+static constexpr size_t kAddonInterfaceV1Size =
+    offsetof(AddonInterface, getSettingsHash) + sizeof(AddonGetSettingsHash_t);
+
+// From GetAddonInterface's table; false if it is not one we can read
+static bool ReadAddonInterface(AddonInfo &addon,
+                               const AddonInterface &table) {
+  if (table.version < 1 || table.size < kAddonInterfaceV1Size)
+    return false;
+  addon.InitFunc = table.initialize;
+  addon.InitAsyncFunc = table.initializeAsync;
+  addon.ShutdownFunc = table.shutdown;
+  addon.RenderSettingsFunc = table.renderSettings;
+  addon.InterceptResourceFunc = table.interceptResource;
+  addon.TransformResourceFunc = table.transformResource;
+  addon.GetSettingsHashFunc = table.getSettingsHash;
+  addon.InterceptResourceBatchFunc = table.interceptResourceBatch;
+  addon.capabilities = table.capabilities;
+  addon.version = table.addonVersion ? table.addonVersion : "";
+  return true;
+}
+
+// Addons without GetAddonInterface: one lookup per export
+static void ReadAddonExports(AddonInfo &addon, HMODULE hAddon) {
+  addon.InitFunc =
+      (AddonInit_t)Platform::GetModuleSymbol(hAddon, "AddonInitialize");
+  if (!addon.InitFunc) {
+    // Try legacy name
+    addon.InitFunc =
+        (AddonInit_t)Platform::GetModuleSymbol(hAddon, "AddonInit");
+  }
+  addon.InitAsyncFunc = (AddonInitAsync_t)Platform::GetModuleSymbol(
+      hAddon, "AddonInitializeAsync");
+
+  addon.ShutdownFunc =
+      (AddonShutdown_t)Platform::GetModuleSymbol(hAddon, "AddonShutdown");
+  addon.RenderSettingsFunc = (AddonRenderSettings_t)Platform::GetModuleSymbol(
+      hAddon, "AddonRenderSettings");
+  addon.InterceptResourceFunc =
+      (AddonInterceptResource_t)Platform::GetModuleSymbol(
+          hAddon, "AddonInterceptResource");
+  addon.TransformResourceFunc =
+      (AddonTransformResource_t)Platform::GetModuleSymbol(
+          hAddon, "AddonTransformResource");
+  addon.GetSettingsHashFunc = (AddonGetSettingsHash_t)Platform::GetModuleSymbol(
+      hAddon, "AddonGetSettingsHash");
+  addon.InterceptResourceBatchFunc =
+      (AddonInterceptResourceBatch_t)Platform::GetModuleSymbol(
+          hAddon, "AddonInterceptResourceBatch");
+  GetAddonCaps_t getCaps = (GetAddonCaps_t)Platform::GetModuleSymbol(
+      hAddon, "GetAddonCapabilities");
+  GetAddonVersion_t getVersion =
+      (GetAddonVersion_t)Platform::GetModuleSymbol(hAddon, "GetAddonVersion");
+
+  if (getCaps) {
+    addon.capabilities = getCaps();
+  }
+  const char *version = getVersion ? getVersion() : nullptr;
+  addon.version = version ? version : "";
+}
+
+void AddonManager::AttachModule(AddonInfo &addon, HMODULE hAddon) {
+  revision++;
   if (hAddon) {
+    LS_TRACE_SCOPE("GetProcAddress");
     addon.hModule = hAddon;
+    addon.loadState = AddonLoadState::Attached;
 
     // Load API Functions
-    addon.InitFunc = (AddonInit_t)GetProcAddress(hAddon, "AddonInitialize");
-    if (!addon.InitFunc) {
-      // Try legacy name
-      addon.InitFunc = (AddonInit_t)GetProcAddress(hAddon, "AddonInit");
+    GetAddonInterface_t getInterface =
+        (GetAddonInterface_t)Platform::GetModuleSymbol(hAddon,
+                                                       "GetAddonInterface");
+    const AddonInterface *table =
+        getInterface ? getInterface(ADDON_INTERFACE_VERSION) : nullptr;
+    if (!table || !ReadAddonInterface(addon, *table)) {
+      if (table) {
+        std::wstring message = L"[AddonManager] " + addon.name +
+                               L" returned an unknown AddonInterface, "
+                               L"using its exports instead";
+        Log(message.c_str());
+      }
+      ReadAddonExports(addon, hAddon);
     }
 
-    addon.ShutdownFunc =
-        (AddonShutdown_t)GetProcAddress(hAddon, "AddonShutdown");
-    addon.RenderSettingsFunc =
-        (AddonRenderSettings_t)GetProcAddress(hAddon, "AddonRenderSettings");
-    addon.InterceptResourceFunc = (AddonInterceptResource_t)GetProcAddress(
-        hAddon, "AddonInterceptResource");
-    GetAddonCaps_t getCaps =
-        (GetAddonCaps_t)GetProcAddress(hAddon, "GetAddonCapabilities");
-
-    if (getCaps) {
-      addon.capabilities = getCaps();
+    // Call Initialize later (in InitializeAddons or PumpStagedLoad), which
+    // also puts the addon in the hooks' reach
+  } else {
+    addon.loadState = AddonLoadState::Failed;
+  }
+}
+
+void AddonManager::InitializeAddons(void *imGuiContext, void *alloc_func,
+                                    void *free_func, void *user_data) {
+  LS_TRACE_SCOPE("InitializeAddons");
+  initArgs = {imGuiContext, alloc_func, free_func, user_data, true};
+
+  for (auto &addon : addons) {
+    if (addon.enabled && addon.hModule) {
+      InitAddon(addon);
     }
+  }
+  // The async ones ran alongside the rest
+  for (auto &addon : addons) {
+    if (addon.loadState == AddonLoadState::Initializing) {
+      WaitForInit(addon);
+      FinishInit(addon);
+    }
+  }
 
-    // Call Initialize later (in InitializeAddons)
-  } else {
-    // Failed to load
+  // Once everything is initialized, so batches see their addon's settings
+  for (auto &addon : addons) {
+    if (addon.enabled && addon.hModule && !addon.InitAsyncFunc)
+      AskInterceptBatch(addon);
+  }
+  RebuildTransformChain();
+  PublishDispatch();
+}
+
+// With the host's pooled allocator, each addon's ImGui allocations are
+// tagged with its name for the memory panel
+static void *AddonAllocUserData(const AddonInfo &addon, void *allocFunc,
+                                void *allocUserData) {
+  if (allocFunc == (void *)&AllocPool::Alloc) {
+    if (AllocPool::Tag *tag =
+            AllocPool::GetTag(fs::path(addon.name).u8string()))
+      return tag;
+  }
+  return allocUserData;
+}
+
+void AddonManager::InitAddon(AddonInfo &addon) {
+  void *allocUserData =
+      AddonAllocUserData(addon, initArgs.allocFunc, initArgs.allocUserData);
+  if (addon.InitAsyncFunc) {
+    LS_TRACE_SCOPE_DYNAMIC("Init " + fs::path(addon.name).u8string());
+    addon.initTask = std::make_shared<AddonInitTask>();
+    addon.loadState = AddonLoadState::Initializing;
+    revision++;
+    t_callingAddon = addon.hModule;
+    addon.InitAsyncFunc(this, (ImGuiContext *)initArgs.imGuiContext,
+                        initArgs.allocFunc, initArgs.freeFunc,
+                        allocUserData, addon.initTask.get());
+    t_callingAddon = nullptr;
+    return;
+  }
+  if (addon.InitFunc) {
+    // A GetAddonInterface table states this signature. Named exports
+    // can't, so older addons written for fewer arguments just ignore the
+    // rest, which the calling convention leaves harmless.
+    LS_TRACE_SCOPE_DYNAMIC("Init " + fs::path(addon.name).u8string());
+    t_callingAddon = addon.hModule;
+    addon.InitFunc(this, (ImGuiContext *)initArgs.imGuiContext,
+                   initArgs.allocFunc, initArgs.freeFunc,
+                   allocUserData);
+    t_callingAddon = nullptr;
+  }
+  addon.loadState = AddonLoadState::Ready;
+  revision++;
+}
+
+void AddonManager::FinishInit(AddonInfo &addon) {
+  bool succeeded;
+  {
+    std::lock_guard<std::mutex> guard(addon.initTask->lock);
+    succeeded = addon.initTask->succeeded;
+  }
+  addon.initTask = nullptr;
+  if (!succeeded) {
+    std::wstring message = L"[AddonManager] " + addon.name +
+                           L" failed to initialize, unloading";
+    Log(message.c_str());
+    UnloadAddon(addon); // Still Initializing, so AddonShutdown runs
+    addon.loadState = AddonLoadState::Failed;
+    return;
+  }
+  addon.loadState = AddonLoadState::Ready;
+  revision++;
+  AskInterceptBatch(addon);
+  RebuildTransformChain();
+  PublishDispatch();
+}
+
+void AddonManager::WaitForInit(AddonInfo &addon) {
+  if (!addon.initTask)
+    return;
+  std::unique_lock<std::mutex> guard(addon.initTask->lock);
+  addon.initTask->completion.wait(guard,
+                                  [&]() { return addon.initTask->completed; });
+}
+
+void AddonManager::CompleteInitialize(AddonInitTask *task, bool succeeded) {
+  if (!task)
+    return;
+  {
+    std::lock_guard<std::mutex> guard(task->lock);
+    if (task->completed)
+      return;
+    task->completed = true;
+    task->succeeded = succeeded;
+    // Under the lock: the waiter may free the task as soon as it wakes
+    task->completion.notify_all();
   }
+  RequestRedraw(); // PumpStagedLoad finishes it
 }
 
-void AddonManager::InitializeAddons(void *imGuiContext) {
-  ImGuiMemAllocFunc alloc_func;
-  ImGuiMemFreeFunc free_func;
-  void *user_data;
-  ImGui::GetAllocatorFunctions(&alloc_func, &free_func, &user_data);
+void AddonManager::BeginStagedLoad(void *imGuiContext, void *allocFunc,
+                                   void *freeFunc, void *allocUserData) {
+  initArgs = {imGuiContext, allocFunc, freeFunc, allocUserData, true};
+  QueueStagedLoad();
+}
 
+void AddonManager::QueueStagedLoad() {
+  std::vector<ModuleLoader::Job> jobs;
+  for (size_t i = 0; i < addons.size(); ++i) {
+    AddonInfo &addon = addons[i];
+    if (addon.enabled && !addon.hModule) {
+      addon.loadState = AddonLoadState::Queued;
+      jobs.push_back({i, addon.path});
+    }
+  }
+  staging = true;
+  stagedTotal = 0;
+  for (const auto &addon : addons) {
+    if (addon.loadState == AddonLoadState::Queued ||
+        addon.loadState == AddonLoadState::Attached)
+      stagedTotal++;
+  }
+  revision++;
+  // The loader wakes the GUI after every module
+  loader.Start(std::move(jobs), [this]() { RequestRedraw(); });
+}
+
+bool AddonManager::PumpStagedLoad() {
+  for (ModuleLoader::Result &result : loader.Poll()) {
+    // Toggled or rescanned while loading: the result is stale
+    AddonInfo *addon =
+        result.index < addons.size() ? &addons[result.index] : nullptr;
+    if (!addon || addon->loadState != AddonLoadState::Queued ||
+        addon->hModule || fs::path(addon->path) != result.path) {
+      if (result.module)
+        Platform::FreeModule(result.module);
+      continue;
+    }
+    AttachModule(*addon, result.module);
+  }
+
+  // AddonInitializeAsync calls that completed since the last call
   for (auto &addon : addons) {
-    if (addon.enabled && addon.InitFunc) {
-      // Cast to void* to match the generic signature, assuming Addons follow
-      // the new API Note: We might need to keep legacy support IF strict ABI is
-      // needed, but since we control both... We'll cast the function pointer to
-      // a type that accepts 5 args. Wait, AddonInit_t is already updated. The
-      // addons need to update their export too. But existing addons binaries
-      // might crash if called with extra args? Standard C calling convention
-      // (cdecl) cleans up stack by caller usually? Actually x64 uses registers
-      // for first 4 args. 5th is stack. To be safe, we should check if it's the
-      // new version? or just assume. User asked to fix it, implies we update
-      // code.
-      addon.InitFunc(this, (ImGuiContext *)imGuiContext, (void *)alloc_func,
-                     (void *)free_func, user_data);
+    if (addon.loadState == AddonLoadState::Initializing &&
+        IsCompleted(*addon.initTask))
+      FinishInit(addon);
+  }
+
+  // One AddonInitialize per call, in list order. Async ones are only
+  // started, so they don't count.
+  bool pending = false;
+  for (auto &addon : addons) {
+    if (addon.loadState == AddonLoadState::Queued) {
+      pending = true;
+      break;
+    }
+    if (addon.loadState == AddonLoadState::Initializing) {
+      pending = true;
+      continue;
     }
+    if (addon.loadState == AddonLoadState::Attached && initArgs.valid) {
+      InitAddon(addon);
+      pending = true;
+      if (addon.loadState == AddonLoadState::Initializing)
+        continue;
+      AskInterceptBatch(addon);
+      RebuildTransformChain();
+      PublishDispatch();
+      RequestRedraw(); // Next frame initializes the next one
+      break;
+    }
+  }
+
+  if (pending || !staging || loader.IsBusy())
+    return false;
+  staging = false;
+  return true;
+}
+
+bool AddonManager::GetLoadProgress(int *done, int *total) const {
+  if (!staging)
+    return false;
+  int remaining = 0;
+  for (const auto &addon : addons) {
+    if (addon.loadState == AddonLoadState::Queued ||
+        addon.loadState == AddonLoadState::Attached ||
+        addon.loadState == AddonLoadState::Initializing)
+      remaining++;
+  }
+  *total = stagedTotal;
+  *done = stagedTotal > remaining ? stagedTotal - remaining : 0;
+  return true;
+}
+
+const char *AddonLoadStateName(AddonLoadState state) {
+  switch (state) {
+  case AddonLoadState::Queued:
+    return "Loading...";
+  case AddonLoadState::Attached:
+    return "Starting...";
+  case AddonLoadState::Initializing:
+    return "Initializing...";
+  case AddonLoadState::Ready:
+    return "Loaded";
+  case AddonLoadState::Failed:
+    return "Failed";
+  default:
+    return "Unloaded";
   }
 }
 
 void AddonManager::UnloadAddon(AddonInfo &addon) {
   if (addon.hModule) {
-    if (addon.ShutdownFunc) {
+    // Out of the hooks' reach first: once PublishDispatch returns, no hook
+    // thread is still inside the addon or holding bytes it returned
+    addon.InterceptResourceFunc = nullptr;
+    addon.TransformResourceFunc = nullptr;
+    addon.GetSettingsHashFunc = nullptr;
+    addon.InterceptResourceBatchFunc = nullptr;
+    addon.batchAnswers = nullptr;
+    RebuildTransformChain();
+    PublishDispatch();
+
+    // An async init still running is using the module: let it finish
+    if (addon.initTask && !IsCompleted(*addon.initTask)) {
+      std::wstring message = L"[AddonManager] Waiting for " + addon.name +
+                             L" to finish initializing before unloading";
+      Log(message.c_str());
+    }
+    WaitForInit(addon);
+    addon.initTask = nullptr;
+
+    // Only addons that got their AddonInitialize (or a failed async one)
+    bool initialized = addon.loadState == AddonLoadState::Ready ||
+                       addon.loadState == AddonLoadState::Initializing;
+    if (addon.ShutdownFunc && initialized) {
       addon.ShutdownFunc();
     }
-    FreeLibrary(addon.hModule);
+    shaderPatcher.RemoveOwner(addon.hModule);
+    telemetry.ReleaseOwner(addon.hModule);
+    ExportProfile::UnsubscribeOwner(addon.hModule);
+    ImportHooks::RemoveOwner(addon.hModule);
+    Platform::FreeModule(addon.hModule);
     addon.hModule = nullptr;
     addon.InitFunc = nullptr;
+    addon.InitAsyncFunc = nullptr;
     addon.ShutdownFunc = nullptr;
     addon.RenderSettingsFunc = nullptr;
-    addon.InterceptResourceFunc = nullptr;
     addon.capabilities = ADDON_CAP_NONE;
+    revision++;
   }
+  addon.loadState = AddonLoadState::Unloaded;
 }
 
 bool AddonManager::InterceptResource(const wchar_t *name, const wchar_t *type,
                                      const void **outData, uint32_t *outSize) {
-  for (const auto &addon : addons) {
-    if (addon.enabled && addon.InterceptResourceFunc) {
-      if (addon.InterceptResourceFunc(name, type, outData, outSize)) {
-        return true;
-      }
-    }
+  DispatchScope scope(*this);
+  const AddonDispatch *current = scope.Get();
+  if (!current)
+    return false;
+
+  // Batch answers settle a directory resource for every addon that gave
+  // them; only the others before the first replacement are still asked
+  const std::vector<AddonInterceptResource_t> &intercepts =
+      current->intercepts;
+  const InterceptBatch *batch = current->batch.get();
+  size_t servedBy = intercepts.size();
+  const std::vector<uint8_t> *batched = nullptr;
+  bool askFirst = true;
+  bool known =
+      batch && batch->Find(name, type, &servedBy, &batched, &askFirst);
+
+  for (size_t i = 0; askFirst && i < servedBy && i < intercepts.size(); ++i) {
+    if (known && batch->Answered(i))
+      continue;
+    if (intercepts[i] && intercepts[i](name, type, outData, outSize))
+      return true;
   }
-  return false;
+  if (!batched)
+    return false;
+  *outData = batched->data();
+  *outSize = (uint32_t)batched->size();
+  return true;
+}
+
+void AddonManager::SetResourceDirectory(
+    std::vector<PeImage::Resource> resources) {
+  resourceDirectory = std::move(resources);
+}
+
+bool AddonManager::TransformResource(const wchar_t *name, const wchar_t *type,
+                                     const uint8_t *input, uint32_t size,
+                                     std::vector<uint8_t> *out) {
+  // The stages' modules stay loaded while this is open (see UnloadAddon)
+  DispatchScope scope(*this);
+  return transformChain.Run(name, type, input, size, out);
 }
 
 std::vector<AddonInfo> &AddonManager::GetAddons() { return addons; }
@@ -200,6 +667,7 @@ std::vector<AddonInfo> &AddonManager::GetAddons() { return addons; }
 void AddonManager::ToggleAddon(int index, bool enable) {
   if (index >= 0 && index < addons.size()) {
     addons[index].enabled = enable;
+    revision++;
     if (enable) {
       if (!addons[index].hModule) {
         LoadAddon(addons[index]);
@@ -208,16 +676,29 @@ void AddonManager::ToggleAddon(int index, bool enable) {
       if (addons[index].hModule) {
         UnloadAddon(addons[index]);
       }
+      addons[index].loadState = AddonLoadState::Unloaded; // Even if queued
     }
     SaveConfig();
+    RequestRedraw();
   }
 }
 
 void AddonManager::RenderAddonSettings(int index) {
   if (index >= 0 && index < addons.size()) {
     auto &addon = addons[index];
-    if (addon.hModule && addon.RenderSettingsFunc) {
+    // No settings UI before the addon has finished initializing
+    if (addon.hModule && addon.RenderSettingsFunc &&
+        addon.loadState == AddonLoadState::Ready) {
+      t_callingAddon = addon.hModule;
       addon.RenderSettingsFunc();
+      t_callingAddon = nullptr;
+
+      // Settings that changed the batch answers: ask again
+      if (addon.batchAnswers && addon.GetSettingsHashFunc &&
+          addon.GetSettingsHashFunc() != addon.batchSettingsHash) {
+        AskInterceptBatch(addon);
+        PublishDispatch();
+      }
     } else {
       // Check if it has legacy settings handling or is just missing the export
       if (addon.capabilities & ADDON_CAP_HAS_SETTINGS) {
@@ -231,6 +712,105 @@ void AddonManager::RenderAddonSettings(int index) {
 
 // IHost Implementation
 void AddonManager::Log(const wchar_t *message) {
-  OutputDebugStringW(message);
-  OutputDebugStringW(L"\n");
-}
\ No newline at end of file
+  Platform::DebugOutput(message);
+}
+
+void AddonManager::RequestRedraw() {
+  void (*callback)(void *);
+  void *user;
+  {
+    std::lock_guard<std::mutex> lock(redrawLock);
+    redrawRequested = true;
+    callback = redrawCallback;
+    user = redrawCallbackUser;
+  }
+  if (callback) {
+    callback(user);
+  }
+}
+
+void AddonManager::RequestAnimation(float framesPerSecond,
+                                    uint32_t durationMs) {
+  // Wakes the GUI without asking for a redraw: the next frame comes at the
+  // animation rate, not at once (see FrameScheduler::SetWakeHandler)
+  void (*callback)(void *);
+  void *user;
+  {
+    std::lock_guard<std::mutex> lock(redrawLock);
+    if (framesPerSecond > pendingAnimationFps)
+      pendingAnimationFps = framesPerSecond;
+    if (durationMs > pendingAnimationMs)
+      pendingAnimationMs = durationMs;
+    callback = redrawCallback;
+    user = redrawCallbackUser;
+  }
+  if (callback) {
+    callback(user);
+  }
+}
+
+void AddonManager::SetRedrawCallback(void (*callback)(void *), void *user) {
+  std::lock_guard<std::mutex> lock(redrawLock);
+  redrawCallback = callback;
+  redrawCallbackUser = user;
+}
+
+bool AddonManager::ConsumeRedrawRequest(float *animationFps,
+                                        uint32_t *animationMs) {
+  std::lock_guard<std::mutex> lock(redrawLock);
+  bool requested = redrawRequested;
+  *animationFps = pendingAnimationFps;
+  *animationMs = pendingAnimationMs;
+  redrawRequested = false;
+  pendingAnimationFps = 0.0f;
+  pendingAnimationMs = 0;
+  return requested;
+}
+
+void AddonManager::TraceBeginSpan(const char *name) {
+#ifdef LOSSLESS_ENABLE_TRACE
+  // Addon strings may not outlive the addon
+  Trace::BeginSpan(Trace::Intern(name ? name : "(null)"));
+#else
+  (void)name;
+#endif
+}
+
+void AddonManager::TraceEndSpan() { LS_TRACE_END(); }
+
+TelemetryChannel *AddonManager::TelemetryCreateChannel(const char *name) {
+  return telemetry.CreateChannel(name, t_callingAddon);
+}
+
+uint32_t AddonManager::RegisterShaderPatch(const ShaderPatch *patch) {
+  if (!patch)
+    return 0;
+  return shaderPatcher.Register(*patch, t_callingAddon);
+}
+
+void AddonManager::RemoveShaderPatch(uint32_t id) { shaderPatcher.Remove(id); }
+
+uint32_t AddonManager::SubscribeExportCalls(ExportCallback_t callback,
+                                            void *user) {
+  if (!callback)
+    return 0;
+  return ExportProfile::Subscribe(callback, user, t_callingAddon);
+}
+
+void AddonManager::UnsubscribeExportCalls(uint32_t id) {
+  ExportProfile::Unsubscribe(id);
+}
+
+uint32_t AddonManager::AddImportCallback(const char *dllName,
+                                         const char *functionName,
+                                         ImportCallback_t pre,
+                                         ImportCallback_t post, void *user) {
+  ImportHooks::HookBase *hook = ImportHooks::Find(dllName, functionName);
+  if (!hook)
+    return 0;
+  return hook->AddCallback(pre, post, user, t_callingAddon);
+}
+
+void AddonManager::RemoveImportCallback(uint32_t id) {
+  ImportHooks::RemoveCallback(id);
+}
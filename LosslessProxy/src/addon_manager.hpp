@@ -1,8 +1,31 @@
 #pragma once
 #include "addon_api.hpp"
+#include "intercept_batch.hpp"
+#include "module_loader.hpp"
+#include "platform.hpp"
+#include "rcu.hpp"
+#include "shader_patch.hpp"
+#include "telemetry.hpp"
+#include "transform_chain.hpp"
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
-#include <windows.h>
+
+// Where an addon is in its startup
+enum class AddonLoadState {
+  Unloaded,
+  Queued,   // Waiting for or in the background LoadLibrary
+  Attached,     // Module loaded, AddonInitialize not called yet
+  Initializing, // AddonInitializeAsync not completed yet
+  Ready,
+  Failed, // LoadLibrary or AddonInitializeAsync failed
+};
+
+// Status text for the addon list
+const char *AddonLoadStateName(AddonLoadState state);
 
 struct AddonInfo {
   std::wstring name;
@@ -11,46 +34,189 @@ struct AddonInfo {
   bool enabled = true;
   HMODULE hModule = nullptr;
   uint32_t capabilities = 0; // Bitmask of AddonCaps
+  std::string version;       // GetAddonVersion, empty if not exported
+  int transformOrder = 100;  // [TransformOrder] in the config, lower first
+  AddonLoadState loadState = AddonLoadState::Unloaded;
 
   // UI State
   bool showSettings = false;
 
   // Cached Function Pointers
   AddonInit_t InitFunc = nullptr;
+  AddonInitAsync_t InitAsyncFunc = nullptr; // Preferred over InitFunc
   AddonShutdown_t ShutdownFunc = nullptr;
   AddonRenderSettings_t RenderSettingsFunc = nullptr;
   AddonInterceptResource_t InterceptResourceFunc = nullptr;
+  AddonTransformResource_t TransformResourceFunc = nullptr;
+  AddonGetSettingsHash_t GetSettingsHashFunc = nullptr;
+  AddonInterceptResourceBatch_t InterceptResourceBatchFunc = nullptr;
+
+  // AddonInterceptResourceBatch results, null until asked
+  std::shared_ptr<const InterceptBatch::Answers> batchAnswers;
+  uint64_t batchSettingsHash = 0;
+
+  // The AddonInitializeAsync in flight, null otherwise
+  std::shared_ptr<AddonInitTask> initTask;
+};
+
+// What the hook threads dispatch from: the loaded, enabled addons that
+// replace resources, in addon order, and their merged batch answers. Built
+// by the GUI thread and never modified once published.
+struct AddonDispatch {
+  std::vector<AddonInterceptResource_t> intercepts; // nullptr: batch only
+  std::shared_ptr<const InterceptBatch> batch;      // Indexed like intercepts
+  bool applyPatches = false; // An addon has ADDON_CAP_PATCH_LS1_LOGIC
+  uint64_t generation = 0;    // Distinct for every publish
+  // Of the addons above that export AddonGetSettingsHash
+  std::vector<AddonGetSettingsHash_t> settingsHashes;
 };
 
 class AddonManager : public IHost {
 public:
-  AddonManager();
+  // Read side for the hooks: the current AddonDispatch, which stays valid,
+  // and its addons loaded, until the scope closes. That includes the bytes
+  // an addon returned. Lock-free; scopes nest.
+  class DispatchScope {
+  public:
+    explicit DispatchScope(const AddonManager &manager)
+        : scope(manager.dispatchRcu),
+          dispatch(manager.dispatch.load(std::memory_order_acquire)) {}
+    // nullptr before the first publish
+    const AddonDispatch *Get() const { return dispatch; }
+    // Changes whenever InterceptResource may answer differently: a new
+    // dispatch, or new settings in one of its addons. 0 before the first
+    // publish.
+    uint64_t InterceptStamp() const;
+
+  private:
+    RcuDomain::ReadScope scope;
+    const AddonDispatch *dispatch;
+  };
+
+  AddonManager(); // <exe dir>/addons
+  explicit AddonManager(const std::filesystem::path &addonsDirectory);
   ~AddonManager();
   void LoadAddons();
   void UnloadAddons();
   void ReloadAddons();
 
   std::vector<AddonInfo> &GetAddons();
+  const std::filesystem::path &GetAddonsDirectory() const { return addonsPath; }
+  const std::filesystem::path &GetConfigFilePath() const {
+    return configFilePath;
+  }
+  // Bumped on every change to the addon list or an addon's state
+  uint64_t GetRevision() const { return revision; }
   void ToggleAddon(int index, bool enable);
   void SaveConfig();
 
   // IHost Implementation
   void Log(const wchar_t *message) override;
+  void RequestRedraw() override;
+  void RequestAnimation(float framesPerSecond, uint32_t durationMs) override;
+  void TraceBeginSpan(const char *name) override;
+  void TraceEndSpan() override;
+  TelemetryChannel *TelemetryCreateChannel(const char *name) override;
+  uint32_t RegisterShaderPatch(const ShaderPatch *patch) override;
+  void RemoveShaderPatch(uint32_t id) override;
+  uint32_t SubscribeExportCalls(ExportCallback_t callback,
+                                void *user) override;
+  void UnsubscribeExportCalls(uint32_t id) override;
+  uint32_t AddImportCallback(const char *dllName, const char *functionName,
+                             ImportCallback_t pre, ImportCallback_t post,
+                             void *user) override;
+  void RemoveImportCallback(uint32_t id) override;
+  void CompleteInitialize(AddonInitTask *task, bool succeeded) override;
+
+  TelemetryHub &GetTelemetry() { return telemetry; }
+  ShaderPatcher &GetShaderPatcher() { return shaderPatcher; }
+
+  // Frame scheduling: the GUI installs a wake callback and drains requests
+  void SetRedrawCallback(void (*callback)(void *), void *user);
+  bool ConsumeRedrawRequest(float *animationFps, uint32_t *animationMs);
 
   // Generic generic API methods
   void RenderAddonSettings(int index);
+  // Any thread. Hold a DispatchScope until the returned bytes are copied.
   bool InterceptResource(const wchar_t *name, const wchar_t *type,
                          const void **outData, uint32_t *outSize);
+  // Lossless' resources, for AddonInterceptResourceBatch. Set before
+  // InitializeAddons.
+  void SetResourceDirectory(std::vector<PeImage::Resource> resources);
+  // Runs the AddonTransformResource chain; false if nothing changed the input.
+  // Any thread.
+  bool TransformResource(const wchar_t *name, const wchar_t *type,
+                         const uint8_t *input, uint32_t size,
+                         std::vector<uint8_t> *out);
+  bool HasTransforms() const { return !transformChain.IsEmpty(); }
+  const TransformChain &GetTransformChain() const { return transformChain; }
 
-  // Lifecycle
-  void InitializeAddons(void *imGuiContext);
+  // Lifecycle. The allocator is the GUI's ImGui allocator, passed through so
+  // addons share one heap with the host. Returns once every addon,
+  // AddonInitializeAsync ones included, has finished initializing.
+  void InitializeAddons(void *imGuiContext, void *allocFunc, void *freeFunc,
+                        void *allocUserData);
+
+  // Staged startup, for a GUI that should stay responsive: the enabled
+  // modules load on a background thread and PumpStagedLoad, called by the
+  // GUI thread between frames, attaches finished ones and runs at most one
+  // AddonInitialize per call. AddonInitializeAsync calls are started
+  // without waiting and finished by a later call once they complete.
+  // PumpStagedLoad returns true once, when the last addon is initialized.
+  // Reloads use the same path, and addons enabled later are initialized by
+  // it too.
+  void BeginStagedLoad(void *imGuiContext, void *allocFunc, void *freeFunc,
+                       void *allocUserData);
+  bool PumpStagedLoad();
+  // False unless a staged load is running
+  bool GetLoadProgress(int *done, int *total) const;
 
 private:
   void LoadAddon(AddonInfo &addon);
+  void AttachModule(AddonInfo &addon, HMODULE module);
+  void InitAddon(AddonInfo &addon);
+  // AddonInitializeAsync's completion: the addon goes live, or is unloaded
+  void FinishInit(AddonInfo &addon);
+  void WaitForInit(AddonInfo &addon);
+  void QueueStagedLoad();
   void UnloadAddon(AddonInfo &addon);
   void ScanAddons();
   void LoadConfig();
+  void RebuildTransformChain();
+  void AskInterceptBatch(AddonInfo &addon);
+  // Publishes a new AddonDispatch and waits out the old one's readers
+  void PublishDispatch();
 
   std::vector<AddonInfo> addons;
-  std::wstring configFilePath;
+  std::filesystem::path addonsPath;
+  std::filesystem::path configFilePath;
+  uint64_t revision = 0;
+  TelemetryHub telemetry;
+  ShaderPatcher shaderPatcher;
+  TransformChain transformChain;
+  std::vector<PeImage::Resource> resourceDirectory;
+
+  // AddonInitialize arguments, known once the GUI has an ImGui context
+  struct InitArgs {
+    void *imGuiContext;
+    void *allocFunc;
+    void *freeFunc;
+    void *allocUserData;
+    bool valid;
+  };
+  InitArgs initArgs = {};
+  ModuleLoader loader;
+  bool staging = false;
+  int stagedTotal = 0;
+  // Replaced whole by PublishDispatch; freed after an RCU grace period
+  std::atomic<const AddonDispatch *> dispatch{nullptr};
+  mutable RcuDomain dispatchRcu;
+  uint64_t dispatchGeneration = 0;
+
+  std::mutex redrawLock;
+  bool redrawRequested = false;
+  float pendingAnimationFps = 0.0f;
+  uint32_t pendingAnimationMs = 0;
+  void (*redrawCallback)(void *) = nullptr;
+  void *redrawCallbackUser = nullptr;
 };
@@ -0,0 +1,306 @@
+#include "alloc_pool.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+
+namespace AllocPool {
+
+// 16-byte steps up to 256, then four classes per power of two up to
+// kMaxPooledSize: at most 25% of a block is slack
+static const int kSmallClasses = 16;
+static const int kClassCount = kSmallClasses + 3 * 4;
+static const size_t kSlabSize = 64 * 1024;
+static const uint32_t kLargeClass = 0xFFFFFFFF;
+
+struct alignas(16) Header {
+  Tag *tag;
+  uint32_t size;
+  uint32_t sizeClass; // kLargeClass for malloc'd blocks
+};
+static_assert(sizeof(Header) == 16, "blocks must stay 16-byte aligned");
+
+struct Tag {
+  std::string name;
+  std::atomic<uint64_t> liveBytes{0};
+  std::atomic<uint64_t> peakBytes{0};
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> frees{0};
+};
+
+struct FreeBlock {
+  FreeBlock *next;
+};
+
+// Shared by every thread: where thread caches refill from and overflow to,
+// so a block freed on another thread than the one that allocated it comes
+// back into circulation. Slabs are carved here and never returned.
+struct CentralClass {
+  std::mutex lock;
+  FreeBlock *free = nullptr;
+  uint8_t *bump = nullptr; // Uncarved rest of the newest slab
+  uint8_t *bumpEnd = nullptr;
+};
+
+// Per thread, so the common case takes no locks. Each list keeps at most
+// CacheLimit blocks; past that half of them go back to the central class.
+struct ThreadList {
+  FreeBlock *free;
+  uint32_t count;
+};
+static thread_local ThreadList t_lists[kClassCount];
+static thread_local bool t_drainArmed = false;
+static thread_local bool t_drained = false; // Thread exiting: bypass t_lists
+
+struct State {
+  Tag tags[kMaxTags];
+  std::atomic<int> tagCount{0};
+  std::mutex tagLock;
+  CentralClass classes[kClassCount];
+  std::atomic<uint64_t> slabBytes{0};
+  std::atomic<uint64_t> largeBytes{0};
+};
+
+// Never destroyed: ImGui may free into the pool after static destructors
+static State &GetState() {
+  static State *state = new State();
+  return *state;
+}
+
+static int ClassForSize(size_t size) {
+  if (size <= 256)
+    return size == 0 ? 0 : (int)((size + 15) / 16) - 1;
+  int group = 0;
+  while ((size_t)512 << group < size)
+    group++;
+  size_t base = (size_t)256 << group;
+  return kSmallClasses + group * 4 + (int)((size - base - 1) / (base / 4));
+}
+
+static size_t ClassSize(int sizeClass) {
+  if (sizeClass < kSmallClasses)
+    return (size_t)(sizeClass + 1) * 16;
+  int group = (sizeClass - kSmallClasses) / 4;
+  size_t base = (size_t)256 << group;
+  return base + (size_t)((sizeClass - kSmallClasses) % 4 + 1) * (base / 4);
+}
+
+// About 8 KB of blocks per class and thread, at least two
+static uint32_t CacheLimit(int sizeClass) {
+  size_t blocks = 8192 / (sizeof(Header) + ClassSize(sizeClass));
+  return blocks < 2 ? 2 : (uint32_t)blocks;
+}
+
+static void ReturnToCentral(int sizeClass, FreeBlock *first, FreeBlock *last) {
+  CentralClass &central = GetState().classes[sizeClass];
+  std::lock_guard<std::mutex> guard(central.lock);
+  last->next = central.free;
+  central.free = first;
+}
+
+// Moves all but keep blocks of the thread's list back to the central class
+static void Trim(int sizeClass, uint32_t keep) {
+  ThreadList &list = t_lists[sizeClass];
+  if (list.count <= keep)
+    return;
+  FreeBlock *first = list.free;
+  FreeBlock *last = first;
+  for (uint32_t i = 1; i < list.count - keep; ++i)
+    last = last->next;
+  list.free = last->next;
+  list.count = keep;
+  ReturnToCentral(sizeClass, first, last);
+}
+
+// Returns the exiting thread's blocks; later frees on it go straight to
+// the central classes
+struct ThreadDrain {
+  ~ThreadDrain() {
+    t_drained = true;
+    for (int sizeClass = 0; sizeClass < kClassCount; ++sizeClass)
+      Trim(sizeClass, 0);
+  }
+};
+static thread_local ThreadDrain t_drain;
+
+static void ArmDrain() {
+  if (t_drainArmed)
+    return;
+  t_drainArmed = true;
+  (void)&t_drain; // Constructed on first odr-use; destroyed at thread exit
+}
+
+// One block from the central class, refilling the thread's list with up to
+// half its limit more. nullptr if out of memory.
+static uint8_t *AllocCentral(int sizeClass, bool refill) {
+  State &state = GetState();
+  CentralClass &central = state.classes[sizeClass];
+  size_t blockSize = sizeof(Header) + ClassSize(sizeClass);
+  uint32_t wanted = refill ? 1 + CacheLimit(sizeClass) / 2 : 1;
+  ThreadList &list = t_lists[sizeClass];
+  uint8_t *block = nullptr;
+
+  std::lock_guard<std::mutex> guard(central.lock);
+  for (uint32_t got = 0; got < wanted; ++got) {
+    uint8_t *next;
+    if (central.free) {
+      next = (uint8_t *)central.free;
+      central.free = central.free->next;
+    } else {
+      if ((size_t)(central.bumpEnd - central.bump) < blockSize) {
+        if (got > 0)
+          break; // Enough for now; don't start a slab for the cache
+        // The tail of the old slab is too small for a block; abandon it
+        uint8_t *slab = (uint8_t *)std::malloc(kSlabSize);
+        if (!slab)
+          return nullptr;
+        state.slabBytes.fetch_add(kSlabSize, std::memory_order_relaxed);
+        central.bump = slab;
+        central.bumpEnd = slab + kSlabSize;
+      }
+      next = central.bump;
+      central.bump += blockSize;
+    }
+    if (!block) {
+      block = next;
+      continue;
+    }
+    FreeBlock *cached = (FreeBlock *)next;
+    cached->next = list.free;
+    list.free = cached;
+    list.count++;
+  }
+  return block;
+}
+
+// Allocations made with a null tag
+static Tag *HostTag() {
+  static Tag *tag = GetTag("Host");
+  return tag;
+}
+
+static void Credit(Tag *tag, uint64_t size) {
+  uint64_t live = tag->liveBytes.fetch_add(size, std::memory_order_relaxed) +
+                  size;
+  uint64_t peak = tag->peakBytes.load(std::memory_order_relaxed);
+  while (live > peak && !tag->peakBytes.compare_exchange_weak(
+                            peak, live, std::memory_order_relaxed)) {
+  }
+  tag->allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+Tag *GetTag(const std::string &name) {
+  State &state = GetState();
+  std::lock_guard<std::mutex> guard(state.tagLock);
+  int count = state.tagCount.load(std::memory_order_relaxed);
+  for (int i = 0; i < count; ++i) {
+    if (state.tags[i].name == name)
+      return &state.tags[i];
+  }
+  if (count >= kMaxTags)
+    return nullptr;
+  state.tags[count].name = name;
+  state.tagCount.store(count + 1, std::memory_order_release);
+  return &state.tags[count];
+}
+
+void *Alloc(size_t size, void *tag) {
+  State &state = GetState();
+  Tag *owner = tag ? (Tag *)tag : HostTag();
+  if (size > UINT32_MAX)
+    return nullptr;
+
+  uint8_t *block;
+  uint32_t sizeClass;
+  if (size > kMaxPooledSize) {
+    block = (uint8_t *)std::malloc(sizeof(Header) + size);
+    if (!block)
+      return nullptr;
+    sizeClass = kLargeClass;
+    state.largeBytes.fetch_add(sizeof(Header) + size,
+                               std::memory_order_relaxed);
+  } else {
+    sizeClass = (uint32_t)ClassForSize(size);
+    ThreadList &list = t_lists[sizeClass];
+    if (list.free && !t_drained) {
+      block = (uint8_t *)list.free;
+      list.free = list.free->next;
+      list.count--;
+    } else {
+      if (!t_drained)
+        ArmDrain();
+      block = AllocCentral((int)sizeClass, !t_drained);
+      if (!block)
+        return nullptr;
+    }
+  }
+
+  Header *header = (Header *)block;
+  header->tag = owner;
+  header->size = (uint32_t)size;
+  header->sizeClass = sizeClass;
+  if (owner)
+    Credit(owner, size);
+  return block + sizeof(Header);
+}
+
+void Free(void *ptr, void *) {
+  if (!ptr)
+    return;
+  uint8_t *block = (uint8_t *)ptr - sizeof(Header);
+  Header *header = (Header *)block;
+  if (Tag *owner = header->tag) {
+    owner->liveBytes.fetch_sub(header->size, std::memory_order_relaxed);
+    owner->frees.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  if (header->sizeClass == kLargeClass) {
+    GetState().largeBytes.fetch_sub(sizeof(Header) + header->size,
+                                    std::memory_order_relaxed);
+    std::free(block);
+    return;
+  }
+  FreeBlock *freed = (FreeBlock *)block;
+  if (t_drained) {
+    ReturnToCentral((int)header->sizeClass, freed, freed);
+    return;
+  }
+  ThreadList &list = t_lists[header->sizeClass];
+  if (list.count == 0)
+    ArmDrain();
+  freed->next = list.free;
+  list.free = freed;
+  uint32_t limit = CacheLimit((int)header->sizeClass);
+  if (++list.count > limit)
+    Trim((int)header->sizeClass, limit / 2);
+}
+
+int GetTagCount() {
+  return GetState().tagCount.load(std::memory_order_acquire);
+}
+
+const char *GetTagName(int index) {
+  if (index < 0 || index >= GetTagCount())
+    return "";
+  return GetState().tags[index].name.c_str(); // Never changes once published
+}
+
+bool ReadTag(int index, TagStats *out) {
+  if (index < 0 || index >= GetTagCount())
+    return false;
+  const Tag &tag = GetState().tags[index];
+  out->liveBytes = tag.liveBytes.load(std::memory_order_relaxed);
+  out->peakBytes = tag.peakBytes.load(std::memory_order_relaxed);
+  out->allocations = tag.allocations.load(std::memory_order_relaxed);
+  out->frees = tag.frees.load(std::memory_order_relaxed);
+  return true;
+}
+
+PoolStats GetPoolStats() {
+  State &state = GetState();
+  PoolStats stats;
+  stats.slabBytes = state.slabBytes.load(std::memory_order_relaxed);
+  stats.largeBytes = state.largeBytes.load(std::memory_order_relaxed);
+  return stats;
+}
+
+} // namespace AllocPool
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Size-class pooled allocator for the shared ImGui context, with the bytes
+// attributed to whoever allocated them. The host installs Alloc/Free with
+// its own tag, and each addon gets the same pair with a tag of its own as
+// the allocator user data, so the manager window can show what every addon
+// keeps alive.
+//
+// Requests up to kMaxPooledSize come from per-class free lists carved out
+// of 64 KB slabs that are never returned, so per-frame widget churn reuses
+// the same blocks instead of fragmenting the heap. Each thread caches a few
+// KB of blocks per class without locks; past that, and when the thread
+// exits, blocks go back to a shared list per class, so memory freed on
+// another thread than it was allocated on is reused. Larger ones go to
+// malloc. Every block carries a 16-byte header
+// naming its tag, so memory one module allocates and another frees
+// (ImGui's shared state) is still credited to the allocator.
+namespace AllocPool {
+
+static constexpr size_t kMaxPooledSize = 2048;
+static constexpr int kMaxTags = 256;
+
+struct Tag;
+
+struct TagStats {
+  uint64_t liveBytes;   // Requested sizes, not counting headers
+  uint64_t peakBytes;
+  uint64_t allocations; // Since the tag was created
+  uint64_t frees;
+};
+
+struct PoolStats {
+  uint64_t slabBytes;  // Reserved for the size classes
+  uint64_t largeBytes; // Live malloc'd requests, including headers
+};
+
+// Same name, same tag, so a reloaded addon keeps its history. Tags live
+// for the process: their memory can outlive the addon. nullptr when all
+// kMaxTags are taken.
+Tag *GetTag(const std::string &name);
+
+// ImGuiMemAllocFunc/ImGuiMemFreeFunc. A null tag counts as "Host"; Free
+// ignores its tag and credits the block's own.
+void *Alloc(size_t size, void *tag);
+void Free(void *ptr, void *tag);
+
+// Lock-free readers
+int GetTagCount();
+const char *GetTagName(int index);
+bool ReadTag(int index, TagStats *out);
+PoolStats GetPoolStats();
+
+} // namespace AllocPool
@@ -0,0 +1,194 @@
+#include "config_editor.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+static const size_t kReadChunkSize = 256 * 1024;
+static const size_t kMinCapacity = 4096;
+
+ConfigEditor::~ConfigEditor() {
+  // Never leave a half written temp file behind
+  if (worker.joinable()) {
+    worker.join();
+  }
+}
+
+void ConfigEditor::StartWorker(std::function<Result()> work,
+                               std::function<void()> onComplete) {
+  if (worker.joinable()) {
+    worker.join(); // Previous operation has already delivered its result
+  }
+  std::promise<Result> promise;
+  pending = promise.get_future();
+  // The result is published before onComplete so a woken GUI sees it
+  worker = std::thread([promise = std::move(promise), work = std::move(work),
+                        onComplete = std::move(onComplete)]() mutable {
+    promise.set_value(work());
+    if (onComplete)
+      onComplete();
+  });
+}
+
+bool ConfigEditor::Open(const fs::path &filePath,
+                        std::function<void()> onComplete) {
+  if (IsBusy())
+    return false;
+
+  path = filePath;
+  error.clear();
+  buffer.clear();
+  buffer.shrink_to_fit();
+  state = State::Loading;
+  StartWorker([filePath]() { return LoadFile(filePath); },
+              std::move(onComplete));
+  return true;
+}
+
+bool ConfigEditor::Save(bool closeWhenDone, std::function<void()> onComplete) {
+  if (state != State::Editing || path.empty())
+    return false;
+
+  // Snapshot the text so editing can continue while the worker writes
+  std::string text(buffer.data(), strnlen(buffer.data(), buffer.size()));
+  error.clear();
+  closeAfterSave = closeWhenDone;
+  state = State::Saving;
+  StartWorker(
+      [filePath = path, text = std::move(text)]() mutable {
+        return SaveFile(filePath, std::move(text));
+      },
+      std::move(onComplete));
+  return true;
+}
+
+void ConfigEditor::Close() {
+  if (state == State::Saving) {
+    closeAfterSave = true; // Finish writing first
+    return;
+  }
+  if (state == State::Loading) {
+    pending.wait();
+    pending = {};
+  }
+  state = State::Closed;
+  buffer.clear();
+  buffer.shrink_to_fit();
+}
+
+void ConfigEditor::WaitIdle() {
+  if (pending.valid()) {
+    pending.wait();
+    Poll();
+  }
+}
+
+void ConfigEditor::Poll() {
+  if (!pending.valid() ||
+      pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    return;
+
+  Result result = pending.get();
+  if (state == State::Loading) {
+    if (result.ok) {
+      buffer = std::move(result.text);
+      state = State::Editing;
+    } else {
+      error = result.error;
+      state = State::Closed;
+    }
+  } else if (state == State::Saving) {
+    state = State::Editing;
+    if (!result.ok) {
+      error = result.error;
+    } else if (closeAfterSave) {
+      Close();
+    }
+  }
+}
+
+void ConfigEditor::Reserve(size_t size) {
+  if (size <= buffer.size())
+    return;
+  // Grow geometrically so typing does not reallocate per keystroke
+  size_t capacity = std::max({size, buffer.size() + buffer.size() / 2,
+                              kMinCapacity});
+  buffer.resize(capacity, '\0');
+}
+
+ConfigEditor::Result ConfigEditor::LoadFile(fs::path filePath) {
+  Result result;
+  std::ifstream file(filePath);
+  if (!file.is_open()) {
+    result.error = "Failed to open " + filePath.u8string();
+    return result;
+  }
+
+  std::error_code ec;
+  uintmax_t fileSize = fs::file_size(filePath, ec);
+  if (ec)
+    fileSize = 0;
+
+  // Text mode may shrink CRLF line ends, so the file size is an upper bound
+  result.text.resize((size_t)fileSize + 1);
+  size_t length = 0;
+  for (;;) {
+    if (result.text.size() - length < kReadChunkSize + 1) {
+      result.text.resize(length + kReadChunkSize + 1);
+    }
+    file.read(result.text.data() + length, kReadChunkSize);
+    length += (size_t)file.gcount();
+    if (!file)
+      break;
+  }
+  if (file.bad()) {
+    result.error = "Failed to read " + filePath.u8string();
+    result.text.clear();
+    return result;
+  }
+
+  result.text.resize(std::max(length + 1, kMinCapacity));
+  std::fill(result.text.begin() + length, result.text.end(), '\0');
+  result.text.shrink_to_fit();
+  result.ok = true;
+  return result;
+}
+
+ConfigEditor::Result ConfigEditor::SaveFile(fs::path filePath,
+                                            std::string text) {
+  Result result;
+  fs::path tempPath = filePath;
+  tempPath += ".tmp";
+
+  {
+    std::ofstream file(tempPath, std::ios::out | std::ios::trunc);
+    if (!file.is_open()) {
+      result.error = "Failed to create " + tempPath.u8string();
+      return result;
+    }
+    file.write(text.data(), (std::streamsize)text.size());
+    file.flush();
+    if (!file) {
+      result.error = "Failed to write " + tempPath.u8string();
+      file.close();
+      std::error_code ignored;
+      fs::remove(tempPath, ignored);
+      return result;
+    }
+  }
+
+  // Replace the original in one step so readers never see a partial file
+  std::error_code ec;
+  fs::rename(tempPath, filePath, ec);
+  if (ec) {
+    result.error = "Failed to replace " + filePath.u8string() + ": " +
+                   ec.message();
+    std::error_code ignored;
+    fs::remove(tempPath, ignored);
+    return result;
+  }
+
+  result.ok = true;
+  return result;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Text buffer behind the config editor window. Files are read and written on
+// a worker thread; saves go to a temp file that is renamed over the target.
+//
+// InputTextMultiline edits contiguous memory, so the buffer is a plain
+// NUL-terminated vector sized to the file that grows through ImGui's resize
+// callback (see Reserve), rather than a gap buffer ImGui could not address.
+class ConfigEditor {
+public:
+  enum class State { Closed, Loading, Editing, Saving };
+
+  ~ConfigEditor();
+
+  // Both return false while another load or save is still running.
+  // onComplete runs on the worker thread once the file operation finishes.
+  bool Open(const std::filesystem::path &path,
+            std::function<void()> onComplete);
+  bool Save(bool closeWhenDone, std::function<void()> onComplete);
+  void Close();
+  // Block until any running load or save has finished and been collected
+  void WaitIdle();
+
+  // GUI thread, once per frame: picks up finished loads and saves
+  void Poll();
+
+  State GetState() const { return state; }
+  bool IsBusy() const { return state == State::Loading || state == State::Saving; }
+  const std::filesystem::path &GetPath() const { return path; }
+  const std::string &GetError() const { return error; }
+
+  char *Data() { return buffer.data(); }
+  size_t Capacity() const { return buffer.size(); }
+  // Grow to hold at least size bytes (including the terminator)
+  void Reserve(size_t size);
+
+private:
+  struct Result {
+    bool ok = false;
+    std::string error;
+    std::vector<char> text; // Loads only
+  };
+
+  static Result LoadFile(std::filesystem::path path);
+  static Result SaveFile(std::filesystem::path path, std::string text);
+  void StartWorker(std::function<Result()> work,
+                   std::function<void()> onComplete);
+
+  State state = State::Closed;
+  std::filesystem::path path;
+  std::vector<char> buffer;
+  std::string error;
+  bool closeAfterSave = false;
+  std::future<Result> pending;
+  std::thread worker;
+};
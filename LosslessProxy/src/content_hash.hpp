@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Fast non-cryptographic 64-bit hash for cache keys over resource bytes
+inline uint64_t HashMix(uint64_t hash, uint64_t value) {
+  hash ^= value;
+  hash *= 0x9E3779B97F4A7C15ull;
+  return hash ^ (hash >> 29);
+}
+
+inline uint64_t HashBytes(uint64_t hash, const void *data, size_t size) {
+  const uint8_t *bytes = (const uint8_t *)data;
+  size_t i = 0;
+  if (size >= 32) {
+    // Four independent lanes keep the multiplier busy
+    uint64_t lanes[4] = {hash, hash + 1, hash + 2, hash + 3};
+    for (; i + 32 <= size; i += 32) {
+      uint64_t words[4];
+      std::memcpy(words, bytes + i, sizeof(words));
+      for (int lane = 0; lane < 4; ++lane)
+        lanes[lane] = HashMix(lanes[lane], words[lane]);
+    }
+    hash = HashMix(HashMix(HashMix(lanes[0], lanes[1]), lanes[2]), lanes[3]);
+  }
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, bytes + i, sizeof(word));
+    hash = HashMix(hash, word);
+  }
+  for (; i < size; ++i)
+    hash = HashMix(hash, bytes[i]);
+  return HashMix(hash, size);
+}
@@ -0,0 +1,117 @@
+#include "control_protocol.hpp"
+#include "addon_manager.hpp"
+#include "shader_hook.hpp"
+#include <cstdlib>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace ControlProtocol {
+
+static const char *StateToken(AddonLoadState state) {
+  switch (state) {
+  case AddonLoadState::Unloaded:
+    return "unloaded";
+  case AddonLoadState::Queued:
+    return "queued";
+  case AddonLoadState::Attached:
+    return "attached";
+  case AddonLoadState::Initializing:
+    return "initializing";
+  case AddonLoadState::Ready:
+    return "ready";
+  case AddonLoadState::Failed:
+    return "failed";
+  }
+  return "unknown";
+}
+
+static std::string Ok(const std::vector<std::string> &lines) {
+  std::string response = "ok " + std::to_string(lines.size()) + "\n";
+  for (const std::string &line : lines)
+    response += line + "\n";
+  return response;
+}
+
+static std::string Error(const std::string &message) {
+  return "err " + message + "\n";
+}
+
+// An addon by folder name, or by its index in "list"; -1 if none
+static int FindAddon(AddonManager &manager, const std::string &what) {
+  std::vector<AddonInfo> &addons = manager.GetAddons();
+  for (size_t i = 0; i < addons.size(); ++i) {
+    if (fs::path(addons[i].name).u8string() == what)
+      return (int)i;
+  }
+  char *end = nullptr;
+  long index = std::strtol(what.c_str(), &end, 10);
+  if (!what.empty() && *end == '\0' && index >= 0 &&
+      index < (long)addons.size())
+    return (int)index;
+  return -1;
+}
+
+static std::vector<std::string> Status(AddonManager &manager) {
+  int enabled = 0, ready = 0, failed = 0;
+  for (const AddonInfo &addon : manager.GetAddons()) {
+    enabled += addon.enabled;
+    ready += addon.loadState == AddonLoadState::Ready;
+    failed += addon.loadState == AddonLoadState::Failed;
+  }
+  std::vector<std::string> lines;
+  lines.push_back("addons " + std::to_string(manager.GetAddons().size()));
+  lines.push_back("enabled " + std::to_string(enabled));
+  lines.push_back("ready " + std::to_string(ready));
+  lines.push_back("failed " + std::to_string(failed));
+  int done = 0, total = 0;
+  if (manager.GetLoadProgress(&done, &total))
+    lines.push_back("loading " + std::to_string(done) + "/" +
+                    std::to_string(total));
+  lines.push_back("revision " + std::to_string(manager.GetRevision()));
+
+  ShaderHook::ShaderCache::Stats cache = ShaderHook::GetCacheStats();
+  lines.push_back("cache_entries " + std::to_string(cache.entries));
+  lines.push_back("cache_hot_bytes " + std::to_string(cache.hotBytes));
+  ResourceOverlay::Stats overlay = ShaderHook::GetOverlayStats();
+  lines.push_back("overlay_files " + std::to_string(overlay.files));
+  lines.push_back("overlay_served " + std::to_string(overlay.served));
+  return lines;
+}
+
+std::string Execute(AddonManager &manager, const std::string &request) {
+  size_t space = request.find(' ');
+  std::string verb = request.substr(0, space);
+  std::string argument =
+      space == std::string::npos ? std::string() : request.substr(space + 1);
+
+  if (verb == "ping")
+    return Ok({});
+  if (verb == "list") {
+    std::vector<std::string> lines;
+    std::vector<AddonInfo> &addons = manager.GetAddons();
+    for (size_t i = 0; i < addons.size(); ++i) {
+      lines.push_back(std::to_string(i) + " " +
+                      (addons[i].enabled ? "1 " : "0 ") +
+                      StateToken(addons[i].loadState) + " " +
+                      fs::path(addons[i].name).u8string());
+    }
+    return Ok(lines);
+  }
+  if (verb == "enable" || verb == "disable") {
+    int index = FindAddon(manager, argument);
+    if (index < 0)
+      return Error("no addon " + argument);
+    manager.ToggleAddon(index, verb == "enable");
+    return Ok({});
+  }
+  if (verb == "reload") {
+    manager.ReloadAddons();
+    return Ok({});
+  }
+  if (verb == "status")
+    return Ok(Status(manager));
+  return Error("unknown request " + verb);
+}
+
+} // namespace ControlProtocol
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+class AddonManager;
+
+// The headless control channel's line protocol. A request is one line of
+// ASCII; the response is "ok <n>" followed by n lines, or "err <message>":
+//
+//   ping                  ok 0
+//   list                  ok <n>, then "<index> <0|1> <state> <name>" rows
+//   enable <name|index>   ok 0 (the addon loads and initializes)
+//   disable <name|index>  ok 0 (the addon is unloaded)
+//   reload                ok 0 (rescans the folder, like the Reload button)
+//   status                ok <n>, then "<key> <value>" rows
+//
+// Enabling and disabling are saved to addons_config.ini as in the window.
+namespace ControlProtocol {
+
+// Longer request lines are refused
+constexpr size_t kMaxRequest = 1024;
+
+// On the thread that owns manager, as for any AddonManager call. request
+// has no line terminator; the result ends with one.
+std::string Execute(AddonManager &manager, const std::string &request);
+
+} // namespace ControlProtocol
@@ -0,0 +1,90 @@
+#include "control_server.hpp"
+#include "control_protocol.hpp"
+#include "process_exit.hpp"
+#include "trace.hpp"
+
+ControlServer::~ControlServer() { Stop(); }
+
+bool ControlServer::Start(const char *channel, Handler requestHandler) {
+  if (thread.joinable())
+    return false;
+  if (!Platform::ListenLocal(channel, &listener))
+    return false;
+  handler = std::move(requestHandler);
+  stopRequested = false;
+  exited.store(false);
+  thread = std::thread([this]() { Loop(); });
+  return true;
+}
+
+void ControlServer::Stop() {
+  if (!thread.joinable())
+    return;
+  {
+    std::lock_guard<std::mutex> guard(connectionLock);
+    stopRequested = true;
+    if (current)
+      Platform::ShutdownLocal(current);
+  }
+  Platform::CloseLocalListener(&listener);
+
+  // No join under the loader lock (see ProcessExit)
+  ProcessExit::WaitForThreadExit(exited);
+  thread.detach();
+}
+
+void ControlServer::Loop() {
+  LS_TRACE_THREAD_NAME("ControlServer");
+  Platform::LocalConnection connection;
+  while (Platform::AcceptLocal(&listener, &connection)) {
+    {
+      std::lock_guard<std::mutex> guard(connectionLock);
+      if (stopRequested) {
+        Platform::CloseLocal(&connection);
+        break;
+      }
+      current = &connection;
+    }
+    Serve(&connection);
+    {
+      std::lock_guard<std::mutex> guard(connectionLock);
+      current = nullptr;
+    }
+    Platform::CloseLocal(&connection);
+  }
+  exited.store(true, std::memory_order_release);
+}
+
+void ControlServer::Serve(Platform::LocalConnection *connection) {
+  std::string pending;
+  char buffer[512];
+  for (;;) {
+    size_t read = Platform::ReadLocal(connection, buffer, sizeof(buffer));
+    if (!read)
+      return; // Client gone, or Stop
+    pending.append(buffer, read);
+
+    size_t start = 0, newline;
+    while ((newline = pending.find('\n', start)) != std::string::npos) {
+      std::string request = pending.substr(start, newline - start);
+      start = newline + 1;
+      if (!request.empty() && request.back() == '\r')
+        request.pop_back();
+      if (request.size() > ControlProtocol::kMaxRequest)
+        break;
+      if (request.empty())
+        continue;
+      std::string response = handler(request);
+      if (!Platform::WriteLocal(connection, response.data(), response.size()))
+        return;
+    }
+    pending.erase(0, start);
+    // Not a client of ours: refuse and drop it
+    if (pending.size() > ControlProtocol::kMaxRequest ||
+        newline != std::string::npos) {
+      static const char kTooLong[] = "err request too long\n";
+      Platform::WriteLocal(connection, kTooLong, sizeof(kTooLong) - 1);
+      return;
+    }
+  }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "platform.hpp"
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Serves a line-per-request protocol on a local channel (see
+// Platform::ListenLocal) from its own thread, one client at a time. Each
+// request line goes to the handler, whose result is written back as is.
+class ControlServer {
+public:
+  typedef std::function<std::string(const std::string &request)> Handler;
+
+  ControlServer() = default;
+  ~ControlServer();
+  ControlServer(const ControlServer &) = delete;
+  ControlServer &operator=(const ControlServer &) = delete;
+
+  // False if running already or the channel name is taken
+  bool Start(const char *channel, Handler handler);
+  // Safe from DllMain: never joins. Drops the connected client.
+  void Stop();
+
+private:
+  void Loop();
+  void Serve(Platform::LocalConnection *connection);
+
+  Handler handler;
+  Platform::LocalListener listener;
+
+  // Stop shuts down the client Loop is serving
+  std::mutex connectionLock;
+  Platform::LocalConnection *current = nullptr;
+  bool stopRequested = false;
+
+  std::thread thread;
+  std::atomic<bool> exited{false};
+};
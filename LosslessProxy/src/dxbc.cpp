@@ -0,0 +1,243 @@
+#include "dxbc.hpp"
+#include <cstring>
+
+namespace Dxbc {
+
+static uint32_t Read32(const uint8_t *p) {
+  uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static void Write32(uint8_t *p, uint32_t value) {
+  std::memcpy(p, &value, sizeof(value));
+}
+
+// Header: magic, checksum[4], version (1), total size, chunk count, then
+// chunkCount offsets to { FourCC, size, data[size] }
+static const size_t kHeaderSize = 32;
+
+bool Container::Parse(const uint8_t *bytes, size_t length) {
+  data = bytes;
+  size = length;
+  valid = false;
+  chunks.clear();
+  if (!bytes || length < kHeaderSize || Read32(bytes) != kMagic ||
+      Read32(bytes + 24) != length)
+    return false;
+
+  uint32_t count = Read32(bytes + 28);
+  if (count > (length - kHeaderSize) / 4)
+    return false;
+  chunks.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t offset = Read32(bytes + kHeaderSize + i * 4);
+    if (offset < kHeaderSize || offset > length - 8)
+      return false;
+    Chunk chunk;
+    chunk.fourCC = Read32(bytes + offset);
+    chunk.size = Read32(bytes + offset + 4);
+    chunk.offset = offset + 8;
+    if (chunk.size > length - chunk.offset)
+      return false;
+    chunks.push_back(chunk);
+  }
+  valid = true;
+  return true;
+}
+
+const Chunk *Container::FindChunk(uint32_t fourCC) const {
+  for (const Chunk &chunk : chunks) {
+    if (chunk.fourCC == fourCC)
+      return &chunk;
+  }
+  return nullptr;
+}
+
+const Chunk *Container::FindShaderChunk() const {
+  const Chunk *chunk = FindChunk(kShaderSM5);
+  return chunk ? chunk : FindChunk(kShaderSM4);
+}
+
+// MD5 block transform (RFC 1321), unrolled
+#define MD5_F(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define MD5_G(x, y, z) ((y) ^ ((z) & ((x) ^ (y))))
+#define MD5_H(x, y, z) ((x) ^ (y) ^ (z))
+#define MD5_I(x, y, z) ((y) ^ ((x) | ~(z)))
+#define MD5_STEP(f, a, b, c, d, x, t, s)                                       \
+  (a) += f((b), (c), (d)) + (x) + (t);                                         \
+  (a) = ((a) << (s) | (a) >> (32 - (s))) + (b)
+
+static void Md5Transform(uint32_t state[4], const uint8_t *block) {
+  uint32_t w[16];
+  for (int i = 0; i < 16; ++i)
+    w[i] = Read32(block + i * 4);
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+
+  MD5_STEP(MD5_F, a, b, c, d, w[0], 0xd76aa478, 7);
+  MD5_STEP(MD5_F, d, a, b, c, w[1], 0xe8c7b756, 12);
+  MD5_STEP(MD5_F, c, d, a, b, w[2], 0x242070db, 17);
+  MD5_STEP(MD5_F, b, c, d, a, w[3], 0xc1bdceee, 22);
+  MD5_STEP(MD5_F, a, b, c, d, w[4], 0xf57c0faf, 7);
+  MD5_STEP(MD5_F, d, a, b, c, w[5], 0x4787c62a, 12);
+  MD5_STEP(MD5_F, c, d, a, b, w[6], 0xa8304613, 17);
+  MD5_STEP(MD5_F, b, c, d, a, w[7], 0xfd469501, 22);
+  MD5_STEP(MD5_F, a, b, c, d, w[8], 0x698098d8, 7);
+  MD5_STEP(MD5_F, d, a, b, c, w[9], 0x8b44f7af, 12);
+  MD5_STEP(MD5_F, c, d, a, b, w[10], 0xffff5bb1, 17);
+  MD5_STEP(MD5_F, b, c, d, a, w[11], 0x895cd7be, 22);
+  MD5_STEP(MD5_F, a, b, c, d, w[12], 0x6b901122, 7);
+  MD5_STEP(MD5_F, d, a, b, c, w[13], 0xfd987193, 12);
+  MD5_STEP(MD5_F, c, d, a, b, w[14], 0xa679438e, 17);
+  MD5_STEP(MD5_F, b, c, d, a, w[15], 0x49b40821, 22);
+
+  MD5_STEP(MD5_G, a, b, c, d, w[1], 0xf61e2562, 5);
+  MD5_STEP(MD5_G, d, a, b, c, w[6], 0xc040b340, 9);
+  MD5_STEP(MD5_G, c, d, a, b, w[11], 0x265e5a51, 14);
+  MD5_STEP(MD5_G, b, c, d, a, w[0], 0xe9b6c7aa, 20);
+  MD5_STEP(MD5_G, a, b, c, d, w[5], 0xd62f105d, 5);
+  MD5_STEP(MD5_G, d, a, b, c, w[10], 0x02441453, 9);
+  MD5_STEP(MD5_G, c, d, a, b, w[15], 0xd8a1e681, 14);
+  MD5_STEP(MD5_G, b, c, d, a, w[4], 0xe7d3fbc8, 20);
+  MD5_STEP(MD5_G, a, b, c, d, w[9], 0x21e1cde6, 5);
+  MD5_STEP(MD5_G, d, a, b, c, w[14], 0xc33707d6, 9);
+  MD5_STEP(MD5_G, c, d, a, b, w[3], 0xf4d50d87, 14);
+  MD5_STEP(MD5_G, b, c, d, a, w[8], 0x455a14ed, 20);
+  MD5_STEP(MD5_G, a, b, c, d, w[13], 0xa9e3e905, 5);
+  MD5_STEP(MD5_G, d, a, b, c, w[2], 0xfcefa3f8, 9);
+  MD5_STEP(MD5_G, c, d, a, b, w[7], 0x676f02d9, 14);
+  MD5_STEP(MD5_G, b, c, d, a, w[12], 0x8d2a4c8a, 20);
+
+  MD5_STEP(MD5_H, a, b, c, d, w[5], 0xfffa3942, 4);
+  MD5_STEP(MD5_H, d, a, b, c, w[8], 0x8771f681, 11);
+  MD5_STEP(MD5_H, c, d, a, b, w[11], 0x6d9d6122, 16);
+  MD5_STEP(MD5_H, b, c, d, a, w[14], 0xfde5380c, 23);
+  MD5_STEP(MD5_H, a, b, c, d, w[1], 0xa4beea44, 4);
+  MD5_STEP(MD5_H, d, a, b, c, w[4], 0x4bdecfa9, 11);
+  MD5_STEP(MD5_H, c, d, a, b, w[7], 0xf6bb4b60, 16);
+  MD5_STEP(MD5_H, b, c, d, a, w[10], 0xbebfbc70, 23);
+  MD5_STEP(MD5_H, a, b, c, d, w[13], 0x289b7ec6, 4);
+  MD5_STEP(MD5_H, d, a, b, c, w[0], 0xeaa127fa, 11);
+  MD5_STEP(MD5_H, c, d, a, b, w[3], 0xd4ef3085, 16);
+  MD5_STEP(MD5_H, b, c, d, a, w[6], 0x04881d05, 23);
+  MD5_STEP(MD5_H, a, b, c, d, w[9], 0xd9d4d039, 4);
+  MD5_STEP(MD5_H, d, a, b, c, w[12], 0xe6db99e5, 11);
+  MD5_STEP(MD5_H, c, d, a, b, w[15], 0x1fa27cf8, 16);
+  MD5_STEP(MD5_H, b, c, d, a, w[2], 0xc4ac5665, 23);
+
+  MD5_STEP(MD5_I, a, b, c, d, w[0], 0xf4292244, 6);
+  MD5_STEP(MD5_I, d, a, b, c, w[7], 0x432aff97, 10);
+  MD5_STEP(MD5_I, c, d, a, b, w[14], 0xab9423a7, 15);
+  MD5_STEP(MD5_I, b, c, d, a, w[5], 0xfc93a039, 21);
+  MD5_STEP(MD5_I, a, b, c, d, w[12], 0x655b59c3, 6);
+  MD5_STEP(MD5_I, d, a, b, c, w[3], 0x8f0ccc92, 10);
+  MD5_STEP(MD5_I, c, d, a, b, w[10], 0xffeff47d, 15);
+  MD5_STEP(MD5_I, b, c, d, a, w[1], 0x85845dd1, 21);
+  MD5_STEP(MD5_I, a, b, c, d, w[8], 0x6fa87e4f, 6);
+  MD5_STEP(MD5_I, d, a, b, c, w[15], 0xfe2ce6e0, 10);
+  MD5_STEP(MD5_I, c, d, a, b, w[6], 0xa3014314, 15);
+  MD5_STEP(MD5_I, b, c, d, a, w[13], 0x4e0811a1, 21);
+  MD5_STEP(MD5_I, a, b, c, d, w[4], 0xf7537e82, 6);
+  MD5_STEP(MD5_I, d, a, b, c, w[11], 0xbd3af235, 10);
+  MD5_STEP(MD5_I, c, d, a, b, w[2], 0x2ad7d2bb, 15);
+  MD5_STEP(MD5_I, b, c, d, a, w[9], 0xeb86d391, 21);
+
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+}
+
+#undef MD5_F
+#undef MD5_G
+#undef MD5_H
+#undef MD5_I
+#undef MD5_STEP
+
+// MD5 with the D3D compiler's own finalization: the bit count goes in the
+// first word of the last block instead of the last two, and the last word
+// is (bits >> 2) | 1
+void ComputeChecksum(const uint8_t *data, size_t size, uint32_t checksum[4]) {
+  uint32_t state[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+  const uint8_t *message = data + kChecksumSkip;
+  size_t length = size > kChecksumSkip ? size - kChecksumSkip : 0;
+  uint32_t bits = (uint32_t)(length * 8);
+
+  size_t fullBlocks = length / 64;
+  for (size_t i = 0; i < fullBlocks; ++i)
+    Md5Transform(state, message + i * 64);
+
+  const uint8_t *tail = message + fullBlocks * 64;
+  size_t tailSize = length - fullBlocks * 64;
+  uint8_t block[64] = {};
+  if (tailSize >= 56) {
+    std::memcpy(block, tail, tailSize);
+    block[tailSize] = 0x80;
+    Md5Transform(state, block);
+    std::memset(block, 0, sizeof(block));
+  } else {
+    std::memcpy(block + 4, tail, tailSize);
+    block[4 + tailSize] = 0x80;
+  }
+  Write32(block, bits);
+  Write32(block + 60, (bits >> 2) | 1);
+  Md5Transform(state, block);
+
+  std::memcpy(checksum, state, sizeof(state));
+}
+
+bool VerifyChecksum(const uint8_t *data, size_t size) {
+  if (size < kHeaderSize)
+    return false;
+  uint32_t checksum[4];
+  ComputeChecksum(data, size, checksum);
+  return std::memcmp(checksum, data + 4, sizeof(checksum)) == 0;
+}
+
+void UpdateChecksum(uint8_t *data, size_t size) {
+  if (size < kHeaderSize)
+    return;
+  uint32_t checksum[4];
+  ComputeChecksum(data, size, checksum);
+  std::memcpy(data + 4, checksum, sizeof(checksum));
+}
+
+bool ReplaceChunk(const uint8_t *data, size_t size, uint32_t fourCC,
+                  const uint8_t *chunkData, size_t chunkSize,
+                  std::vector<uint8_t> *out) {
+  Container container;
+  if (!container.Parse(data, size) || !container.FindChunk(fourCC))
+    return false;
+
+  // Same header and chunk order, every chunk copied to its new offset
+  const std::vector<Chunk> &chunks = container.GetChunks();
+  size_t total = kHeaderSize + chunks.size() * 4;
+  for (const Chunk &chunk : chunks)
+    total += 8 + (chunk.fourCC == fourCC ? chunkSize : chunk.size);
+  if (total > UINT32_MAX)
+    return false;
+
+  out->assign(total, 0);
+  uint8_t *bytes = out->data();
+  std::memcpy(bytes, data, 24);
+  Write32(bytes + 24, (uint32_t)total);
+  Write32(bytes + 28, (uint32_t)chunks.size());
+
+  size_t offset = kHeaderSize + chunks.size() * 4;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    const Chunk &chunk = chunks[i];
+    bool replaced = chunk.fourCC == fourCC;
+    const uint8_t *source = replaced ? chunkData : data + chunk.offset;
+    size_t length = replaced ? chunkSize : chunk.size;
+    Write32(bytes + kHeaderSize + i * 4, (uint32_t)offset);
+    Write32(bytes + offset, chunk.fourCC);
+    Write32(bytes + offset + 4, (uint32_t)length);
+    if (length > 0)
+      std::memcpy(bytes + offset + 8, source, length);
+    offset += 8 + length;
+  }
+  UpdateChecksum(bytes, total);
+  return true;
+}
+
+} // namespace Dxbc
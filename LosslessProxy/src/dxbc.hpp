@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// DXBC shader containers as produced by the D3D compiler: a header with an
+// MD5-variant checksum, then a table of offsets to FourCC-tagged chunks
+// (RDEF, ISGN, OSGN, SHDR/SHEX, STAT, ...). D3D refuses bytecode whose
+// checksum does not match, so anything that edits a container must call
+// UpdateChecksum afterwards.
+namespace Dxbc {
+
+constexpr uint32_t FourCC(char a, char b, char c, char d) {
+  return (uint32_t)(uint8_t)a | (uint32_t)(uint8_t)b << 8 |
+         (uint32_t)(uint8_t)c << 16 | (uint32_t)(uint8_t)d << 24;
+}
+
+const uint32_t kMagic = FourCC('D', 'X', 'B', 'C');
+const uint32_t kResourceDef = FourCC('R', 'D', 'E', 'F');
+const uint32_t kInputSignature = FourCC('I', 'S', 'G', 'N');
+const uint32_t kOutputSignature = FourCC('O', 'S', 'G', 'N');
+const uint32_t kShaderSM4 = FourCC('S', 'H', 'D', 'R');
+const uint32_t kShaderSM5 = FourCC('S', 'H', 'E', 'X');
+const uint32_t kStatistics = FourCC('S', 'T', 'A', 'T');
+
+// Bytes before the checksummed region: magic and the checksum itself
+const size_t kChecksumSkip = 20;
+
+struct Chunk {
+  uint32_t fourCC;
+  uint32_t offset; // Of the chunk data, past its FourCC and size
+  uint32_t size;
+};
+
+// Read-only view of a container; the bytes must outlive it
+class Container {
+public:
+  bool Parse(const uint8_t *data, size_t size);
+
+  bool IsValid() const { return valid; }
+  const std::vector<Chunk> &GetChunks() const { return chunks; }
+  // First chunk with the FourCC, nullptr if absent
+  const Chunk *FindChunk(uint32_t fourCC) const;
+  // SHEX or SHDR, whichever the shader has
+  const Chunk *FindShaderChunk() const;
+  const uint8_t *GetChunkData(const Chunk &chunk) const {
+    return data + chunk.offset;
+  }
+
+private:
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+  bool valid = false;
+  std::vector<Chunk> chunks;
+};
+
+// Checksum over data[kChecksumSkip..size), as stored at offset 4
+void ComputeChecksum(const uint8_t *data, size_t size, uint32_t checksum[4]);
+bool VerifyChecksum(const uint8_t *data, size_t size);
+void UpdateChecksum(uint8_t *data, size_t size);
+
+// Copy of the container with one chunk's data replaced (sizes may differ)
+// and a fresh checksum. False if the chunk is missing or the input invalid.
+bool ReplaceChunk(const uint8_t *data, size_t size, uint32_t fourCC,
+                  const uint8_t *chunkData, size_t chunkSize,
+                  std::vector<uint8_t> *out);
+
+} // namespace Dxbc
@@ -0,0 +1,280 @@
+#include "export_profile.hpp"
+#include "rcu.hpp"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+namespace ExportProfile {
+
+const char *const kExportNames[kExportCount] = {
+    "Activate",
+    "ApplySettings",
+    "GetAdapterNames",
+    "GetDisplayNames",
+    "GetDwmRefreshRate",
+    "GetForegroundWindowEx",
+    "Init",
+    "IsWindowsBuildAtLeast",
+    "SetDriverSettings",
+    "SetWindowsSettings",
+    "UnInit",
+};
+
+// Deeper nesting (an export calling back into another through the proxy)
+// is still forwarded, just not timed
+static const uint32_t kMaxDepth = 32;
+
+struct Counters {
+  std::atomic<uint64_t> calls{0};
+  std::atomic<uint64_t> totalNanos{0};
+  std::atomic<uint64_t> maxNanos{0};
+  std::atomic<uint64_t> histogram[kHistogramBins] = {};
+};
+
+struct Frame {
+  void *returnAddress;
+  uint32_t index;
+  uint64_t start;
+};
+
+// One per thread that ever called an export. Never freed, so GetStats can
+// read a block while its thread exits; the counters have a single writer.
+struct ThreadBlock {
+  Counters counters[kExportCount];
+  Frame frames[kMaxDepth];
+  uint32_t depth = 0;
+};
+
+struct Subscriber {
+  uint32_t id;
+  ExportCallback_t callback;
+  void *user;
+  const void *owner;
+};
+typedef std::vector<Subscriber> Subscribers;
+
+static void *g_targets[kExportCount] = {};
+
+static std::mutex g_threadsLock;
+static std::vector<ThreadBlock *> g_threads;
+static thread_local ThreadBlock *t_block = nullptr;
+
+// Replaced, never modified; read by Notify inside g_subscribersRcu
+static std::mutex g_subscribersLock;
+static std::atomic<const Subscribers *> g_subscribers{nullptr};
+static RcuDomain g_subscribersRcu;
+static uint32_t g_nextSubscriberId = 1;
+static std::atomic<uint32_t> g_subscriberCount{0};
+// Lists replaced from inside a callback, freed by the next replacement
+static std::vector<const Subscribers *> g_retiredSubscribers;
+// Notify calls the current thread is in
+static thread_local uint32_t t_notifying = 0;
+
+static uint64_t NowNanos() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static ThreadBlock *CurrentThread() {
+  if (!t_block) {
+    t_block = new ThreadBlock();
+    std::lock_guard<std::mutex> guard(g_threadsLock);
+    g_threads.push_back(t_block);
+  }
+  return t_block;
+}
+
+// Single writer, so no read-modify-write instructions
+static void Add(std::atomic<uint64_t> &counter, uint64_t value) {
+  counter.store(counter.load(std::memory_order_relaxed) + value,
+                std::memory_order_relaxed);
+}
+
+static int HistogramBin(uint64_t nanos) {
+  int bin = 0;
+  while (nanos > 1 && bin < kHistogramBins - 1) {
+    nanos >>= 1;
+    bin++;
+  }
+  return bin;
+}
+
+static void Notify(uint32_t index, uint32_t phase, uint64_t nanos) {
+  RcuDomain::ReadScope scope(g_subscribersRcu);
+  t_notifying++;
+  if (const Subscribers *subscribers = g_subscribers.load()) {
+    ExportCallInfo call = {kExportNames[index], phase, nanos};
+    for (const Subscriber &subscriber : *subscribers)
+      subscriber.callback(&call, subscriber.user);
+  }
+  t_notifying--;
+}
+
+// Publishes next with g_subscribersLock held, releasing it. Once no Notify
+// can still be calling into the list it replaced, that list is freed; from
+// inside a callback this thread can't wait for itself, so the next
+// replacement frees it instead.
+static void ReplaceSubscribers(std::unique_lock<std::mutex> &guard,
+                               const Subscribers *next) {
+  g_subscriberCount.store(next ? (uint32_t)next->size() : 0,
+                          std::memory_order_release);
+  std::vector<const Subscribers *> garbage;
+  garbage.push_back(g_subscribers.exchange(next));
+  if (t_notifying) {
+    g_retiredSubscribers.push_back(garbage.back());
+    return;
+  }
+  garbage.insert(garbage.end(), g_retiredSubscribers.begin(),
+                 g_retiredSubscribers.end());
+  g_retiredSubscribers.clear();
+  // Not under the lock: a callback being waited for may subscribe
+  guard.unlock();
+  if (!g_subscribersRcu.Synchronize())
+    return; // Leaked: see ProcessExit::SetExiting
+  for (const Subscribers *list : garbage)
+    delete list;
+}
+
+void SetTarget(Export index, void *original) {
+  if (index < kExportCount)
+    g_targets[index] = original;
+}
+
+bool IsActive() { return g_targets[kInit] != nullptr; }
+
+Stats GetStats(Export index) {
+  Stats stats = {};
+  if (index >= kExportCount)
+    return stats;
+  std::lock_guard<std::mutex> guard(g_threadsLock);
+  for (const ThreadBlock *block : g_threads) {
+    const Counters &counters = block->counters[index];
+    stats.calls += counters.calls.load(std::memory_order_relaxed);
+    stats.totalNanos += counters.totalNanos.load(std::memory_order_relaxed);
+    uint64_t max = counters.maxNanos.load(std::memory_order_relaxed);
+    if (max > stats.maxNanos)
+      stats.maxNanos = max;
+    for (int bin = 0; bin < kHistogramBins; ++bin)
+      stats.histogram[bin] +=
+          counters.histogram[bin].load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+uint64_t Percentile(const Stats &stats, double p) {
+  uint64_t timed = 0;
+  for (uint64_t count : stats.histogram)
+    timed += count;
+  if (timed == 0)
+    return 0;
+  uint64_t rank = (uint64_t)(p * (timed - 1));
+  uint64_t seen = 0;
+  for (int bin = 0; bin < kHistogramBins; ++bin) {
+    seen += stats.histogram[bin];
+    if (seen > rank)
+      return bin + 1 < 64 ? (uint64_t)1 << (bin + 1) : UINT64_MAX;
+  }
+  return stats.maxNanos;
+}
+
+std::vector<std::wstring> FormatSummary() {
+  std::vector<std::wstring> lines;
+  for (uint32_t i = 0; i < kExportCount; ++i) {
+    Stats stats = GetStats((Export)i);
+    if (stats.calls == 0)
+      continue;
+    std::wostringstream line;
+    line << L"[Exports] " << kExportNames[i] << L": " << stats.calls
+         << L" calls, mean " << stats.totalNanos / stats.calls / 1000
+         << L" us, p50 < " << Percentile(stats, 0.50) / 1000 << L" us, p99 < "
+         << Percentile(stats, 0.99) / 1000 << L" us, max "
+         << stats.maxNanos / 1000 << L" us";
+    lines.push_back(line.str());
+  }
+  return lines;
+}
+
+uint32_t Subscribe(ExportCallback_t callback, void *user, const void *owner) {
+  if (!callback || !IsActive())
+    return 0;
+  std::unique_lock<std::mutex> guard(g_subscribersLock);
+  auto next = std::make_unique<Subscribers>();
+  if (const Subscribers *current = g_subscribers.load())
+    *next = *current;
+  uint32_t id = g_nextSubscriberId++;
+  next->push_back({id, callback, user, owner});
+  ReplaceSubscribers(guard, next.release());
+  return id;
+}
+
+template <typename Match> static void RemoveSubscribers(Match match) {
+  std::unique_lock<std::mutex> guard(g_subscribersLock);
+  const Subscribers *current = g_subscribers.load();
+  if (!current)
+    return;
+  auto next = std::make_unique<Subscribers>();
+  for (const Subscriber &subscriber : *current) {
+    if (!match(subscriber))
+      next->push_back(subscriber);
+  }
+  if (next->size() == current->size())
+    return;
+  // The wait keeps an unloading addon's callback from being entered after
+  // this returns, except by a Notify this thread is inside of
+  ReplaceSubscribers(guard, next->empty() ? nullptr : next.release());
+}
+
+void Unsubscribe(uint32_t id) {
+  RemoveSubscribers([id](const Subscriber &s) { return s.id == id; });
+}
+
+void UnsubscribeOwner(const void *owner) {
+  if (!owner)
+    return;
+  RemoveSubscribers([owner](const Subscriber &s) { return s.owner == owner; });
+}
+
+} // namespace ExportProfile
+
+using namespace ExportProfile;
+
+extern "C" void *ExportProfileEnter(uint32_t index, void **returnSlot,
+                                    void *returnStub) {
+  ThreadBlock *block = CurrentThread();
+  if (block->depth >= kMaxDepth) {
+    Add(block->counters[index].calls, 1);
+    return g_targets[index];
+  }
+
+  Frame &frame = block->frames[block->depth++];
+  frame.returnAddress = *returnSlot;
+  frame.index = index;
+  *returnSlot = returnStub;
+
+  if (g_subscriberCount.load(std::memory_order_relaxed))
+    Notify(index, EXPORT_CALL_BEFORE, 0);
+  // After the callbacks, so they don't count against the export
+  frame.start = NowNanos();
+  return g_targets[index];
+}
+
+extern "C" void *ExportProfileLeave() {
+  uint64_t end = NowNanos();
+  ThreadBlock *block = t_block;
+  Frame frame = block->frames[--block->depth];
+  uint64_t nanos = end - frame.start;
+
+  Counters &counters = block->counters[frame.index];
+  Add(counters.calls, 1);
+  Add(counters.totalNanos, nanos);
+  if (nanos > counters.maxNanos.load(std::memory_order_relaxed))
+    counters.maxNanos.store(nanos, std::memory_order_relaxed);
+  Add(counters.histogram[HistogramBin(nanos)], 1);
+
+  if (g_subscriberCount.load(std::memory_order_relaxed))
+    Notify(frame.index, EXPORT_CALL_AFTER, nanos);
+  return frame.returnAddress;
+}
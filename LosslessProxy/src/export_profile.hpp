@@ -0,0 +1,70 @@
+#pragma once
+#include "addon_api.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Call counts and latency histograms for Lossless_original's exports, and
+// the IHost::SubscribeExportCalls notifications. Fed by the thunks in
+// export_thunks_x64.asm, which replace the linker forwarders when the proxy
+// is built with LOSSLESS_INSTRUMENT_EXPORTS; otherwise nothing calls in and
+// every count stays zero.
+//
+// Counters are per thread, written only by their thread and summed by
+// GetStats, so a call costs two clock reads and a few plain stores.
+namespace ExportProfile {
+
+// Keep in step with the EXPORT_THUNK indices in export_thunks_x64.asm
+enum Export : uint32_t {
+  kActivate,
+  kApplySettings,
+  kGetAdapterNames,
+  kGetDisplayNames,
+  kGetDwmRefreshRate,
+  kGetForegroundWindowEx,
+  kInit,
+  kIsWindowsBuildAtLeast,
+  kSetDriverSettings,
+  kSetWindowsSettings,
+  kUnInit,
+  kExportCount
+};
+
+extern const char *const kExportNames[kExportCount];
+
+// Log2 nanosecond buckets: bin b counts calls that took [2^b, 2^(b+1)) ns
+static constexpr int kHistogramBins = 40;
+
+struct Stats {
+  uint64_t calls;
+  uint64_t totalNanos;
+  uint64_t maxNanos;
+  uint64_t histogram[kHistogramBins];
+};
+
+// Where each thunk jumps. Set all of them before the first call.
+void SetTarget(Export index, void *original);
+bool IsActive();
+
+Stats GetStats(Export index);
+// Upper bound of the bucket holding the p-th percentile call, in ns
+uint64_t Percentile(const Stats &stats, double p);
+// One line per export that was called, for ShaderHook.log
+std::vector<std::wstring> FormatSummary();
+
+// Returns 0 when the exports are not instrumented (the callback would never
+// run). owner identifies the addon for UnsubscribeOwner; may be null.
+uint32_t Subscribe(ExportCallback_t callback, void *user, const void *owner);
+// Waits for running callbacks to return; from inside one, returns at once
+void Unsubscribe(uint32_t id);
+void UnsubscribeOwner(const void *owner);
+
+} // namespace ExportProfile
+
+// Called by the thunks. Enter records the call and returns the original
+// export; if it could take the call, it swaps *returnSlot for returnStub so
+// the export returns through the thunk, which calls Leave for the real
+// return address.
+extern "C" void *ExportProfileEnter(uint32_t index, void **returnSlot,
+                                    void *returnStub);
+extern "C" void *ExportProfileLeave();
@@ -0,0 +1,86 @@
+; Instrumented forwarders for Lossless_original's exports, used instead of
+; the linker forwarders in main.cpp when building with
+; LOSSLESS_INSTRUMENT_EXPORTS (MSVC, x64).
+;
+; The export signatures are unknown, so a thunk must not disturb arguments
+; or the stack: it saves the argument registers, lets ExportProfileEnter
+; record the call and swap the caller's return address for
+; ExportThunkReturn, then jumps to the original with the caller's frame
+; untouched. ExportThunkReturn times the call through ExportProfileLeave,
+; which hands back the real return address.
+;
+; These frames carry no unwind data: an exception escaping one of the
+; exports can't unwind through a thunk.
+
+EXTERN ExportProfileEnter:PROC
+EXTERN ExportProfileLeave:PROC
+
+.code
+
+; One thunk per export; index is its ExportProfile::Export value
+EXPORT_THUNK MACRO name, index
+PUBLIC LosslessThunk_&name
+LosslessThunk_&name PROC
+    mov eax, index
+    jmp ExportThunkCommon
+LosslessThunk_&name ENDP
+ENDM
+
+EXPORT_THUNK Activate, 0
+EXPORT_THUNK ApplySettings, 1
+EXPORT_THUNK GetAdapterNames, 2
+EXPORT_THUNK GetDisplayNames, 3
+EXPORT_THUNK GetDwmRefreshRate, 4
+EXPORT_THUNK GetForegroundWindowEx, 5
+EXPORT_THUNK Init, 6
+EXPORT_THUNK IsWindowsBuildAtLeast, 7
+EXPORT_THUNK SetDriverSettings, 8
+EXPORT_THUNK SetWindowsSettings, 9
+EXPORT_THUNK UnInit, 10
+
+; eax = export index, [rsp] = caller's return address
+ExportThunkCommon PROC
+    sub rsp, 98h                    ; Shadow space + saved arguments, aligned
+    mov [rsp+20h], rcx
+    mov [rsp+28h], rdx
+    mov [rsp+30h], r8
+    mov [rsp+38h], r9
+    movdqa [rsp+40h], xmm0
+    movdqa [rsp+50h], xmm1
+    movdqa [rsp+60h], xmm2
+    movdqa [rsp+70h], xmm3
+
+    mov ecx, eax
+    lea rdx, [rsp+98h]              ; Return address slot
+    lea r8, ExportThunkReturn
+    call ExportProfileEnter
+    mov r10, rax                    ; Original export
+
+    mov rcx, [rsp+20h]
+    mov rdx, [rsp+28h]
+    mov r8, [rsp+30h]
+    mov r9, [rsp+38h]
+    movdqa xmm0, [rsp+40h]
+    movdqa xmm1, [rsp+50h]
+    movdqa xmm2, [rsp+60h]
+    movdqa xmm3, [rsp+70h]
+    add rsp, 98h
+    jmp r10
+ExportThunkCommon ENDP
+
+; The original returns here, with its result in rax (rdx) or xmm0
+ExportThunkReturn PROC
+    sub rsp, 50h
+    movdqa [rsp+20h], xmm0
+    mov [rsp+30h], rax
+    mov [rsp+38h], rdx
+    call ExportProfileLeave
+    mov [rsp+48h], rax              ; Real return address, for ret
+    movdqa xmm0, [rsp+20h]
+    mov rax, [rsp+30h]
+    mov rdx, [rsp+38h]
+    add rsp, 48h
+    ret
+ExportThunkReturn ENDP
+
+END
@@ -0,0 +1,108 @@
+#include "frame_scheduler.hpp"
+#include <algorithm>
+
+FrameScheduler::FrameScheduler(IFrameClock *clock, IFrameEventSource *events)
+    : clock(clock), events(events) {}
+
+uint64_t FrameScheduler::NextDeadline(uint64_t now) const {
+  if (minimized)
+    return kWaitForever; // Restoring the window sends WM_SIZE
+  if (occluded)
+    return lastProbeTime + kOcclusionProbeMicros;
+  if (pendingFrames > 0)
+    return now;
+  if (animationInterval && now < animationUntil)
+    return lastFrameTime + animationInterval;
+  return kWaitForever;
+}
+
+FrameScheduler::Action FrameScheduler::WaitForNextFrame() {
+  for (;;) {
+    uint64_t now = clock->NowMicros();
+    uint64_t deadline = NextDeadline(now);
+    if (deadline <= now) {
+      return occluded ? Action::ProbeOcclusion : Action::Render;
+    }
+
+    uint64_t timeout =
+        (deadline == kWaitForever) ? kWaitForever : deadline - now;
+    switch (events->WaitAndDispatch(timeout)) {
+    case IFrameEventSource::WaitResult::Quit:
+      return Action::Quit;
+    case IFrameEventSource::WaitResult::Events:
+      Invalidate();
+      break;
+    case IFrameEventSource::WaitResult::Wake:
+      if (wakeHandler) {
+        wakeHandler(wakeHandlerUser);
+      } else {
+        Invalidate();
+      }
+      break;
+    case IFrameEventSource::WaitResult::Timeout:
+      break;
+    }
+  }
+}
+
+void FrameScheduler::OnFrameRendered() {
+  lastFrameTime = clock->NowMicros();
+  if (pendingFrames > 0)
+    pendingFrames--;
+  if (animationInterval && lastFrameTime >= animationUntil)
+    animationInterval = 0;
+}
+
+void FrameScheduler::OnOcclusionProbed(bool stillOccluded) {
+  lastProbeTime = clock->NowMicros();
+  if (!stillOccluded)
+    SetOccluded(false);
+}
+
+void FrameScheduler::Invalidate(uint32_t frames) {
+  pendingFrames = std::max(pendingFrames, frames);
+}
+
+void FrameScheduler::RequestAnimation(float framesPerSecond,
+                                      uint64_t durationMicros) {
+  if (framesPerSecond <= 0.0f || durationMicros == 0)
+    return;
+
+  uint64_t now = clock->NowMicros();
+  uint64_t interval = (uint64_t)(1000000.0f / framesPerSecond);
+  if (interval == 0)
+    interval = 1;
+
+  // Overlapping requests: fastest rate wins, longest deadline wins
+  if (animationInterval && now < animationUntil) {
+    animationInterval = std::min(animationInterval, interval);
+    animationUntil = std::max(animationUntil, now + durationMicros);
+  } else {
+    animationInterval = interval;
+    animationUntil = now + durationMicros;
+  }
+}
+
+void FrameScheduler::SetWakeHandler(void (*handler)(void *), void *user) {
+  wakeHandler = handler;
+  wakeHandlerUser = user;
+}
+
+void FrameScheduler::SetOccluded(bool value) {
+  if (occluded == value)
+    return;
+  occluded = value;
+  if (occluded) {
+    lastProbeTime = clock->NowMicros();
+  } else {
+    Invalidate();
+  }
+}
+
+void FrameScheduler::SetMinimized(bool value) {
+  if (minimized == value)
+    return;
+  minimized = value;
+  if (!minimized)
+    Invalidate();
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+// Frame scheduling for the manager window. The policy is pure logic: time and
+// window events come from injected interfaces so it can be driven off Windows.
+
+class IFrameClock {
+public:
+  virtual ~IFrameClock() = default;
+  virtual uint64_t NowMicros() = 0;
+};
+
+class SteadyFrameClock : public IFrameClock {
+public:
+  uint64_t NowMicros() override {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+};
+
+class IFrameEventSource {
+public:
+  // Wake: only cross-thread wake-ups arrived, no window input
+  enum class WaitResult { Timeout, Events, Wake, Quit };
+
+  virtual ~IFrameEventSource() = default;
+  // Block until events arrive or timeoutMicros elapses, then dispatch
+  // everything pending. FrameScheduler::kWaitForever means no timeout.
+  virtual WaitResult WaitAndDispatch(uint64_t timeoutMicros) = 0;
+};
+
+class FrameScheduler {
+public:
+  enum class Action { Render, ProbeOcclusion, Quit };
+
+  static constexpr uint64_t kWaitForever = UINT64_MAX;
+  // ImGui needs a few frames after an event to settle hover and layout state
+  static constexpr uint32_t kSettleFrames = 3;
+  static constexpr uint64_t kOcclusionProbeMicros = 250000;
+
+  FrameScheduler(IFrameClock *clock, IFrameEventSource *events);
+
+  // Blocks until the next frame is due
+  Action WaitForNextFrame();
+  void OnFrameRendered();
+  void OnOcclusionProbed(bool stillOccluded);
+
+  // Input or state change: redraw now and for a few settle frames
+  void Invalidate(uint32_t frames = kSettleFrames);
+  // Keep redrawing at framesPerSecond until durationMicros from now
+  void RequestAnimation(float framesPerSecond, uint64_t durationMicros);
+  // Called on a Wake instead of Invalidate, to drain what the waker asked
+  // for: an animation request must not turn into settle frames
+  void SetWakeHandler(void (*handler)(void *user), void *user);
+
+  void SetOccluded(bool occluded);
+  void SetMinimized(bool minimized);
+  bool IsOccluded() const { return occluded; }
+  bool IsMinimized() const { return minimized; }
+
+  // Earliest time a frame (or probe) is due; kWaitForever when idle
+  uint64_t NextDeadline(uint64_t now) const;
+
+private:
+  IFrameClock *clock;
+  IFrameEventSource *events;
+  void (*wakeHandler)(void *) = nullptr;
+  void *wakeHandlerUser = nullptr;
+
+  uint32_t pendingFrames = kSettleFrames;
+  uint64_t lastFrameTime = 0;
+  uint64_t lastProbeTime = 0;
+  uint64_t animationInterval = 0; // 0 = not animating
+  uint64_t animationUntil = 0;
+  bool occluded = false;
+  bool minimized = false;
+};
@@ -0,0 +1,434 @@
+#include "gui_frame.hpp"
+#include "addon_display_model.hpp"
+#include "alloc_pool.hpp"
+#include "config_editor.hpp"
+#include "telemetry.hpp"
+#include "imgui.h"
+#include <cstdio>
+#include <vector>
+
+// Config Editor State
+static bool g_showConfigEditor = false;
+static ConfigEditor g_configEditor;
+
+// Addons Panel State
+static AddonDisplayModel g_displayModel;
+static char g_addonSearch[128] = "";
+
+// Memory Panel State: allocation counts at the last rate sample
+static std::vector<uint64_t> g_memoryAllocations;
+static std::vector<float> g_memoryRates;
+static double g_memorySampleTime = 0.0;
+
+namespace GuiFrame {
+
+void OpenConfigEditor(IGuiHost *host, const std::filesystem::path &path) {
+  if (g_configEditor.Open(path, [host]() { host->RequestRedraw(); })) {
+    g_showConfigEditor = true;
+  }
+}
+
+void Shutdown() {
+  g_configEditor.WaitIdle();
+  g_configEditor.Close();
+  g_showConfigEditor = false;
+}
+
+void SetupStyle() {
+  ImGuiStyle &style = ImGui::GetStyle();
+  style.WindowRounding = 8.0f;
+  style.FrameRounding = 6.0f;
+  style.PopupRounding = 6.0f;
+  style.ScrollbarRounding = 6.0f;
+  style.GrabRounding = 6.0f;
+  style.TabRounding = 6.0f;
+  style.ChildRounding = 8.0f;
+
+  ImVec4 *colors = style.Colors;
+  // Dark background matching the screenshot (approx)
+  ImVec4 bgDark = ImVec4(0.11f, 0.09f, 0.09f, 1.00f);  // Very dark reddish grey
+  ImVec4 panelBg = ImVec4(0.16f, 0.14f, 0.14f, 1.00f); // Slightly lighter
+  ImVec4 accentRed = ImVec4(0.95f, 0.20f, 0.20f, 1.00f); // Bright red
+  ImVec4 textWhite = ImVec4(0.95f, 0.95f, 0.95f, 1.00f);
+  ImVec4 textDisabled = ImVec4(0.60f, 0.60f, 0.60f, 1.00f);
+
+  colors[ImGuiCol_WindowBg] = bgDark;
+  colors[ImGuiCol_ChildBg] = panelBg;
+  colors[ImGuiCol_PopupBg] = panelBg;
+  colors[ImGuiCol_Border] = ImVec4(0.25f, 0.20f, 0.20f, 0.50f);
+  colors[ImGuiCol_BorderShadow] = ImVec4(0.00f, 0.00f, 0.00f, 0.00f);
+
+  colors[ImGuiCol_Header] = ImVec4(0.25f, 0.20f, 0.20f, 1.00f);
+  colors[ImGuiCol_HeaderHovered] = ImVec4(0.30f, 0.25f, 0.25f, 1.00f);
+  colors[ImGuiCol_HeaderActive] = ImVec4(0.35f, 0.30f, 0.30f, 1.00f);
+
+  colors[ImGuiCol_Button] = ImVec4(0.25f, 0.20f, 0.20f, 1.00f);
+  colors[ImGuiCol_ButtonHovered] = ImVec4(0.30f, 0.25f, 0.25f, 1.00f);
+  colors[ImGuiCol_ButtonActive] = ImVec4(0.35f, 0.30f, 0.30f, 1.00f);
+
+  colors[ImGuiCol_FrameBg] = ImVec4(0.20f, 0.18f, 0.18f, 1.00f);
+  colors[ImGuiCol_FrameBgHovered] = ImVec4(0.25f, 0.22f, 0.22f, 1.00f);
+  colors[ImGuiCol_FrameBgActive] = ImVec4(0.30f, 0.25f, 0.25f, 1.00f);
+
+  colors[ImGuiCol_CheckMark] = accentRed;
+  colors[ImGuiCol_SliderGrab] = accentRed;
+  colors[ImGuiCol_SliderGrabActive] = ImVec4(1.00f, 0.30f, 0.30f, 1.00f);
+
+  colors[ImGuiCol_Text] = textWhite;
+  colors[ImGuiCol_TextDisabled] = textDisabled;
+
+  colors[ImGuiCol_TitleBg] = bgDark;
+  colors[ImGuiCol_TitleBgActive] = bgDark;
+  colors[ImGuiCol_TitleBgCollapsed] = bgDark;
+}
+
+static void BuildTelemetryPanel(IGuiHost *host) {
+  const TelemetryHub *telemetry = host->GetTelemetry();
+  int count = telemetry ? telemetry->GetChannelCount() : 0;
+  if (count == 0)
+    return;
+
+  ImGui::Dummy(ImVec2(0, 10));
+  ImGui::BeginChild("TelemetryPanel", ImVec2(0, 0), true);
+  ImGui::Text("Telemetry");
+  ImGui::Separator();
+
+  // Aggregates refresh on their own; keep the graphs moving while visible
+  host->RequestAnimation(
+      1000.0f / TelemetryHub::kAggregateIntervalMs,
+      TelemetryHub::kAggregateIntervalMs * 2);
+
+  TelemetryStats stats;
+  for (int i = 0; i < count; ++i) {
+    if (!telemetry->ReadStats(i, &stats))
+      continue;
+    ImGui::PushID(i);
+
+    const char *name = telemetry->GetChannelName(i);
+    ImGui::TextUnformatted(name);
+    ImGui::SameLine(ImGui::GetWindowWidth() * 0.35f);
+    ImGui::Text("p50 %.3f  p95 %.3f  p99 %.3f  max %.3f", stats.p50,
+                stats.p95, stats.p99, stats.max);
+    if (stats.dropped) {
+      ImGui::SameLine();
+      ImGui::TextDisabled("(%u dropped)", stats.dropped);
+    }
+
+    float graphWidth = ImGui::GetContentRegionAvail().x * 0.5f;
+    ImGui::PlotLines("##history", stats.history, stats.historyCount, 0,
+                     nullptr, 0.0f, stats.max * 1.1f,
+                     ImVec2(graphWidth - 4, 50));
+    ImGui::SameLine();
+    char overlay[64];
+    std::snprintf(overlay, sizeof(overlay), "%.3f .. %.3f", stats.min,
+                  stats.max);
+    ImGui::PlotHistogram("##histogram", stats.histogram,
+                         TelemetryStats::kHistogramBins, 0, overlay, 0.0f,
+                         FLT_MAX, ImVec2(-FLT_MIN, 50));
+
+    ImGui::PopID();
+  }
+  ImGui::EndChild();
+}
+
+static void FormatBytes(char *out, size_t size, uint64_t bytes) {
+  if (bytes >= 1024 * 1024)
+    std::snprintf(out, size, "%.1f MB", bytes / (1024.0 * 1024.0));
+  else
+    std::snprintf(out, size, "%.1f KB", bytes / 1024.0);
+}
+
+// ImGui memory per allocator tag: the host and each addon
+static void BuildMemoryPanel() {
+  int count = AllocPool::GetTagCount();
+  if (count == 0)
+    return;
+
+  // Rates over at least a second; they only move while frames are drawn
+  double now = ImGui::GetTime();
+  double elapsed = now - g_memorySampleTime;
+  bool sample = elapsed >= 1.0 || (int)g_memoryRates.size() != count;
+  g_memoryAllocations.resize(count, 0);
+  g_memoryRates.resize(count, 0.0f);
+
+  ImGui::Dummy(ImVec2(0, 10));
+  float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+  ImGui::BeginChild("MemoryPanel", ImVec2(0, rowHeight * (count + 3)), true);
+  ImGui::Text("ImGui Memory");
+  ImGui::Separator();
+
+  float width = ImGui::GetWindowWidth();
+  ImGui::TextDisabled("Owner");
+  ImGui::SameLine(width * 0.35f);
+  ImGui::TextDisabled("Live");
+  ImGui::SameLine(width * 0.55f);
+  ImGui::TextDisabled("Peak");
+  ImGui::SameLine(width * 0.75f);
+  ImGui::TextDisabled("Allocs/s");
+
+  AllocPool::TagStats stats;
+  for (int i = 0; i < count; ++i) {
+    if (!AllocPool::ReadTag(i, &stats))
+      continue;
+    if (sample) {
+      g_memoryRates[i] =
+          elapsed > 0.0
+              ? (float)((stats.allocations - g_memoryAllocations[i]) / elapsed)
+              : 0.0f;
+      g_memoryAllocations[i] = stats.allocations;
+    }
+
+    char live[32], peak[32];
+    FormatBytes(live, sizeof(live), stats.liveBytes);
+    FormatBytes(peak, sizeof(peak), stats.peakBytes);
+    ImGui::TextUnformatted(AllocPool::GetTagName(i));
+    ImGui::SameLine(width * 0.35f);
+    ImGui::TextUnformatted(live);
+    ImGui::SameLine(width * 0.55f);
+    ImGui::TextUnformatted(peak);
+    ImGui::SameLine(width * 0.75f);
+    ImGui::Text("%.0f", g_memoryRates[i]);
+  }
+  if (sample)
+    g_memorySampleTime = now;
+  ImGui::EndChild();
+}
+
+static void BuildAddonRow(IGuiHost *host, const AddonDisplayRow &row) {
+  bool enabled = row.enabled;
+  ImGui::PushID(row.addonIndex);
+
+  // Custom toggle switch style
+  if (ImGui::Checkbox("", &enabled)) {
+    host->ToggleAddon(row.addonIndex, enabled);
+  }
+  ImGui::SameLine();
+  ImGui::TextUnformatted(row.name.c_str());
+
+  // Config Button if path exists
+  if (!row.configPath.empty()) {
+    ImGui::SameLine();
+    ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.3f, 0.3f, 0.3f, 1.0f));
+    if (ImGui::SmallButton("Config")) {
+      OpenConfigEditor(host, row.configPath);
+    }
+    ImGui::PopStyleColor();
+  }
+
+  if (row.hasSettings) {
+    ImGui::SameLine();
+    if (ImGui::Button("Settings")) {
+      *row.showSettings = !*row.showSettings;
+    }
+  }
+
+  ImGui::SameLine(ImGui::GetWindowWidth() - 100);
+  ImGui::TextDisabled("%s", row.status);
+
+  ImGui::PopID();
+}
+
+static void BuildAddonsPanel(IGuiHost *host) {
+  ImGui::BeginChild("AddonsPanel", ImVec2(0, 250), true);
+  ImGui::Text("Addons Installati");
+  ImGui::Separator();
+  ImGui::Dummy(ImVec2(0, 5));
+
+  g_displayModel.Sync(host);
+
+  // Search and filter
+  ImGui::SetNextItemWidth(200);
+  if (ImGui::InputTextWithHint("##search", "Search...", g_addonSearch,
+                               sizeof(g_addonSearch))) {
+    g_displayModel.SetSearch(g_addonSearch);
+  }
+  ImGui::SameLine();
+  int filter = (int)g_displayModel.GetFilter();
+  const char *filterNames[(int)AddonDisplayModel::Filter::Count];
+  for (int i = 0; i < (int)AddonDisplayModel::Filter::Count; ++i) {
+    filterNames[i] =
+        AddonDisplayModel::FilterName((AddonDisplayModel::Filter)i);
+  }
+  ImGui::SetNextItemWidth(140);
+  if (ImGui::Combo("##filter", &filter, filterNames,
+                   (int)AddonDisplayModel::Filter::Count)) {
+    g_displayModel.SetFilter((AddonDisplayModel::Filter)filter);
+  }
+  ImGui::SameLine();
+  ImGui::TextDisabled("%d / %d", (int)g_displayModel.GetVisibleRows().size(),
+                      (int)g_displayModel.GetRows().size());
+
+  int loadedCount = 0, loadTotal = 0;
+  if (host->GetLoadProgress(&loadedCount, &loadTotal) && loadTotal > 0) {
+    char overlay[64];
+    std::snprintf(overlay, sizeof(overlay), "Loading addons %d / %d",
+                  loadedCount, loadTotal);
+    ImGui::ProgressBar((float)loadedCount / (float)loadTotal,
+                       ImVec2(-FLT_MIN, 0), overlay);
+  }
+
+  // Only rows inside the scroll view are submitted
+  ImGui::BeginChild("AddonsList", ImVec2(0, 0), false);
+  const std::vector<AddonDisplayRow> &rows = g_displayModel.GetRows();
+  const std::vector<int> &visible = g_displayModel.GetVisibleRows();
+  ImGuiListClipper clipper;
+  clipper.Begin((int)visible.size(), ImGui::GetFrameHeightWithSpacing());
+  while (clipper.Step()) {
+    for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+      BuildAddonRow(host, rows[visible[i]]);
+    }
+  }
+  clipper.End();
+  ImGui::EndChild();
+
+  ImGui::EndChild();
+}
+
+static void BuildOptionsPanel(IGuiHost *host) {
+  ImGui::BeginChild("OptionsPanel", ImVec2(0, 80), true);
+  ImGui::Text("Opzioni & Debug");
+  ImGui::Separator();
+  ImGui::Dummy(ImVec2(0, 10));
+
+  ImGui::Columns(2, "OptionsCols", false);
+
+  ImGui::NextColumn();
+
+  // Red button style for Reload
+  ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.80f, 0.10f, 0.10f, 1.00f));
+  ImGui::PushStyleColor(ImGuiCol_ButtonHovered,
+                        ImVec4(0.90f, 0.15f, 0.15f, 1.00f));
+  ImGui::PushStyleColor(ImGuiCol_ButtonActive,
+                        ImVec4(1.00f, 0.20f, 0.20f, 1.00f));
+  if (ImGui::Button("Reload All Addons", ImVec2(-1, 30))) {
+    host->ReloadAddons();
+  }
+  ImGui::PopStyleColor(3);
+
+  ImGui::Columns(1);
+  ImGui::EndChild();
+}
+
+// Grows the editor buffer when the text outgrows it
+static int ConfigEditorResizeCallback(ImGuiInputTextCallbackData *data) {
+  if (data->EventFlag == ImGuiInputTextFlags_CallbackResize) {
+    ConfigEditor *editor = (ConfigEditor *)data->UserData;
+    editor->Reserve((size_t)data->BufSize);
+    data->Buf = editor->Data();
+  }
+  return 0;
+}
+
+static void BuildConfigEditor(IGuiHost *host) {
+  g_configEditor.Poll();
+  ConfigEditor::State state = g_configEditor.GetState();
+  if (state == ConfigEditor::State::Closed &&
+      g_configEditor.GetError().empty()) {
+    g_showConfigEditor = false; // Finished "Save & Close"
+  } else if (state == ConfigEditor::State::Editing &&
+             !g_configEditor.GetError().empty()) {
+    g_showConfigEditor = true; // A save failed after the window was closed
+  }
+  if (!g_showConfigEditor)
+    return;
+
+  ImGui::SetNextWindowSize(ImVec2(600, 400), ImGuiCond_FirstUseEver);
+  if (ImGui::Begin("Config Editor", &g_showConfigEditor)) {
+    bool editing = state == ConfigEditor::State::Editing;
+    ImGui::BeginDisabled(!editing);
+    if (ImGui::Button("Save & Close")) {
+      g_configEditor.Save(true, [host]() { host->RequestRedraw(); });
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Save")) {
+      g_configEditor.Save(false, [host]() { host->RequestRedraw(); });
+    }
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    if (ImGui::Button("Cancel")) {
+      g_showConfigEditor = false;
+    }
+    ImGui::SameLine();
+    if (state == ConfigEditor::State::Loading) {
+      ImGui::TextDisabled("Loading...");
+    } else if (state == ConfigEditor::State::Saving) {
+      ImGui::TextDisabled("Saving...");
+    } else if (!g_configEditor.GetError().empty()) {
+      ImGui::TextColored(ImVec4(0.95f, 0.30f, 0.30f, 1.00f), "%s",
+                         g_configEditor.GetError().c_str());
+    }
+
+    ImGui::Separator();
+
+    if (state == ConfigEditor::State::Editing ||
+        state == ConfigEditor::State::Saving) {
+      ImGui::InputTextMultiline(
+          "##source", g_configEditor.Data(), g_configEditor.Capacity(),
+          ImVec2(-FLT_MIN, -FLT_MIN),
+          ImGuiInputTextFlags_AllowTabInput |
+              ImGuiInputTextFlags_CallbackResize,
+          ConfigEditorResizeCallback, &g_configEditor);
+    }
+  }
+  ImGui::End();
+
+  // Window closed via Cancel or the title bar button
+  if (!g_showConfigEditor) {
+    g_configEditor.Close();
+  }
+}
+
+static void BuildSettingsWindows(IGuiHost *host) {
+  // Actions earlier in the frame may have rebuilt the addon list
+  g_displayModel.Sync(host);
+  for (const AddonDisplayRow &row : g_displayModel.GetRows()) {
+    if (row.hasSettings && *row.showSettings) {
+      ImGui::SetNextWindowSize(ImVec2(400, 300), ImGuiCond_FirstUseEver);
+      if (ImGui::Begin(row.settingsTitle.c_str(), row.showSettings)) {
+        host->RenderAddonSettings(row.addonIndex);
+      }
+      ImGui::End();
+    }
+  }
+}
+
+void Build(IGuiHost *host) {
+  // Main Window
+  ImGui::SetNextWindowPos(ImVec2(0, 0));
+  ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+  ImGui::Begin("Main", nullptr,
+               ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize |
+                   ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse |
+                   ImGuiWindowFlags_NoBringToFrontOnFocus);
+
+  // Main Content Area
+  ImGui::BeginGroup();
+  ImGui::Dummy(ImVec2(0, 10));
+
+  // Addons Panel
+  ImGui::BeginChild("ContentScroll", ImVec2(0, 0), false);
+
+  // Panel 1: Addons List
+  BuildAddonsPanel(host);
+
+  ImGui::Dummy(ImVec2(0, 10));
+
+  // Panel 3: Options & Actions
+  BuildOptionsPanel(host);
+
+  // ImGui memory by owner, when the pooled allocator is installed
+  BuildMemoryPanel();
+
+  // Panel 4: Addon telemetry, only once an addon publishes some
+  BuildTelemetryPanel(host);
+
+  ImGui::EndChild(); // ContentScroll
+  ImGui::EndGroup();
+
+  ImGui::End();
+
+  BuildConfigEditor(host);
+  BuildSettingsWindows(host);
+}
+
+} // namespace GuiFrame
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+class TelemetryHub;
+
+// What the manager UI needs from the host. GuiManager adapts AddonManager to
+// it; tools/gui_bench.cpp feeds synthetic addons through a null backend.
+class IGuiHost {
+public:
+  virtual ~IGuiHost() = default;
+
+  // Changes whenever the addon list or any addon's state changes
+  virtual uint64_t GetRevision() = 0;
+  virtual int GetAddonCount() = 0;
+  virtual std::string GetAddonName(int index) = 0; // UTF-8
+  virtual bool IsAddonEnabled(int index) = 0;
+  virtual bool IsAddonLoaded(int index) = 0;
+  // Short state shown in the list, e.g. "Loaded" or "Loading..."
+  virtual const char *GetAddonStatus(int index) = 0;
+  // False unless addons are still loading in the background
+  virtual bool GetLoadProgress(int *done, int *total) = 0;
+  virtual bool HasAddonSettings(int index) = 0;
+  virtual bool *GetShowSettingsFlag(int index) = 0;
+  virtual std::filesystem::path GetAddonConfigPath(int index) = 0;
+
+  virtual void ToggleAddon(int index, bool enable) = 0;
+  virtual void ReloadAddons() = 0;
+  virtual void RenderAddonSettings(int index) = 0;
+  // Wake the GUI for a new frame. Called from worker threads.
+  virtual void RequestRedraw() = 0;
+  // Called from Build, on the GUI thread
+  virtual void RequestAnimation(float framesPerSecond, uint32_t durationMs) = 0;
+  // nullptr when the host has no telemetry
+  virtual const TelemetryHub *GetTelemetry() = 0;
+};
+
+// Builds the manager window contents. Backend independent: call between
+// ImGui::NewFrame() and ImGui::Render().
+namespace GuiFrame {
+void SetupStyle();
+void Build(IGuiHost *host);
+// Waits for background file operations; host must outlive them
+void Shutdown();
+
+void OpenConfigEditor(IGuiHost *host, const std::filesystem::path &path);
+} // namespace GuiFrame
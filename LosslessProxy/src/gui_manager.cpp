@@ -1,12 +1,17 @@
 #include "gui_manager.hpp"
 #include "addon_manager.hpp"
+#include "alloc_pool.hpp"
+#include "frame_scheduler.hpp"
+#include "gui_frame.hpp"
 #include "imgui.h"
 #include "imgui_impl_dx11.h"
 #include "imgui_impl_win32.h"
+#include "shader_hook.hpp"
+#include "trace.hpp"
 #include <d3d11.h>
 #include <dxgi.h>
-#include <fstream>
-#include <sstream>
+#include <filesystem>
+#include <memory>
 #include <string>
 #include <tchar.h>
 #include <vector>
@@ -21,13 +26,7 @@ static ID3D11DeviceContext *g_pd3dDeviceContext = nullptr;
 static IDXGISwapChain *g_pSwapChain = nullptr;
 static ID3D11RenderTargetView *g_mainRenderTargetView = nullptr;
 static AddonManager *g_manager = nullptr;
-
-// Config Editor State
-static bool g_showConfigEditor = false;
-static std::string g_configEditorContent;
-static std::wstring g_configEditorPath;
-static const size_t g_configBufferSize = 1024 * 1024; // 1MB buffer
-static std::vector<char> g_configBuffer;
+static FrameScheduler *g_scheduler = nullptr;
 
 // Forward declarations of helper functions
 bool CreateDeviceD3D(HWND hWnd);
@@ -35,8 +34,6 @@ void CleanupDeviceD3D();
 void CreateRenderTarget();
 void CleanupRenderTarget();
 LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
-void OpenConfigEditor(const std::wstring &path);
-void SaveConfigEditor();
 
 // Forward declare message handler from imgui_impl_win32.cpp
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd,
@@ -56,36 +53,106 @@ std::string WStringToString(const std::wstring &wstr) {
   return strTo;
 }
 
-void OpenConfigEditor(const std::wstring &path) {
-  g_configEditorPath = path;
-  std::ifstream file(path);
-  if (file.is_open()) {
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    g_configEditorContent = buffer.str();
-
-    // Resize buffer if needed
-    if (g_configBuffer.size() < g_configBufferSize) {
-      g_configBuffer.resize(g_configBufferSize);
-    }
+// Exposes the live AddonManager to the backend-independent frame code
+class AddonManagerGuiHost : public IGuiHost {
+public:
+  AddonManagerGuiHost(AddonManager *manager, FrameScheduler *scheduler)
+      : manager(manager), scheduler(scheduler) {}
 
-    // Copy content to buffer
-    strncpy_s(g_configBuffer.data(), g_configBuffer.size(),
-              g_configEditorContent.c_str(), _TRUNCATE);
+  uint64_t GetRevision() override { return manager->GetRevision(); }
+  int GetAddonCount() override { return (int)manager->GetAddons().size(); }
+  std::string GetAddonName(int index) override {
+    return WStringToString(manager->GetAddons()[index].name);
+  }
+  bool IsAddonEnabled(int index) override {
+    return manager->GetAddons()[index].enabled;
+  }
+  bool IsAddonLoaded(int index) override {
+    return manager->GetAddons()[index].hModule != nullptr;
+  }
+  const char *GetAddonStatus(int index) override {
+    return AddonLoadStateName(manager->GetAddons()[index].loadState);
+  }
+  bool GetLoadProgress(int *done, int *total) override {
+    return manager->GetLoadProgress(done, total);
+  }
+  bool HasAddonSettings(int index) override {
+    // Hidden until the addon has finished initializing
+    const AddonInfo &addon = manager->GetAddons()[index];
+    return (addon.capabilities & ADDON_CAP_HAS_SETTINGS) != 0 &&
+           addon.loadState == AddonLoadState::Ready;
+  }
+  bool *GetShowSettingsFlag(int index) override {
+    return &manager->GetAddons()[index].showSettings;
+  }
+  std::filesystem::path GetAddonConfigPath(int index) override {
+    return manager->GetAddons()[index].configPath;
+  }
 
-    g_showConfigEditor = true;
+  void ToggleAddon(int index, bool enable) override {
+    manager->ToggleAddon(index, enable);
   }
-}
+  void ReloadAddons() override { manager->ReloadAddons(); }
+  void RenderAddonSettings(int index) override {
+    manager->RenderAddonSettings(index);
+  }
+  void RequestRedraw() override { manager->RequestRedraw(); }
+  // On the GUI thread already: no need to wake it
+  void RequestAnimation(float framesPerSecond, uint32_t durationMs) override {
+    scheduler->RequestAnimation(framesPerSecond, (uint64_t)durationMs * 1000);
+  }
+  const TelemetryHub *GetTelemetry() override {
+    return &manager->GetTelemetry();
+  }
+
+private:
+  AddonManager *manager;
+  FrameScheduler *scheduler;
+};
+
+// Blocks in MsgWaitForMultipleObjectsEx instead of spinning on PeekMessage
+class Win32MessageSource : public IFrameEventSource {
+public:
+  WaitResult WaitAndDispatch(uint64_t timeoutMicros) override {
+    DWORD timeoutMs = INFINITE;
+    if (timeoutMicros != FrameScheduler::kWaitForever) {
+      timeoutMs = (DWORD)((timeoutMicros + 999) / 1000);
+    }
+    MsgWaitForMultipleObjectsEx(0, nullptr, timeoutMs, QS_ALLINPUT,
+                                MWMO_INPUTAVAILABLE);
 
-void SaveConfigEditor() {
-  if (!g_configEditorPath.empty()) {
-    std::ofstream file(g_configEditorPath);
-    if (file.is_open()) {
-      file << g_configBuffer.data();
-      file.close();
-      g_showConfigEditor = false;
+    bool dispatched = false, woken = false;
+    MSG msg;
+    while (PeekMessage(&msg, NULL, 0U, 0U, PM_REMOVE)) {
+      if (msg.message == WM_QUIT)
+        return WaitResult::Quit;
+      if (msg.message == WM_NULL) {
+        woken = true; // Posted by WakeGuiThread; nothing to dispatch
+        continue;
+      }
+      TranslateMessage(&msg);
+      DispatchMessage(&msg);
+      dispatched = true;
     }
+    if (dispatched)
+      return WaitResult::Events;
+    return woken ? WaitResult::Wake : WaitResult::Timeout;
   }
+};
+
+// Addons may request redraws from any thread; wake the blocked GUI thread
+static void WakeGuiThread(void *user) {
+  PostMessageW((HWND)user, WM_NULL, 0, 0);
+}
+
+// A redraw request gets its settle frames; an animation request only its rate
+static void DrainWake(void *user) {
+  FrameScheduler *scheduler = (FrameScheduler *)user;
+  float animationFps = 0.0f;
+  uint32_t animationMs = 0;
+  if (g_manager->ConsumeRedrawRequest(&animationFps, &animationMs))
+    scheduler->Invalidate();
+  scheduler->RequestAnimation(animationFps, (uint64_t)animationMs * 1000);
 }
 
 void GuiManager::StartGuiThread(AddonManager *manager) {
@@ -93,59 +160,11 @@ void GuiManager::StartGuiThread(AddonManager *manager) {
   CreateThread(NULL, 0, GuiThread, NULL, 0, NULL);
 }
 
-void SetupImGuiStyle() {
-  ImGuiStyle &style = ImGui::GetStyle();
-  style.WindowRounding = 8.0f;
-  style.FrameRounding = 6.0f;
-  style.PopupRounding = 6.0f;
-  style.ScrollbarRounding = 6.0f;
-  style.GrabRounding = 6.0f;
-  style.TabRounding = 6.0f;
-  style.ChildRounding = 8.0f;
-
-  ImVec4 *colors = style.Colors;
-  // Dark background matching the screenshot (approx)
-  ImVec4 bgDark = ImVec4(0.11f, 0.09f, 0.09f, 1.00f);  // Very dark reddish grey
-  ImVec4 panelBg = ImVec4(0.16f, 0.14f, 0.14f, 1.00f); // Slightly lighter
-  ImVec4 accentRed = ImVec4(0.95f, 0.20f, 0.20f, 1.00f); // Bright red
-  ImVec4 textWhite = ImVec4(0.95f, 0.95f, 0.95f, 1.00f);
-  ImVec4 textDisabled = ImVec4(0.60f, 0.60f, 0.60f, 1.00f);
-
-  colors[ImGuiCol_WindowBg] = bgDark;
-  colors[ImGuiCol_ChildBg] = panelBg;
-  colors[ImGuiCol_PopupBg] = panelBg;
-  colors[ImGuiCol_Border] = ImVec4(0.25f, 0.20f, 0.20f, 0.50f);
-  colors[ImGuiCol_BorderShadow] = ImVec4(0.00f, 0.00f, 0.00f, 0.00f);
-
-  colors[ImGuiCol_Header] = ImVec4(0.25f, 0.20f, 0.20f, 1.00f);
-  colors[ImGuiCol_HeaderHovered] = ImVec4(0.30f, 0.25f, 0.25f, 1.00f);
-  colors[ImGuiCol_HeaderActive] = ImVec4(0.35f, 0.30f, 0.30f, 1.00f);
-
-  colors[ImGuiCol_Button] = ImVec4(0.25f, 0.20f, 0.20f, 1.00f);
-  colors[ImGuiCol_ButtonHovered] = ImVec4(0.30f, 0.25f, 0.25f, 1.00f);
-  colors[ImGuiCol_ButtonActive] = ImVec4(0.35f, 0.30f, 0.30f, 1.00f);
-
-  colors[ImGuiCol_FrameBg] = ImVec4(0.20f, 0.18f, 0.18f, 1.00f);
-  colors[ImGuiCol_FrameBgHovered] = ImVec4(0.25f, 0.22f, 0.22f, 1.00f);
-  colors[ImGuiCol_FrameBgActive] = ImVec4(0.30f, 0.25f, 0.25f, 1.00f);
-
-  colors[ImGuiCol_CheckMark] = accentRed;
-  colors[ImGuiCol_SliderGrab] = accentRed;
-  colors[ImGuiCol_SliderGrabActive] = ImVec4(1.00f, 0.30f, 0.30f, 1.00f);
-
-  colors[ImGuiCol_Text] = textWhite;
-  colors[ImGuiCol_TextDisabled] = textDisabled;
-
-  colors[ImGuiCol_TitleBg] = bgDark;
-  colors[ImGuiCol_TitleBgActive] = bgDark;
-  colors[ImGuiCol_TitleBgCollapsed] = bgDark;
-}
-
 DWORD WINAPI GuiManager::GuiThread(LPVOID lpParam) {
-  if (g_manager) {
-    g_manager->LoadAddons();
-  }
+  LS_TRACE_THREAD_NAME("GuiThread");
 
+  // The window comes up first; addons load in the background once the
+  // ImGui context exists (see the frame loop)
   WNDCLASSEXW wc = {sizeof(wc),
                     CS_CLASSDC,
                     WndProc,
@@ -163,7 +182,10 @@ DWORD WINAPI GuiManager::GuiThread(LPVOID lpParam) {
       wc.lpszClassName, L"Lossless Scaling Addons Manager", WS_OVERLAPPEDWINDOW,
       100, 100, 1000, 700, NULL, NULL, wc.hInstance, NULL);
 
-  if (!CreateDeviceD3D(hwnd)) {
+  LS_TRACE_BEGIN("CreateDeviceD3D");
+  bool deviceCreated = CreateDeviceD3D(hwnd);
+  LS_TRACE_END();
+  if (!deviceCreated) {
     CleanupDeviceD3D();
     UnregisterClassW(wc.lpszClassName, wc.hInstance);
     return 1;
@@ -173,18 +195,16 @@ DWORD WINAPI GuiManager::GuiThread(LPVOID lpParam) {
   UpdateWindow(hwnd);
 
   IMGUI_CHECKVERSION();
+  // Before the context exists, so all of its memory comes from the pool
+  ImGui::SetAllocatorFunctions(AllocPool::Alloc, AllocPool::Free,
+                               AllocPool::GetTag("Host"));
   ImGui::CreateContext();
 
-  // Initialize Addons with ImGui Context
-  if (g_manager) {
-    g_manager->InitializeAddons(ImGui::GetCurrentContext());
-  }
-
   ImGuiIO &io = ImGui::GetIO();
   (void)io;
   io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
 
-  SetupImGuiStyle();
+  GuiFrame::SetupStyle();
 
   ImGui_ImplWin32_Init(hwnd);
   ImGui_ImplDX11_Init(g_pd3dDevice, g_pd3dDeviceContext);
@@ -192,154 +212,64 @@ DWORD WINAPI GuiManager::GuiThread(LPVOID lpParam) {
   bool show_demo_window = false;
   ImVec4 clear_color = ImVec4(0.11f, 0.09f, 0.09f, 1.00f);
 
-  bool done = false;
-  while (!done) {
-    MSG msg;
-    while (PeekMessage(&msg, NULL, 0U, 0U, PM_REMOVE)) {
-      TranslateMessage(&msg);
-      DispatchMessage(&msg);
-      if (msg.message == WM_QUIT)
-        done = true;
-    }
-    if (done)
-      break;
-
-    ImGui_ImplDX11_NewFrame();
-    ImGui_ImplWin32_NewFrame();
-    ImGui::NewFrame();
-
-    // Main Window
-    {
-      ImGui::SetNextWindowPos(ImVec2(0, 0));
-      ImGui::SetNextWindowSize(io.DisplaySize);
-      ImGui::Begin("Main", nullptr,
-                   ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize |
-                       ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse |
-                       ImGuiWindowFlags_NoBringToFrontOnFocus);
-
-      // Main Content Area
-      ImGui::BeginGroup();
-      ImGui::Dummy(ImVec2(0, 10));
-
-      // Addons Panel
-      ImGui::BeginChild("ContentScroll", ImVec2(0, 0), false);
-
-      // Panel 1: Addons List
-      ImGui::BeginChild("AddonsPanel", ImVec2(0, 250), true);
-      ImGui::Text("Addons Installati");
-      ImGui::Separator();
-      ImGui::Dummy(ImVec2(0, 5));
-
-      if (g_manager) {
-        auto &addons = g_manager->GetAddons();
-        for (int i = 0; i < addons.size(); ++i) {
-          bool enabled = addons[i].enabled;
-          ImGui::PushID(i);
-
-          // Custom toggle switch style
-          if (ImGui::Checkbox("", &enabled)) {
-            g_manager->ToggleAddon(i, enabled);
-          }
-          ImGui::SameLine();
-          ImGui::Text("%s", WStringToString(addons[i].name).c_str());
-
-          // Config Button if path exists
-          if (!addons[i].configPath.empty()) {
-            ImGui::SameLine();
-            ImGui::PushStyleColor(ImGuiCol_Button,
-                                  ImVec4(0.3f, 0.3f, 0.3f, 1.0f));
-            if (ImGui::SmallButton("Config")) {
-              OpenConfigEditor(addons[i].configPath);
-            }
-            ImGui::PopStyleColor();
-          }
-
-          if (addons[i].capabilities & ADDON_CAP_HAS_SETTINGS) {
-            ImGui::SameLine();
-            if (ImGui::Button("Settings")) {
-              addons[i].showSettings = !addons[i].showSettings;
-            }
-          }
-
-          ImGui::SameLine(ImGui::GetWindowWidth() - 100);
-          ImGui::TextDisabled(addons[i].hModule ? "Loaded" : "Unloaded");
-
-          ImGui::PopID();
-        }
-      }
-      ImGui::EndChild();
-
-      ImGui::Dummy(ImVec2(0, 10));
-
-      // Panel 3: Options & Actions
-      ImGui::BeginChild("OptionsPanel", ImVec2(0, 80), true);
-      ImGui::Text("Opzioni & Debug");
-      ImGui::Separator();
-      ImGui::Dummy(ImVec2(0, 10));
-
-      ImGui::Columns(2, "OptionsCols", false);
-
-      ImGui::NextColumn();
-
-      // Red button style for Reload
-      ImGui::PushStyleColor(ImGuiCol_Button,
-                            ImVec4(0.80f, 0.10f, 0.10f, 1.00f));
-      ImGui::PushStyleColor(ImGuiCol_ButtonHovered,
-                            ImVec4(0.90f, 0.15f, 0.15f, 1.00f));
-      ImGui::PushStyleColor(ImGuiCol_ButtonActive,
-                            ImVec4(1.00f, 0.20f, 0.20f, 1.00f));
-      if (ImGui::Button("Reload All Addons", ImVec2(-1, 30))) {
-        if (g_manager)
-          g_manager->ReloadAddons();
-      }
-      ImGui::PopStyleColor(3);
-
-      ImGui::Columns(1);
-      ImGui::EndChild();
+  SteadyFrameClock clock;
+  Win32MessageSource messageSource;
+  FrameScheduler scheduler(&clock, &messageSource);
+  g_scheduler = &scheduler;
+  std::unique_ptr<AddonManagerGuiHost> guiHost;
+  bool startupComplete = false;
+  if (g_manager) {
+    g_manager->SetRedrawCallback(WakeGuiThread, hwnd);
+    scheduler.SetWakeHandler(DrainWake, &scheduler);
+    guiHost = std::make_unique<AddonManagerGuiHost>(g_manager, &scheduler);
+
+    // Load addons in the background; each AddonInitialize runs on this
+    // thread between frames, with the ImGui context. Addons get the pool
+    // too, under a tag of their own.
+    g_manager->BeginStagedLoad(ImGui::GetCurrentContext(),
+                               (void *)&AllocPool::Alloc,
+                               (void *)&AllocPool::Free, nullptr);
+  }
 
-      ImGui::EndChild(); // ContentScroll
-      ImGui::EndGroup();
+  for (;;) {
+    FrameScheduler::Action action = scheduler.WaitForNextFrame();
+    if (action == FrameScheduler::Action::Quit)
+      break;
 
-      ImGui::End();
+    if (action == FrameScheduler::Action::ProbeOcclusion) {
+      // Test present: nothing is drawn, it only reports visibility
+      HRESULT hr = g_pSwapChain->Present(0, DXGI_PRESENT_TEST);
+      scheduler.OnOcclusionProbed(hr == DXGI_STATUS_OCCLUDED);
+      continue;
     }
 
-    // Config Editor Window
-    if (g_showConfigEditor) {
-      ImGui::SetNextWindowSize(ImVec2(600, 400), ImGuiCond_FirstUseEver);
-      if (ImGui::Begin("Config Editor", &g_showConfigEditor)) {
-        if (ImGui::Button("Save & Close")) {
-          SaveConfigEditor();
-        }
-        ImGui::SameLine();
-        if (ImGui::Button("Cancel")) {
-          g_showConfigEditor = false;
-        }
-
-        ImGui::Separator();
-
-        // InputTextMultiline
-        ImGui::InputTextMultiline(
-            "##source", g_configBuffer.data(), g_configBuffer.size(),
-            ImVec2(-FLT_MIN, -FLT_MIN), ImGuiInputTextFlags_AllowTabInput);
-
-        ImGui::End();
-      }
+    // Reloads finish through here too; startup only happens once
+    if (g_manager && g_manager->PumpStagedLoad() && !startupComplete) {
+      // Startup is complete once addons are initialized
+      startupComplete = true;
+      ShaderHook::StartPrefetch();
+#ifdef LOSSLESS_ENABLE_TRACE
+      wchar_t exePath[MAX_PATH];
+      GetModuleFileNameW(NULL, exePath, MAX_PATH);
+      LS_TRACE_WRITE(std::filesystem::path(exePath).parent_path() /
+                     L"LosslessTrace.json");
+#endif
     }
 
-    // Render Addon Settings Windows
     if (g_manager) {
-      auto &addons = g_manager->GetAddons();
-      for (int i = 0; i < addons.size(); ++i) {
-        if (addons[i].showSettings) {
-          std::string windowName =
-              "Settings: " + WStringToString(addons[i].name);
-          ImGui::SetNextWindowSize(ImVec2(400, 300), ImGuiCond_FirstUseEver);
-          if (ImGui::Begin(windowName.c_str(), &addons[i].showSettings)) {
-            g_manager->RenderAddonSettings(i);
-          }
-          ImGui::End();
-        }
-      }
+      float animationFps = 0.0f;
+      uint32_t animationMs = 0;
+      g_manager->ConsumeRedrawRequest(&animationFps, &animationMs);
+      scheduler.RequestAnimation(animationFps,
+                                 (uint64_t)animationMs * 1000);
+    }
+
+    ImGui_ImplDX11_NewFrame();
+    ImGui_ImplWin32_NewFrame();
+    ImGui::NewFrame();
+
+    if (guiHost) {
+      GuiFrame::Build(guiHost.get());
     }
 
     ImGui::Render();
@@ -351,8 +281,21 @@ DWORD WINAPI GuiManager::GuiThread(LPVOID lpParam) {
                                                clear_color_with_alpha);
     ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
 
-    g_pSwapChain->Present(1, 0);
+    HRESULT hr = g_pSwapChain->Present(1, 0);
+    scheduler.SetOccluded(hr == DXGI_STATUS_OCCLUDED);
+    scheduler.OnFrameRendered();
+
+    // Keep the text caret blinking while an input field has focus
+    if (io.WantTextInput) {
+      scheduler.RequestAnimation(10.0f, 200000);
+    }
+  }
+
+  GuiFrame::Shutdown();
+  if (g_manager) {
+    g_manager->SetRedrawCallback(nullptr, nullptr);
   }
+  g_scheduler = nullptr;
 
   ImGui_ImplDX11_Shutdown();
   ImGui_ImplWin32_Shutdown();
@@ -494,6 +437,9 @@ LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
 
   switch (msg) {
   case WM_SIZE:
+    if (g_scheduler) {
+      g_scheduler->SetMinimized(wParam == SIZE_MINIMIZED);
+    }
     if (g_pd3dDevice != nullptr && wParam != SIZE_MINIMIZED) {
       CleanupRenderTarget();
       g_pSwapChain->ResizeBuffers(0, (UINT)LOWORD(lParam), (UINT)HIWORD(lParam),
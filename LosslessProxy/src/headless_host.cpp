@@ -0,0 +1,112 @@
+#include "headless_host.hpp"
+#include "addon_manager.hpp"
+#include "alloc_pool.hpp"
+#include "control_protocol.hpp"
+#include "process_exit.hpp"
+#include "shader_hook.hpp"
+#include "trace.hpp"
+
+HeadlessHost::~HeadlessHost() { Stop(); }
+
+bool HeadlessHost::Start(AddonManager *addonManager, const char *channel) {
+  if (thread.joinable() || !addonManager)
+    return false;
+  manager = addonManager;
+  stopRequested = false;
+  wakeRequested = false;
+  exited.store(false);
+  thread = std::thread([this]() { Loop(); });
+  return server.Start(channel, [this](const std::string &request) {
+    return Submit(request);
+  });
+}
+
+void HeadlessHost::Stop() {
+  if (!thread.joinable())
+    return;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    stopRequested = true;
+    // Queued requests won't run; one running now still completes
+    for (Request *request : requests) {
+      request->response = "err shutting down\n";
+      request->done = true;
+    }
+    requests.clear();
+  }
+  wakeSignal.notify_all();
+  completion.notify_all();
+  server.Stop();
+
+  // No join under the loader lock (see ProcessExit)
+  ProcessExit::WaitForThreadExit(exited);
+  thread.detach();
+}
+
+void HeadlessHost::Wake(void *user) {
+  HeadlessHost *host = (HeadlessHost *)user;
+  {
+    std::lock_guard<std::mutex> guard(host->lock);
+    host->wakeRequested = true;
+  }
+  host->wakeSignal.notify_all();
+}
+
+std::string HeadlessHost::Submit(const std::string &text) {
+  Request request;
+  request.text = text;
+  std::unique_lock<std::mutex> guard(lock);
+  if (stopRequested)
+    return "err shutting down\n";
+  requests.push_back(&request);
+  wakeSignal.notify_all();
+  completion.wait(guard, [&request]() { return request.done; });
+  return request.response;
+}
+
+void HeadlessHost::Loop() {
+  LS_TRACE_THREAD_NAME("HeadlessHost");
+  manager->SetRedrawCallback(Wake, this);
+  // No ImGui context, but addons still allocate from the pool under their
+  // own tags
+  manager->BeginStagedLoad(nullptr, (void *)&AllocPool::Alloc,
+                           (void *)&AllocPool::Free, nullptr);
+
+  bool startupComplete = false;
+  std::unique_lock<std::mutex> guard(lock);
+  while (!stopRequested) {
+    wakeRequested = false;
+    guard.unlock();
+
+    // Each call initializes at most one addon and wakes us for the next
+    if (manager->PumpStagedLoad() && !startupComplete) {
+      startupComplete = true;
+      ShaderHook::StartPrefetch();
+      LS_TRACE_WRITE(Platform::GetHostExecutablePath().parent_path() /
+                     L"LosslessTrace.json");
+    }
+    // Nothing to draw: animations are dropped
+    float animationFps;
+    uint32_t animationMs;
+    manager->ConsumeRedrawRequest(&animationFps, &animationMs);
+
+    guard.lock();
+    while (!requests.empty() && !stopRequested) {
+      Request *request = requests.front();
+      requests.pop_front();
+      guard.unlock();
+      std::string response = ControlProtocol::Execute(*manager, request->text);
+      guard.lock();
+      request->response = std::move(response);
+      request->done = true;
+      completion.notify_all();
+    }
+    wakeSignal.wait(guard, [this]() {
+      return stopRequested || wakeRequested || !requests.empty();
+    });
+  }
+  guard.unlock();
+
+  manager->SetRedrawCallback(nullptr, nullptr);
+  exited.store(true, std::memory_order_release);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "control_server.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class AddonManager;
+
+// Runs the addons without the manager window: no D3D device, no ImGui
+// context and no frame loop. Its thread owns the AddonManager the way the
+// GUI thread otherwise does, loading addons through the staged path and
+// sleeping until an addon, the loader or a control request needs it.
+// Requests arrive on a ControlServer and are answered by ControlProtocol.
+// Addons are initialized with a null ImGuiContext, and AddonRenderSettings
+// is never called.
+class HeadlessHost {
+public:
+  static constexpr const char *kDefaultChannel = "LosslessAddons";
+
+  HeadlessHost() = default;
+  ~HeadlessHost();
+  HeadlessHost(const HeadlessHost &) = delete;
+  HeadlessHost &operator=(const HeadlessHost &) = delete;
+
+  // manager must outlive Stop. The addons load either way; false if the
+  // control channel could not be opened.
+  bool Start(AddonManager *manager, const char *channel);
+  // Safe from DllMain: never joins
+  void Stop();
+
+private:
+  struct Request {
+    std::string text;
+    std::string response;
+    bool done = false;
+  };
+
+  void Loop();
+  // From the server thread: runs request on the host thread and waits
+  std::string Submit(const std::string &request);
+  static void Wake(void *user);
+
+  AddonManager *manager = nullptr;
+  ControlServer server;
+
+  std::mutex lock;
+  std::condition_variable wakeSignal; // To the host thread
+  std::condition_variable completion; // To Submit
+  std::deque<Request *> requests;
+  bool wakeRequested = false;
+  bool stopRequested = false;
+
+  std::thread thread;
+  std::atomic<bool> exited{false};
+};
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <windows.h>
+#include "pe_image.hpp"
+#include <vector>
 
 // IAT patching utilities
 namespace IatPatcher {
@@ -11,71 +13,115 @@ namespace IatPatcher {
     // ImportName: Name of function being imported (e.g. "FindResourceW")
     // NewFunction: Replacement function pointer
     // Returns: Original function pointer
-    
+
     template<typename FuncPtr>
-    FuncPtr PatchIat(HMODULE moduleToPatc, const char* importDllName, const char* importName, FuncPtr newFunction) {
-        // Get the DOS header
-        PIMAGE_DOS_HEADER pDosHeader = (PIMAGE_DOS_HEADER)moduleToPatc;
-        if (pDosHeader->e_magic != IMAGE_DOS_SIGNATURE) {
+    FuncPtr PatchIat(HMODULE moduleToPatch, const char* importDllName, const char* importName, FuncPtr newFunction) {
+        PeImage image;
+        if (!image.Parse((const uint8_t*)moduleToPatch, 0, true)) {
             return nullptr;
         }
 
-        // Get the NT headers
-        PIMAGE_NT_HEADERS pNtHeaders = (PIMAGE_NT_HEADERS)((BYTE*)moduleToPatc + pDosHeader->e_lfanew);
-        if (pNtHeaders->Signature != IMAGE_NT_SIGNATURE) {
+        void* slot = image.FindImportSlot(importDllName, importName);
+        if (!slot) {
             return nullptr;
         }
 
-        // Get the import table directory
-        PIMAGE_IMPORT_DESCRIPTOR pImportDesc = (PIMAGE_IMPORT_DESCRIPTOR)
-            ((BYTE*)moduleToPatc + pNtHeaders->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT].VirtualAddress);
+        // Found the function! Patch it
+        FuncPtr* entry = (FuncPtr*)slot;
+        FuncPtr originalFunc = *entry;
 
-        if (!pImportDesc) {
-            return nullptr;
-        }
+        // Unprotect the memory page
+        DWORD oldProtect = 0;
+        VirtualProtect(entry, sizeof(*entry), PAGE_READWRITE, &oldProtect);
 
-        // Find the import descriptor for the target DLL
-        for (; pImportDesc->Name; pImportDesc++) {
-            const char* dllName = (const char*)((BYTE*)moduleToPatc + pImportDesc->Name);
-            if (_stricmp(dllName, importDllName) != 0) {
-                continue;
-            }
-
-            // Found the DLL, now find the function
-            PIMAGE_THUNK_DATA pThunk = (PIMAGE_THUNK_DATA)((BYTE*)moduleToPatc + pImportDesc->FirstThunk);
-            PIMAGE_THUNK_DATA pOrigThunk = (PIMAGE_THUNK_DATA)((BYTE*)moduleToPatc + pImportDesc->OriginalFirstThunk);
+        // Patch the IAT entry
+        *entry = newFunction;
 
-            for (; pThunk->u1.Function; pThunk++, pOrigThunk++) {
-                // Check if this is an imported by name (not by ordinal)
-                if (IMAGE_SNAP_BY_ORDINAL(pOrigThunk->u1.Ordinal)) {
-                    continue;
-                }
+        // Restore the old protection
+        VirtualProtect(entry, sizeof(*entry), oldProtect, &oldProtect);
 
-                PIMAGE_IMPORT_BY_NAME pImportByName = (PIMAGE_IMPORT_BY_NAME)
-                    ((BYTE*)moduleToPatc + pOrigThunk->u1.AddressOfData);
-
-                if (strcmp((const char*)pImportByName->Name, importName) != 0) {
-                    continue;
-                }
-
-                // Found the function! Patch it
-                FuncPtr originalFunc = (FuncPtr)pThunk->u1.Function;
+        return originalFunc;
+    }
 
-                // Unprotect the memory page
-                DWORD oldProtect = 0;
-                VirtualProtect(pThunk, sizeof(*pThunk), PAGE_READWRITE, &oldProtect);
+    // One import for PatchIatBatch. original receives the slot's current
+    // target, nullptr if the module doesn't import the function.
+    struct IatPatch {
+        const char* importDllName;
+        const char* importName;
+        void* newFunction;
+        void* original;
+    };
+
+    // Redirect several imports with one parse of the module and one
+    // VirtualProtect round trip per page their slots are on (the IAT is
+    // contiguous, so usually one), each page getting its own protection
+    // back. beforeWrite(patches, count) runs once the originals are
+    // known and before any slot changes, so dispatchers can be pointed at
+    // their originals before the first redirected call. Returns how many
+    // imports were patched.
+    template<typename BeforeWrite>
+    size_t PatchIatBatch(HMODULE moduleToPatch, IatPatch* patches, size_t count, BeforeWrite beforeWrite) {
+        PeImage image;
+        if (!image.Parse((const uint8_t*)moduleToPatch, 0, true)) {
+            return 0;
+        }
 
-                // Patch the IAT entry
-                pThunk->u1.Function = (ULONG_PTR)newFunction;
+        SYSTEM_INFO system;
+        GetSystemInfo(&system);
+        uintptr_t pageMask = ~(uintptr_t)(system.dwPageSize - 1);
+
+        // The pages holding the slots, each with the protection to restore
+        struct Page {
+            uintptr_t base;
+            DWORD oldProtect;
+            bool writable;
+        };
+        std::vector<void**> slots(count, nullptr);
+        std::vector<Page> pages;
+        for (size_t i = 0; i < count; ++i) {
+            slots[i] = (void**)image.FindImportSlot(patches[i].importDllName, patches[i].importName);
+            patches[i].original = slots[i] ? *slots[i] : nullptr;
+            if (!slots[i]) {
+                continue;
+            }
+            uintptr_t base = (uintptr_t)slots[i] & pageMask;
+            bool known = false;
+            for (const Page& page : pages) {
+                known = known || page.base == base;
+            }
+            if (!known) {
+                pages.push_back({base, 0, false});
+            }
+        }
+        if (pages.empty()) {
+            return 0;
+        }
 
-                // Restore the old protection
-                VirtualProtect(pThunk, sizeof(*pThunk), oldProtect, &oldProtect);
+        beforeWrite(patches, count);
 
-                return originalFunc;
+        for (Page& page : pages) {
+            page.writable = VirtualProtect((void*)page.base, system.dwPageSize, PAGE_READWRITE, &page.oldProtect) != FALSE;
+        }
+        size_t patched = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (!slots[i]) {
+                continue;
+            }
+            uintptr_t base = (uintptr_t)slots[i] & pageMask;
+            for (const Page& page : pages) {
+                if (page.base == base && page.writable) {
+                    *slots[i] = patches[i].newFunction;
+                    patched++;
+                }
             }
         }
-
-        return nullptr;
+        for (const Page& page : pages) {
+            DWORD ignored = 0;
+            if (page.writable) {
+                VirtualProtect((void*)page.base, system.dwPageSize, page.oldProtect, &ignored);
+            }
+        }
+        return patched;
     }
 }
 
@@ -0,0 +1,169 @@
+#include "import_hook.hpp"
+#include <cctype>
+#include <cstring>
+#include <memory>
+
+namespace ImportHooks {
+
+static std::vector<HookBase *> &Registry() {
+  // Hooks register from static constructors in any translation unit
+  static std::vector<HookBase *> hooks;
+  return hooks;
+}
+
+static std::atomic<uint32_t> g_nextCallbackId{1};
+
+// A read of one hook's callbacks. The scopes a thread is in are chained, so
+// a callback that changes its own hook's list is recognised.
+class HookBase::CallbackScope {
+public:
+  explicit CallbackScope(const HookBase &hook)
+      : rcu(hook.callbacksRcu), hook(hook), outer(t_innermost) {
+    t_innermost = this;
+  }
+  ~CallbackScope() { t_innermost = outer; }
+  CallbackScope(const CallbackScope &) = delete;
+  CallbackScope &operator=(const CallbackScope &) = delete;
+
+  static bool InsideOf(const HookBase &hook) {
+    for (const CallbackScope *scope = t_innermost; scope;
+         scope = scope->outer) {
+      if (&scope->hook == &hook)
+        return true;
+    }
+    return false;
+  }
+
+private:
+  RcuDomain::ReadScope rcu;
+  const HookBase &hook;
+  const CallbackScope *outer;
+  static thread_local const CallbackScope *t_innermost;
+};
+
+thread_local const HookBase::CallbackScope
+    *HookBase::CallbackScope::t_innermost = nullptr;
+
+static bool SameDllName(const char *a, const char *b) {
+  for (; *a && *b; ++a, ++b) {
+    if (std::tolower((unsigned char)*a) != std::tolower((unsigned char)*b))
+      return false;
+  }
+  return *a == *b;
+}
+
+HookBase::HookBase(const char *dllName, const char *functionName,
+                   void *dispatch)
+    : dllName(dllName), functionName(functionName), dispatch(dispatch) {
+  Registry().push_back(this);
+}
+
+void HookBase::Install(void *next) {
+  target.store(next, std::memory_order_release);
+}
+
+uint32_t HookBase::AddCallback(ImportCallback_t pre, ImportCallback_t post,
+                               void *user, const void *owner) {
+  if (!IsInstalled() || (!pre && !post))
+    return 0;
+  std::unique_lock<std::mutex> guard(lock);
+  auto next = std::make_unique<CallbackList>();
+  if (const CallbackList *current = callbacks.load())
+    next->callbacks = current->callbacks;
+  // Under the lock: ids in a hook's list only grow, which RunPost relies on
+  uint32_t id = g_nextCallbackId.fetch_add(1);
+  next->callbacks.push_back({id, pre, post, user, owner});
+  next->idLimit = id + 1;
+  Replace(guard, next.release());
+  return id;
+}
+
+bool HookBase::RemoveCallbacks(uint32_t id, const void *owner) {
+  std::unique_lock<std::mutex> guard(lock);
+  const CallbackList *current = callbacks.load();
+  if (!current)
+    return false;
+  auto next = std::make_unique<CallbackList>();
+  next->idLimit = current->idLimit;
+  for (const Callback &callback : current->callbacks) {
+    if (callback.id != id && (!owner || callback.owner != owner))
+      next->callbacks.push_back(callback);
+  }
+  if (next->callbacks.size() == current->callbacks.size())
+    return false;
+  // None left: the dispatcher goes back to calling the original only
+  Replace(guard, next->callbacks.empty() ? nullptr : next.release());
+  return true;
+}
+
+void HookBase::Replace(std::unique_lock<std::mutex> &guard,
+                       const CallbackList *next) {
+  std::vector<const CallbackList *> garbage;
+  garbage.push_back(callbacks.exchange(next));
+  // Our own dispatch is reading it: the next replacement frees it
+  if (CallbackScope::InsideOf(*this)) {
+    retired.push_back(garbage.back());
+    return;
+  }
+  garbage.insert(garbage.end(), retired.begin(), retired.end());
+  retired.clear();
+  // Not under the lock: a callback being waited for may add another
+  guard.unlock();
+  if (!callbacksRcu.Synchronize())
+    return; // Leaked: see ProcessExit::SetExiting
+  for (const CallbackList *list : garbage)
+    delete list;
+}
+
+uint32_t HookBase::RunPre(ImportCall *call) const {
+  CallbackScope scope(*this);
+  const CallbackList *list = callbacks.load();
+  if (!list)
+    return 0;
+  for (const Callback &callback : list->callbacks) {
+    if (callback.pre)
+      callback.pre(call, callback.user);
+  }
+  return list->idLimit;
+}
+
+void HookBase::RunPost(ImportCall *call, uint32_t idLimit) const {
+  CallbackScope scope(*this);
+  const CallbackList *list = callbacks.load();
+  if (!list)
+    return;
+  // Removed ones are gone from the list; skip those added since RunPre
+  for (const Callback &callback : list->callbacks) {
+    if (callback.post && callback.id < idLimit)
+      callback.post(call, callback.user);
+  }
+}
+
+const std::vector<HookBase *> &All() { return Registry(); }
+
+HookBase *Find(const char *dllName, const char *functionName) {
+  if (!dllName || !functionName)
+    return nullptr;
+  for (HookBase *hook : Registry()) {
+    if (SameDllName(hook->GetDllName(), dllName) &&
+        std::strcmp(hook->GetFunctionName(), functionName) == 0)
+      return hook;
+  }
+  return nullptr;
+}
+
+void RemoveCallback(uint32_t id) {
+  for (HookBase *hook : Registry()) {
+    if (hook->RemoveCallbacks(id, nullptr))
+      return;
+  }
+}
+
+void RemoveOwner(const void *owner) {
+  if (!owner)
+    return;
+  for (HookBase *hook : Registry())
+    hook->RemoveCallbacks(0, owner);
+}
+
+} // namespace ImportHooks
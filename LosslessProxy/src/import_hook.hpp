@@ -0,0 +1,163 @@
+#pragma once
+#include "addon_api.hpp"
+#include "platform.hpp"
+#include "rcu.hpp"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+// Hooks for Lossless_original's imports, declared by signature:
+//
+//   LS_IMPORT_HOOK(g_createFileHook, "kernel32.dll", "CreateFileW",
+//                  HANDLE(WINAPI *)(LPCWSTR, DWORD, DWORD, ...));
+//
+// Each declaration instantiates a dispatcher with that exact signature. The
+// host writes every declared dispatcher into the IAT in one batched rewrite
+// (ShaderHook::InstallHooks), and addons attach pre/post callbacks through
+// IHost::AddImportCallback. With no callbacks, a dispatcher only checks for
+// them and calls the original, but that is still a call through the
+// dispatcher on every import: see core_bench's "Import call" rows.
+namespace ImportHooks {
+
+struct Callback {
+  uint32_t id;
+  ImportCallback_t pre;
+  ImportCallback_t post;
+  void *user;
+  const void *owner;
+};
+typedef std::vector<Callback> Callbacks;
+
+// The untyped half of a hook: its import, where it forwards, and its
+// callbacks. Registers itself for Find/All on construction.
+class HookBase {
+public:
+  HookBase(const char *dllName, const char *functionName, void *dispatch);
+  HookBase(const HookBase &) = delete;
+  HookBase &operator=(const HookBase &) = delete;
+
+  const char *GetDllName() const { return dllName; }
+  const char *GetFunctionName() const { return functionName; }
+  // What to write into the IAT slot
+  void *GetDispatch() const { return dispatch; }
+
+  // Point the dispatcher at next (the import's original target) and accept
+  // callbacks. Tools without an IAT call this directly.
+  void Install(void *next);
+  bool IsInstalled() const {
+    return target.load(std::memory_order_acquire) != nullptr;
+  }
+
+  // 0 if the hook isn't installed. owner identifies the addon for
+  // RemoveOwner; may be null.
+  uint32_t AddCallback(ImportCallback_t pre, ImportCallback_t post,
+                       void *user, const void *owner);
+  // Drops matching callbacks; false if none matched. Waits for dispatches
+  // still running them, unless called from one of this hook's callbacks.
+  bool RemoveCallbacks(uint32_t id, const void *owner);
+
+protected:
+  struct CallbackList {
+    Callbacks callbacks;
+    uint32_t idLimit; // Above every id in callbacks
+  };
+
+  // Run the callbacks, each phase in its own read of callbacksRcu so that
+  // removal never waits on the original. RunPre returns what RunPost needs
+  // to skip callbacks added in between.
+  uint32_t RunPre(ImportCall *call) const;
+  void RunPost(ImportCall *call, uint32_t idLimit) const;
+
+  std::atomic<void *> target{nullptr};
+  std::atomic<const CallbackList *> callbacks{nullptr}; // Null when none
+
+private:
+  class CallbackScope;
+
+  // Publishes next, then frees the list it replaced once no dispatch can
+  // still be reading it. Called with lock held; releases it.
+  void Replace(std::unique_lock<std::mutex> &guard, const CallbackList *next);
+
+  const char *dllName;
+  const char *functionName;
+  void *dispatch;
+  std::mutex lock;
+  mutable RcuDomain callbacksRcu;
+  // Replaced from inside a callback, so not yet freed
+  std::vector<const CallbackList *> retired;
+};
+
+// Declared hooks, in declaration order
+const std::vector<HookBase *> &All();
+// Case-insensitive DLL name; nullptr if no hook is declared
+HookBase *Find(const char *dllName, const char *functionName);
+
+// As HookBase::RemoveCallbacks, on every hook
+void RemoveCallback(uint32_t id);
+void RemoveOwner(const void *owner);
+
+template <typename Tag, typename Function> class ImportHook;
+
+template <typename Tag, typename R, typename... Args>
+class ImportHook<Tag, R(WINAPI *)(Args...)> : public HookBase {
+public:
+  typedef R(WINAPI *Function)(Args...);
+
+  ImportHook(const char *dllName, const char *functionName)
+      : HookBase(dllName, functionName, (void *)&Dispatch) {
+    instance = this;
+  }
+
+  Function Next() const {
+    return (Function)target.load(std::memory_order_relaxed);
+  }
+
+  static R WINAPI Dispatch(Args... args) {
+    ImportHook *self = instance;
+    if (!self->callbacks.load(std::memory_order_relaxed))
+      return self->Next()(args...);
+    return self->DispatchWithCallbacks(args...);
+  }
+
+private:
+  R DispatchWithCallbacks(Args... args) {
+    // One extra slot so functions without arguments still get an array
+    void *argv[sizeof...(Args) + 1] = {(void *)&args...};
+    typename std::conditional<std::is_void<R>::value, int, R>::type result{};
+    ImportCall call = {GetDllName(),
+                       GetFunctionName(),
+                       argv,
+                       (uint32_t)sizeof...(Args),
+                       std::is_void<R>::value ? nullptr : (void *)&result,
+                       false};
+
+    uint32_t idLimit = RunPre(&call);
+    if (!call.skipOriginal) {
+      if constexpr (std::is_void<R>::value)
+        Next()(args...);
+      else
+        result = Next()(args...);
+    }
+    RunPost(&call, idLimit);
+
+    if constexpr (!std::is_void<R>::value)
+      return result;
+  }
+
+  static ImportHook *instance;
+};
+
+template <typename Tag, typename R, typename... Args>
+ImportHook<Tag, R(WINAPI *)(Args...)>
+    *ImportHook<Tag, R(WINAPI *)(Args...)>::instance = nullptr;
+
+} // namespace ImportHooks
+
+// Declares a hook with static storage. Signature is the import's function
+// pointer type, e.g. DWORD(WINAPI *)(HMODULE, HRSRC).
+#define LS_IMPORT_HOOK(name, dllName, functionName, Signature)                \
+  struct name##Tag;                                                            \
+  static ImportHooks::ImportHook<name##Tag, Signature> name(dllName,           \
+                                                            functionName)
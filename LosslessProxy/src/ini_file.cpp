@@ -0,0 +1,142 @@
+#include "ini_file.hpp"
+#include <cctype>
+#include <fstream>
+
+static std::string Trim(const std::string &text) {
+  size_t begin = text.find_first_not_of(" \t\r\n");
+  if (begin == std::string::npos)
+    return std::string();
+  size_t end = text.find_last_not_of(" \t\r\n");
+  return text.substr(begin, end - begin + 1);
+}
+
+static bool EqualsNoCase(const std::string &a, const std::string &b) {
+  if (a.size() != b.size())
+    return false;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (std::tolower((unsigned char)a[i]) != std::tolower((unsigned char)b[i]))
+      return false;
+  }
+  return true;
+}
+
+static bool IsSectionHeader(const std::string &trimmed) {
+  return trimmed.size() >= 2 && trimmed.front() == '[' &&
+         trimmed.find(']') != std::string::npos;
+}
+
+bool IniFile::Load(const std::filesystem::path &path) {
+  lines.clear();
+  std::ifstream in(path);
+  if (!in.is_open())
+    return false;
+
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    lines.push_back(line);
+  }
+  // Drop a UTF-8 BOM so the first header still matches
+  if (!lines.empty() && lines[0].compare(0, 3, "\xEF\xBB\xBF") == 0)
+    lines[0].erase(0, 3);
+  return true;
+}
+
+bool IniFile::Save(const std::filesystem::path &path) const {
+  std::ofstream out(path, std::ios::out | std::ios::trunc);
+  if (!out.is_open())
+    return false;
+  for (const std::string &line : lines) {
+    out << line << '\n';
+  }
+  return out.good();
+}
+
+int IniFile::FindSection(const std::string &section) const {
+  for (size_t i = 0; i < lines.size(); ++i) {
+    std::string trimmed = Trim(lines[i]);
+    if (!IsSectionHeader(trimmed))
+      continue;
+    std::string name = Trim(trimmed.substr(1, trimmed.find(']') - 1));
+    if (EqualsNoCase(name, section))
+      return (int)i;
+  }
+  return -1;
+}
+
+int IniFile::SectionEnd(int sectionLine) const {
+  int i = sectionLine + 1;
+  for (; i < (int)lines.size(); ++i) {
+    if (IsSectionHeader(Trim(lines[i])))
+      break;
+  }
+  return i;
+}
+
+int IniFile::FindKey(int sectionLine, const std::string &key) const {
+  int end = SectionEnd(sectionLine);
+  for (int i = sectionLine + 1; i < end; ++i) {
+    const std::string &line = lines[i];
+    size_t equals = line.find('=');
+    if (equals == std::string::npos)
+      continue;
+    std::string trimmed = Trim(line);
+    if (trimmed.empty() || trimmed[0] == ';' || trimmed[0] == '#')
+      continue;
+    if (EqualsNoCase(Trim(line.substr(0, equals)), key))
+      return i;
+  }
+  return -1;
+}
+
+std::string IniFile::Get(const std::string &section, const std::string &key,
+                         const std::string &defaultValue) const {
+  int sectionLine = FindSection(section);
+  if (sectionLine < 0)
+    return defaultValue;
+  int keyLine = FindKey(sectionLine, key);
+  if (keyLine < 0)
+    return defaultValue;
+  const std::string &line = lines[keyLine];
+  return Trim(line.substr(line.find('=') + 1));
+}
+
+int IniFile::GetInt(const std::string &section, const std::string &key,
+                    int defaultValue) const {
+  std::string value = Get(section, key, std::string());
+  if (value.empty())
+    return defaultValue;
+
+  bool negative = value[0] == '-';
+  int result = 0;
+  for (size_t i = negative ? 1 : 0; i < value.size(); ++i) {
+    if (!std::isdigit((unsigned char)value[i]))
+      break;
+    result = result * 10 + (value[i] - '0');
+  }
+  return negative ? -result : result;
+}
+
+void IniFile::Set(const std::string &section, const std::string &key,
+                  const std::string &value) {
+  std::string entry = key + "=" + value;
+  int sectionLine = FindSection(section);
+  if (sectionLine < 0) {
+    lines.push_back("[" + section + "]");
+    lines.push_back(entry);
+    return;
+  }
+
+  int keyLine = FindKey(sectionLine, key);
+  if (keyLine >= 0) {
+    lines[keyLine] = entry;
+    return;
+  }
+
+  // Append after the section's last non-blank line
+  int insertAt = SectionEnd(sectionLine);
+  while (insertAt > sectionLine + 1 && Trim(lines[insertAt - 1]).empty())
+    --insertAt;
+  lines.insert(lines.begin() + insertAt, entry);
+}
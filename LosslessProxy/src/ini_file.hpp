@@ -0,0 +1,31 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Small INI reader/writer with GetPrivateProfile* semantics: section and key
+// names match case-insensitively, and comments, blank lines and unknown keys
+// survive a load/save round trip.
+class IniFile {
+public:
+  // A missing file loads as empty
+  bool Load(const std::filesystem::path &path);
+  bool Save(const std::filesystem::path &path) const;
+
+  std::string Get(const std::string &section, const std::string &key,
+                  const std::string &defaultValue) const;
+  // Leading decimal digits of the value, like GetPrivateProfileInt
+  int GetInt(const std::string &section, const std::string &key,
+             int defaultValue) const;
+  void Set(const std::string &section, const std::string &key,
+           const std::string &value);
+
+private:
+  // Index of the section header line, or -1
+  int FindSection(const std::string &section) const;
+  // Index of the key line within the section starting after sectionLine, or -1
+  int FindKey(int sectionLine, const std::string &key) const;
+  int SectionEnd(int sectionLine) const;
+
+  std::vector<std::string> lines;
+};
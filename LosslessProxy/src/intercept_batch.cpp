@@ -0,0 +1,74 @@
+#include "intercept_batch.hpp"
+#include "resource_key.hpp"
+
+static LPCWSTR ResourceIdPointer(const PeImage::ResourceId &id) {
+  return id.id ? MAKEINTRESOURCEW(id.id) : id.name.c_str();
+}
+
+static std::string KeyOf(const PeImage::Resource &resource) {
+  return MakeResourceKey(ResourceIdPointer(resource.name),
+                         ResourceIdPointer(resource.type));
+}
+
+std::shared_ptr<const InterceptBatch::Answers>
+InterceptBatch::Ask(AddonInterceptResourceBatch_t batch,
+                    const std::vector<PeImage::Resource> &resources) {
+  std::vector<ResourceRequest> requests;
+  requests.reserve(resources.size());
+  for (const PeImage::Resource &resource : resources) {
+    requests.push_back(
+        {ResourceIdPointer(resource.name), ResourceIdPointer(resource.type)});
+  }
+  std::vector<ResourceResponse> responses(resources.size(), {nullptr, 0});
+  batch(requests.data(), (uint32_t)requests.size(), responses.data());
+
+  auto answers = std::make_shared<Answers>();
+  for (size_t i = 0; i < resources.size(); ++i) {
+    const ResourceResponse &response = responses[i];
+    if (!response.data || response.size == 0)
+      continue;
+    const uint8_t *bytes = (const uint8_t *)response.data;
+    (*answers)[KeyOf(resources[i])].assign(bytes, bytes + response.size);
+  }
+  return answers;
+}
+
+InterceptBatch::InterceptBatch(
+    const std::vector<PeImage::Resource> &resources,
+    const std::vector<std::shared_ptr<const Answers>> &addonAnswers,
+    const std::vector<bool> &perCall)
+    : answers(addonAnswers) {
+  for (const PeImage::Resource &resource : resources) {
+    Entry entry = {answers.size(), nullptr, false, KeyOf(resource)};
+    for (size_t i = 0; i < answers.size(); ++i) {
+      if (!answers[i])
+        continue;
+      auto it = answers[i]->find(entry.key);
+      if (it != answers[i]->end()) {
+        entry.servedBy = i;
+        entry.data = &it->second;
+        break;
+      }
+    }
+    for (size_t i = 0; i < entry.servedBy && i < perCall.size(); ++i)
+      entry.askFirst = entry.askFirst || perCall[i];
+    LPCWSTR name = ResourceIdPointer(resource.name);
+    LPCWSTR type = ResourceIdPointer(resource.type);
+    entries[ResourceLookupKey(name, type)] = std::move(entry);
+  }
+}
+
+bool InterceptBatch::Find(LPCWSTR name, LPCWSTR type, size_t *servedBy,
+                          const std::vector<uint8_t> **data,
+                          bool *askFirst) const {
+  auto it = entries.find(ResourceLookupKey(name, type));
+  if (it == entries.end())
+    return false;
+  if (!(IS_INTRESOURCE(name) && IS_INTRESOURCE(type)) &&
+      it->second.key != MakeResourceKey(name, type))
+    return false;
+  *servedBy = it->second.servedBy;
+  *data = it->second.data;
+  *askFirst = it->second.askFirst;
+  return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "addon_api.hpp"
+#include "pe_image.hpp"
+#include "platform.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Every addon's AddonInterceptResourceBatch answers merged in addon order:
+// for each resource in Lossless' directory, the first addon that replaces it
+// and with what. Built whole and never modified, so the hooks read it without
+// locking while the GUI thread builds its successor.
+class InterceptBatch {
+public:
+  // One addon's replacements by MakeResourceKey; declined keys are absent
+  typedef std::unordered_map<std::string, std::vector<uint8_t>> Answers;
+
+  // Calls batch once with every resource and copies what it returns
+  static std::shared_ptr<const Answers>
+  Ask(AddonInterceptResourceBatch_t batch,
+      const std::vector<PeImage::Resource> &resources);
+
+  // answers[i] belongs to addon i, nullptr if it has not answered;
+  // perCall[i] is true for addons that must still be asked per call
+  InterceptBatch(const std::vector<PeImage::Resource> &resources,
+                 const std::vector<std::shared_ptr<const Answers>> &answers,
+                 const std::vector<bool> &perCall);
+
+  // False if the resource is not in the directory, so every addon must be
+  // asked. Otherwise *servedBy is the first addon that replaces it (the
+  // addon count if none does), *data its bytes, and *askFirst whether a
+  // per-call addon comes before it.
+  bool Find(LPCWSTR name, LPCWSTR type, size_t *servedBy,
+            const std::vector<uint8_t> **data, bool *askFirst) const;
+  // True if addon i answered, so it declined everything it did not serve
+  bool Answered(size_t addon) const {
+    return addon < answers.size() && answers[addon];
+  }
+
+private:
+  struct Entry {
+    size_t servedBy;
+    const std::vector<uint8_t> *data;
+    bool askFirst;
+    std::string key; // MakeResourceKey, checked for string names only
+  };
+
+  std::unordered_map<uint64_t, Entry> entries; // By ResourceLookupKey
+  std::vector<std::shared_ptr<const Answers>> answers; // Own the bytes
+};
@@ -0,0 +1,156 @@
+#include "lz4_block.hpp"
+#include <cstring>
+
+namespace Lz4Block {
+
+static const size_t kMinMatch = 4;
+static const size_t kLastLiterals = 5; // The block must end in literals
+static const size_t kMatchStartLimit = 12;
+static const size_t kMaxOffset = 65535;
+static const int kHashBits = 12;
+static const size_t kWideCopy = 16;
+
+static uint32_t Read32(const uint8_t *p) {
+  uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static uint32_t Hash(uint32_t sequence) {
+  return (sequence * 2654435761u) >> (32 - kHashBits);
+}
+
+// Lengths of 15 and up continue in 255-saturated bytes after the token
+static uint8_t *WriteLength(uint8_t *out, size_t length) {
+  while (length >= 255) {
+    *out++ = 255;
+    length -= 255;
+  }
+  *out++ = (uint8_t)length;
+  return out;
+}
+
+static uint8_t *WriteLiterals(uint8_t *out, const uint8_t *literals,
+                              size_t count, uint8_t matchNibble) {
+  *out++ = (uint8_t)((count < 15 ? count : 15) << 4 | matchNibble);
+  if (count >= 15)
+    out = WriteLength(out, count - 15);
+  if (count > 0)
+    std::memcpy(out, literals, count);
+  return out + count;
+}
+
+void Compress(const uint8_t *data, size_t size, std::vector<uint8_t> *out) {
+  // Worst case: all literals plus their length bytes and one token
+  out->resize(size + size / 255 + 16);
+  uint8_t *write = out->data();
+
+  size_t anchor = 0;
+  if (size > kMatchStartLimit) {
+    // Positions + 1, so 0 means empty
+    uint32_t table[1 << kHashBits] = {};
+    const size_t matchEndLimit = size - kLastLiterals;
+    const size_t searchEnd = size - kMatchStartLimit;
+
+    size_t pos = 0;
+    while (pos < searchEnd) {
+      uint32_t sequence = Read32(data + pos);
+      uint32_t &slot = table[Hash(sequence)];
+      size_t candidate = slot;
+      slot = (uint32_t)(pos + 1);
+      if (candidate == 0 || pos - (candidate - 1) > kMaxOffset ||
+          Read32(data + candidate - 1) != sequence) {
+        // Step faster through data that keeps missing
+        pos += 1 + ((pos - anchor) >> 6);
+        continue;
+      }
+
+      size_t match = candidate - 1;
+      size_t length = kMinMatch;
+      while (pos + length < matchEndLimit &&
+             data[match + length] == data[pos + length])
+        length++;
+
+      size_t matchCode = length - kMinMatch;
+      write = WriteLiterals(write, data + anchor, pos - anchor,
+                            (uint8_t)(matchCode < 15 ? matchCode : 15));
+      size_t offset = pos - match;
+      *write++ = (uint8_t)offset;
+      *write++ = (uint8_t)(offset >> 8);
+      if (matchCode >= 15)
+        write = WriteLength(write, matchCode - 15);
+
+      pos += length;
+      anchor = pos;
+    }
+  }
+  write = WriteLiterals(write, data + anchor, size - anchor, 0);
+  out->resize(write - out->data());
+}
+
+static bool ReadLength(const uint8_t *block, size_t blockSize, size_t *in,
+                       size_t *length) {
+  uint8_t byte;
+  do {
+    if (*in >= blockSize)
+      return false;
+    byte = block[(*in)++];
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+bool Decompress(const uint8_t *block, size_t blockSize, uint8_t *output,
+                size_t outputSize) {
+  size_t in = 0, out = 0;
+  while (in < blockSize) {
+    uint8_t token = block[in++];
+
+    size_t literals = token >> 4;
+    if (literals == 15 && !ReadLength(block, blockSize, &in, &literals))
+      return false;
+    if (literals > blockSize - in || literals > outputSize - out)
+      return false;
+    if (literals <= kWideCopy && blockSize - in >= kWideCopy &&
+        outputSize - out >= kWideCopy) {
+      // Fixed-size copy; the overshoot is overwritten by what follows
+      std::memcpy(output + out, block + in, kWideCopy);
+    } else if (literals > 0) {
+      std::memcpy(output + out, block + in, literals);
+    }
+    in += literals;
+    out += literals;
+    if (in == blockSize)
+      break; // The last sequence has no match
+
+    if (blockSize - in < 2)
+      return false;
+    size_t offset = block[in] | (size_t)block[in + 1] << 8;
+    in += 2;
+    if (offset == 0 || offset > out)
+      return false;
+
+    size_t length = token & 15;
+    if (length == 15 && !ReadLength(block, blockSize, &in, &length))
+      return false;
+    length += kMinMatch;
+    if (length > outputSize - out)
+      return false;
+
+    const uint8_t *match = output + out - offset;
+    if (offset >= kWideCopy && outputSize - out >= length + kWideCopy) {
+      for (size_t i = 0; i < length; i += kWideCopy)
+        std::memcpy(output + out + i, match + i, kWideCopy);
+    } else if (offset >= length) {
+      std::memcpy(output + out, match, length);
+    } else {
+      // Overlapping copy repeats the last offset bytes
+      for (size_t i = 0; i < length; ++i)
+        output[out + i] = match[i];
+    }
+    out += length;
+  }
+  return out == outputSize;
+}
+
+} // namespace Lz4Block
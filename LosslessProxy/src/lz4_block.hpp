@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// LZ4 block format (no frame header or checksums): a fast greedy compressor
+// and a bounds-checked decompressor. Used by the shader cache's cold tier,
+// where decompression sits on the LockResource path.
+namespace Lz4Block {
+
+// Replaces *out with the compressed block. Incompressible input grows by
+// at most size / 255 + 16 bytes.
+void Compress(const uint8_t *data, size_t size, std::vector<uint8_t> *out);
+
+// False on malformed input or if the block does not expand to exactly
+// outputSize bytes
+bool Decompress(const uint8_t *block, size_t blockSize, uint8_t *output,
+                size_t outputSize);
+
+} // namespace Lz4Block
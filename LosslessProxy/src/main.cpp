@@ -1,12 +1,38 @@
 #include "addon_manager.hpp"
+#include "export_profile.hpp"
 #include "gui_manager.hpp"
+#include "headless_host.hpp"
+#include "ini_file.hpp"
+#include "process_exit.hpp"
 #include "shader_hook.hpp"
+#include "trace.hpp"
+#include <cstdint>
+#include <cstdlib>
 #include <filesystem>
-#include <iostream>
 #include <string>
 #include <vector>
 #include <windows.h>
 
+#ifdef LOSSLESS_INSTRUMENT_EXPORTS
+// Export through the counting thunks in export_thunks_x64.asm; DllMain
+// points them at the original exports
+#pragma comment(linker, "/export:Activate=LosslessThunk_Activate")
+#pragma comment(linker, "/export:ApplySettings=LosslessThunk_ApplySettings")
+#pragma comment(linker, "/export:GetAdapterNames=LosslessThunk_GetAdapterNames")
+#pragma comment(linker, "/export:GetDisplayNames=LosslessThunk_GetDisplayNames")
+#pragma comment(linker,                                                        \
+                "/export:GetDwmRefreshRate=LosslessThunk_GetDwmRefreshRate")
+#pragma comment(                                                               \
+    linker, "/export:GetForegroundWindowEx=LosslessThunk_GetForegroundWindowEx")
+#pragma comment(linker, "/export:Init=LosslessThunk_Init")
+#pragma comment(                                                               \
+    linker, "/export:IsWindowsBuildAtLeast=LosslessThunk_IsWindowsBuildAtLeast")
+#pragma comment(linker,                                                        \
+                "/export:SetDriverSettings=LosslessThunk_SetDriverSettings")
+#pragma comment(linker,                                                        \
+                "/export:SetWindowsSettings=LosslessThunk_SetWindowsSettings")
+#pragma comment(linker, "/export:UnInit=LosslessThunk_UnInit")
+#else
 // Forward exports to the original DLL
 #pragma comment(linker, "/export:Activate=Lossless_original.Activate")
 #pragma comment(linker, "/export:ApplySettings=Lossless_original.ApplySettings")
@@ -28,44 +54,123 @@
 #pragma comment(                                                               \
     linker, "/export:SetWindowsSettings=Lossless_original.SetWindowsSettings")
 #pragma comment(linker, "/export:UnInit=Lossless_original.UnInit")
+#endif
 
 AddonManager *g_addonManager = nullptr;
 
+// Time DllMain spent under the loader lock, logged by DeferredInit
+static uint64_t g_loaderLockMicros = 0;
+
+// Replaces the manager window when headless
+static HeadlessHost *g_headlessHost = nullptr;
+
+// Everything that does not have to precede Lossless_original's first resource
+// lookup. Runs on its own thread so none of it holds the loader lock: the
+// addon scan and INI parsing, the resource index and the GUI thread. Until
+// ShaderHook::Initialize publishes the manager, the hooks pass through.
+static DWORD WINAPI DeferredInit(LPVOID param) {
+  HMODULE hLosslessOriginal = (HMODULE)param;
+  LS_TRACE_THREAD_NAME("Init");
+  LS_TRACE_SCOPE("DeferredInit");
+
+  uint64_t start = Trace::NowMicros();
+  LS_TRACE_BEGIN("AddonManager");
+  AddonManager *manager = new AddonManager();
+  LS_TRACE_END();
+
+  ShaderHook::Initialize(manager);
+  LS_TRACE_BEGIN("IndexResources");
+  ShaderHook::IndexResources(hLosslessOriginal);
+  LS_TRACE_END();
+  g_addonManager = manager;
+
+  // DllMain used to do all of the above itself, so the two together are
+  // what it held the loader lock for before
+  uint64_t movedMicros = Trace::NowMicros() - start;
+  ShaderHook::LogToFile(L"[Main] DllMain held the loader lock for " +
+                        std::to_wstring(g_loaderLockMicros) +
+                        L" us; the startup moved out of it took " +
+                        std::to_wstring(movedMicros) + L" us (" +
+                        std::to_wstring(g_loaderLockMicros + movedMicros) +
+                        L" us under the lock before)");
+
+  // LOSSLESS_HEADLESS=1 or [Manager] Headless=1: no window or D3D device,
+  // only the [Manager] ControlChannel pipe
+  IniFile config;
+  config.Load(manager->GetConfigFilePath());
+  bool headless = config.GetInt("Manager", "Headless", 0) != 0;
+  if (const char *value = std::getenv("LOSSLESS_HEADLESS"))
+    headless = std::atoi(value) != 0;
+  if (headless) {
+    std::string channel = config.Get("Manager", "ControlChannel",
+                                     HeadlessHost::kDefaultChannel);
+    g_headlessHost = new HeadlessHost();
+    std::wstring pipe =
+        L"\\\\.\\pipe\\" + std::filesystem::u8path(channel).wstring();
+    if (g_headlessHost->Start(manager, channel.c_str()))
+      ShaderHook::LogToFile(L"[Main] Headless; control pipe " + pipe);
+    else
+      ShaderHook::LogToFile(L"[Main] Headless; could not open " + pipe);
+    return 0;
+  }
+
+  // Addons load from threads the GUI starts, to avoid Loader Lock issues
+  // with LoadLibrary
+  GuiManager::StartGuiThread(manager);
+  return 0;
+}
+
 BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call,
                       LPVOID lpReserved) {
   switch (ul_reason_for_call) {
   case DLL_PROCESS_ATTACH: {
+    uint64_t start = Trace::NowMicros();
+    LS_TRACE_THREAD_NAME("Loader");
+    LS_TRACE_SCOPE("DllMain");
     DisableThreadLibraryCalls(hModule);
 
-    // CRITICAL: Load Lossless_original.dll FIRST so we can IAT patch it
-    // The pragma linker comments will auto-load it, but we do it explicitly
-    // here
-    HMODULE hLosslessOriginal = LoadLibraryW(L"Lossless_original.dll");
-    if (!hLosslessOriginal) {
-      std::wcerr << L"[ERROR] Failed to load Lossless_original.dll"
-                 << std::endl;
+    // The forwarded exports make the loader map Lossless_original before us,
+    // so this normally only looks it up (the instrumented thunks don't)
+    HMODULE hLosslessOriginal = GetModuleHandleW(L"Lossless_original.dll");
+    if (!hLosslessOriginal)
+      hLosslessOriginal = LoadLibraryW(L"Lossless_original.dll");
+    if (!hLosslessOriginal)
       return FALSE;
-    }
-    std::wcout << L"[Main] Lossless_original.dll loaded successfully"
-               << std::endl;
 
-    // Initialize Addon Manager
-    g_addonManager = new AddonManager();
-
-    // Initialize shader hook system AFTER Lossless_original is loaded
-    ShaderHook::Initialize(g_addonManager);
-    ShaderHook::InstallHooks(); // This patches the IAT of Lossless_original
+#ifdef LOSSLESS_INSTRUMENT_EXPORTS
+    for (uint32_t i = 0; i < ExportProfile::kExportCount; ++i) {
+      FARPROC original =
+          GetProcAddress(hLosslessOriginal, ExportProfile::kExportNames[i]);
+      // A forwarder to a missing export would have failed the load too
+      if (!original)
+        return FALSE;
+      ExportProfile::SetTarget((ExportProfile::Export)i, (void *)original);
+    }
+#endif
 
-    std::wcout << L"[Main] Shader hooks installed, loading addons..."
-               << std::endl;
+    // The IAT patch is the only step that must happen here: Lossless may look
+    // up its first shader before any thread we start gets to run
+    LS_TRACE_BEGIN("InstallHooks");
+    ShaderHook::InstallHooks();
+    LS_TRACE_END();
 
-    // We load addons in the GUI thread to avoid Loader Lock issues with
-    // LoadLibrary
-    GuiManager::StartGuiThread(g_addonManager);
+    g_loaderLockMicros = Trace::NowMicros() - start;
+    HANDLE thread =
+        CreateThread(nullptr, 0, DeferredInit, hLosslessOriginal, 0, nullptr);
+    if (thread)
+      CloseHandle(thread);
     break;
   }
   case DLL_PROCESS_DETACH:
+    // Terminating: our threads are gone, some perhaps inside a hook's RCU
+    // read, and none of the shutdown below should wait for them
+    if (lpReserved)
+      ProcessExit::SetExiting();
+    for (const std::wstring &line : ExportProfile::FormatSummary())
+      ShaderHook::LogToFile(line);
     ShaderHook::UninstallHooks();
+    if (g_headlessHost)
+      g_headlessHost->Stop(); // Leaked: its threads may outlive Stop
     ShaderHook::Shutdown();
     if (g_addonManager) {
       delete g_addonManager;
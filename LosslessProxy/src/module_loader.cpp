@@ -0,0 +1,90 @@
+#include "module_loader.hpp"
+#include "process_exit.hpp"
+#include "trace.hpp"
+#include <chrono>
+#include <thread>
+
+static uint64_t NowNanos() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+ModuleLoader::~ModuleLoader() { Cancel(); }
+
+void ModuleLoader::Start(std::vector<Job> jobs,
+                         std::function<void()> callback) {
+  Cancel();
+  if (jobs.empty())
+    return;
+  batch = std::make_shared<Batch>();
+  batch->onLoaded = std::move(callback);
+  std::thread(Run, batch, std::move(jobs)).detach();
+}
+
+void ModuleLoader::Run(std::shared_ptr<Batch> batch, std::vector<Job> jobs) {
+  LS_TRACE_THREAD_NAME("AddonLoader");
+  for (const Job &job : jobs) {
+    {
+      std::lock_guard<std::mutex> guard(batch->lock);
+      if (batch->stopRequested)
+        break;
+    }
+    Result result = {job.index, job.path, nullptr, 0};
+    uint64_t started = NowNanos();
+    {
+      LS_TRACE_SCOPE_DYNAMIC("LoadLibrary " +
+                             job.path.filename().u8string());
+      result.module = Platform::LoadModule(job.path);
+    }
+    result.nanos = NowNanos() - started;
+
+    // Under the lock, so nothing is published or called back once Cancel
+    // has returned
+    std::lock_guard<std::mutex> guard(batch->lock);
+    if (batch->stopRequested) {
+      if (result.module)
+        Platform::FreeModule(result.module);
+      break;
+    }
+    batch->finished.push_back(std::move(result));
+    if (batch->onLoaded)
+      batch->onLoaded();
+  }
+  batch->exited.store(true, std::memory_order_release);
+}
+
+std::vector<ModuleLoader::Result> ModuleLoader::Poll() {
+  std::vector<Result> results;
+  if (!batch)
+    return results;
+  std::lock_guard<std::mutex> guard(batch->lock);
+  results.swap(batch->finished);
+  return results;
+}
+
+void ModuleLoader::Cancel() {
+  if (!batch)
+    return;
+  {
+    std::lock_guard<std::mutex> guard(batch->lock);
+    batch->stopRequested = true;
+  }
+  // This can run from DllMain on unload, where a worker inside LoadLibrary
+  // waits for the loader lock we hold (see ProcessExit)
+  ProcessExit::WaitForThreadExit(batch->exited);
+  for (const Result &result : Poll()) {
+    if (result.module)
+      Platform::FreeModule(result.module);
+  }
+  batch = nullptr;
+}
+
+bool ModuleLoader::IsBusy() const {
+  if (!batch)
+    return false;
+  if (!batch->exited.load(std::memory_order_acquire))
+    return true;
+  std::lock_guard<std::mutex> guard(batch->lock);
+  return !batch->finished.empty();
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "platform.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Loads addon modules on a background thread, in order. Finished loads are
+// collected with Poll() on the thread that owns the addon list, so only that
+// thread ever writes AddonInfo.
+class ModuleLoader {
+public:
+  struct Job {
+    size_t index; // Into the addon list
+    std::filesystem::path path;
+  };
+
+  struct Result {
+    size_t index;
+    std::filesystem::path path;
+    HMODULE module; // nullptr if the load failed
+    uint64_t nanos;
+  };
+
+  ~ModuleLoader();
+
+  // onLoaded runs on the worker after each load
+  void Start(std::vector<Job> jobs, std::function<void()> onLoaded);
+  // Loads finished since the last call
+  std::vector<Result> Poll();
+  // Stops after the current load and frees modules nobody collected. Safe
+  // from DllMain: a worker still inside LoadLibrary after a second is left
+  // to finish, and frees that module itself.
+  void Cancel();
+
+  // Jobs left to load or results left to collect
+  bool IsBusy() const;
+
+private:
+  // Per Start, shared with its worker so a worker Cancel gave up on never
+  // touches the loader
+  struct Batch {
+    std::mutex lock;
+    std::vector<Result> finished;
+    std::function<void()> onLoaded;
+    bool stopRequested = false;
+    std::atomic<bool> exited{false};
+  };
+
+  static void Run(std::shared_ptr<Batch> batch, std::vector<Job> jobs);
+
+  std::shared_ptr<Batch> batch;
+};
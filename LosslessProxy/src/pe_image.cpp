@@ -0,0 +1,225 @@
+#include "pe_image.hpp"
+#include <cctype>
+#include <cstring>
+
+// Field offsets from the PE/COFF specification. Read with memcpy so raw file
+// buffers need no particular alignment.
+namespace {
+const uint16_t kDosSignature = 0x5A4D;  // "MZ"
+const uint32_t kNtSignature = 0x4550;   // "PE\0\0"
+const uint16_t kMagicPe32 = 0x10B;
+const uint16_t kMagicPe32Plus = 0x20B;
+const size_t kFileHeaderSize = 20;
+const size_t kSectionHeaderSize = 40;
+const size_t kImportDescriptorSize = 20;
+const int kDirectoryImport = 1;
+const int kDirectoryResource = 2;
+const size_t kResourceDirectorySize = 16;
+const size_t kResourceEntrySize = 8;
+const uint32_t kResourceHighBit = 0x80000000u;
+
+template <typename T> T Read(const uint8_t *p) {
+  T value;
+  std::memcpy(&value, p, sizeof(T));
+  return value;
+}
+
+bool EqualsNoCase(const char *a, const char *b) {
+  for (; *a && *b; ++a, ++b) {
+    if (std::tolower((unsigned char)*a) != std::tolower((unsigned char)*b))
+      return false;
+  }
+  return *a == *b;
+}
+} // namespace
+
+bool PeImage::Parse(const uint8_t *data, size_t size, bool isMapped) {
+  valid = false;
+  base = data;
+  mapped = isMapped;
+  imageSize = size ? size : 4096; // Enough for the headers until we know more
+  if (!data)
+    return false;
+
+  if (imageSize < 0x40 || Read<uint16_t>(data) != kDosSignature)
+    return false;
+  uint32_t ntOffset = Read<uint32_t>(data + 0x3C);
+  if ((size_t)ntOffset + 4 + kFileHeaderSize + 2 > imageSize ||
+      Read<uint32_t>(data + ntOffset) != kNtSignature)
+    return false;
+
+  const uint8_t *fileHeader = data + ntOffset + 4;
+  sectionCount = Read<uint16_t>(fileHeader + 2);
+  uint16_t optionalSize = Read<uint16_t>(fileHeader + 16);
+  const uint8_t *optional = fileHeader + kFileHeaderSize;
+  uint16_t magic = Read<uint16_t>(optional);
+  if (magic == kMagicPe32Plus) {
+    is64Bit = true;
+  } else if (magic == kMagicPe32) {
+    is64Bit = false;
+  } else {
+    return false;
+  }
+
+  if (isMapped && size == 0)
+    imageSize = Read<uint32_t>(optional + 56); // SizeOfImage
+
+  size_t countOffset = is64Bit ? 108 : 92; // NumberOfRvaAndSizes
+  directoryCount = Read<uint32_t>(optional + countOffset);
+  directories = optional + countOffset + 4;
+  if (countOffset + 4 + (size_t)directoryCount * 8 > optionalSize)
+    directoryCount = (uint32_t)((optionalSize - countOffset - 4) / 8);
+
+  sections = optional + optionalSize;
+  size_t sectionsEnd = (size_t)(sections - data) +
+                       (size_t)sectionCount * kSectionHeaderSize;
+  if (sectionsEnd > imageSize)
+    return false;
+
+  valid = true;
+  return true;
+}
+
+const uint8_t *PeImage::RvaToPointer(uint32_t rva, size_t length) const {
+  if (!base)
+    return nullptr;
+  if (mapped) {
+    if ((size_t)rva + length > imageSize)
+      return nullptr;
+    return base + rva;
+  }
+
+  for (uint16_t i = 0; i < sectionCount; ++i) {
+    const uint8_t *section = sections + (size_t)i * kSectionHeaderSize;
+    uint32_t virtualSize = Read<uint32_t>(section + 8);
+    uint32_t virtualAddress = Read<uint32_t>(section + 12);
+    uint32_t rawSize = Read<uint32_t>(section + 16);
+    uint32_t rawOffset = Read<uint32_t>(section + 20);
+    uint32_t extent = virtualSize > rawSize ? virtualSize : rawSize;
+    if (rva < virtualAddress || rva - virtualAddress >= extent)
+      continue;
+    size_t offset = (size_t)rawOffset + (rva - virtualAddress);
+    if (rva - virtualAddress + length > rawSize || offset + length > imageSize)
+      return nullptr; // Uninitialized tail has no file bytes
+    return base + offset;
+  }
+  // Headers are not inside any section
+  if ((size_t)rva + length <= imageSize && sectionCount > 0 &&
+      rva < Read<uint32_t>(sections + 12))
+    return base + rva;
+  return nullptr;
+}
+
+bool PeImage::GetDirectory(int index, uint32_t *rva, uint32_t *size) const {
+  if (!valid || index < 0 || (uint32_t)index >= directoryCount)
+    return false;
+  *rva = Read<uint32_t>(directories + (size_t)index * 8);
+  *size = Read<uint32_t>(directories + (size_t)index * 8 + 4);
+  return *rva != 0;
+}
+
+void *PeImage::FindImportSlot(const char *dllName,
+                              const char *functionName) const {
+  uint32_t importRva, importSize;
+  if (!GetDirectory(kDirectoryImport, &importRva, &importSize))
+    return nullptr;
+
+  size_t thunkSize = GetThunkSize();
+  uint64_t ordinalFlag = is64Bit ? (1ull << 63) : (1ull << 31);
+
+  for (uint32_t rva = importRva;; rva += kImportDescriptorSize) {
+    const uint8_t *descriptor = RvaToPointer(rva, kImportDescriptorSize);
+    if (!descriptor)
+      return nullptr;
+    uint32_t originalFirstThunk = Read<uint32_t>(descriptor);
+    uint32_t nameRva = Read<uint32_t>(descriptor + 12);
+    uint32_t firstThunk = Read<uint32_t>(descriptor + 16);
+    if (!nameRva)
+      return nullptr;
+
+    const char *name = (const char *)RvaToPointer(nameRva);
+    if (!name || !EqualsNoCase(name, dllName))
+      continue;
+
+    // Bound or old-style images keep the names in the IAT itself
+    uint32_t lookupRva = originalFirstThunk ? originalFirstThunk : firstThunk;
+    for (uint32_t i = 0;; ++i) {
+      const uint8_t *lookup =
+          RvaToPointer(lookupRva + i * (uint32_t)thunkSize, thunkSize);
+      const uint8_t *slot =
+          RvaToPointer(firstThunk + i * (uint32_t)thunkSize, thunkSize);
+      if (!lookup || !slot)
+        break;
+      uint64_t entry =
+          is64Bit ? Read<uint64_t>(lookup) : (uint64_t)Read<uint32_t>(lookup);
+      if (!entry)
+        break;
+      if (entry & ordinalFlag)
+        continue;
+
+      // IMAGE_IMPORT_BY_NAME: WORD hint, then the name
+      const char *importName =
+          (const char *)RvaToPointer((uint32_t)entry + 2);
+      if (importName && std::strcmp(importName, functionName) == 0)
+        return (void *)slot;
+    }
+  }
+}
+
+void PeImage::ReadResourceLevel(uint32_t root, uint32_t offset,
+                                std::vector<ResourceLink> *links) const {
+  const uint8_t *table = RvaToPointer(root + offset, kResourceDirectorySize);
+  if (!table)
+    return;
+  // NumberOfNamedEntries, then NumberOfIdEntries; the entries follow
+  uint32_t count =
+      (uint32_t)Read<uint16_t>(table + 12) + Read<uint16_t>(table + 14);
+  const uint8_t *entries = RvaToPointer(root + offset + kResourceDirectorySize,
+                                        (size_t)count * kResourceEntrySize);
+  if (!entries)
+    return;
+
+  for (uint32_t i = 0; i < count; ++i) {
+    const uint8_t *entry = entries + (size_t)i * kResourceEntrySize;
+    uint32_t nameField = Read<uint32_t>(entry);
+    ResourceLink link;
+    link.target = Read<uint32_t>(entry + 4);
+    if (nameField & kResourceHighBit) {
+      // IMAGE_RESOURCE_DIR_STRING_U: WORD length, then UTF-16 characters
+      uint32_t stringRva = root + (nameField & ~kResourceHighBit);
+      const uint8_t *length = RvaToPointer(stringRva, 2);
+      if (!length)
+        continue;
+      uint16_t chars = Read<uint16_t>(length);
+      const uint8_t *text = RvaToPointer(stringRva + 2, (size_t)chars * 2);
+      if (!text)
+        continue;
+      link.id.id = 0;
+      for (uint16_t c = 0; c < chars; ++c)
+        link.id.name.push_back((wchar_t)Read<uint16_t>(text + c * 2));
+    } else {
+      link.id.id = (uint16_t)nameField;
+    }
+    links->push_back(std::move(link));
+  }
+}
+
+std::vector<PeImage::Resource> PeImage::ListResources() const {
+  std::vector<Resource> resources;
+  uint32_t root, size;
+  if (!GetDirectory(kDirectoryResource, &root, &size))
+    return resources;
+
+  // Type level, then name level; the language level below is not needed
+  std::vector<ResourceLink> types;
+  ReadResourceLevel(root, 0, &types);
+  for (const ResourceLink &type : types) {
+    if (!(type.target & kResourceHighBit))
+      continue;
+    std::vector<ResourceLink> names;
+    ReadResourceLevel(root, type.target & ~kResourceHighBit, &names);
+    for (const ResourceLink &name : names)
+      resources.push_back({type.id, name.id});
+  }
+  return resources;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Read-only view of a PE32/PE32+ image. Works on a module mapped by the
+// loader (RVAs are offsets) or on the raw bytes of a file on disk (RVAs are
+// translated through the section table), so the same parsing runs in the
+// proxy and in Linux tools.
+class PeImage {
+public:
+  // For a mapped module size may be 0 to trust SizeOfImage from the headers
+  bool Parse(const uint8_t *data, size_t size, bool mapped);
+
+  bool IsValid() const { return valid; }
+  bool Is64Bit() const { return is64Bit; }
+
+  // nullptr if the range is not inside the image
+  const uint8_t *RvaToPointer(uint32_t rva, size_t length = 1) const;
+
+  // Address of the import address table slot the loader filled for
+  // dllName!functionName (names compared case-insensitively for the DLL),
+  // nullptr if not imported by name. Slot width is GetThunkSize().
+  void *FindImportSlot(const char *dllName, const char *functionName) const;
+  size_t GetThunkSize() const { return is64Bit ? 8 : 4; }
+
+  // Data directory (IMAGE_DIRECTORY_ENTRY_*); false if absent
+  bool GetDirectory(int index, uint32_t *rva, uint32_t *size) const;
+
+  // A resource type or name: an integer id, or a string when id is 0
+  struct ResourceId {
+    uint16_t id;
+    std::wstring name;
+  };
+  struct Resource {
+    ResourceId type;
+    ResourceId name;
+  };
+  // Every (type, name) in the resource directory, languages merged; empty if
+  // the image has none
+  std::vector<Resource> ListResources() const;
+
+private:
+  struct ResourceLink {
+    ResourceId id;
+    uint32_t target; // High bit set for a subdirectory
+  };
+  // Entries of the IMAGE_RESOURCE_DIRECTORY at offset from root
+  void ReadResourceLevel(uint32_t root, uint32_t offset,
+                         std::vector<ResourceLink> *links) const;
+
+  const uint8_t *base = nullptr;
+  size_t imageSize = 0;
+  bool mapped = false;
+  bool valid = false;
+  bool is64Bit = false;
+
+  const uint8_t *sections = nullptr; // IMAGE_SECTION_HEADER array
+  uint16_t sectionCount = 0;
+  const uint8_t *directories = nullptr; // IMAGE_DATA_DIRECTORY array
+  uint32_t directoryCount = 0;
+};
@@ -0,0 +1,113 @@
+#pragma once
+// Thin OS layer for LosslessCore. On Windows this is <windows.h> plus a few
+// helpers; elsewhere it supplies the handful of Win32 types the core uses so
+// the same code builds for Linux tools.
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cstdint>
+
+#define WINAPI
+#define TRUE 1
+#define FALSE 0
+#ifndef MAX_PATH
+#define MAX_PATH 260
+#endif
+
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef void *LPVOID;
+typedef const wchar_t *LPCWSTR;
+
+// Opaque handles; distinct types like STRICT Win32 so overloads stay sane
+typedef struct HINSTANCE__ *HMODULE;
+typedef struct HRSRC__ *HRSRC;
+typedef void *HGLOBAL;
+
+#define IS_INTRESOURCE(r) ((((uintptr_t)(r)) >> 16) == 0)
+#define MAKEINTRESOURCEW(i) ((LPCWSTR)((uintptr_t)((WORD)(i))))
+#endif
+
+namespace Platform {
+
+// File extension of loadable addon modules (".dll" or ".so")
+extern const wchar_t *const kModuleExtension;
+
+std::filesystem::path GetHostExecutablePath();
+
+// Loads with the module's own directory on the dependency search path
+HMODULE LoadModule(const std::filesystem::path &path);
+void *GetModuleSymbol(HMODULE module, const char *name);
+void FreeModule(HMODULE module);
+
+void DebugOutput(const wchar_t *message);
+
+uint32_t GetProcessId();
+
+// A named memory segment other processes can map (a file mapping in the
+// session's Local\ namespace on Windows, POSIX shm elsewhere)
+struct SharedMemory {
+  void *data = nullptr;
+  size_t size = 0;
+  void *handle = nullptr; // The mapping, on Windows
+  std::string unlinkName; // POSIX creator: removed again on close
+};
+
+// Creates the segment zero-filled, replacing a stale one left by a crashed
+// process, and maps it read-write
+bool CreateSharedMemory(const char *name, size_t size, SharedMemory *out);
+// Maps an existing segment read-only, at its full size
+bool OpenSharedMemory(const char *name, SharedMemory *out);
+// Unmaps; the creator's close also removes the name
+void CloseSharedMemory(SharedMemory *memory);
+
+// A whole file mapped read-only. Writing into a mapped file would change
+// the bytes under the reader, so update one by writing a new file and
+// renaming it over the old. While mapped, Windows keeps the file open
+// without write sharing, so it can't be written, deleted or replaced at all.
+struct MappedFile {
+  const void *data = nullptr;
+  size_t size = 0;
+  intptr_t handle = -1; // The open file on Windows; unused elsewhere
+};
+
+// False for missing and empty files
+bool MapFile(const std::filesystem::path &path, MappedFile *out);
+void UnmapFile(MappedFile *file);
+
+// Local stream connections for the control channel: a named pipe
+// (\\.\pipe\<name>) on Windows, a Unix socket in $XDG_RUNTIME_DIR (or
+// /tmp) elsewhere, reachable only by the same user
+struct LocalConnection {
+  intptr_t handle = -1; // HANDLE or file descriptor
+};
+
+struct LocalListener {
+  intptr_t handle = -1; // Listening socket; unused on Windows
+  std::string path;     // Pipe name or socket path
+  std::atomic<bool> closing{false};
+};
+
+bool ListenLocal(const char *name, LocalListener *out);
+// Blocks until a client connects. Once CloseLocalListener was called,
+// releases the listener and returns false.
+bool AcceptLocal(LocalListener *listener, LocalConnection *out);
+// Any thread: removes the name and wakes AcceptLocal
+void CloseLocalListener(LocalListener *listener);
+bool ConnectLocal(const char *name, LocalConnection *out);
+// Bytes read; 0 at the end of the stream, on errors and after ShutdownLocal
+size_t ReadLocal(LocalConnection *connection, void *buffer, size_t size);
+bool WriteLocal(LocalConnection *connection, const void *data, size_t size);
+// Any thread: fails reads blocked on the connection without closing it
+void ShutdownLocal(LocalConnection *connection);
+void CloseLocal(LocalConnection *connection);
+
+} // namespace Platform
@@ -0,0 +1,231 @@
+#include "platform.hpp"
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <system_error>
+
+namespace Platform {
+
+const wchar_t *const kModuleExtension = L".so";
+
+std::filesystem::path GetHostExecutablePath() {
+  std::error_code ec;
+  std::filesystem::path path =
+      std::filesystem::read_symlink("/proc/self/exe", ec);
+  return ec ? std::filesystem::current_path() / "host" : path;
+}
+
+HMODULE LoadModule(const std::filesystem::path &path) {
+  // RTLD_LOCAL keeps addon symbols apart like separate DLLs would be
+  return (HMODULE)dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+}
+
+void *GetModuleSymbol(HMODULE module, const char *name) {
+  return dlsym((void *)module, name);
+}
+
+void FreeModule(HMODULE module) { dlclose((void *)module); }
+
+void DebugOutput(const wchar_t *message) {
+  std::fprintf(stderr, "%ls\n", message);
+}
+
+uint32_t GetProcessId() { return (uint32_t)getpid(); }
+
+static std::string SharedMemoryName(const char *name) {
+  return std::string("/") + name;
+}
+
+bool CreateSharedMemory(const char *name, size_t size, SharedMemory *out) {
+  // A crashed writer leaves its segment behind; start from an empty one
+  std::string path = SharedMemoryName(name);
+  shm_unlink(path.c_str());
+  int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0)
+    return false;
+  void *data = MAP_FAILED;
+  if (ftruncate(fd, (off_t)size) == 0)
+    data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    shm_unlink(path.c_str());
+    return false;
+  }
+  out->data = data;
+  out->size = size;
+  out->unlinkName = path;
+  return true;
+}
+
+bool OpenSharedMemory(const char *name, SharedMemory *out) {
+  int fd = shm_open(SharedMemoryName(name).c_str(), O_RDONLY, 0);
+  if (fd < 0)
+    return false;
+  struct stat info;
+  void *data = MAP_FAILED;
+  if (fstat(fd, &info) == 0 && info.st_size > 0)
+    data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return false;
+  out->data = data;
+  out->size = (size_t)info.st_size;
+  return true;
+}
+
+void CloseSharedMemory(SharedMemory *memory) {
+  if (memory->data)
+    munmap(memory->data, memory->size);
+  if (!memory->unlinkName.empty())
+    shm_unlink(memory->unlinkName.c_str());
+  *memory = SharedMemory();
+}
+
+bool MapFile(const std::filesystem::path &path, MappedFile *out) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat info;
+  void *data = MAP_FAILED;
+  if (fstat(fd, &info) == 0 && info.st_size > 0)
+    data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return false;
+  out->data = data;
+  out->size = (size_t)info.st_size;
+  return true;
+}
+
+void UnmapFile(MappedFile *file) {
+  if (file->data)
+    munmap((void *)file->data, file->size);
+  *file = MappedFile();
+}
+
+static std::string LocalSocketPath(const char *name) {
+  const char *dir = std::getenv("XDG_RUNTIME_DIR");
+  return std::string(dir && *dir ? dir : "/tmp") + "/" + name + ".sock";
+}
+
+static bool LocalAddress(const std::string &path, sockaddr_un *address) {
+  *address = sockaddr_un();
+  address->sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address->sun_path))
+    return false;
+  std::memcpy(address->sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+
+bool ListenLocal(const char *name, LocalListener *out) {
+  std::string path = LocalSocketPath(name);
+  sockaddr_un address;
+  if (!LocalAddress(path, &address))
+    return false;
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+    return false;
+  // A crashed host leaves its socket file behind
+  unlink(path.c_str());
+  if (bind(fd, (sockaddr *)&address, sizeof(address)) != 0 ||
+      chmod(path.c_str(), 0600) != 0 || listen(fd, 4) != 0) {
+    close(fd);
+    unlink(path.c_str());
+    return false;
+  }
+  out->handle = fd;
+  out->path = path;
+  out->closing.store(false);
+  return true;
+}
+
+bool AcceptLocal(LocalListener *listener, LocalConnection *out) {
+  int fd = (int)listener->handle;
+  while (!listener->closing.load()) {
+    // Wakes up now and then to notice CloseLocalListener
+    pollfd ready = {fd, POLLIN, 0};
+    if (poll(&ready, 1, 100) <= 0)
+      continue;
+    int client = accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client >= 0) {
+      out->handle = client;
+      return true;
+    }
+  }
+  close(fd);
+  listener->handle = -1;
+  return false;
+}
+
+void CloseLocalListener(LocalListener *listener) {
+  if (!listener->closing.exchange(true))
+    unlink(listener->path.c_str());
+}
+
+bool ConnectLocal(const char *name, LocalConnection *out) {
+  sockaddr_un address;
+  if (!LocalAddress(LocalSocketPath(name), &address))
+    return false;
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+    return false;
+  if (connect(fd, (sockaddr *)&address, sizeof(address)) != 0) {
+    close(fd);
+    return false;
+  }
+  out->handle = fd;
+  return true;
+}
+
+size_t ReadLocal(LocalConnection *connection, void *buffer, size_t size) {
+  for (;;) {
+    ssize_t read = recv((int)connection->handle, buffer, size, 0);
+    if (read >= 0)
+      return (size_t)read;
+    if (errno != EINTR)
+      return 0;
+  }
+}
+
+bool WriteLocal(LocalConnection *connection, const void *data, size_t size) {
+  const char *bytes = (const char *)data;
+  while (size > 0) {
+    // No SIGPIPE for a client that went away
+    ssize_t written =
+        send((int)connection->handle, bytes, size, MSG_NOSIGNAL);
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written <= 0)
+      return false;
+    bytes += written;
+    size -= (size_t)written;
+  }
+  return true;
+}
+
+void ShutdownLocal(LocalConnection *connection) {
+  if (connection->handle >= 0)
+    shutdown((int)connection->handle, SHUT_RDWR);
+}
+
+void CloseLocal(LocalConnection *connection) {
+  if (connection->handle >= 0)
+    close((int)connection->handle);
+  connection->handle = -1;
+}
+
+} // namespace Platform
+
+#endif // !_WIN32
@@ -0,0 +1,260 @@
+#include "platform.hpp"
+
+#ifdef _WIN32
+
+#include <algorithm>
+
+namespace Platform {
+
+const wchar_t *const kModuleExtension = L".dll";
+
+std::filesystem::path GetHostExecutablePath() {
+  wchar_t buffer[MAX_PATH];
+  GetModuleFileNameW(NULL, buffer, MAX_PATH);
+  return std::filesystem::path(buffer);
+}
+
+HMODULE LoadModule(const std::filesystem::path &path) {
+  // Use LoadLibraryEx with LOAD_WITH_ALTERED_SEARCH_PATH to ensure dependencies
+  // in the same directory are found.
+  HMODULE module =
+      LoadLibraryExW(path.c_str(), NULL, LOAD_WITH_ALTERED_SEARCH_PATH);
+  if (!module) {
+    module = LoadLibraryW(path.c_str());
+  }
+  return module;
+}
+
+void *GetModuleSymbol(HMODULE module, const char *name) {
+  return (void *)GetProcAddress(module, name);
+}
+
+void FreeModule(HMODULE module) { FreeLibrary(module); }
+
+void DebugOutput(const wchar_t *message) {
+  OutputDebugStringW(message);
+  OutputDebugStringW(L"\n");
+}
+
+uint32_t GetProcessId() { return (uint32_t)GetCurrentProcessId(); }
+
+static std::wstring SharedMemoryName(const char *name) {
+  std::wstring wide = L"Local\\";
+  for (; *name; ++name)
+    wide += (wchar_t)(unsigned char)*name;
+  return wide;
+}
+
+bool CreateSharedMemory(const char *name, size_t size, SharedMemory *out) {
+  std::wstring mappingName = SharedMemoryName(name);
+  HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr,
+                                      PAGE_READWRITE,
+                                      (DWORD)((uint64_t)size >> 32),
+                                      (DWORD)size, mappingName.c_str());
+  if (!mapping)
+    return false;
+  // Another instance owns the name (or a reader still maps a dead one's
+  // segment): two writers would tear each other's snapshots
+  if (GetLastError() == ERROR_ALREADY_EXISTS) {
+    CloseHandle(mapping);
+    return false;
+  }
+  void *data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+  if (!data) {
+    CloseHandle(mapping);
+    return false;
+  }
+  out->data = data; // Fresh pagefile-backed sections are zero-filled
+  out->size = size;
+  out->handle = mapping;
+  return true;
+}
+
+bool OpenSharedMemory(const char *name, SharedMemory *out) {
+  HANDLE mapping =
+      OpenFileMappingW(FILE_MAP_READ, FALSE, SharedMemoryName(name).c_str());
+  if (!mapping)
+    return false;
+  void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  MEMORY_BASIC_INFORMATION info;
+  if (!data || !VirtualQuery(data, &info, sizeof(info))) {
+    if (data)
+      UnmapViewOfFile(data);
+    CloseHandle(mapping);
+    return false;
+  }
+  out->data = data;
+  out->size = info.RegionSize;
+  out->handle = mapping;
+  return true;
+}
+
+void CloseSharedMemory(SharedMemory *memory) {
+  if (memory->data)
+    UnmapViewOfFile(memory->data);
+  if (memory->handle)
+    CloseHandle((HANDLE)memory->handle);
+  *memory = SharedMemory();
+}
+
+bool MapFile(const std::filesystem::path &path, MappedFile *out) {
+  // No FILE_SHARE_WRITE, and the handle stays open until UnmapFile: a
+  // writer would change bytes Lossless already holds
+  HANDLE file = CreateFileW(path.c_str(), GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+  LARGE_INTEGER size;
+  HANDLE mapping = nullptr;
+  if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    CloseHandle(file);
+    return false;
+  }
+  // The view keeps the section open by itself
+  void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (!data) {
+    CloseHandle(file);
+    return false;
+  }
+  out->data = data;
+  out->size = (size_t)size.QuadPart;
+  out->handle = (intptr_t)file;
+  return true;
+}
+
+void UnmapFile(MappedFile *file) {
+  if (file->data)
+    UnmapViewOfFile(file->data);
+  if (file->handle != -1)
+    CloseHandle((HANDLE)file->handle);
+  *file = MappedFile();
+}
+
+static std::wstring PipeName(const std::string &path) {
+  std::wstring wide;
+  for (char c : path)
+    wide += (wchar_t)(unsigned char)c;
+  return wide;
+}
+
+static HANDLE CreatePipeInstance(const std::string &path, DWORD flags) {
+  return CreateNamedPipeW(PipeName(path).c_str(), PIPE_ACCESS_DUPLEX | flags,
+                          PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT |
+                              PIPE_REJECT_REMOTE_CLIENTS,
+                          PIPE_UNLIMITED_INSTANCES, 4096, 4096, 0, nullptr);
+}
+
+bool ListenLocal(const char *name, LocalListener *out) {
+  std::string path = std::string("\\\\.\\pipe\\") + name;
+  // The first instance claims the name, so a second host fails here
+  HANDLE instance = CreatePipeInstance(path, FILE_FLAG_FIRST_PIPE_INSTANCE);
+  if (instance == INVALID_HANDLE_VALUE)
+    return false;
+  out->handle = (intptr_t)instance;
+  out->path = path;
+  out->closing.store(false);
+  return true;
+}
+
+bool AcceptLocal(LocalListener *listener, LocalConnection *out) {
+  // Each client takes the waiting instance; the next one is made on demand
+  while (!listener->closing.load()) {
+    HANDLE instance = (HANDLE)listener->handle;
+    if (instance == INVALID_HANDLE_VALUE) {
+      instance = CreatePipeInstance(listener->path, 0);
+      if (instance == INVALID_HANDLE_VALUE)
+        break;
+      listener->handle = (intptr_t)instance;
+    }
+    bool connected = ConnectNamedPipe(instance, nullptr) ||
+                     GetLastError() == ERROR_PIPE_CONNECTED;
+    if (listener->closing.load())
+      break; // CloseLocalListener's own wake-up connection
+    if (connected) {
+      out->handle = (intptr_t)instance;
+      listener->handle = -1;
+      return true;
+    }
+    DisconnectNamedPipe(instance);
+  }
+  if ((HANDLE)listener->handle != INVALID_HANDLE_VALUE)
+    CloseHandle((HANDLE)listener->handle);
+  listener->handle = -1;
+  return false;
+}
+
+void CloseLocalListener(LocalListener *listener) {
+  if (listener->closing.exchange(true))
+    return;
+  // ConnectNamedPipe has no timeout: connect to it to wake it. Between two
+  // clients there may briefly be no instance to connect to.
+  std::wstring pipe = PipeName(listener->path);
+  for (int attempt = 0; attempt < 10; ++attempt) {
+    HANDLE wake = CreateFileW(pipe.c_str(), GENERIC_READ | GENERIC_WRITE, 0,
+                              nullptr, OPEN_EXISTING, 0, nullptr);
+    if (wake != INVALID_HANDLE_VALUE) {
+      CloseHandle(wake);
+      return;
+    }
+    Sleep(10);
+  }
+}
+
+bool ConnectLocal(const char *name, LocalConnection *out) {
+  std::wstring pipe = PipeName(std::string("\\\\.\\pipe\\") + name);
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    HANDLE handle = CreateFileW(pipe.c_str(), GENERIC_READ | GENERIC_WRITE,
+                                0, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (handle != INVALID_HANDLE_VALUE) {
+      out->handle = (intptr_t)handle;
+      return true;
+    }
+    // Another client holds the only instance
+    if (GetLastError() != ERROR_PIPE_BUSY ||
+        !WaitNamedPipeW(pipe.c_str(), 2000))
+      return false;
+  }
+  return false;
+}
+
+size_t ReadLocal(LocalConnection *connection, void *buffer, size_t size) {
+  DWORD read = 0;
+  if (!ReadFile((HANDLE)connection->handle, buffer,
+                (DWORD)(std::min<size_t>)(size, MAXDWORD), &read, nullptr))
+    return 0;
+  return read;
+}
+
+bool WriteLocal(LocalConnection *connection, const void *data, size_t size) {
+  const char *bytes = (const char *)data;
+  while (size > 0) {
+    DWORD written = 0;
+    if (!WriteFile((HANDLE)connection->handle, bytes,
+                   (DWORD)(std::min<size_t>)(size, MAXDWORD), &written,
+                   nullptr) ||
+        written == 0)
+      return false;
+    bytes += written;
+    size -= written;
+  }
+  return true;
+}
+
+void ShutdownLocal(LocalConnection *connection) {
+  if (connection->handle != -1)
+    CancelIoEx((HANDLE)connection->handle, nullptr);
+}
+
+void CloseLocal(LocalConnection *connection) {
+  if (connection->handle != -1)
+    CloseHandle((HANDLE)connection->handle);
+  connection->handle = -1;
+}
+
+} // namespace Platform
+
+#endif // _WIN32
@@ -0,0 +1,23 @@
+#include "process_exit.hpp"
+#include <chrono>
+#include <thread>
+
+namespace ProcessExit {
+
+static std::atomic<bool> g_exiting{false};
+
+void SetExiting(bool exiting) { g_exiting.store(exiting); }
+
+bool IsExiting() { return g_exiting.load(std::memory_order_relaxed); }
+
+bool WaitForThreadExit(const std::atomic<bool> &exited) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  while (!exited.load(std::memory_order_acquire)) {
+    if (IsExiting() || std::chrono::steady_clock::now() >= deadline)
+      return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+} // namespace ProcessExit
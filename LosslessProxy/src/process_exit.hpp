@@ -0,0 +1,20 @@
+#pragma once
+#include <atomic>
+
+// Shutdown from DllMain. Threads are stopped by waiting for a flag they set
+// on the way out, not by join(), which deadlocks on the loader lock. When the
+// process is terminating the other threads are already gone, perhaps
+// without setting their flag, so nothing is waited for at all then.
+namespace ProcessExit {
+
+// From DllMain when its lpReserved says the process is terminating. Tests
+// clear it again.
+void SetExiting(bool exiting = true);
+bool IsExiting();
+
+// Waits for a thread to set exited, up to a second, and not at all once the
+// process is exiting. False if it never did: the thread may still use what
+// it was given, so leave that to the OS.
+bool WaitForThreadExit(const std::atomic<bool> &exited);
+
+} // namespace ProcessExit
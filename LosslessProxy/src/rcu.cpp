@@ -0,0 +1,36 @@
+#include "rcu.hpp"
+#include "process_exit.hpp"
+#include <thread>
+
+// All seq_cst: a reader that validated the epoch before Synchronize flipped
+// it has its count seen by Synchronize, and one that validated after reads
+// the pointer published before the flip.
+
+RcuDomain::ReadScope::ReadScope(const RcuDomain &domain) : domain(domain) {
+  for (;;) {
+    uint32_t current = domain.epoch.load();
+    slot = current & 1;
+    domain.readers[slot].count.fetch_add(1);
+    if (domain.epoch.load() == current)
+      return;
+    // Flipped in between: Synchronize may already have seen this parity
+    // drain, so count under the new one instead
+    domain.readers[slot].count.fetch_sub(1);
+  }
+}
+
+RcuDomain::ReadScope::~ReadScope() {
+  domain.readers[slot].count.fetch_sub(1, std::memory_order_release);
+}
+
+bool RcuDomain::Synchronize() {
+  std::lock_guard<std::mutex> guard(writerLock);
+  uint32_t previous = epoch.load();
+  epoch.store(previous + 1);
+  while (readers[previous & 1].count.load() != 0) {
+    if (ProcessExit::IsExiting())
+      return false;
+    std::this_thread::yield();
+  }
+  return true;
+}
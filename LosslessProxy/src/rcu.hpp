@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+// Read-copy-update for state the hook threads read while the GUI thread
+// replaces it. Readers bracket their use of a published pointer with a
+// ReadScope, which costs two atomic increments and never waits. A writer
+// publishes the replacement and then calls Synchronize, which returns once
+// every reader that could still see the old version has left its scope.
+// Only then is the old version (and any module its function pointers lead
+// into) freed.
+//
+// Readers count themselves under the parity of the current epoch.
+// Synchronize flips the epoch and waits for the old parity to drain, so
+// readers arriving meanwhile can't hold it up.
+//
+// At process termination the other threads are gone, perhaps inside a
+// scope they will never leave. Once ProcessExit::SetExiting is called,
+// Synchronize gives up instead of waiting and the caller leaks the old
+// version.
+class RcuDomain {
+public:
+  class ReadScope {
+  public:
+    explicit ReadScope(const RcuDomain &domain);
+    ~ReadScope();
+    ReadScope(const ReadScope &) = delete;
+    ReadScope &operator=(const ReadScope &) = delete;
+
+  private:
+    const RcuDomain &domain;
+    uint32_t slot;
+  };
+
+  RcuDomain() = default;
+  RcuDomain(const RcuDomain &) = delete;
+  RcuDomain &operator=(const RcuDomain &) = delete;
+
+  // Never from inside a ReadScope of this domain: it would wait for itself.
+  // False only after ProcessExit::SetExiting, if a reader is still counted.
+  bool Synchronize();
+
+private:
+  struct alignas(64) Readers {
+    std::atomic<uint32_t> count{0};
+  };
+
+  mutable Readers readers[2];
+  std::atomic<uint32_t> epoch{0};
+  std::mutex writerLock;
+};
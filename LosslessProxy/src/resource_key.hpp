@@ -0,0 +1,34 @@
+#pragma once
+#include "content_hash.hpp"
+#include "platform.hpp"
+#include <cwchar>
+#include <filesystem>
+#include <string>
+
+// Text key for a FindResource (name, type) pair: "type\tname", with "#123"
+// for integer ids as FindResource itself accepts and UTF-8 otherwise
+inline std::string ResourceKeyPart(LPCWSTR value) {
+  if (IS_INTRESOURCE(value))
+    return "#" + std::to_string((uintptr_t)value);
+  return std::filesystem::path(value).u8string();
+}
+
+inline std::string MakeResourceKey(LPCWSTR name, LPCWSTR type) {
+  return ResourceKeyPart(type) + "\t" + ResourceKeyPart(name);
+}
+
+// Hash-map key for the same pair without building the text: exact for
+// integer ids, a hash for string names (compare MakeResourceKey on a hit)
+inline uint64_t ResourceLookupKey(LPCWSTR name, LPCWSTR type) {
+  static const uint64_t kIdsOnly = 1ull << 63;
+  if (IS_INTRESOURCE(name) && IS_INTRESOURCE(type))
+    return kIdsOnly | ((uint64_t)(uintptr_t)type << 16) | (uintptr_t)name;
+  uint64_t hash = 0;
+  for (LPCWSTR part : {type, name}) {
+    if (IS_INTRESOURCE(part))
+      hash = HashMix(hash, (uintptr_t)part);
+    else
+      hash = HashBytes(hash, part, std::wcslen(part) * sizeof(wchar_t));
+  }
+  return hash & ~kIdsOnly;
+}
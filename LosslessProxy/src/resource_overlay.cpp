@@ -0,0 +1,262 @@
+#include "resource_overlay.hpp"
+#include "ini_file.hpp"
+#include "process_exit.hpp"
+#include "resource_key.hpp"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Decimal text is an integer id, as "#123" is to FindResourceW
+static LPCWSTR IdOrName(const std::wstring &text) {
+  if (text.empty() || text.size() > 5)
+    return text.c_str();
+  uint32_t value = 0;
+  for (wchar_t c : text) {
+    if (c < L'0' || c > L'9')
+      return text.c_str();
+    value = value * 10 + (uint32_t)(c - L'0');
+  }
+  return value && value <= 0xFFFF ? MAKEINTRESOURCEW(value) : text.c_str();
+}
+
+// Subdirectories (or files) of dir; missing directories list as empty and
+// entries that vanish mid-scan are skipped, so a rescan never throws
+static std::vector<fs::directory_entry> ListDirectory(const fs::path &dir,
+                                                      bool directories) {
+  std::vector<fs::directory_entry> entries;
+  std::error_code ec;
+  for (fs::directory_iterator it(dir, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    std::error_code typeError;
+    bool match = directories ? it->is_directory(typeError)
+                             : it->is_regular_file(typeError);
+    if (match && !typeError)
+      entries.push_back(*it);
+  }
+  return entries;
+}
+
+ResourceOverlay::~ResourceOverlay() { Stop(); }
+
+void ResourceOverlay::Start(const fs::path &addonsDirectory,
+                            const fs::path &configPath, uint32_t poll) {
+  if (thread.joinable())
+    return;
+  addonsPath = addonsDirectory;
+  configFilePath = configPath;
+  pollMs = poll;
+  Refresh();
+  // Nothing to watch: no thread rereading the folders every pollMs
+  {
+    std::lock_guard<std::mutex> guard(refreshLock);
+    if (!pollMs || !resourceFolders)
+      return;
+  }
+  stopRequested = false;
+  exited.store(false);
+  thread = std::thread([this]() { Loop(); });
+}
+
+void ResourceOverlay::Stop() {
+  if (thread.joinable()) {
+    {
+      std::lock_guard<std::mutex> guard(stopLock);
+      stopRequested = true;
+    }
+    stopSignal.notify_all();
+    bool finished = ProcessExit::WaitForThreadExit(exited);
+    thread.detach();
+    if (!finished)
+      return; // Still rescanning: leave the mappings to the OS
+  }
+
+  active.store(false);
+  const Index *previous = index.exchange(nullptr);
+  if (!indexRcu.Synchronize())
+    return; // A dead reader may hold the index: leave it to the OS
+  delete previous;
+  files.store(0);
+
+  std::lock_guard<std::mutex> guard(mapLock);
+  for (auto &chunk : chunks) {
+    Platform::MappedFile *mappings = chunk.exchange(nullptr);
+    if (!mappings)
+      continue;
+    for (uint32_t i = 0; i < kSlotsPerChunk; ++i)
+      Platform::UnmapFile(&mappings[i]);
+    delete[] mappings;
+  }
+  slotCount = 0;
+  mappedBytes = 0;
+}
+
+void ResourceOverlay::Loop() {
+  std::unique_lock<std::mutex> guard(stopLock);
+  while (!stopSignal.wait_for(guard, std::chrono::milliseconds(pollMs),
+                              [this]() { return stopRequested; })) {
+    guard.unlock();
+    Refresh();
+    guard.lock();
+  }
+  exited.store(true, std::memory_order_release);
+}
+
+bool ResourceOverlay::Refresh() {
+  std::lock_guard<std::mutex> guard(refreshLock);
+  IniFile config;
+  config.Load(configFilePath);
+
+  std::vector<fs::path> folders;
+  for (const fs::directory_entry &entry : ListDirectory(addonsPath, true)) {
+    std::string name = entry.path().filename().u8string();
+    if (config.GetInt("Addons", name, 1) != 0)
+      folders.push_back(entry.path());
+  }
+  std::sort(folders.begin(), folders.end());
+  resourceFolders = (uint32_t)std::count_if(
+      folders.begin(), folders.end(), [](const fs::path &folder) {
+        std::error_code ec;
+        return fs::is_directory(folder / "resources", ec);
+      });
+
+  // Files whose size and write time match keep their entry, and with it
+  // their mapping
+  const Index *current = index.load(std::memory_order_acquire);
+  auto next = std::make_unique<Index>();
+  bool changed = current == nullptr;
+  for (const fs::path &folder : folders) {
+    for (const fs::directory_entry &typeDir :
+         ListDirectory(folder / "resources", true)) {
+      std::wstring typeText = typeDir.path().filename().wstring();
+      LPCWSTR type = IdOrName(typeText);
+      for (const fs::directory_entry &entry :
+           ListDirectory(typeDir.path(), false)) {
+        if (entry.path().extension() != ".bin")
+          continue;
+        std::wstring nameText = entry.path().stem().wstring();
+        LPCWSTR name = IdOrName(nameText);
+        uint64_t key = ResourceLookupKey(name, type);
+        if (next->count(key))
+          continue; // An earlier folder has it
+        std::error_code ec;
+        uintmax_t size = entry.file_size(ec);
+        fs::file_time_type writeTime = entry.last_write_time(ec);
+        if (ec)
+          continue;
+
+        std::shared_ptr<File> file;
+        if (current) {
+          auto it = current->find(key);
+          if (it != current->end() && it->second->path == entry.path() &&
+              it->second->size == size && it->second->writeTime == writeTime)
+            file = it->second;
+        }
+        if (!file) {
+          file = std::make_shared<File>();
+          file->path = entry.path();
+          file->key = MakeResourceKey(name, type);
+          file->size = size;
+          file->writeTime = writeTime;
+          changed = true;
+        }
+        (*next)[key] = std::move(file);
+      }
+    }
+  }
+  // Only reused entries left: any difference is a removal
+  changed = changed || next->size() != current->size();
+  if (!changed)
+    return false;
+
+  files.store((uint32_t)next->size());
+  active.store(!next->empty());
+  const Index *previous = index.exchange(next.release());
+  indexRcu.Synchronize();
+  delete previous;
+  rescans.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+uint32_t ResourceOverlay::Find(LPCWSTR name, LPCWSTR type, const void **data,
+                               uint32_t *size) {
+  if (!active.load(std::memory_order_relaxed))
+    return 0;
+  uint32_t slot;
+  {
+    RcuDomain::ReadScope scope(indexRcu);
+    const Index *current = index.load(std::memory_order_acquire);
+    if (!current)
+      return 0;
+    auto it = current->find(ResourceLookupKey(name, type));
+    if (it == current->end())
+      return 0;
+    File &file = *it->second;
+    if ((!IS_INTRESOURCE(name) || !IS_INTRESOURCE(type)) &&
+        file.key != MakeResourceKey(name, type))
+      return 0;
+    slot = file.slot.load(std::memory_order_acquire);
+    if (!slot)
+      slot = MapSlot(file);
+  }
+  if (slot == kFailed || !Get(slot, data, size))
+    return 0;
+  served.fetch_add(1, std::memory_order_relaxed);
+  return slot;
+}
+
+uint32_t ResourceOverlay::MapSlot(File &file) {
+  std::lock_guard<std::mutex> guard(mapLock);
+  uint32_t slot = file.slot.load(std::memory_order_relaxed);
+  if (slot)
+    return slot; // Another thread mapped it meanwhile
+
+  Platform::MappedFile mapping;
+  if (slotCount >= kMaxSlots || !Platform::MapFile(file.path, &mapping)) {
+    file.slot.store(kFailed, std::memory_order_release);
+    return kFailed;
+  }
+  if (mapping.size > UINT32_MAX) {
+    Platform::UnmapFile(&mapping);
+    file.slot.store(kFailed, std::memory_order_release);
+    return kFailed;
+  }
+  uint32_t position = slotCount++;
+  std::atomic<Platform::MappedFile *> &chunk =
+      chunks[position / kSlotsPerChunk];
+  Platform::MappedFile *mappings = chunk.load(std::memory_order_relaxed);
+  if (!mappings) {
+    mappings = new Platform::MappedFile[kSlotsPerChunk];
+    chunk.store(mappings, std::memory_order_release);
+  }
+  mappings[position % kSlotsPerChunk] = mapping;
+  mappedBytes += mapping.size;
+  file.slot.store(position + 1, std::memory_order_release);
+  return position + 1;
+}
+
+bool ResourceOverlay::Get(uint32_t slot, const void **data,
+                          uint32_t *size) const {
+  if (slot == 0 || slot > kMaxSlots)
+    return false;
+  const Platform::MappedFile *mappings =
+      chunks[(slot - 1) / kSlotsPerChunk].load(std::memory_order_acquire);
+  if (!mappings || !mappings[(slot - 1) % kSlotsPerChunk].data)
+    return false;
+  const Platform::MappedFile &mapping = mappings[(slot - 1) % kSlotsPerChunk];
+  *data = mapping.data;
+  *size = (uint32_t)mapping.size;
+  return true;
+}
+
+ResourceOverlay::Stats ResourceOverlay::GetStats() const {
+  Stats stats = {};
+  stats.files = files.load(std::memory_order_relaxed);
+  stats.served = served.load(std::memory_order_relaxed);
+  stats.rescans = rescans.load(std::memory_order_relaxed);
+  std::lock_guard<std::mutex> guard(mapLock);
+  stats.mapped = slotCount;
+  stats.mappedBytes = mappedBytes;
+  return stats;
+}
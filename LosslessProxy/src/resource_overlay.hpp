@@ -0,0 +1,108 @@
+#pragma once
+#include "platform.hpp"
+#include "rcu.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// Resource replacements shipped as plain files instead of addon code:
+// <addons>/<folder>/resources/<type>/<name>.bin, where a decimal type or
+// name is an integer id (resources/10/123.bin is RCDATA #123) and anything
+// else a string. Start indexes every folder not disabled under [Addons] in
+// addons_config.ini; when two ship the same resource, the first folder by
+// name wins. A file is mapped read-only the first time Lossless asks for
+// it, and the hooks hand out pointers straight into the mapping. When any
+// indexed folder has a resources/ directory, a background thread rescans
+// the folders and reindexes only what changed; without one, a folder that
+// gains it is only picked up by the next Start or Refresh.
+// Since Lossless may keep a pointer it was given, a replaced file's old
+// mapping stays until Stop. Files must be updated by renaming a new one over
+// them, not written in place (see Platform::MappedFile).
+class ResourceOverlay {
+public:
+  struct Stats {
+    uint32_t files;       // Indexed
+    uint32_t mapped;      // Mappings made, replaced versions included
+    uint64_t mappedBytes;
+    uint64_t served;      // FindResourceW calls answered
+    uint32_t rescans;     // That found a change
+  };
+
+  static constexpr uint32_t kDefaultPollMs = 1000;
+  // Handles carry the slot; 16 bits of them on 32-bit builds
+  static constexpr uint32_t kMaxSlots = 0xFFFF;
+
+  ResourceOverlay() = default;
+  ~ResourceOverlay();
+  ResourceOverlay(const ResourceOverlay &) = delete;
+  ResourceOverlay &operator=(const ResourceOverlay &) = delete;
+
+  // Indexes once, then rescans every pollMs until Stop (0: never), if
+  // there is anything to rescan
+  void Start(const std::filesystem::path &addonsDirectory,
+             const std::filesystem::path &configPath, uint32_t pollMs);
+  // Safe from DllMain: never joins. Unmaps everything.
+  void Stop();
+  // Rescans now; false if nothing changed
+  bool Refresh();
+
+  // Hook side, lock-free once a file is mapped. Returns the slot serving
+  // the resource (0 for none) and its bytes.
+  uint32_t Find(LPCWSTR name, LPCWSTR type, const void **data,
+                uint32_t *size);
+  // Bytes of a slot Find returned; valid until Stop
+  bool Get(uint32_t slot, const void **data, uint32_t *size) const;
+
+  Stats GetStats() const;
+
+private:
+  struct File {
+    std::filesystem::path path;
+    std::string key; // MakeResourceKey, checked for string names
+    uintmax_t size = 0;
+    std::filesystem::file_time_type writeTime;
+    std::atomic<uint32_t> slot{0}; // 0 until mapped, kFailed if unmappable
+  };
+  typedef std::unordered_map<uint64_t, std::shared_ptr<File>> Index;
+
+  static constexpr uint32_t kFailed = ~0u;
+  static constexpr uint32_t kSlotsPerChunk = 1024;
+  static constexpr uint32_t kChunks =
+      (kMaxSlots + kSlotsPerChunk - 1) / kSlotsPerChunk;
+
+  uint32_t MapSlot(File &file);
+  void Loop();
+
+  std::filesystem::path addonsPath;
+  std::filesystem::path configFilePath;
+  uint32_t pollMs = kDefaultPollMs;
+  uint32_t resourceFolders = 0; // Under refreshLock
+
+  // Replaced whole by Refresh; freed after an RCU grace period
+  std::atomic<const Index *> index{nullptr};
+  std::atomic<bool> active{false}; // Index has files: skips the scope
+  RcuDomain indexRcu;
+  std::mutex refreshLock;
+
+  // Append-only, so Get needs no lock
+  std::atomic<Platform::MappedFile *> chunks[kChunks] = {};
+  mutable std::mutex mapLock;
+  uint32_t slotCount = 0;
+  uint64_t mappedBytes = 0;
+
+  std::atomic<uint32_t> files{0};
+  std::atomic<uint64_t> served{0};
+  std::atomic<uint32_t> rescans{0};
+
+  std::thread thread;
+  std::mutex stopLock;
+  std::condition_variable stopSignal;
+  bool stopRequested = false;
+  std::atomic<bool> exited{false};
+};
@@ -0,0 +1,230 @@
+#include "resource_prefetch.hpp"
+#include "addon_manager.hpp"
+#include "process_exit.hpp"
+#include "resource_key.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+static uint64_t NowNanos() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Holds the wide strings a parsed key points into
+struct ParsedKey {
+  std::wstring nameText, typeText;
+  LPCWSTR name = nullptr, type = nullptr;
+};
+
+// False for an id that can't be one (#0, or past 0xFFFF): the log is a
+// plain file and may have been edited or cut short
+static bool ParsePart(const std::string &part, std::wstring *storage,
+                      LPCWSTR *out) {
+  if (part.size() > 1 && part[0] == '#' &&
+      std::all_of(part.begin() + 1, part.end(), ::isdigit)) {
+    if (part.size() > 6)
+      return false;
+    unsigned long value = std::strtoul(part.c_str() + 1, nullptr, 10);
+    if (value == 0 || value > 0xFFFF)
+      return false;
+    *out = MAKEINTRESOURCEW(value);
+    return true;
+  }
+  *storage = fs::u8path(part).wstring();
+  *out = storage->c_str();
+  return true;
+}
+
+static bool ParseKey(const std::string &key, ParsedKey *out) {
+  size_t tab = key.find('\t');
+  if (tab == std::string::npos || tab == 0 || tab + 1 == key.size())
+    return false;
+  return ParsePart(key.substr(0, tab), &out->typeText, &out->type) &&
+         ParsePart(key.substr(tab + 1), &out->nameText, &out->name);
+}
+
+// FNV-1a over the sorted enabled addon names
+static std::string ProfileName(AddonManager *manager) {
+  std::vector<std::string> names;
+  for (const AddonInfo &addon : manager->GetAddons()) {
+    if (addon.enabled)
+      names.push_back(fs::path(addon.name).u8string());
+  }
+  std::sort(names.begin(), names.end());
+  uint64_t hash = 1469598103934665603ull;
+  for (const std::string &name : names) {
+    for (unsigned char c : name + "\n") {
+      hash ^= c;
+      hash *= 1099511628211ull;
+    }
+  }
+  char text[17];
+  std::snprintf(text, sizeof(text), "%016llx", (unsigned long long)hash);
+  return text;
+}
+
+ResourcePrefetcher::~ResourcePrefetcher() { Stop(); }
+
+void ResourcePrefetcher::Start(AddonManager *addonManager) {
+  if (worker.joinable() || !addonManager)
+    return;
+  manager = addonManager;
+  logPath = manager->GetAddonsDirectory() / "prefetch" /
+            (ProfileName(manager) + ".log");
+
+  std::vector<std::string> order;
+  std::ifstream in(logPath);
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    ParsedKey parsed;
+    if (ParseKey(line, &parsed))
+      order.push_back(line);
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    warmed.clear();
+    sessionOrder.clear();
+    sessionSeen.clear();
+    stats = Stats();
+    stats.logged = (uint32_t)order.size();
+    stats.running = !order.empty();
+  }
+  available.store(0);
+  stopRequested.store(false);
+  workerExited.store(false);
+  if (order.empty())
+    return;
+  worker = std::thread([this, order]() { Warm(order); });
+}
+
+void ResourcePrefetcher::Warm(std::vector<std::string> order) {
+  uint64_t started = NowNanos();
+  for (const std::string &key : order) {
+    if (stopRequested.load(std::memory_order_relaxed))
+      break;
+    {
+      // The game got there first; the hook already called the addons
+      std::lock_guard<std::mutex> guard(lock);
+      if (sessionSeen.count(key))
+        continue;
+    }
+
+    ParsedKey parsed;
+    ParseKey(key, &parsed);
+    const void *data = nullptr;
+    uint32_t size = 0;
+    uint64_t callStarted = NowNanos();
+    AddonManager::DispatchScope scope(*manager); // Until data is copied
+    uint64_t stamp = scope.InterceptStamp();
+    bool intercepted =
+        manager->InterceptResource(parsed.name, parsed.type, &data, &size);
+    uint64_t nanos = NowNanos() - callStarted;
+    if (!intercepted || !data || size == 0)
+      continue;
+    if (scope.InterceptStamp() != stamp)
+      continue; // Settings changed under the call: the answer may be either
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (sessionSeen.count(key))
+      continue;
+    Entry &entry = warmed[key];
+    entry.data.assign((const uint8_t *)data, (const uint8_t *)data + size);
+    entry.nanos = nanos;
+    entry.stamp = stamp;
+    stats.warmed++;
+    available.fetch_add(1, std::memory_order_release);
+  }
+
+  std::lock_guard<std::mutex> guard(lock);
+  stats.warmupNanos = NowNanos() - started;
+  stats.running = false;
+  workerExited.store(true, std::memory_order_release);
+}
+
+void ResourcePrefetcher::Stop() {
+  stopRequested.store(true);
+  bool finished = true;
+  if (worker.joinable()) {
+    // This runs from DllMain on unload (see ProcessExit)
+    finished = ProcessExit::WaitForThreadExit(workerExited);
+    worker.detach();
+  }
+  if (manager) {
+    // A worker still running may hold the lock SaveLog needs
+    if (finished)
+      SaveLog();
+    manager = nullptr;
+  }
+}
+
+void ResourcePrefetcher::SaveLog() {
+  std::vector<std::string> order;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    // A session that never reached the game's shader loads keeps the old log
+    if (sessionOrder.empty())
+      return;
+    order = sessionOrder;
+  }
+
+  std::error_code ec;
+  fs::create_directories(logPath.parent_path(), ec);
+  std::ofstream out(logPath, std::ios::out | std::ios::trunc);
+  for (const std::string &key : order) {
+    out << key << '\n';
+  }
+}
+
+void ResourcePrefetcher::NoteIntercept(LPCWSTR name, LPCWSTR type, bool hit) {
+  std::string key = MakeResourceKey(name, type);
+  std::lock_guard<std::mutex> guard(lock);
+  if (!sessionSeen.insert(key).second)
+    return; // Only the first request per resource counts
+  sessionOrder.push_back(key);
+  if (!hit)
+    stats.misses++;
+}
+
+bool ResourcePrefetcher::Take(LPCWSTR name, LPCWSTR type,
+                              const AddonManager::DispatchScope &scope,
+                              std::vector<uint8_t> *data) {
+  // Keeps the common case (nothing warmed or left) free of locks and strings
+  if (available.load(std::memory_order_acquire) == 0)
+    return false;
+
+  std::string key = MakeResourceKey(name, type);
+  uint64_t stamp = scope.InterceptStamp(); // Addon code: not under the lock
+  std::lock_guard<std::mutex> guard(lock);
+  auto it = warmed.find(key);
+  if (it == warmed.end() || it->second.taken)
+    return false;
+  if (it->second.stamp != stamp) {
+    // An addon was toggled, reloaded or changed its settings since
+    it->second.taken = true;
+    it->second.data.clear();
+    it->second.data.shrink_to_fit();
+    available.fetch_sub(1, std::memory_order_relaxed);
+    stats.stale++;
+    return false;
+  }
+  data->swap(it->second.data);
+  it->second.taken = true;
+  available.fetch_sub(1, std::memory_order_relaxed);
+  stats.hits++;
+  stats.savedNanos += it->second.nanos;
+  return true;
+}
+
+ResourcePrefetcher::Stats ResourcePrefetcher::GetStats() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return stats;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "addon_manager.hpp"
+#include "platform.hpp"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Warms addon intercept results ahead of the game's own requests. Each
+// profile (the set of enabled addons) keeps a log of the resources addons
+// intercepted, in first-request order. Start() replays that log on a
+// background thread through AddonManager::InterceptResource; the first
+// real FindResourceW for a warmed resource then takes the stored bytes
+// instead of calling the addons again. Warmed results are used once, so
+// later requests still see an addon's current output, and only while the
+// dispatch and addon settings they were produced under are current.
+class ResourcePrefetcher {
+public:
+  struct Stats {
+    uint32_t logged;      // Entries in the profile's access log
+    uint32_t warmed;      // Addons produced data for these in the background
+    uint32_t hits;        // Real requests served from warmed data
+    uint32_t misses;      // Intercepted requests that were not warmed (yet)
+    uint32_t stale;       // Warmed, then dropped: addons or settings changed
+    uint64_t savedNanos;  // Addon time the hits skipped
+    uint64_t warmupNanos; // Wall time of the background pass
+    bool running;
+  };
+
+  ~ResourcePrefetcher();
+
+  // Reads <addons>/prefetch/<profile>.log and starts warming
+  void Start(AddonManager *manager);
+  // Stops the background pass and writes this session's access order
+  void Stop();
+
+  // Hook side: called for every intercepted FindResourceW
+  void NoteIntercept(LPCWSTR name, LPCWSTR type, bool hit);
+  // The scope is the caller's, open around the lookup
+  bool Take(LPCWSTR name, LPCWSTR type,
+            const AddonManager::DispatchScope &scope,
+            std::vector<uint8_t> *data);
+
+  Stats GetStats() const;
+
+private:
+  struct Entry {
+    std::vector<uint8_t> data;
+    uint64_t nanos = 0;
+    uint64_t stamp = 0; // DispatchScope::InterceptStamp when produced
+    bool taken = false;
+  };
+
+  void Warm(std::vector<std::string> order);
+  void SaveLog();
+
+  AddonManager *manager = nullptr;
+  std::filesystem::path logPath;
+
+  mutable std::mutex lock;
+  std::unordered_map<std::string, Entry> warmed;
+  std::vector<std::string> sessionOrder;
+  std::unordered_set<std::string> sessionSeen;
+  Stats stats = {};
+
+  std::atomic<uint32_t> available{0}; // Warmed and not yet taken
+
+  std::thread worker;
+  std::atomic<bool> stopRequested{false};
+  std::atomic<bool> workerExited{false};
+};
@@ -0,0 +1,162 @@
+#include "resource_trace.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cwchar>
+
+namespace ResourceTrace {
+
+static const size_t kFlushBytes = 64 * 1024;
+
+static uint64_t SteadyNanos() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static uint16_t ThreadIndex() {
+  static std::atomic<uint16_t> s_next{0};
+  thread_local uint16_t t_index = s_next.fetch_add(1);
+  return t_index;
+}
+
+const char *OpName(Op op) {
+  switch (op) {
+  case Op::FindResource:
+    return "FindResourceW";
+  case Op::LoadResource:
+    return "LoadResource";
+  case Op::SizeofResource:
+    return "SizeofResource";
+  case Op::LockResource:
+    return "LockResource";
+  case Op::FreeResource:
+    return "FreeResource";
+  }
+  return "?";
+}
+
+Writer::~Writer() { Close(); }
+
+bool Writer::Open(const std::filesystem::path &path) {
+  std::lock_guard<std::mutex> guard(lock);
+  if (file)
+    return false;
+#ifdef _WIN32
+  file = _wfopen(path.c_str(), L"wb");
+#else
+  file = std::fopen(path.c_str(), "wb");
+#endif
+  if (!file)
+    return false;
+
+  FileHeader header = {kMagic, kVersion, (uint16_t)sizeof(Record), 0};
+  std::fwrite(&header, sizeof(header), 1, file);
+  buffer.reserve(kFlushBytes + 1024);
+  originNanos = SteadyNanos();
+  return true;
+}
+
+void Writer::Close() {
+  std::lock_guard<std::mutex> guard(lock);
+  if (!file)
+    return;
+  Flush();
+  std::fclose(file);
+  file = nullptr;
+}
+
+uint64_t Writer::Now() const { return SteadyNanos() - originNanos; }
+
+static void AppendString(std::vector<uint8_t> &buffer, const wchar_t *text,
+                         uint64_t length) {
+  for (uint64_t i = 0; i < length; ++i) {
+    uint16_t unit = (uint16_t)text[i]; // Resource names are BMP
+    const uint8_t *bytes = (const uint8_t *)&unit;
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(unit));
+  }
+}
+
+void Writer::Write(Record record, const wchar_t *resourceName,
+                   const wchar_t *resourceType) {
+  record.thread = ThreadIndex();
+  if (record.flags & kNameIsString)
+    record.name = std::wcslen(resourceName);
+  if (record.flags & kTypeIsString)
+    record.type = std::wcslen(resourceType);
+
+  std::lock_guard<std::mutex> guard(lock);
+  if (!file)
+    return;
+  const uint8_t *bytes = (const uint8_t *)&record;
+  buffer.insert(buffer.end(), bytes, bytes + sizeof(record));
+  if (record.flags & kNameIsString)
+    AppendString(buffer, resourceName, record.name);
+  if (record.flags & kTypeIsString)
+    AppendString(buffer, resourceType, record.type);
+  if (buffer.size() >= kFlushBytes)
+    Flush();
+}
+
+void Writer::Flush() {
+  if (!buffer.empty()) {
+    std::fwrite(buffer.data(), 1, buffer.size(), file);
+    buffer.clear();
+  }
+  std::fflush(file);
+}
+
+static bool ReadString(std::FILE *file, uint64_t length, std::wstring *out) {
+  if (length > 0xFFFF)
+    return false;
+  out->resize((size_t)length);
+  for (uint64_t i = 0; i < length; ++i) {
+    uint16_t unit;
+    if (std::fread(&unit, sizeof(unit), 1, file) != 1)
+      return false;
+    (*out)[(size_t)i] = (wchar_t)unit;
+  }
+  return true;
+}
+
+bool ReadFile(const std::filesystem::path &path, std::vector<Event> *events,
+              std::string *error) {
+#ifdef _WIN32
+  std::FILE *file = _wfopen(path.c_str(), L"rb");
+#else
+  std::FILE *file = std::fopen(path.c_str(), "rb");
+#endif
+  if (!file) {
+    *error = "cannot open " + path.u8string();
+    return false;
+  }
+
+  FileHeader header;
+  if (std::fread(&header, sizeof(header), 1, file) != 1 ||
+      header.magic != kMagic || header.version != kVersion ||
+      header.recordSize != sizeof(Record)) {
+    std::fclose(file);
+    *error = "not a version " + std::to_string(kVersion) + " resource trace";
+    return false;
+  }
+
+  events->clear();
+  Event event;
+  while (std::fread(&event.record, sizeof(Record), 1, file) == 1) {
+    event.name.clear();
+    event.type.clear();
+    if (((event.record.flags & kNameIsString) &&
+         !ReadString(file, event.record.name, &event.name)) ||
+        ((event.record.flags & kTypeIsString) &&
+         !ReadString(file, event.record.type, &event.type))) {
+      *error = "truncated string after record " +
+               std::to_string(events->size());
+      break; // Keep what was read; the recording may have been cut short
+    }
+    events->push_back(event);
+  }
+  std::fclose(file);
+  return true;
+}
+
+} // namespace ResourceTrace
@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Binary log of hooked resource calls, written by ShaderHook when recording
+// is enabled and read back by tools/resource_replay. A file is a FileHeader
+// followed by Records; a string resource name or type follows its record as
+// UTF-16 code units (the length is stored in the name/type field).
+namespace ResourceTrace {
+
+const uint32_t kMagic = 0x54524C4C; // "LLRT"
+const uint16_t kVersion = 1;
+
+enum class Op : uint8_t {
+  FindResource = 1,
+  LoadResource,
+  SizeofResource,
+  LockResource,
+  FreeResource,
+};
+
+enum Flags : uint8_t {
+  kIntercepted = 1 << 0, // Served from the shader cache / an addon
+  kNameIsString = 1 << 1,
+  kTypeIsString = 1 << 2,
+};
+
+#pragma pack(push, 1)
+struct FileHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t recordSize;
+  uint64_t reserved;
+};
+
+struct Record {
+  uint8_t op;
+  uint8_t flags;
+  uint16_t thread;         // Small per-recording thread index
+  uint32_t durationNanos;  // Time spent inside the hook
+  uint64_t timestampNanos; // Call start, relative to the recording start
+  uint64_t module;
+  uint64_t handle; // HRSRC or HGLOBAL argument
+  uint64_t name;   // Integer id, or string length with kNameIsString
+  uint64_t type;   // Integer id, or string length with kTypeIsString
+  uint64_t result;
+};
+#pragma pack(pop)
+
+const char *OpName(Op op);
+
+// Thread-safe, buffered. Stays valid after Close() so hooks racing with the
+// end of a recording only find it closed.
+class Writer {
+public:
+  ~Writer();
+  bool Open(const std::filesystem::path &path);
+  void Close();
+
+  // Nanoseconds since Open
+  uint64_t Now() const;
+  // resourceName/resourceType are only read when flags mark them as strings
+  void Write(Record record, const wchar_t *resourceName,
+             const wchar_t *resourceType);
+
+private:
+  void Flush();
+
+  std::mutex lock;
+  std::FILE *file = nullptr;
+  std::vector<uint8_t> buffer;
+  uint64_t originNanos = 0;
+};
+
+struct Event {
+  Record record;
+  std::wstring name; // Set when kNameIsString
+  std::wstring type; // Set when kTypeIsString
+};
+
+bool ReadFile(const std::filesystem::path &path, std::vector<Event> *events,
+              std::string *error);
+
+} // namespace ResourceTrace
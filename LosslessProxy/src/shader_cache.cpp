@@ -0,0 +1,210 @@
+#include "shader_cache.hpp"
+#include "lz4_block.hpp"
+#include <cstring>
+
+namespace ShaderHook {
+
+std::unique_lock<std::mutex> ShaderCache::Acquire() const {
+  std::unique_lock<std::mutex> guard(lock, std::try_to_lock);
+  if (!guard.owns_lock()) {
+    contended.fetch_add(1, std::memory_order_relaxed);
+    guard.lock();
+  }
+  return guard;
+}
+
+void ShaderCache::SetBudget(size_t bytes) {
+  auto guard = Acquire();
+  budget = bytes;
+  EnforceBudget();
+}
+
+size_t ShaderCache::GetBudget() const {
+  auto guard = Acquire();
+  return budget;
+}
+
+void ShaderCache::Touch(HRSRC handle, Entry &entry) {
+  if (entry.holds > 0)
+    return; // Listed again by the last Release
+  if (entry.listed)
+    lru.erase(entry.recent);
+  lru.push_front(handle);
+  entry.recent = lru.begin();
+  entry.listed = true;
+}
+
+void ShaderCache::Store(HRSRC handle, const void *data, uint32_t size) {
+  stores.fetch_add(1, std::memory_order_relaxed);
+  auto guard = Acquire();
+  Entry &entry = entries[handle];
+  if (!entry.cold && entry.size == size && size > 0 &&
+      std::memcmp(entry.bytes.data(), data, size) == 0) {
+    Touch(handle, entry); // Same bytecode: nothing to replace
+    return;
+  }
+  if (entry.cold) {
+    coldBytes -= entry.bytes.size();
+    coldRawBytes -= entry.size;
+  } else if (entry.holds > 0) {
+    // Lossless may still be reading these through a pointer Lock returned;
+    // they stay counted as hot until the last hold is dropped
+    entry.retired.emplace_back();
+    entry.retired.back().swap(entry.bytes);
+  } else {
+    hotBytes -= entry.size;
+  }
+  Touch(handle, entry);
+  entry.bytes.assign((const uint8_t *)data, (const uint8_t *)data + size);
+  entry.size = size;
+  entry.cold = false;
+  entry.incompressible = false;
+  hotBytes += size;
+  // The caller is about to load it; compress older entries instead
+  EnforceBudget(handle);
+}
+
+bool ShaderCache::Contains(HRSRC handle) const {
+  auto guard = Acquire();
+  return entries.count(handle) != 0;
+}
+
+DWORD ShaderCache::GetSize(HRSRC handle) const {
+  finds.fetch_add(1, std::memory_order_relaxed);
+  auto guard = Acquire();
+  auto it = entries.find(handle);
+  return it != entries.end() ? it->second.size : 0;
+}
+
+bool ShaderCache::Restore(Entry &entry) {
+  std::vector<uint8_t> raw(entry.size);
+  if (!Lz4Block::Decompress(entry.bytes.data(), entry.bytes.size(),
+                            raw.data(), raw.size()))
+    return false;
+  coldBytes -= entry.bytes.size();
+  coldRawBytes -= entry.size;
+  hotBytes += entry.size;
+  entry.bytes.swap(raw);
+  entry.cold = false;
+  restores++;
+  return true;
+}
+
+void ShaderCache::AddRef(HRSRC handle) {
+  auto guard = Acquire();
+  auto it = entries.find(handle);
+  if (it == entries.end())
+    return;
+  Entry &entry = it->second;
+  if (entry.holds++ == 0 && entry.listed) {
+    lru.erase(entry.recent);
+    entry.listed = false;
+  }
+}
+
+const void *ShaderCache::Lock(HRSRC handle) {
+  finds.fetch_add(1, std::memory_order_relaxed);
+  auto guard = Acquire();
+  auto it = entries.find(handle);
+  if (it == entries.end())
+    return nullptr;
+  Entry &entry = it->second;
+  if (entry.cold && !Restore(entry))
+    return nullptr;
+  if (entry.bytes.empty())
+    return nullptr;
+  if (entry.holds == 0) {
+    // LockResource without LoadResource: held until the next FreeResource
+    entry.holds = 1;
+    if (entry.listed) {
+      lru.erase(entry.recent);
+      entry.listed = false;
+    }
+    EnforceBudget();
+  }
+  return entry.bytes.data();
+}
+
+void ShaderCache::Release(HRSRC handle) {
+  auto guard = Acquire();
+  auto it = entries.find(handle);
+  if (it == entries.end() || it->second.holds == 0)
+    return;
+  Entry &entry = it->second;
+  if (--entry.holds > 0)
+    return;
+  FreeRetired(entry);
+  if (!entry.cold)
+    Touch(handle, entry);
+  EnforceBudget();
+}
+
+void ShaderCache::FreeRetired(Entry &entry) {
+  for (const std::vector<uint8_t> &bytes : entry.retired)
+    hotBytes -= bytes.size();
+  entry.retired.clear();
+  entry.retired.shrink_to_fit();
+}
+
+void ShaderCache::EnforceBudget(HRSRC keep) {
+  if (budget == 0)
+    return;
+  // Oldest first; held entries are never listed
+  auto it = lru.end();
+  while (hotBytes > budget && it != lru.begin()) {
+    --it;
+    Entry &entry = entries.find(*it)->second;
+    if (entry.incompressible || *it == keep)
+      continue;
+
+    std::vector<uint8_t> block;
+    Lz4Block::Compress(entry.bytes.data(), entry.size, &block);
+    if (block.size() >= entry.size) {
+      entry.incompressible = true; // Keeping it hot costs nothing extra
+      continue;
+    }
+    block.shrink_to_fit();
+    hotBytes -= entry.size;
+    coldBytes += block.size();
+    coldRawBytes += entry.size;
+    entry.bytes.swap(block);
+    entry.cold = true;
+    entry.listed = false;
+    evictions++;
+    it = lru.erase(it);
+  }
+}
+
+size_t ShaderCache::GetCount() const {
+  auto guard = Acquire();
+  return entries.size();
+}
+
+void ShaderCache::Clear() {
+  auto guard = Acquire();
+  entries.clear();
+  lru.clear();
+  hotBytes = coldBytes = coldRawBytes = 0;
+}
+
+ShaderCache::Stats ShaderCache::GetStats() const {
+  Stats stats = {};
+  stats.finds = finds.load(std::memory_order_relaxed);
+  stats.stores = stores.load(std::memory_order_relaxed);
+  stats.contended = contended.load(std::memory_order_relaxed);
+
+  std::lock_guard<std::mutex> guard(lock);
+  stats.evictions = evictions;
+  stats.restores = restores;
+  stats.hotBytes = hotBytes;
+  stats.coldBytes = coldBytes;
+  stats.coldRawBytes = coldRawBytes;
+  stats.entries = (uint32_t)entries.size();
+  for (const auto &pair : entries) {
+    if (pair.second.holds > 0)
+      stats.held++;
+  }
+  return stats;
+}
+
+} // namespace ShaderHook
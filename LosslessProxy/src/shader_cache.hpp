@@ -0,0 +1,90 @@
+#pragma once
+
+#include "platform.hpp"
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace ShaderHook {
+
+    // Replacement bytecode keyed by the fake HRSRC handed back to the game.
+    // Handles follow the resource calls: LoadResource takes a hold,
+    // LockResource returns the bytes (taking a hold itself if there is none)
+    // and FreeResource drops one. Bytes are only moved while an entry has no
+    // holds, so a pointer Lock returned stays valid until the matching
+    // FreeResource; a module that never frees keeps its entries hot. When
+    // the uncompressed (hot) bytes exceed the budget, entries without holds
+    // are LZ4-compressed into the cold tier, least recently used first, and
+    // decompressed again by the next Lock. Bytecode stored under a held
+    // handle leaves the old bytes in place until the last hold is dropped.
+    class ShaderCache {
+    public:
+        struct Stats {
+            uint64_t finds;
+            uint64_t stores;
+            uint64_t contended; // Lock acquisitions that had to wait
+            uint64_t evictions; // Entries compressed into the cold tier
+            uint64_t restores;  // Cold entries decompressed by Lock
+            uint64_t hotBytes;
+            uint64_t coldBytes;    // Compressed size of the cold tier
+            uint64_t coldRawBytes; // What the cold tier expands to
+            uint32_t entries;
+            uint32_t held; // With LoadResource/LockResource holds left
+        };
+
+        // Limit for uncompressed bytecode; 0 keeps everything hot
+        void SetBudget(size_t bytes);
+        size_t GetBudget() const;
+
+        void Store(HRSRC handle, const void* data, uint32_t size);
+        bool Contains(HRSRC handle) const;
+        // Uncompressed size, 0 if unknown
+        DWORD GetSize(HRSRC handle) const;
+
+        // LoadResource / LockResource / FreeResource
+        void AddRef(HRSRC handle);
+        const void* Lock(HRSRC handle);
+        void Release(HRSRC handle);
+
+        size_t GetCount() const;
+        void Clear();
+        Stats GetStats() const;
+
+    private:
+        struct Entry {
+            std::vector<uint8_t> bytes; // Raw when hot, an LZ4 block when cold
+            uint32_t size = 0;
+            uint32_t holds = 0;
+            bool cold = false;
+            bool incompressible = false;
+            bool listed = false; // In lru, at recent; true while hot
+            std::list<HRSRC>::iterator recent;
+            // Replaced while held; freed with the last hold
+            std::vector<std::vector<uint8_t>> retired;
+        };
+
+        std::unique_lock<std::mutex> Acquire() const;
+        void Touch(HRSRC handle, Entry& entry);
+        bool Restore(Entry& entry);
+        void FreeRetired(Entry& entry);
+        // Compresses entries without holds, other than keep, until the hot
+        // bytes fit the budget
+        void EnforceBudget(HRSRC keep = nullptr);
+
+        mutable std::mutex lock;
+        std::map<HRSRC, Entry> entries;
+        std::list<HRSRC> lru; // Hot entries, most recently used first
+        size_t budget = 0;
+        uint64_t hotBytes = 0;
+        uint64_t coldBytes = 0;
+        uint64_t coldRawBytes = 0;
+        uint64_t evictions = 0;
+        uint64_t restores = 0;
+        mutable std::atomic<uint64_t> finds{0};
+        std::atomic<uint64_t> stores{0};
+        mutable std::atomic<uint64_t> contended{0};
+    };
+}
@@ -1,29 +1,51 @@
 #include "shader_hook.hpp"
 #include "addon_manager.hpp"
-#include "iat_patcher.hpp"
+#include "ini_file.hpp"
+#include "pe_image.hpp"
+#include "resource_overlay.hpp"
+#include "resource_key.hpp"
+#include "resource_prefetch.hpp"
+#include "resource_trace.hpp"
+#include "stats_publisher.hpp"
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <sstream>
+#include <unordered_map>
 
 namespace ShaderHook {
 
 // Global state
-static AddonManager *g_addonManager = nullptr;
-static std::map<HRSRC, CachedShader> g_shaderCache;
-static CRITICAL_SECTION g_cacheLock;
-static bool g_hooksInstalled = false;
+// Published last by Initialize: the hooks can be installed (from DllMain)
+// before it runs, and pass everything through until then
+static std::atomic<AddonManager *> g_addonManager{nullptr};
+static ShaderCache g_shaderCache;
+// Cache handle id per (name, type) ever intercepted, so different resources
+// never share cache bytes
+static std::mutex g_handleIdLock;
+static std::unordered_map<std::string, DWORD> g_handleIds;
+static const int kDefaultCacheBudgetMB = 64;
+static ResourcePrefetcher g_prefetcher;
+static ResourceOverlay g_overlay;
+static ResourceTrace::Writer g_recorder;
+static std::atomic<bool> g_recording{false};
+static StatsPublisher g_statsPublisher;
 static std::wfstream g_logFile;
-static int g_findResourceCallCount = 0; // Count total FindResourceW calls
+// Count total FindResourceW calls
+static std::atomic<uint32_t> g_findResourceCallCount{0};
 static std::map<WORD, int> g_resourceIdCallCount; // Count calls per resource ID
 static std::map<std::wstring, int>
     g_shaderCallCount; // Track calls per shader name for rotation
 
 // Log helper function
-static void LogToFile(const std::wstring &message) {
+void LogToFile(const std::wstring &message) {
   try {
     // Create log file path in the same directory as Lossless Scaling
     static bool g_logInitialized = false;
@@ -31,10 +53,8 @@ static void LogToFile(const std::wstring &message) {
       g_logInitialized = true;
 
       // Get Lossless Scaling installation directory
-      wchar_t exePath[MAX_PATH];
-      GetModuleFileNameW(nullptr, exePath, MAX_PATH);
       std::filesystem::path logPath =
-          std::filesystem::path(exePath).parent_path() / L"ShaderHook.log";
+          Platform::GetHostExecutablePath().parent_path() / L"ShaderHook.log";
 
       // Open log file for appending
       g_logFile.open(logPath, std::ios::app | std::ios::out);
@@ -50,11 +70,7 @@ static void LogToFile(const std::wstring &message) {
 }
 
 // Original API function pointers
-static HRSRC(WINAPI *g_origFindResourceW)(HMODULE, LPCWSTR, LPCWSTR) = nullptr;
-static HGLOBAL(WINAPI *g_origLoadResource)(HMODULE, HRSRC) = nullptr;
-static DWORD(WINAPI *g_origSizeofResource)(HMODULE, HRSRC) = nullptr;
-static LPVOID(WINAPI *g_origLockResource)(HGLOBAL) = nullptr;
-static BOOL(WINAPI *g_origFreeResource)(HGLOBAL) = nullptr;
+static ResourceApi g_orig = {};
 
 // Magic value to identify our custom handles (use a 32-bit constant)
 static const uint32_t CUSTOM_SHADER_MAGIC =
@@ -80,33 +96,183 @@ inline DWORD GetCustomHandleId(HRSRC handle) {
   return (DWORD)(v & 0xFFFF);
 }
 
+// Overlay files are served from their mappings, not the cache: their handles
+// carry the overlay slot under a magic of their own
+static const uint32_t OVERLAY_MAGIC = 0xF00DB0BAu;
+
+inline HRSRC MakeOverlayHandle(uint32_t slot) {
+  uintptr_t magicShift = (sizeof(uintptr_t) == 8) ? 32 : 16;
+  return (HRSRC)((((uintptr_t)OVERLAY_MAGIC) << magicShift) | slot);
+}
+
+inline bool IsOverlayHandle(HRSRC handle) {
+  uintptr_t magicShift = (sizeof(uintptr_t) == 8) ? 32 : 16;
+  return ((uintptr_t)handle >> magicShift) == (uintptr_t)OVERLAY_MAGIC;
+}
+
+inline uint32_t GetOverlaySlot(HRSRC handle) {
+  uintptr_t magicShift = (sizeof(uintptr_t) == 8) ? 32 : 16;
+  return (uint32_t)((uintptr_t)handle & (((uintptr_t)1 << magicShift) - 1));
+}
+
 void Initialize(AddonManager *addonManager) {
-  g_addonManager = addonManager;
-  InitializeCriticalSection(&g_cacheLock);
   LogToFile(L"[ShaderHook] Initialized");
+
+  // [ShaderCache] BudgetMB in addons_config.ini; 0 disables eviction
+  IniFile config;
+  config.Load(addonManager->GetConfigFilePath());
+  int budgetMB =
+      config.GetInt("ShaderCache", "BudgetMB", kDefaultCacheBudgetMB);
+  g_shaderCache.SetBudget((size_t)budgetMB * 1024 * 1024);
+
+  // <addon>/resources/<type>/<name>.bin files; [ResourceOverlay] PollMs is
+  // how often to look for changes, 0 for never
+  int pollMs = config.GetInt("ResourceOverlay", "PollMs",
+                             (int)ResourceOverlay::kDefaultPollMs);
+  g_overlay.Stop();
+  g_overlay.Start(addonManager->GetAddonsDirectory(),
+                  addonManager->GetConfigFilePath(),
+                  (uint32_t)std::max(pollMs, 0));
+  if (uint32_t files = g_overlay.GetStats().files)
+    LogToFile(L"[ShaderHook] Resource overlay: " + std::to_wstring(files) +
+              L" files");
+
+  // LOSSLESS_RECORD_RESOURCES=<file> records every hooked call for
+  // tools/resource_replay; relative paths are next to the executable
+  if (const char *recordPath = std::getenv("LOSSLESS_RECORD_RESOURCES")) {
+    std::filesystem::path path = std::filesystem::u8path(recordPath);
+    if (path.is_relative())
+      path = Platform::GetHostExecutablePath().parent_path() / path;
+    StartRecording(path);
+  }
+
+  // LOSSLESS_PUBLISH_STATS=<interval ms> samples counters into the shared
+  // SharedStats::kSegmentName segment for external dashboards
+  if (const char *interval = std::getenv("LOSSLESS_PUBLISH_STATS")) {
+    int intervalMs = std::atoi(interval);
+    if (intervalMs <= 0)
+      intervalMs = StatsPublisher::kDefaultIntervalMs;
+    g_statsPublisher.Stop();
+    if (g_statsPublisher.Start(addonManager, SharedStats::kSegmentName,
+                               (uint32_t)intervalMs)) {
+      LogToFile(L"[ShaderHook] Publishing stats every " +
+                std::to_wstring(intervalMs) + L" ms");
+    } else {
+      LogToFile(L"[ShaderHook] Could not create the stats segment");
+    }
+  }
+  g_addonManager.store(addonManager, std::memory_order_release);
 }
 
-void Shutdown() {
-  EnterCriticalSection(&g_cacheLock);
-  g_shaderCache.clear();
-  LeaveCriticalSection(&g_cacheLock);
-  DeleteCriticalSection(&g_cacheLock);
-  g_addonManager = nullptr;
+void IndexResources(HMODULE module) {
+  AddonManager *manager = g_addonManager.load(std::memory_order_acquire);
+  PeImage image;
+  if (!manager || !module || !image.Parse((const uint8_t *)module, 0, true))
+    return;
+  std::vector<PeImage::Resource> resources = image.ListResources();
+  std::wostringstream oss;
+  oss << L"[ShaderHook] Indexed " << resources.size() << L" resources";
+  LogToFile(oss.str());
+  manager->SetResourceDirectory(std::move(resources));
 }
 
-bool IsOurShaderHandle(HRSRC handle) { return IsCustomHandle(handle); }
+void StartPrefetch() {
+  if (AddonManager *manager = g_addonManager.load(std::memory_order_acquire))
+    g_prefetcher.Start(manager);
+}
 
-const CachedShader *GetCachedShader(HRSRC handle) {
-  EnterCriticalSection(&g_cacheLock);
-  auto it = g_shaderCache.find(handle);
-  LeaveCriticalSection(&g_cacheLock);
+ResourcePrefetcher::Stats GetPrefetchStats() { return g_prefetcher.GetStats(); }
 
-  if (it != g_shaderCache.end()) {
-    return &it->second;
+ResourceOverlay::Stats GetOverlayStats() { return g_overlay.GetStats(); }
+
+static void LogPrefetchStats() {
+  ResourcePrefetcher::Stats stats = g_prefetcher.GetStats();
+  uint32_t requests = stats.hits + stats.misses;
+  if (stats.logged == 0 && requests == 0)
+    return;
+  std::wostringstream oss;
+  oss << L"[ShaderHook] Prefetch: warmed " << stats.warmed << L"/"
+      << stats.logged << L" in " << stats.warmupNanos / 1000000 << L" ms, "
+      << stats.hits << L"/" << requests << L" intercepted requests served ("
+      << (requests ? 100 * stats.hits / requests : 0) << L"%), saved "
+      << stats.savedNanos / 1000000 << L" ms of addon time, " << stats.stale
+      << L" dropped as stale";
+  LogToFile(oss.str());
+}
+
+static void LogOverlayStats() {
+  ResourceOverlay::Stats stats = g_overlay.GetStats();
+  if (stats.served == 0)
+    return;
+  std::wostringstream oss;
+  oss << L"[ShaderHook] Resource overlay: served " << stats.served
+      << L" requests from " << stats.mapped << L" mapped files ("
+      << stats.mappedBytes / 1024 << L" KB), " << stats.files
+      << L" files indexed";
+  LogToFile(oss.str());
+}
+
+static void LogCacheStats() {
+  ShaderCache::Stats stats = g_shaderCache.GetStats();
+  if (stats.stores == 0)
+    return;
+  std::wostringstream oss;
+  oss << L"[ShaderHook] Shader cache: " << stats.entries << L" entries, "
+      << stats.hotBytes / 1024 << L" KB hot, " << stats.coldRawBytes / 1024
+      << L" KB cold in " << stats.coldBytes / 1024 << L" KB compressed, "
+      << stats.evictions << L" evictions, " << stats.restores
+      << L" restores, " << stats.held << L" still held";
+  LogToFile(oss.str());
+}
+
+void Shutdown() {
+  g_statsPublisher.Stop();
+  g_prefetcher.Stop();
+  LogPrefetchStats();
+  LogOverlayStats();
+  LogCacheStats();
+  StopRecording();
+  g_overlay.Stop();
+  g_shaderCache.Clear();
+  {
+    std::lock_guard<std::mutex> guard(g_handleIdLock);
+    g_handleIds.clear();
   }
-  return nullptr;
+  g_addonManager.store(nullptr, std::memory_order_release);
+}
+
+bool StartRecording(const std::filesystem::path &path) {
+  if (g_recording.load() || !g_recorder.Open(path)) {
+    LogToFile(L"[ShaderHook] Could not start recording to " + path.wstring());
+    return false;
+  }
+  g_recording.store(true, std::memory_order_release);
+  LogToFile(L"[ShaderHook] Recording resource calls to " + path.wstring());
+  return true;
+}
+
+void StopRecording() {
+  if (!g_recording.exchange(false))
+    return;
+  g_recorder.Close();
+}
+
+void SetResourceApi(const ResourceApi &api) { g_orig = api; }
+
+bool ShouldApplyPatches() {
+  AddonManager *manager = g_addonManager.load(std::memory_order_acquire);
+  if (!manager)
+    return false;
+  AddonManager::DispatchScope scope(*manager);
+  return scope.Get() && scope.Get()->applyPatches;
+}
+
+bool IsOurShaderHandle(HRSRC handle) {
+  return IsCustomHandle(handle) || IsOverlayHandle(handle);
 }
 
+ShaderCache::Stats GetCacheStats() { return g_shaderCache.GetStats(); }
+
 // Helper for logging/debug only
 bool IsShaderResourceId(LPCWSTR lpName, LPCWSTR lpType) {
   if ((uintptr_t)lpType != 0xa)
@@ -120,200 +286,289 @@ bool IsShaderResourceId(LPCWSTR lpName, LPCWSTR lpType) {
 // Hooked FindResourceW Implementation
 // --------------------------------------------------------------------------------------
 
-HRSRC WINAPI HookedFindResourceW(HMODULE hModule, LPCWSTR lpName,
-                                 LPCWSTR lpType) {
-  g_findResourceCallCount++;
-
-  // Try to intercept via Addon Manager
-  if (g_addonManager) {
-    const void *customData = nullptr;
-    uint32_t customSize = 0;
-
-    if (g_addonManager->InterceptResource(lpName, lpType, &customData,
-                                          &customSize)) {
-      if (customData && customSize > 0) {
-        DWORD handleId = 0;
-        if (IS_INTRESOURCE(lpName)) {
-          handleId = (DWORD)(uintptr_t)lpName;
-        } else {
-          handleId = 0xFFFF; // Fallback for string names
-        }
-
-        HRSRC customHandle = MakeCustomHandle(handleId);
-
-        EnterCriticalSection(&g_cacheLock);
-        CachedShader &cached = g_shaderCache[customHandle];
-        cached.bytecode.assign((const uint8_t *)customData,
-                               (const uint8_t *)customData + customSize);
-        cached.size = customSize;
-        LeaveCriticalSection(&g_cacheLock);
-
-        std::wostringstream oss;
-        oss << L"[ShaderHook] Intercepted resource. Handle: 0x" << std::hex
-            << (uintptr_t)customHandle;
-        LogToFile(oss.str());
-
-        return customHandle;
-      }
-    }
+// 0 once the 16 bits a handle carries are used up
+static DWORD HandleIdFor(LPCWSTR lpName, LPCWSTR lpType) {
+  std::string key = MakeResourceKey(lpName, lpType);
+  std::lock_guard<std::mutex> guard(g_handleIdLock);
+  auto it = g_handleIds.find(key);
+  if (it != g_handleIds.end())
+    return it->second;
+  if (g_handleIds.size() >= 0xFFFF)
+    return 0;
+  DWORD id = (DWORD)g_handleIds.size() + 1;
+  g_handleIds.emplace(std::move(key), id);
+  return id;
+}
+
+static HRSRC StoreIntercepted(HMODULE hModule, LPCWSTR lpName,
+                              LPCWSTR lpType, const void *data,
+                              uint32_t size) {
+  DWORD handleId = HandleIdFor(lpName, lpType);
+  if (!handleId) {
+    LogToFile(L"[ShaderHook] Out of handles, serving the original");
+    return g_orig.FindResourceW ? g_orig.FindResourceW(hModule, lpName, lpType)
+                                : nullptr;
+  }
+
+  HRSRC customHandle = MakeCustomHandle(handleId);
+
+  g_shaderCache.Store(customHandle, data, size);
+
+  std::wostringstream oss;
+  oss << L"[ShaderHook] Intercepted resource. Handle: 0x" << std::hex
+      << (uintptr_t)customHandle;
+  LogToFile(oss.str());
+
+  return customHandle;
+}
+
+// The resource as kernel32 has it; nullptr data if it cannot be loaded
+static HRSRC LoadOriginal(HMODULE hModule, LPCWSTR lpName, LPCWSTR lpType,
+                          const void **data, uint32_t *size) {
+  *data = nullptr;
+  *size = 0;
+  if (!g_orig.FindResourceW)
+    return nullptr;
+  HRSRC info = g_orig.FindResourceW(hModule, lpName, lpType);
+  if (!info || !g_orig.LoadResource || !g_orig.SizeofResource ||
+      !g_orig.LockResource)
+    return info;
+  HGLOBAL loaded = g_orig.LoadResource(hModule, info);
+  *data = loaded ? g_orig.LockResource(loaded) : nullptr;
+  *size = *data ? g_orig.SizeofResource(hModule, info) : 0;
+  return info;
+}
+
+static HRSRC FindResourceImpl(HMODULE hModule, LPCWSTR lpName,
+                              LPCWSTR lpType) {
+  g_findResourceCallCount.fetch_add(1, std::memory_order_relaxed);
+
+  AddonManager *manager = g_addonManager.load(std::memory_order_acquire);
+  if (!manager) {
+    return g_orig.FindResourceW ? g_orig.FindResourceW(hModule, lpName, lpType)
+                                : nullptr;
   }
 
-  // Original Behavior
-  if (g_origFindResourceW) {
-    return g_origFindResourceW(hModule, lpName, lpType);
+  // Until StoreIntercepted has copied them, the bytes may belong to an addon
+  // the GUI thread is unloading; the scope keeps it loaded
+  AddonManager::DispatchScope scope(*manager);
+
+  // An overlay file, straight from its mapping; or an addon's whole
+  // replacement: warmed in the background from last session's access log,
+  // or asked for now
+  std::vector<uint8_t> prefetched;
+  const void *data = nullptr;
+  uint32_t size = 0;
+  uint32_t overlaySlot = g_overlay.Find(lpName, lpType, &data, &size);
+  if (overlaySlot) {
+    // Served as is unless transforms run on it
+  } else if (g_prefetcher.Take(lpName, lpType, scope, &prefetched)) {
+    g_prefetcher.NoteIntercept(lpName, lpType, true);
+    data = prefetched.data();
+    size = (uint32_t)prefetched.size();
+  } else if (manager->InterceptResource(lpName, lpType, &data, &size) &&
+             data && size > 0) {
+    g_prefetcher.NoteIntercept(lpName, lpType, false);
+  } else {
+    data = nullptr;
+    size = 0;
   }
-  return nullptr;
+  bool intercepted = data != nullptr;
+
+  // Patches apply to the original only; transforms to whatever came before
+  bool patches = !intercepted &&
+                 manager->GetShaderPatcher().HasPatches(lpName, lpType);
+  bool transforms = manager->HasTransforms();
+  if (!patches && !transforms) {
+    if (overlaySlot)
+      return MakeOverlayHandle(overlaySlot);
+    if (intercepted)
+      return StoreIntercepted(hModule, lpName, lpType, data, size);
+    return g_orig.FindResourceW ? g_orig.FindResourceW(hModule, lpName, lpType)
+                                : nullptr;
+  }
+
+  HRSRC originalInfo = nullptr;
+  if (!intercepted) {
+    originalInfo = LoadOriginal(hModule, lpName, lpType, &data, &size);
+    if (!data)
+      return originalInfo;
+  }
+
+  // An overlay file is only copied into the cache if a transform changes it
+  bool changed = intercepted && !overlaySlot;
+  std::vector<uint8_t> patched;
+  if (patches && manager->GetShaderPatcher().Apply(
+                     lpName, lpType, (const uint8_t *)data, size, &patched)) {
+    data = patched.data();
+    size = (uint32_t)patched.size();
+    changed = true;
+  }
+  std::vector<uint8_t> transformed;
+  if (transforms &&
+      manager->TransformResource(lpName, lpType, (const uint8_t *)data, size,
+                                 &transformed)) {
+    data = transformed.data();
+    size = (uint32_t)transformed.size();
+    changed = true;
+  }
+
+  if (changed)
+    return StoreIntercepted(hModule, lpName, lpType, data, size);
+  if (overlaySlot)
+    return MakeOverlayHandle(overlaySlot);
+  return originalInfo;
 }
 
 // Hooked LoadResource
-HGLOBAL WINAPI HookedLoadResource(HMODULE hModule, HRSRC hResInfo) {
+static HGLOBAL LoadResourceImpl(HMODULE hModule, HRSRC hResInfo) {
+  if (IsOverlayHandle(hResInfo))
+    return (HGLOBAL)hResInfo;
   if (IsCustomHandle(hResInfo)) {
+    g_shaderCache.AddRef(hResInfo);
     return (HGLOBAL)hResInfo;
   }
-  if (g_origLoadResource) {
-    return g_origLoadResource(hModule, hResInfo);
+  if (g_orig.LoadResource) {
+    return g_orig.LoadResource(hModule, hResInfo);
   }
   return nullptr;
 }
 
 // Hooked SizeofResource
-DWORD WINAPI HookedSizeofResource(HMODULE hModule, HRSRC hResInfo) {
+static DWORD SizeofResourceImpl(HMODULE hModule, HRSRC hResInfo) {
+  if (IsOverlayHandle(hResInfo)) {
+    const void *data;
+    uint32_t size;
+    return g_overlay.Get(GetOverlaySlot(hResInfo), &data, &size) ? size : 0;
+  }
   if (IsCustomHandle(hResInfo)) {
-    const CachedShader *cached = GetCachedShader(hResInfo);
-    if (cached) {
-      return cached->size;
-    }
-    return 0;
+    return g_shaderCache.GetSize(hResInfo);
   }
-  if (g_origSizeofResource) {
-    return g_origSizeofResource(hModule, hResInfo);
+  if (g_orig.SizeofResource) {
+    return g_orig.SizeofResource(hModule, hResInfo);
   }
   return 0;
 }
 
 // Hooked LockResource
-LPVOID WINAPI HookedLockResource(HGLOBAL hResData) {
+static LPVOID LockResourceImpl(HGLOBAL hResData) {
   HRSRC asHandle = (HRSRC)hResData;
+  if (IsOverlayHandle(asHandle)) {
+    const void *data;
+    uint32_t size;
+    return g_overlay.Get(GetOverlaySlot(asHandle), &data, &size)
+               ? (LPVOID)data
+               : nullptr;
+  }
   if (IsCustomHandle(asHandle)) {
-    const CachedShader *cached = GetCachedShader(asHandle);
-    if (cached && !cached->bytecode.empty()) {
-      return (void *)cached->bytecode.data();
+    if (const void *bytecode = g_shaderCache.Lock(asHandle)) {
+      return (LPVOID)bytecode;
     }
   }
-  if (g_origLockResource) {
-    return g_origLockResource(hResData);
+  if (g_orig.LockResource) {
+    return g_orig.LockResource(hResData);
   }
   return nullptr;
 }
 
 // Hooked FreeResource
-BOOL WINAPI HookedFreeResource(HGLOBAL hResData) {
+static BOOL FreeResourceImpl(HGLOBAL hResData) {
   HRSRC asHandle = (HRSRC)hResData;
+  if (IsOverlayHandle(asHandle))
+    return TRUE; // Mapped until shutdown
   if (IsCustomHandle(asHandle)) {
+    // An entry with no holds left may go to the cold tier
+    g_shaderCache.Release(asHandle);
     return TRUE;
   }
-  if (g_origFreeResource) {
-    return g_origFreeResource(hResData);
+  if (g_orig.FreeResource) {
+    return g_orig.FreeResource(hResData);
   }
   return TRUE;
 }
 
-// Helper to patch memory
-void PatchMemory(HMODULE hModule, DWORD rva,
-                 const std::vector<uint8_t> &bytes) {
-  if (!hModule)
-    return;
-  uint8_t *address = (uint8_t *)hModule + rva;
-
-  DWORD oldProtect;
-  if (VirtualProtect(address, bytes.size(), PAGE_EXECUTE_READWRITE,
-                     &oldProtect)) {
-    std::memcpy(address, bytes.data(), bytes.size());
-    VirtualProtect(address, bytes.size(), oldProtect, &oldProtect);
-    std::wostringstream oss;
-    oss << L"[ShaderHook] Patched memory at RVA 0x" << std::hex << rva;
-    LogToFile(oss.str());
-  }
-}
-
-// Install hooks
-void InstallHooks() {
-  if (g_hooksInstalled)
-    return;
-
-  HMODULE hKernel32 = GetModuleHandleW(L"kernel32.dll");
-  if (!hKernel32)
-    return;
+// --------------------------------------------------------------------------------------
+// Hook entry points: the implementations above plus optional recording
+// --------------------------------------------------------------------------------------
 
-  g_origFindResourceW = (HRSRC(WINAPI *)(
-      HMODULE, LPCWSTR, LPCWSTR))GetProcAddress(hKernel32, "FindResourceW");
-  g_origLoadResource = (HGLOBAL(WINAPI *)(HMODULE, HRSRC))GetProcAddress(
-      hKernel32, "LoadResource");
-  g_origSizeofResource = (DWORD(WINAPI *)(HMODULE, HRSRC))GetProcAddress(
-      hKernel32, "SizeofResource");
-  g_origLockResource =
-      (LPVOID(WINAPI *)(HGLOBAL))GetProcAddress(hKernel32, "LockResource");
-  g_origFreeResource =
-      (BOOL(WINAPI *)(HGLOBAL))GetProcAddress(hKernel32, "FreeResource");
-
-  if (!g_origFindResourceW || !g_origLoadResource || !g_origSizeofResource ||
-      !g_origLockResource || !g_origFreeResource) {
-    LogToFile(L"[ShaderHook] Failed to get original function pointers");
-    return;
-  }
+static void RecordCall(ResourceTrace::Op op, uint64_t started, HMODULE module,
+                       const void *handle, LPCWSTR name, LPCWSTR type,
+                       uint64_t result, bool intercepted) {
+  ResourceTrace::Record record = {};
+  record.op = (uint8_t)op;
+  record.timestampNanos = started;
+  record.durationNanos = (uint32_t)(g_recorder.Now() - started);
+  record.module = (uint64_t)(uintptr_t)module;
+  record.handle = (uint64_t)(uintptr_t)handle;
+  record.name = (uint64_t)(uintptr_t)name;
+  record.type = (uint64_t)(uintptr_t)type;
+  record.result = result;
+  if (intercepted)
+    record.flags |= ResourceTrace::kIntercepted;
+  if (name && !IS_INTRESOURCE(name))
+    record.flags |= ResourceTrace::kNameIsString;
+  if (type && !IS_INTRESOURCE(type))
+    record.flags |= ResourceTrace::kTypeIsString;
+  g_recorder.Write(record, name, type);
+}
 
-  HMODULE hLosslessOriginal = GetModuleHandleW(L"Lossless_original.dll");
-  if (!hLosslessOriginal) {
-    LogToFile(L"[ShaderHook] Failed to get Lossless_original.dll handle");
-    return;
-  }
+HRSRC WINAPI HookedFindResourceW(HMODULE hModule, LPCWSTR lpName,
+                                 LPCWSTR lpType) {
+  if (!g_recording.load(std::memory_order_acquire))
+    return FindResourceImpl(hModule, lpName, lpType);
+
+  uint64_t started = g_recorder.Now();
+  HRSRC result = FindResourceImpl(hModule, lpName, lpType);
+  RecordCall(ResourceTrace::Op::FindResource, started, hModule, nullptr,
+             lpName, lpType, (uintptr_t)result, IsOurShaderHandle(result));
+  return result;
+}
 
-  // Patch IAT
-  IatPatcher::PatchIat(hLosslessOriginal, "kernel32.dll", "FindResourceW",
-                       &HookedFindResourceW);
-  IatPatcher::PatchIat(hLosslessOriginal, "kernel32.dll", "LoadResource",
-                       &HookedLoadResource);
-  IatPatcher::PatchIat(hLosslessOriginal, "kernel32.dll", "SizeofResource",
-                       &HookedSizeofResource);
-  IatPatcher::PatchIat(hLosslessOriginal, "kernel32.dll", "LockResource",
-                       &HookedLockResource);
-  IatPatcher::PatchIat(hLosslessOriginal, "kernel32.dll", "FreeResource",
-                       &HookedFreeResource);
-
-  // Apply Patches if any addon requests it
-  bool shouldApplyPatches = false;
-  if (g_addonManager) {
-    auto &addons = g_addonManager->GetAddons();
-    for (const auto &addon : addons) {
-      if (addon.enabled && (addon.capabilities & ADDON_CAP_PATCH_LS1_LOGIC)) {
-        shouldApplyPatches = true;
-        break;
-      }
-    }
-  }
+HGLOBAL WINAPI HookedLoadResource(HMODULE hModule, HRSRC hResInfo) {
+  if (!g_recording.load(std::memory_order_acquire))
+    return LoadResourceImpl(hModule, hResInfo);
+
+  uint64_t started = g_recorder.Now();
+  HGLOBAL result = LoadResourceImpl(hModule, hResInfo);
+  RecordCall(ResourceTrace::Op::LoadResource, started, hModule, hResInfo,
+             nullptr, nullptr, (uintptr_t)result,
+             IsOurShaderHandle(hResInfo));
+  return result;
+}
 
-  if (shouldApplyPatches) {
-    std::vector<uint8_t> nops = {0x90, 0x90};
-    std::vector<DWORD> patchOffsets = {0x51ac, 0x59c6, 0x5ab7, 0x5bc9, 0x5ce2,
-                                       0x65ec, 0x6f04, 0x6fe7, 0x78a7, 0x7f86,
-                                       0x8056, 0x8128, 0x8201, 0x8bdc, 0x92f0,
-                                       0x941d, 0x9d6c, 0xa480, 0xa589};
-    for (DWORD rva : patchOffsets) {
-      PatchMemory(hLosslessOriginal, rva, nops);
-    }
-    LogToFile(L"[ShaderHook] Applied memory patches");
-  }
+DWORD WINAPI HookedSizeofResource(HMODULE hModule, HRSRC hResInfo) {
+  if (!g_recording.load(std::memory_order_acquire))
+    return SizeofResourceImpl(hModule, hResInfo);
+
+  uint64_t started = g_recorder.Now();
+  DWORD result = SizeofResourceImpl(hModule, hResInfo);
+  RecordCall(ResourceTrace::Op::SizeofResource, started, hModule, hResInfo,
+             nullptr, nullptr, result, IsOurShaderHandle(hResInfo));
+  return result;
+}
 
-  FlushInstructionCache(GetCurrentProcess(), nullptr, 0);
-  g_hooksInstalled = true;
-  LogToFile(L"[ShaderHook] Hooks installed");
+LPVOID WINAPI HookedLockResource(HGLOBAL hResData) {
+  if (!g_recording.load(std::memory_order_acquire))
+    return LockResourceImpl(hResData);
+
+  uint64_t started = g_recorder.Now();
+  LPVOID result = LockResourceImpl(hResData);
+  RecordCall(ResourceTrace::Op::LockResource, started, nullptr, hResData,
+             nullptr, nullptr, (uintptr_t)result,
+             IsOurShaderHandle((HRSRC)hResData));
+  return result;
 }
 
-void UninstallHooks() {
-  if (!g_hooksInstalled)
-    return;
-  g_hooksInstalled = false;
-  LogToFile(L"[ShaderHook] Hooks uninstalled");
+BOOL WINAPI HookedFreeResource(HGLOBAL hResData) {
+  if (!g_recording.load(std::memory_order_acquire))
+    return FreeResourceImpl(hResData);
+
+  uint64_t started = g_recorder.Now();
+  BOOL result = FreeResourceImpl(hResData);
+  RecordCall(ResourceTrace::Op::FreeResource, started, nullptr, hResData,
+             nullptr, nullptr, (uint64_t)result,
+             IsOurShaderHandle((HRSRC)hResData));
+  return result;
 }
 
 } // namespace ShaderHook
@@ -1,7 +1,11 @@
 #pragma once
 
-#include <windows.h>
-#include <unordered_map>
+#include "platform.hpp"
+#include "resource_overlay.hpp"
+#include "resource_prefetch.hpp"
+#include "shader_cache.hpp"
+#include <filesystem>
+#include <string>
 #include <vector>
 #include <memory>
 
@@ -10,29 +14,59 @@ class AddonManager;
 // Shader hook - handles FindResourceW/LoadResource interception
 namespace ShaderHook {
 
-    // Custom shader info stored in our cache
-    struct CachedShader {
-        std::vector<uint8_t> bytecode;
-        DWORD size;
+    // The resource functions the hooks fall through to. InstallHooks fills
+    // this from kernel32; tools and benchmarks can supply their own.
+    struct ResourceApi {
+        HRSRC(WINAPI* FindResourceW)(HMODULE, LPCWSTR, LPCWSTR);
+        HGLOBAL(WINAPI* LoadResource)(HMODULE, HRSRC);
+        DWORD(WINAPI* SizeofResource)(HMODULE, HRSRC);
+        LPVOID(WINAPI* LockResource)(HGLOBAL);
+        BOOL(WINAPI* FreeResource)(HGLOBAL);
     };
 
     // Initialize hook with addon manager reference
     void Initialize(AddonManager* addonManager);
-    
+
     // Cleanup
     void Shutdown();
 
-    // Install Windows API hooks
+    // Set the functions non-intercepted calls are forwarded to
+    void SetResourceApi(const ResourceApi& api);
+
+    // Hand the resource directory of a loaded module (Lossless_original) to
+    // the addon manager for AddonInterceptResourceBatch
+    void IndexResources(HMODULE module);
+
+    // Warm addon intercepts in the background from the last session's
+    // access order. Call once addons are initialized.
+    void StartPrefetch();
+    ResourcePrefetcher::Stats GetPrefetchStats();
+
+    // Files served from the addons' resources/ folders (resource_overlay.hpp)
+    ResourceOverlay::Stats GetOverlayStats();
+
+    // Record every hooked call to a binary trace (see resource_trace.hpp).
+    // Initialize starts this when LOSSLESS_RECORD_RESOURCES names a file.
+    bool StartRecording(const std::filesystem::path& path);
+    void StopRecording();
+
+    // Install Windows API hooks (Windows only)
     void InstallHooks();
 
     // Uninstall hooks
     void UninstallHooks();
 
+    // Append a line to ShaderHook.log next to the host executable
+    void LogToFile(const std::wstring& message);
+
+    // True if an enabled addon asks for the LS1 code patches
+    bool ShouldApplyPatches();
+
     // Check if a resource handle is one of ours (custom shader)
     bool IsOurShaderHandle(HRSRC handle);
 
-    // Get cached shader data for a handle
-    const CachedShader* GetCachedShader(HRSRC handle);
+    // Cache lookups, lock contention and memory tiers
+    ShaderCache::Stats GetCacheStats();
 
     // Hooked API functions (these match the original signatures)
     HRSRC WINAPI HookedFindResourceW(HMODULE hModule, LPCWSTR lpName, LPCWSTR lpType);
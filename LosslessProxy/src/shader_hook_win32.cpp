@@ -0,0 +1,156 @@
+// Win32-only half of ShaderHook: IAT and code patching of
+// Lossless_original.dll. The hooks themselves live in shader_hook.cpp.
+#include "iat_patcher.hpp"
+#include "import_hook.hpp"
+#include "shader_hook.hpp"
+#include <cstring>
+#include <d3d11.h>
+#include <sstream>
+#include <vector>
+
+namespace ShaderHook {
+
+static bool g_hooksInstalled = false;
+
+// The resource imports. Their dispatchers forward to the Hooked* functions,
+// which fall through to kernel32 via ResourceApi.
+LS_IMPORT_HOOK(g_findResourceHook, "kernel32.dll", "FindResourceW",
+               HRSRC(WINAPI *)(HMODULE, LPCWSTR, LPCWSTR));
+LS_IMPORT_HOOK(g_loadResourceHook, "kernel32.dll", "LoadResource",
+               HGLOBAL(WINAPI *)(HMODULE, HRSRC));
+LS_IMPORT_HOOK(g_sizeofResourceHook, "kernel32.dll", "SizeofResource",
+               DWORD(WINAPI *)(HMODULE, HRSRC));
+LS_IMPORT_HOOK(g_lockResourceHook, "kernel32.dll", "LockResource",
+               LPVOID(WINAPI *)(HGLOBAL));
+LS_IMPORT_HOOK(g_freeResourceHook, "kernel32.dll", "FreeResource",
+               BOOL(WINAPI *)(HGLOBAL));
+
+// Imports addons can observe through IHost::AddImportCallback; they forward
+// straight to the original. Ones Lossless_original doesn't import are
+// skipped. Add a line here to expose another.
+LS_IMPORT_HOOK(g_d3d11CreateDeviceHook, "d3d11.dll", "D3D11CreateDevice",
+               PFN_D3D11_CREATE_DEVICE);
+LS_IMPORT_HOOK(g_createDxgiFactory1Hook, "dxgi.dll", "CreateDXGIFactory1",
+               HRESULT(WINAPI *)(REFIID, void **));
+LS_IMPORT_HOOK(g_createDxgiFactory2Hook, "dxgi.dll", "CreateDXGIFactory2",
+               HRESULT(WINAPI *)(UINT, REFIID, void **));
+LS_IMPORT_HOOK(g_loadLibraryHook, "kernel32.dll", "LoadLibraryW",
+               HMODULE(WINAPI *)(LPCWSTR));
+LS_IMPORT_HOOK(g_getProcAddressHook, "kernel32.dll", "GetProcAddress",
+               FARPROC(WINAPI *)(HMODULE, LPCSTR));
+LS_IMPORT_HOOK(g_createFileHook, "kernel32.dll", "CreateFileW",
+               HANDLE(WINAPI *)(LPCWSTR, DWORD, DWORD, LPSECURITY_ATTRIBUTES,
+                                DWORD, DWORD, HANDLE));
+LS_IMPORT_HOOK(g_queryPerformanceCounterHook, "kernel32.dll",
+               "QueryPerformanceCounter", BOOL(WINAPI *)(LARGE_INTEGER *));
+LS_IMPORT_HOOK(g_sleepHook, "kernel32.dll", "Sleep", void(WINAPI *)(DWORD));
+
+// Sends a found resource import through our implementation instead
+static void ForwardTo(ImportHooks::HookBase &hook, void *hooked) {
+  if (hook.IsInstalled())
+    hook.Install(hooked);
+}
+
+// Helper to patch memory
+void PatchMemory(HMODULE hModule, DWORD rva,
+                 const std::vector<uint8_t> &bytes) {
+  if (!hModule)
+    return;
+  uint8_t *address = (uint8_t *)hModule + rva;
+
+  DWORD oldProtect;
+  if (VirtualProtect(address, bytes.size(), PAGE_EXECUTE_READWRITE,
+                     &oldProtect)) {
+    std::memcpy(address, bytes.data(), bytes.size());
+    VirtualProtect(address, bytes.size(), oldProtect, &oldProtect);
+    std::wostringstream oss;
+    oss << L"[ShaderHook] Patched memory at RVA 0x" << std::hex << rva;
+    LogToFile(oss.str());
+  }
+}
+
+// Install hooks
+void InstallHooks() {
+  if (g_hooksInstalled)
+    return;
+
+  HMODULE hKernel32 = GetModuleHandleW(L"kernel32.dll");
+  if (!hKernel32)
+    return;
+
+  ResourceApi orig;
+  orig.FindResourceW = (HRSRC(WINAPI *)(
+      HMODULE, LPCWSTR, LPCWSTR))GetProcAddress(hKernel32, "FindResourceW");
+  orig.LoadResource = (HGLOBAL(WINAPI *)(HMODULE, HRSRC))GetProcAddress(
+      hKernel32, "LoadResource");
+  orig.SizeofResource = (DWORD(WINAPI *)(HMODULE, HRSRC))GetProcAddress(
+      hKernel32, "SizeofResource");
+  orig.LockResource =
+      (LPVOID(WINAPI *)(HGLOBAL))GetProcAddress(hKernel32, "LockResource");
+  orig.FreeResource =
+      (BOOL(WINAPI *)(HGLOBAL))GetProcAddress(hKernel32, "FreeResource");
+
+  if (!orig.FindResourceW || !orig.LoadResource || !orig.SizeofResource ||
+      !orig.LockResource || !orig.FreeResource) {
+    LogToFile(L"[ShaderHook] Failed to get original function pointers");
+    return;
+  }
+  SetResourceApi(orig);
+
+  HMODULE hLosslessOriginal = GetModuleHandleW(L"Lossless_original.dll");
+  if (!hLosslessOriginal) {
+    LogToFile(L"[ShaderHook] Failed to get Lossless_original.dll handle");
+    return;
+  }
+
+  // Every declared import hook in one IAT rewrite
+  const std::vector<ImportHooks::HookBase *> &hooks = ImportHooks::All();
+  std::vector<IatPatcher::IatPatch> patches;
+  for (ImportHooks::HookBase *hook : hooks) {
+    patches.push_back({hook->GetDllName(), hook->GetFunctionName(),
+                       hook->GetDispatch(), nullptr});
+  }
+  size_t patched = IatPatcher::PatchIatBatch(
+      hLosslessOriginal, patches.data(), patches.size(),
+      [&](const IatPatcher::IatPatch *found, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+          if (found[i].original)
+            hooks[i]->Install(found[i].original);
+        }
+        ForwardTo(g_findResourceHook, (void *)&HookedFindResourceW);
+        ForwardTo(g_loadResourceHook, (void *)&HookedLoadResource);
+        ForwardTo(g_sizeofResourceHook, (void *)&HookedSizeofResource);
+        ForwardTo(g_lockResourceHook, (void *)&HookedLockResource);
+        ForwardTo(g_freeResourceHook, (void *)&HookedFreeResource);
+      });
+  std::wostringstream oss;
+  oss << L"[ShaderHook] Patched " << patched << L" of " << patches.size()
+      << L" imports";
+  LogToFile(oss.str());
+
+  // Apply Patches if any addon requests it
+  if (ShouldApplyPatches()) {
+    std::vector<uint8_t> nops = {0x90, 0x90};
+    std::vector<DWORD> patchOffsets = {0x51ac, 0x59c6, 0x5ab7, 0x5bc9, 0x5ce2,
+                                       0x65ec, 0x6f04, 0x6fe7, 0x78a7, 0x7f86,
+                                       0x8056, 0x8128, 0x8201, 0x8bdc, 0x92f0,
+                                       0x941d, 0x9d6c, 0xa480, 0xa589};
+    for (DWORD rva : patchOffsets) {
+      PatchMemory(hLosslessOriginal, rva, nops);
+    }
+    LogToFile(L"[ShaderHook] Applied memory patches");
+  }
+
+  FlushInstructionCache(GetCurrentProcess(), nullptr, 0);
+  g_hooksInstalled = true;
+  LogToFile(L"[ShaderHook] Hooks installed");
+}
+
+void UninstallHooks() {
+  if (!g_hooksInstalled)
+    return;
+  g_hooksInstalled = false;
+  LogToFile(L"[ShaderHook] Hooks uninstalled");
+}
+
+} // namespace ShaderHook
@@ -0,0 +1,193 @@
+#include "shader_patch.hpp"
+#include "content_hash.hpp"
+#include "dxbc.hpp"
+#include "resource_key.hpp"
+#include <algorithm>
+#include <cstring>
+
+// Enough for every shader Lossless ships; a full cache just starts over
+static const size_t kMaxResults = 512;
+
+// A DXBC container already carries a hash of its contents; anything else
+// is hashed in full
+static uint64_t HashInput(const std::string &key, const uint8_t *data,
+                          uint32_t size) {
+  uint64_t hash = HashBytes(0, key.data(), key.size());
+  uint32_t magic = 0;
+  if (size >= 32)
+    std::memcpy(&magic, data, sizeof(magic));
+  if (magic == Dxbc::kMagic)
+    return HashBytes(hash, data, 32); // Magic, checksum, version, size
+  return HashBytes(hash, data, size);
+}
+
+uint32_t ShaderPatcher::Register(const ShaderPatch &patch, const void *owner) {
+  if (!patch.name || !patch.type || (patch.size > 0 && !patch.data))
+    return 0;
+  if (patch.kind == SHADER_PATCH_BYTES) {
+    if (patch.size == 0)
+      return 0;
+  } else if (patch.kind != SHADER_PATCH_CHUNK || patch.chunk == 0) {
+    return 0;
+  }
+
+  StoredPatch stored;
+  stored.owner = owner;
+  stored.key = MakeResourceKey(patch.name, patch.type);
+  stored.kind = patch.kind;
+  stored.chunk = patch.chunk;
+  stored.offset = patch.offset;
+  const uint8_t *data = (const uint8_t *)patch.data;
+  stored.data.assign(data, data + patch.size);
+  if (patch.kind == SHADER_PATCH_BYTES && patch.expected) {
+    const uint8_t *expected = (const uint8_t *)patch.expected;
+    stored.expected.assign(expected, expected + patch.size);
+  }
+
+  std::lock_guard<std::mutex> guard(lock);
+  stored.id = nextId++;
+  patches.push_back(std::move(stored));
+  PatchesChanged();
+  return patches.back().id;
+}
+
+void ShaderPatcher::Remove(uint32_t id) {
+  std::lock_guard<std::mutex> guard(lock);
+  patches.erase(std::remove_if(patches.begin(), patches.end(),
+                               [id](const StoredPatch &patch) {
+                                 return patch.id == id;
+                               }),
+                patches.end());
+  PatchesChanged();
+}
+
+void ShaderPatcher::RemoveOwner(const void *owner) {
+  if (!owner)
+    return;
+  std::lock_guard<std::mutex> guard(lock);
+  patches.erase(std::remove_if(patches.begin(), patches.end(),
+                               [owner](const StoredPatch &patch) {
+                                 return patch.owner == owner;
+                               }),
+                patches.end());
+  PatchesChanged();
+}
+
+void ShaderPatcher::PatchesChanged() {
+  results.clear();
+  stats.patches = (uint32_t)patches.size();
+  patchCount.store((uint32_t)patches.size(), std::memory_order_release);
+}
+
+bool ShaderPatcher::HasPatches(LPCWSTR name, LPCWSTR type) const {
+  if (patchCount.load(std::memory_order_acquire) == 0)
+    return false;
+  std::string key = MakeResourceKey(name, type);
+  std::lock_guard<std::mutex> guard(lock);
+  for (const StoredPatch &patch : patches) {
+    if (patch.key == key)
+      return true;
+  }
+  return false;
+}
+
+bool ShaderPatcher::Apply(LPCWSTR name, LPCWSTR type, const uint8_t *original,
+                          uint32_t size, std::vector<uint8_t> *out) {
+  if (patchCount.load(std::memory_order_acquire) == 0 || !original)
+    return false;
+  std::string key = MakeResourceKey(name, type);
+
+  std::lock_guard<std::mutex> guard(lock);
+  std::vector<const StoredPatch *> matching;
+  for (const StoredPatch &patch : patches) {
+    if (patch.key == key)
+      matching.push_back(&patch);
+  }
+  if (matching.empty())
+    return false;
+
+  uint64_t hash = HashInput(key, original, size);
+  auto it = results.find(hash);
+  if (it != results.end()) {
+    stats.cached++;
+    if (it->second.empty())
+      return false;
+    *out = it->second;
+    return true;
+  }
+
+  std::vector<uint8_t> patched;
+  bool applied = ApplyPatches(matching, original, size, &patched);
+  if (results.size() >= kMaxResults)
+    results.clear();
+  std::vector<uint8_t> &result = results[hash];
+  if (!applied)
+    return false;
+  stats.applied++;
+  result = patched;
+  out->swap(patched);
+  return true;
+}
+
+bool ShaderPatcher::ApplyPatches(
+    const std::vector<const StoredPatch *> &matching, const uint8_t *original,
+    uint32_t size, std::vector<uint8_t> *out) {
+  std::vector<uint8_t> work(original, original + size);
+  bool changed = false;
+  bool checksumStale = false;
+  Dxbc::Container container;
+
+  for (const StoredPatch *patch : matching) {
+    if (patch->kind == SHADER_PATCH_CHUNK) {
+      std::vector<uint8_t> rebuilt;
+      if (!Dxbc::ReplaceChunk(work.data(), work.size(), patch->chunk,
+                              patch->data.data(), patch->data.size(),
+                              &rebuilt)) {
+        stats.skipped++;
+        continue;
+      }
+      work.swap(rebuilt); // Comes with a fresh checksum
+      changed = true;
+      checksumStale = false;
+      continue;
+    }
+
+    size_t base = 0, limit = work.size();
+    if (patch->chunk != 0) {
+      const Dxbc::Chunk *chunk = nullptr;
+      if (container.Parse(work.data(), work.size()))
+        chunk = container.FindChunk(patch->chunk);
+      if (!chunk) {
+        stats.skipped++;
+        continue;
+      }
+      base = chunk->offset;
+      limit = chunk->size;
+    }
+    if (patch->offset > limit || patch->data.size() > limit - patch->offset) {
+      stats.skipped++;
+      continue;
+    }
+    uint8_t *target = work.data() + base + patch->offset;
+    if (!patch->expected.empty() &&
+        std::memcmp(target, patch->expected.data(), patch->expected.size())) {
+      stats.skipped++;
+      continue;
+    }
+    std::memcpy(target, patch->data.data(), patch->data.size());
+    changed = true;
+    checksumStale = true;
+  }
+
+  if (!changed)
+    return false;
+  if (checksumStale && container.Parse(work.data(), work.size()))
+    Dxbc::UpdateChecksum(work.data(), work.size());
+  out->swap(work);
+  return true;
+}
+
+ShaderPatcher::Stats ShaderPatcher::GetStats() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return stats;
+}
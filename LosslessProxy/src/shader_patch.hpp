@@ -0,0 +1,64 @@
+#pragma once
+#include "addon_api.hpp"
+#include "platform.hpp"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Host side of IHost::RegisterShaderPatch. Holds the registered patches and
+// applies them to a resource's original bytes (patching DXBC chunks and
+// fixing up the container checksum). Results are cached by a hash of the
+// original bytes, so Lossless reloading a shader costs one hash and a copy.
+class ShaderPatcher {
+public:
+  struct Stats {
+    uint32_t patches;
+    uint64_t applied;  // Resources patched from scratch
+    uint64_t cached;   // Served from the result cache
+    uint64_t skipped;  // Patches that did not fit (missing chunk, bounds,
+                       // expected bytes differ)
+  };
+
+  // owner identifies the registering addon for RemoveOwner; may be null
+  uint32_t Register(const ShaderPatch &patch, const void *owner);
+  void Remove(uint32_t id);
+  void RemoveOwner(const void *owner);
+
+  // Lock-free when nothing is registered
+  bool HasPatches(LPCWSTR name, LPCWSTR type) const;
+  // False if no patch applied; *out then stays untouched
+  bool Apply(LPCWSTR name, LPCWSTR type, const uint8_t *original,
+             uint32_t size, std::vector<uint8_t> *out);
+
+  Stats GetStats() const;
+
+private:
+  struct StoredPatch {
+    uint32_t id;
+    const void *owner;
+    std::string key; // MakeResourceKey
+    uint32_t kind;
+    uint32_t chunk;
+    uint32_t offset;
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> expected;
+  };
+
+  // Callers hold lock
+  bool ApplyPatches(const std::vector<const StoredPatch *> &patches,
+                    const uint8_t *original, uint32_t size,
+                    std::vector<uint8_t> *out);
+  void PatchesChanged();
+
+  mutable std::mutex lock;
+  std::vector<StoredPatch> patches;
+  std::atomic<uint32_t> patchCount{0};
+  uint32_t nextId = 1;
+  // Patched bytes keyed by resource, original-bytes hash; empty vectors
+  // record that nothing applied
+  std::unordered_map<uint64_t, std::vector<uint8_t>> results;
+  Stats stats = {};
+};
@@ -0,0 +1,149 @@
+#include "shared_stats.hpp"
+#include <cstring>
+#include <thread>
+
+namespace SharedStats {
+
+static const size_t kSegmentSize =
+    sizeof(Header) + (size_t)kMaxMetrics * sizeof(Metric);
+
+Writer::~Writer() { Close(); }
+
+bool Writer::Open(const char *name, uint64_t intervalMicros) {
+  if (IsOpen() || !Platform::CreateSharedMemory(name, kSegmentSize, &memory))
+    return false;
+
+  // Magic last: a reader that opens the segment this early sees no header
+  // yet rather than half of one
+  Header *header = GetHeader();
+  header->version = kVersion;
+  header->headerSize = sizeof(Header);
+  header->metricSize = sizeof(Metric);
+  header->maxMetrics = kMaxMetrics;
+  header->processId = Platform::GetProcessId();
+  header->intervalMicros = intervalMicros;
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic = kMagic;
+
+  staged.reserve(kMaxMetrics);
+  return true;
+}
+
+void Writer::Close() {
+  Platform::CloseSharedMemory(&memory);
+  staged.clear();
+  indices.clear();
+}
+
+Metric *Writer::Stage(const char *name, MetricKind kind) {
+  std::string key(name, strnlen(name, kNameLength - 1));
+  auto found = indices.find(key);
+  if (found != indices.end()) {
+    Metric &metric = staged[found->second];
+    metric.kind = kind;
+    return &metric;
+  }
+  if (staged.size() >= kMaxMetrics)
+    return nullptr;
+
+  Metric metric = {};
+  std::memcpy(metric.name, key.data(), key.size());
+  metric.kind = kind;
+  indices.emplace(std::move(key), (uint32_t)staged.size());
+  staged.push_back(metric);
+  return &staged.back();
+}
+
+void Writer::SetCounter(const char *name, uint64_t total) {
+  if (Metric *metric = Stage(name, kCounter))
+    metric->count = total;
+}
+
+void Writer::SetGauge(const char *name, double value) {
+  if (Metric *metric = Stage(name, kGauge))
+    metric->value = value;
+}
+
+void Writer::Publish(uint64_t nowMicros) {
+  Header *header = GetHeader();
+  if (!header)
+    return;
+
+  // Seqlock write, as in TelemetryHub::Publish
+  uint32_t sequence = header->sequence.load(std::memory_order_relaxed);
+  header->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  if (!staged.empty()) {
+    std::memcpy((void *)(header + 1), staged.data(),
+                staged.size() * sizeof(Metric));
+  }
+  header->metricCount = (uint32_t)staged.size();
+  header->publishCount++;
+  header->publishMicros = nowMicros;
+  header->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+Reader::~Reader() { Close(); }
+
+bool Reader::Open(const char *name) {
+  if (IsOpen() || !Platform::OpenSharedMemory(name, &memory))
+    return false;
+  const Header *header = (const Header *)memory.data;
+  bool readable = memory.size >= sizeof(Header) && header->magic == kMagic;
+  // Pairs with the fence in Writer::Open
+  std::atomic_thread_fence(std::memory_order_acquire);
+  readable = readable && header->version == kVersion &&
+             header->headerSize >= sizeof(Header) &&
+             header->metricSize >= sizeof(Metric) &&
+             header->headerSize +
+                     (uint64_t)header->maxMetrics * header->metricSize <=
+                 memory.size;
+  if (!readable)
+    Close();
+  return readable;
+}
+
+void Reader::Close() { Platform::CloseSharedMemory(&memory); }
+
+bool Reader::Read(Snapshot *out, int maxAttempts) const {
+  const Header *header = (const Header *)memory.data;
+  if (!header)
+    return false;
+  const uint8_t *first = (const uint8_t *)header + header->headerSize;
+
+  out->retries = 0;
+  for (int attempt = 0; attempt < maxAttempts; ++attempt) {
+    uint32_t before = header->sequence.load(std::memory_order_acquire);
+    if (before == 0)
+      return false; // Nothing published yet
+    if (before & 1) {
+      out->retries++;
+      std::this_thread::yield();
+      continue;
+    }
+
+    uint32_t count = header->metricCount;
+    if (count > header->maxMetrics)
+      count = header->maxMetrics; // Torn; the sequence check rejects it
+    out->processId = header->processId;
+    out->publishCount = header->publishCount;
+    out->publishMicros = header->publishMicros;
+    out->intervalMicros = header->intervalMicros;
+    out->metrics.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+      std::memcpy(&out->metrics[i], first + (size_t)i * header->metricSize,
+                  sizeof(Metric));
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header->sequence.load(std::memory_order_relaxed) == before) {
+      for (Metric &metric : out->metrics)
+        metric.name[kNameLength - 1] = 0;
+      return true;
+    }
+    out->retries++;
+  }
+  return false;
+}
+
+} // namespace SharedStats
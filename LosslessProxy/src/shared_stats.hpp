@@ -0,0 +1,126 @@
+#pragma once
+#include "platform.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Counters, gauges and histograms published into a named shared-memory
+// segment, so a dashboard in another process can sample the proxy as often
+// as it likes without any IPC round trip.
+//
+// One writer stages its metrics in private memory and copies them into the
+// segment under a seqlock: the sequence is odd while a copy is in progress,
+// and a reader keeps its own copy only if the sequence was even and
+// unchanged around it. Readers map the segment read-only, so they can never
+// slow down or corrupt the writer.
+//
+// The layout is versioned. Readers check magic and version and step through
+// metrics by metricSize, so fields appended later don't break them.
+namespace SharedStats {
+
+static constexpr const char *kSegmentName = "LosslessStats";
+static constexpr uint32_t kMagic = 0x5453534C; // "LSST"
+static constexpr uint32_t kVersion = 1;
+static constexpr uint32_t kMaxMetrics = 256;
+static constexpr uint32_t kNameLength = 48;
+static constexpr uint32_t kHistogramBins = 32;
+
+enum MetricKind : uint32_t {
+  kCounter = 1,   // Running total in count
+  kGauge = 2,     // Current value
+  kHistogram = 3, // count samples over [min, max]; mean in value
+};
+
+struct Metric {
+  char name[kNameLength]; // UTF-8, NUL-terminated, e.g. "cache/hot_bytes"
+  uint32_t kind;
+  uint32_t binCount; // Histograms: bins used, evenly spanning [min, max]
+  uint64_t count;
+  double value;
+  double min, max;
+  double p50, p95, p99;
+  uint32_t bins[kHistogramBins];
+};
+static_assert(sizeof(Metric) == 240, "Metric is part of the shared layout");
+
+struct Header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t headerSize; // Offset of the first metric
+  uint32_t metricSize;
+  uint32_t maxMetrics;
+  uint32_t processId;
+  std::atomic<uint32_t> sequence; // Odd while the writer copies
+  uint32_t metricCount;
+  uint64_t publishCount;
+  uint64_t publishMicros;  // Writer's steady clock at the last publish
+  uint64_t intervalMicros; // How often the writer means to publish
+};
+static_assert(sizeof(Header) == 56, "Header is part of the shared layout");
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "the sequence must work across processes");
+
+// What a reader copies out of the segment
+struct Snapshot {
+  uint32_t processId = 0;
+  uint64_t publishCount = 0;
+  uint64_t publishMicros = 0;
+  uint64_t intervalMicros = 0;
+  std::vector<Metric> metrics;
+  uint32_t retries = 0; // Copies dropped because the writer was mid-publish
+};
+
+// The publishing side; one per segment, used from one thread
+class Writer {
+public:
+  Writer() = default;
+  ~Writer();
+  Writer(const Writer &) = delete;
+  Writer &operator=(const Writer &) = delete;
+
+  // Fails if the name is taken by another live writer
+  bool Open(const char *name, uint64_t intervalMicros);
+  void Close();
+  bool IsOpen() const { return memory.data != nullptr; }
+
+  // The staged metric with this name, created (zeroed) on first use and
+  // keeping its slot from then on. nullptr when kMaxMetrics are taken.
+  // Names longer than kNameLength - 1 bytes are cut.
+  Metric *Stage(const char *name, MetricKind kind);
+  void SetCounter(const char *name, uint64_t total);
+  void SetGauge(const char *name, double value);
+
+  // Copies every staged metric into the segment at once
+  void Publish(uint64_t nowMicros);
+
+private:
+  Header *GetHeader() const { return (Header *)memory.data; }
+
+  Platform::SharedMemory memory;
+  std::vector<Metric> staged;
+  std::unordered_map<std::string, uint32_t> indices;
+};
+
+class Reader {
+public:
+  Reader() = default;
+  ~Reader();
+  Reader(const Reader &) = delete;
+  Reader &operator=(const Reader &) = delete;
+
+  // False if there's no segment, or one with a layout this build can't read
+  bool Open(const char *name);
+  void Close();
+  bool IsOpen() const { return memory.data != nullptr; }
+
+  // A consistent copy of the last publish. False if the writer kept
+  // publishing through maxAttempts copies (or never published).
+  bool Read(Snapshot *out, int maxAttempts = 100) const;
+
+private:
+  Platform::SharedMemory memory;
+};
+
+} // namespace SharedStats
@@ -0,0 +1,157 @@
+#include "stats_publisher.hpp"
+#include "addon_manager.hpp"
+#include "alloc_pool.hpp"
+#include "export_profile.hpp"
+#include "process_exit.hpp"
+#include "shader_hook.hpp"
+#include "trace.hpp"
+#include <chrono>
+#include <string>
+
+static_assert(SharedStats::kHistogramBins == TelemetryStats::kHistogramBins,
+              "telemetry histograms are published bin for bin");
+
+StatsPublisher::~StatsPublisher() { Stop(); }
+
+bool StatsPublisher::Start(AddonManager *addonManager, const char *segmentName,
+                           uint32_t interval) {
+  if (thread.joinable() || !addonManager)
+    return false;
+  intervalMs = interval ? interval : kDefaultIntervalMs;
+  if (!writer.Open(segmentName, (uint64_t)intervalMs * 1000))
+    return false;
+  manager = addonManager;
+  stopRequested = false;
+  exited.store(false);
+  thread = std::thread([this]() { Loop(); });
+  return true;
+}
+
+void StatsPublisher::Stop() {
+  if (!thread.joinable())
+    return;
+  {
+    std::lock_guard<std::mutex> guard(stopLock);
+    stopRequested = true;
+  }
+  stopSignal.notify_all();
+
+  // No join under the loader lock (see ProcessExit). A thread that never
+  // finished may still write: leave the mapping to the OS.
+  bool finished = ProcessExit::WaitForThreadExit(exited);
+  thread.detach();
+  if (finished)
+    writer.Close();
+}
+
+void StatsPublisher::Loop() {
+  std::unique_lock<std::mutex> guard(stopLock);
+  while (!stopRequested) {
+    guard.unlock();
+    Sample();
+    writer.Publish(Trace::NowMicros());
+    guard.lock();
+    stopSignal.wait_for(guard, std::chrono::milliseconds(intervalMs),
+                        [this]() { return stopRequested; });
+  }
+  exited.store(true, std::memory_order_release);
+}
+
+void StatsPublisher::Sample() {
+  ShaderHook::ShaderCache::Stats cache = ShaderHook::GetCacheStats();
+  writer.SetCounter("cache/finds", cache.finds);
+  writer.SetCounter("cache/stores", cache.stores);
+  writer.SetCounter("cache/contended", cache.contended);
+  writer.SetCounter("cache/evictions", cache.evictions);
+  writer.SetCounter("cache/restores", cache.restores);
+  writer.SetGauge("cache/entries", cache.entries);
+  writer.SetGauge("cache/held", cache.held);
+  writer.SetGauge("cache/hot_bytes", (double)cache.hotBytes);
+  writer.SetGauge("cache/cold_bytes", (double)cache.coldBytes);
+  writer.SetGauge("cache/cold_raw_bytes", (double)cache.coldRawBytes);
+
+  ResourcePrefetcher::Stats prefetch = ShaderHook::GetPrefetchStats();
+  writer.SetGauge("prefetch/logged", prefetch.logged);
+  writer.SetGauge("prefetch/warmed", prefetch.warmed);
+  writer.SetCounter("prefetch/hits", prefetch.hits);
+  writer.SetCounter("prefetch/misses", prefetch.misses);
+  writer.SetCounter("prefetch/stale", prefetch.stale);
+  writer.SetCounter("prefetch/saved_ns", prefetch.savedNanos);
+
+  ResourceOverlay::Stats overlay = ShaderHook::GetOverlayStats();
+  writer.SetGauge("overlay/files", overlay.files);
+  writer.SetGauge("overlay/mapped", overlay.mapped);
+  writer.SetGauge("overlay/mapped_bytes", (double)overlay.mappedBytes);
+  writer.SetCounter("overlay/served", overlay.served);
+  writer.SetCounter("overlay/rescans", overlay.rescans);
+
+  ShaderPatcher::Stats patches = manager->GetShaderPatcher().GetStats();
+  writer.SetGauge("patches/registered", patches.patches);
+  writer.SetCounter("patches/applied", patches.applied);
+  writer.SetCounter("patches/cached", patches.cached);
+  writer.SetCounter("patches/skipped", patches.skipped);
+
+  TransformChain::Stats transforms = manager->GetTransformChain().GetStats();
+  writer.SetGauge("transforms/stages", transforms.stages);
+  writer.SetCounter("transforms/runs", transforms.runs);
+  writer.SetCounter("transforms/stage_calls", transforms.stageCalls);
+  writer.SetCounter("transforms/memo_hits", transforms.memoHits);
+
+  AllocPool::PoolStats pool = AllocPool::GetPoolStats();
+  writer.SetGauge("imgui/slab_bytes", (double)pool.slabBytes);
+  writer.SetGauge("imgui/large_bytes", (double)pool.largeBytes);
+  for (int i = 0; i < AllocPool::GetTagCount(); ++i) {
+    AllocPool::TagStats tag;
+    if (!AllocPool::ReadTag(i, &tag))
+      continue;
+    std::string prefix = std::string("imgui/") + AllocPool::GetTagName(i);
+    writer.SetGauge((prefix + "/live_bytes").c_str(), (double)tag.liveBytes);
+    writer.SetCounter((prefix + "/allocations").c_str(), tag.allocations);
+  }
+
+  // Addon channels, with the aggregator's window and histogram as is
+  const TelemetryHub &telemetry = manager->GetTelemetry();
+  for (int i = 0; i < telemetry.GetChannelCount(); ++i) {
+    TelemetryStats stats;
+    if (!telemetry.ReadStats(i, &stats))
+      continue;
+    std::string name =
+        std::string("telemetry/") + telemetry.GetChannelName(i);
+    SharedStats::Metric *metric =
+        writer.Stage(name.c_str(), SharedStats::kHistogram);
+    if (!metric)
+      continue;
+    metric->count = stats.totalSamples;
+    metric->value = stats.mean;
+    metric->min = stats.min;
+    metric->max = stats.max;
+    metric->p50 = stats.p50;
+    metric->p95 = stats.p95;
+    metric->p99 = stats.p99;
+    metric->binCount = stats.windowSamples ? SharedStats::kHistogramBins : 0;
+    for (uint32_t bin = 0; bin < SharedStats::kHistogramBins; ++bin)
+      metric->bins[bin] = (uint32_t)stats.histogram[bin];
+  }
+
+  // Log2 buckets don't map onto even bins: percentiles only
+  if (!ExportProfile::IsActive())
+    return;
+  for (uint32_t i = 0; i < ExportProfile::kExportCount; ++i) {
+    ExportProfile::Stats stats =
+        ExportProfile::GetStats((ExportProfile::Export)i);
+    if (stats.calls == 0)
+      continue;
+    std::string name =
+        std::string("exports/") + ExportProfile::kExportNames[i];
+    SharedStats::Metric *metric =
+        writer.Stage(name.c_str(), SharedStats::kHistogram);
+    if (!metric)
+      continue;
+    metric->count = stats.calls;
+    metric->value = (double)stats.totalNanos / stats.calls;
+    metric->max = (double)stats.maxNanos;
+    metric->p50 = (double)ExportProfile::Percentile(stats, 0.50);
+    metric->p95 = (double)ExportProfile::Percentile(stats, 0.95);
+    metric->p99 = (double)ExportProfile::Percentile(stats, 0.99);
+  }
+}
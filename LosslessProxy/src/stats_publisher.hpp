@@ -0,0 +1,45 @@
+#pragma once
+#include "shared_stats.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+class AddonManager;
+
+// Samples the statistics the proxy already keeps for ShaderHook.log and the
+// manager window into a SharedStats segment on its own thread: the shader
+// cache, prefetching, shader patches and transforms, addon telemetry
+// channels, ImGui memory per tag and, when instrumented, export calls. The
+// hot paths do no extra work for it.
+class StatsPublisher {
+public:
+  static constexpr uint32_t kDefaultIntervalMs = 50;
+
+  StatsPublisher() = default;
+  ~StatsPublisher();
+  StatsPublisher(const StatsPublisher &) = delete;
+  StatsPublisher &operator=(const StatsPublisher &) = delete;
+
+  // manager must outlive Stop. False if running already or the segment
+  // can't be created.
+  bool Start(AddonManager *manager, const char *segmentName,
+             uint32_t intervalMs);
+  // Safe from DllMain: never joins
+  void Stop();
+
+private:
+  void Loop();
+  void Sample();
+
+  AddonManager *manager = nullptr;
+  SharedStats::Writer writer;
+  uint32_t intervalMs = kDefaultIntervalMs;
+
+  std::thread thread;
+  std::mutex stopLock;
+  std::condition_variable stopSignal;
+  bool stopRequested = false;
+  std::atomic<bool> exited{false};
+};
@@ -0,0 +1,204 @@
+#include "telemetry.hpp"
+#include "process_exit.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+TelemetryHub::~TelemetryHub() { Shutdown(); }
+
+TelemetryChannel *TelemetryHub::CreateChannel(const char *name,
+                                              const void *owner) {
+  if (!name)
+    return nullptr;
+
+  std::lock_guard<std::mutex> lock(createLock);
+  int count = channelCount.load(std::memory_order_relaxed);
+  for (int i = 0; i < count; ++i) {
+    Slot &slot = slots[i];
+    if (slot.name != name)
+      continue;
+    if (slot.claimed)
+      return nullptr; // A second producer would race the first
+    // Its last producer was unloaded (and with it, its thread)
+    slot.owner = owner;
+    slot.claimed = true;
+    return &slot.channel;
+  }
+  if (count >= kMaxChannels)
+    return nullptr;
+
+  Slot &slot = slots[count];
+  slot.name = name;
+  slot.owner = owner;
+  slot.claimed = true;
+  slot.ring.assign(kRingCapacity, 0.0f);
+  slot.window.assign(kWindowSize, 0.0f);
+  slot.history.assign(TelemetryStats::kHistoryLength, 0.0f);
+  slot.channel.writeIndex.store(0, std::memory_order_relaxed);
+  slot.channel.dropped.store(0, std::memory_order_relaxed);
+  slot.channel.readIndex.store(0, std::memory_order_relaxed);
+  slot.channel.capacityMask = kRingCapacity - 1;
+  slot.channel.samples = slot.ring.data();
+  for (auto &word : slot.published) // Reads as a zeroed TelemetryStats
+    word.store(0, std::memory_order_relaxed);
+  channelCount.store(count + 1, std::memory_order_release);
+
+  if (!aggregator.joinable() && !stopRequested.load()) {
+    aggregator = std::thread([this]() { AggregatorLoop(); });
+  }
+  return &slot.channel;
+}
+
+void TelemetryHub::ReleaseOwner(const void *owner) {
+  if (!owner)
+    return;
+  std::lock_guard<std::mutex> lock(createLock);
+  int count = channelCount.load(std::memory_order_relaxed);
+  for (int i = 0; i < count; ++i) {
+    if (slots[i].owner == owner)
+      slots[i].claimed = false;
+  }
+}
+
+void TelemetryHub::Shutdown() {
+  stopRequested.store(true);
+  if (!aggregator.joinable())
+    return;
+
+  // This can run from DllMain (see ProcessExit)
+  ProcessExit::WaitForThreadExit(aggregatorExited);
+  aggregator.detach();
+}
+
+int TelemetryHub::GetChannelCount() const {
+  return channelCount.load(std::memory_order_acquire);
+}
+
+const char *TelemetryHub::GetChannelName(int index) const {
+  if (index < 0 || index >= GetChannelCount())
+    return "";
+  return slots[index].name.c_str(); // Never changes once published
+}
+
+bool TelemetryHub::ReadStats(int index, TelemetryStats *out) const {
+  if (index < 0 || index >= GetChannelCount())
+    return false;
+
+  const Slot &slot = slots[index];
+  for (;;) {
+    uint32_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before & 1) {
+      std::this_thread::yield(); // Aggregator mid-publish
+      continue;
+    }
+    uint32_t words[kStatsWords];
+    for (size_t i = 0; i < kStatsWords; ++i)
+      words[i] = slot.published[i].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) == before) {
+      std::memcpy((void *)out, words, sizeof(TelemetryStats));
+      return true;
+    }
+  }
+}
+
+void TelemetryHub::AggregatorLoop() {
+  std::vector<float> scratch;
+  scratch.reserve(kWindowSize);
+
+  while (!stopRequested.load(std::memory_order_relaxed)) {
+    int count = GetChannelCount();
+    for (int i = 0; i < count; ++i) {
+      if (Drain(slots[i])) {
+        Publish(slots[i], scratch);
+      }
+    }
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(kAggregateIntervalMs));
+  }
+  aggregatorExited.store(true, std::memory_order_release);
+}
+
+bool TelemetryHub::Drain(Slot &slot) {
+  TelemetryChannel &channel = slot.channel;
+  uint32_t read = channel.readIndex.load(std::memory_order_relaxed);
+  uint32_t write = channel.writeIndex.load(std::memory_order_acquire);
+  if (read == write)
+    return false;
+
+  for (; read != write; ++read) {
+    float value = channel.samples[read & channel.capacityMask];
+
+    slot.window[slot.windowNext] = value;
+    slot.windowNext = (slot.windowNext + 1) % kWindowSize;
+    slot.windowCount = std::min(slot.windowCount + 1, kWindowSize);
+
+    slot.history[slot.historyNext] = value;
+    slot.historyNext = (slot.historyNext + 1) % TelemetryStats::kHistoryLength;
+    slot.historyCount = std::min<uint32_t>(slot.historyCount + 1,
+                                           TelemetryStats::kHistoryLength);
+    slot.totalSamples++;
+  }
+  channel.readIndex.store(write, std::memory_order_release);
+  return true;
+}
+
+void TelemetryHub::Publish(Slot &slot, std::vector<float> &scratch) {
+  TelemetryStats stats;
+  stats.totalSamples = slot.totalSamples;
+  stats.windowSamples = slot.windowCount;
+  stats.dropped = slot.channel.dropped.load(std::memory_order_relaxed);
+
+  // The window fills from index 0, so the first windowCount entries are valid
+  scratch.assign(slot.window.begin(), slot.window.begin() + slot.windowCount);
+  if (!scratch.empty()) {
+    auto minmax = std::minmax_element(scratch.begin(), scratch.end());
+    stats.min = *minmax.first;
+    stats.max = *minmax.second;
+    double sum = 0;
+    for (float v : scratch)
+      sum += v;
+    stats.mean = (float)(sum / scratch.size());
+
+    float range = stats.max - stats.min;
+    for (float v : scratch) {
+      int bin = range > 0.0f ? (int)((v - stats.min) / range *
+                                     TelemetryStats::kHistogramBins)
+                             : 0;
+      bin = std::min(bin, TelemetryStats::kHistogramBins - 1);
+      stats.histogram[bin] += 1.0f;
+    }
+
+    // Ascending percentiles, each selection narrowing the next
+    auto percentile = [&](float p, size_t from) {
+      size_t k = (size_t)(p * (scratch.size() - 1));
+      std::nth_element(scratch.begin() + from, scratch.begin() + k,
+                       scratch.end());
+      return k;
+    };
+    size_t k50 = percentile(0.50f, 0);
+    stats.p50 = scratch[k50];
+    size_t k95 = percentile(0.95f, k50);
+    stats.p95 = scratch[k95];
+    stats.p99 = scratch[percentile(0.99f, k95)];
+  }
+
+  uint32_t start = slot.historyCount < TelemetryStats::kHistoryLength
+                       ? 0
+                       : slot.historyNext;
+  for (uint32_t i = 0; i < slot.historyCount; ++i) {
+    stats.history[i] =
+        slot.history[(start + i) % TelemetryStats::kHistoryLength];
+  }
+  stats.historyCount = (int)slot.historyCount;
+
+  // Seqlock write: odd sequence while the copy is in progress
+  uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+  slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  uint32_t words[kStatsWords];
+  std::memcpy(words, &stats, sizeof(TelemetryStats));
+  for (size_t i = 0; i < kStatsWords; ++i)
+    slot.published[i].store(words[i], std::memory_order_relaxed);
+  slot.sequence.store(sequence + 2, std::memory_order_release);
+}
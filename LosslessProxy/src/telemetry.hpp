@@ -0,0 +1,94 @@
+#pragma once
+#include "addon_api.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Aggregated view of one telemetry channel over its rolling window
+struct TelemetryStats {
+  static constexpr int kHistogramBins = 32;
+  static constexpr int kHistoryLength = 120;
+
+  uint64_t totalSamples = 0;
+  uint32_t windowSamples = 0;
+  uint32_t dropped = 0;
+  float p50 = 0, p95 = 0, p99 = 0;
+  float min = 0, max = 0, mean = 0;
+  float histogram[kHistogramBins] = {}; // Bins span [min, max]
+  float history[kHistoryLength] = {};   // Most recent samples, oldest first
+  int historyCount = 0;
+};
+
+// Owns the telemetry rings handed to addons. An aggregator thread drains them
+// and publishes TelemetryStats per channel under a seqlock, so the GUI reads
+// without taking locks.
+class TelemetryHub {
+public:
+  static constexpr int kMaxChannels = 64;
+  static constexpr uint32_t kRingCapacity = 4096;
+  static constexpr uint32_t kWindowSize = 2048;
+  static constexpr uint32_t kAggregateIntervalMs = 100;
+
+  TelemetryHub() = default;
+  ~TelemetryHub();
+  TelemetryHub(const TelemetryHub &) = delete;
+  TelemetryHub &operator=(const TelemetryHub &) = delete;
+
+  // Starts the aggregator on first use. nullptr when all slots are taken or
+  // the name is in use: each channel has exactly one producer. owner
+  // identifies the creating addon for ReleaseOwner; may be null.
+  TelemetryChannel *CreateChannel(const char *name, const void *owner);
+  // The owner is unloaded: its channels may be created again, and keep
+  // their history
+  void ReleaseOwner(const void *owner);
+  void Shutdown();
+
+  // Lock-free readers (GUI thread)
+  int GetChannelCount() const;
+  const char *GetChannelName(int index) const;
+  bool ReadStats(int index, TelemetryStats *out) const;
+
+private:
+  static constexpr size_t kStatsWords =
+      sizeof(TelemetryStats) / sizeof(uint32_t);
+  static_assert(sizeof(TelemetryStats) % sizeof(uint32_t) == 0,
+                "TelemetryStats is published in whole words");
+
+  struct Slot {
+    std::string name;
+    const void *owner = nullptr; // Under createLock
+    bool claimed = false;        // Under createLock: has a producer
+    TelemetryChannel channel;
+    std::vector<float> ring;
+
+    // Aggregator-owned
+    std::vector<float> window;
+    uint32_t windowNext = 0;
+    uint32_t windowCount = 0;
+    uint64_t totalSamples = 0;
+    std::vector<float> history;
+    uint32_t historyNext = 0;
+    uint32_t historyCount = 0;
+
+    // Seqlock: TelemetryStats copied as relaxed atomic words, so a reader
+    // overlapping the copy is defined and only fails the sequence check
+    mutable std::atomic<uint32_t> sequence{0};
+    std::atomic<uint32_t> published[kStatsWords];
+  };
+
+  void AggregatorLoop();
+  bool Drain(Slot &slot);
+  void Publish(Slot &slot, std::vector<float> &scratch);
+
+  Slot slots[kMaxChannels];
+  std::atomic<int> channelCount{0};
+  std::mutex createLock;
+
+  std::thread aggregator;
+  std::atomic<bool> stopRequested{false};
+  std::atomic<bool> aggregatorExited{false};
+};
@@ -0,0 +1,162 @@
+#include "trace.hpp"
+#include <chrono>
+
+namespace Trace {
+
+// Outside the #ifdef: the proxy also times DllMain without a tracer
+uint64_t NowMicros() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+} // namespace Trace
+
+#ifdef LOSSLESS_ENABLE_TRACE
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace Trace {
+
+struct Event {
+  const char *name;
+  uint64_t start;
+  uint64_t end; // 0 while the span is open
+};
+
+// Only the owning thread appends; the lock is uncontended except while a
+// trace is being written.
+struct ThreadBuffer {
+  uint32_t tid = 0;
+  const char *threadName = nullptr;
+  std::mutex lock;
+  std::vector<Event> events;
+  std::vector<size_t> open;
+};
+
+// Leaked on purpose: spans may still be recorded during DLL_PROCESS_DETACH
+static std::mutex g_registryLock;
+static std::vector<ThreadBuffer *> *g_buffers = nullptr;
+static std::unordered_set<std::string> *g_names = nullptr;
+static thread_local ThreadBuffer *t_buffer = nullptr;
+
+static ThreadBuffer *GetThreadBuffer() {
+  if (!t_buffer) {
+    ThreadBuffer *buffer = new ThreadBuffer();
+    buffer->events.reserve(256);
+    std::lock_guard<std::mutex> lock(g_registryLock);
+    if (!g_buffers)
+      g_buffers = new std::vector<ThreadBuffer *>();
+    buffer->tid = (uint32_t)g_buffers->size() + 1;
+    g_buffers->push_back(buffer);
+    t_buffer = buffer;
+  }
+  return t_buffer;
+}
+
+const char *Intern(const std::string &name) {
+  std::lock_guard<std::mutex> lock(g_registryLock);
+  if (!g_names)
+    g_names = new std::unordered_set<std::string>();
+  return g_names->insert(name).first->c_str();
+}
+
+void BeginSpan(const char *name) {
+  ThreadBuffer *buffer = GetThreadBuffer();
+  uint64_t now = NowMicros();
+  std::lock_guard<std::mutex> lock(buffer->lock);
+  buffer->open.push_back(buffer->events.size());
+  buffer->events.push_back({name, now, 0});
+}
+
+void EndSpan() {
+  ThreadBuffer *buffer = GetThreadBuffer();
+  uint64_t now = NowMicros();
+  std::lock_guard<std::mutex> lock(buffer->lock);
+  if (buffer->open.empty())
+    return; // Unbalanced EndSpan (e.g. from an addon)
+  buffer->events[buffer->open.back()].end = now;
+  buffer->open.pop_back();
+}
+
+void SetThreadName(const char *name) {
+  ThreadBuffer *buffer = GetThreadBuffer();
+  std::lock_guard<std::mutex> lock(buffer->lock);
+  buffer->threadName = name;
+}
+
+static void WriteJsonString(std::ofstream &out, const char *text) {
+  out << '"';
+  for (const char *p = text; *p; ++p) {
+    unsigned char c = (unsigned char)*p;
+    if (c == '"' || c == '\\') {
+      out << '\\' << (char)c;
+    } else if (c < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      out << escaped;
+    } else {
+      out << (char)c;
+    }
+  }
+  out << '"';
+}
+
+bool WriteChromeTrace(const std::filesystem::path &path) {
+  std::ofstream out(path, std::ios::out | std::ios::trunc);
+  if (!out.is_open())
+    return false;
+
+  uint64_t now = NowMicros();
+  std::lock_guard<std::mutex> registryLock(g_registryLock);
+  if (!g_buffers) {
+    out << "{\"traceEvents\":[]}\n";
+    return true;
+  }
+
+  // Timestamps relative to the first recorded span
+  uint64_t origin = UINT64_MAX;
+  for (ThreadBuffer *buffer : *g_buffers) {
+    std::lock_guard<std::mutex> lock(buffer->lock);
+    for (const Event &event : buffer->events) {
+      if (event.start < origin)
+        origin = event.start;
+    }
+  }
+  if (origin == UINT64_MAX)
+    origin = now;
+
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  bool first = true;
+  for (ThreadBuffer *buffer : *g_buffers) {
+    std::lock_guard<std::mutex> lock(buffer->lock);
+    if (buffer->threadName) {
+      out << (first ? "" : ",\n")
+          << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+          << buffer->tid << ",\"args\":{\"name\":";
+      WriteJsonString(out, buffer->threadName);
+      out << "}}";
+      first = false;
+    }
+    for (const Event &event : buffer->events) {
+      uint64_t end = event.end ? event.end : now; // Still open: clamp
+      out << (first ? "" : ",\n") << "{\"name\":";
+      WriteJsonString(out, event.name);
+      out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+          << ",\"ts\":" << (event.start - origin)
+          << ",\"dur\":" << (end - event.start) << "}";
+      first = false;
+    }
+  }
+  out << "\n]}\n";
+  return out.good();
+}
+
+} // namespace Trace
+
+#endif // LOSSLESS_ENABLE_TRACE
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+// Startup timeline tracer. Spans go into per-thread buffers stamped with a
+// monotonic clock and are written as Chrome trace-event JSON, viewable in
+// chrome://tracing or ui.perfetto.dev.
+//
+// Everything but NowMicros is compiled out unless LOSSLESS_ENABLE_TRACE is
+// defined; use the LS_TRACE_* macros so call sites vanish with it.
+namespace Trace {
+
+// Steady clock, in microseconds
+uint64_t NowMicros();
+
+// Names must stay valid until the trace is written: pass string literals or
+// the result of Intern().
+const char *Intern(const std::string &name);
+void BeginSpan(const char *name);
+void EndSpan();
+void SetThreadName(const char *name);
+
+bool WriteChromeTrace(const std::filesystem::path &path);
+
+class ScopedSpan {
+public:
+  explicit ScopedSpan(const char *name) { BeginSpan(name); }
+  ~ScopedSpan() { EndSpan(); }
+  ScopedSpan(const ScopedSpan &) = delete;
+  ScopedSpan &operator=(const ScopedSpan &) = delete;
+};
+
+} // namespace Trace
+
+#define LS_TRACE_CONCAT_INNER(a, b) a##b
+#define LS_TRACE_CONCAT(a, b) LS_TRACE_CONCAT_INNER(a, b)
+
+#ifdef LOSSLESS_ENABLE_TRACE
+#define LS_TRACE_SCOPE(name)                                                   \
+  Trace::ScopedSpan LS_TRACE_CONCAT(lsTraceSpan, __LINE__)(name)
+// For names built at runtime; the expression is not evaluated when disabled
+#define LS_TRACE_SCOPE_DYNAMIC(nameExpr)                                       \
+  Trace::ScopedSpan LS_TRACE_CONCAT(lsTraceSpan,                               \
+                                    __LINE__)(Trace::Intern(nameExpr))
+#define LS_TRACE_BEGIN(name) Trace::BeginSpan(name)
+#define LS_TRACE_END() Trace::EndSpan()
+#define LS_TRACE_THREAD_NAME(name) Trace::SetThreadName(name)
+#define LS_TRACE_WRITE(path) Trace::WriteChromeTrace(path)
+#else
+#define LS_TRACE_SCOPE(name) ((void)0)
+#define LS_TRACE_SCOPE_DYNAMIC(nameExpr) ((void)0)
+#define LS_TRACE_BEGIN(name) ((void)0)
+#define LS_TRACE_END() ((void)0)
+#define LS_TRACE_THREAD_NAME(name) ((void)0)
+#define LS_TRACE_WRITE(path) ((void)0)
+#endif
@@ -0,0 +1,109 @@
+#include "transform_chain.hpp"
+#include "content_hash.hpp"
+#include "resource_key.hpp"
+
+// Stage results kept across all resources; a full memo just starts over
+static const size_t kMaxMemo = 1024;
+
+void TransformChain::SetStages(const std::vector<Stage> &newStages) {
+  auto chain = std::make_shared<std::vector<ChainStage>>();
+  for (const Stage &stage : newStages) {
+    uint64_t identity = HashBytes(0, stage.name.data(), stage.name.size());
+    identity = HashBytes(identity, stage.version.data(), stage.version.size());
+    chain->push_back({stage, identity});
+  }
+
+  // Memo entries stay: they are keyed by stage identity, so an addon that
+  // is re-enabled finds its old results
+  std::lock_guard<std::mutex> guard(lock);
+  stages = chain;
+  stats.stages = (uint32_t)chain->size();
+  stageCount.store((uint32_t)chain->size(), std::memory_order_release);
+}
+
+bool TransformChain::Run(LPCWSTR name, LPCWSTR type, const uint8_t *input,
+                         uint32_t size, std::vector<uint8_t> *out) {
+  std::shared_ptr<const std::vector<ChainStage>> chain;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    chain = stages;
+    stats.runs++;
+  }
+  if (!chain || chain->empty() || !input)
+    return false;
+
+  std::string key = MakeResourceKey(name, type);
+  uint64_t resourceHash = HashBytes(0, key.data(), key.size());
+
+  // The current stage input: the caller's bytes until a stage replaces them
+  std::shared_ptr<const Memo> current;
+  const uint8_t *data = input;
+  uint32_t dataSize = size;
+  uint64_t dataHash = HashBytes(resourceHash, input, size);
+
+  for (const ChainStage &link : *chain) {
+    const Stage &stage = link.stage;
+    uint64_t memoKey = 0;
+    if (stage.settingsHash) {
+      memoKey = HashMix(HashMix(dataHash, link.identity), stage.settingsHash());
+      std::shared_ptr<const Memo> hit;
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = memo.find(memoKey);
+        if (it != memo.end()) {
+          hit = it->second;
+          stats.memoHits++;
+        }
+      }
+      if (hit) {
+        if (hit->replaced) {
+          current = hit;
+          data = hit->data.data();
+          dataSize = (uint32_t)hit->data.size();
+          dataHash = hit->dataHash;
+        }
+        continue;
+      }
+    }
+
+    // Outside the lock: addons may take as long as they like
+    const void *outData = nullptr;
+    uint32_t outSize = 0;
+    bool replaced = stage.transform(name, type, data, dataSize, &outData,
+                                    &outSize) &&
+                    outData;
+
+    auto result = std::make_shared<Memo>();
+    result->replaced = replaced;
+    if (replaced) {
+      const uint8_t *bytes = (const uint8_t *)outData;
+      result->data.assign(bytes, bytes + outSize);
+      result->dataHash = HashBytes(resourceHash, bytes, outSize);
+    }
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      stats.stageCalls++;
+      if (stage.settingsHash) {
+        if (memo.size() >= kMaxMemo)
+          memo.clear();
+        memo[memoKey] = result;
+      }
+    }
+    if (replaced) {
+      current = result;
+      data = result->data.data();
+      dataSize = (uint32_t)result->data.size();
+      dataHash = result->dataHash;
+    }
+  }
+
+  if (!current)
+    return false;
+  out->assign(data, data + dataSize);
+  return true;
+}
+
+TransformChain::Stats TransformChain::GetStats() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return stats;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "addon_api.hpp"
+#include "platform.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// The AddonTransformResource stages, in order. Each stage's output is
+// memoized by (stage, input hash, addon version, settings hash), so after a
+// settings change only that stage reruns, and the stages after it only if
+// their input actually changed. Stages without AddonGetSettingsHash are
+// never memoized.
+class TransformChain {
+public:
+  struct Stage {
+    std::string name;    // Addon name, UTF-8
+    std::string version; // GetAddonVersion, may be empty
+    AddonTransformResource_t transform;
+    AddonGetSettingsHash_t settingsHash; // May be null
+  };
+
+  struct Stats {
+    uint32_t stages;
+    uint64_t runs;
+    uint64_t stageCalls; // Into addons
+    uint64_t memoHits;   // Stage results reused
+  };
+
+  void SetStages(const std::vector<Stage> &stages);
+  // Lock-free
+  bool IsEmpty() const {
+    return stageCount.load(std::memory_order_acquire) == 0;
+  }
+
+  // False if every stage passed the input through; *out then stays untouched
+  bool Run(LPCWSTR name, LPCWSTR type, const uint8_t *input, uint32_t size,
+           std::vector<uint8_t> *out);
+
+  Stats GetStats() const;
+
+private:
+  struct ChainStage {
+    Stage stage;
+    uint64_t identity; // Name and version
+  };
+
+  struct Memo {
+    bool replaced;
+    std::vector<uint8_t> data;
+    uint64_t dataHash;
+  };
+
+  mutable std::mutex lock;
+  // Replaced, never modified, so Run can use it outside the lock
+  std::shared_ptr<const std::vector<ChainStage>> stages;
+  std::atomic<uint32_t> stageCount{0};
+  std::unordered_map<uint64_t, std::shared_ptr<const Memo>> memo;
+  Stats stats = {};
+};
@@ -0,0 +1,2082 @@
+// Unit tests for LosslessCore, without Windows or Lossless. Each suite is
+// one ctest test:
+//
+//   core_tests [suite...]
+//
+// runs the named suites, or all of them. A failed CHECK prints its location
+// and the suite goes on; the exit code is the number of failed checks.
+
+#include "addon_manager.hpp"
+#include "alloc_pool.hpp"
+#include "bench_support.hpp"
+#include "control_protocol.hpp"
+#include "dxbc.hpp"
+#include "frame_scheduler.hpp"
+#include "headless_host.hpp"
+#include "import_hook.hpp"
+#include "ini_file.hpp"
+#include "intercept_batch.hpp"
+#include "lz4_block.hpp"
+#include "pe_image.hpp"
+#include "process_exit.hpp"
+#include "rcu.hpp"
+#include "resource_overlay.hpp"
+#include "resource_prefetch.hpp"
+#include "resource_trace.hpp"
+#include "shader_cache.hpp"
+#include "shader_patch.hpp"
+#include "shared_stats.hpp"
+#include "telemetry.hpp"
+#include "transform_chain.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static int g_failures = 0;
+
+#define CHECK(condition)                                                       \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,             \
+                  #condition);                                                 \
+      g_failures++;                                                            \
+    }                                                                          \
+  } while (0)
+
+// A scratch directory under the system temp, removed again by the suite
+static fs::path ScratchPath(const char *name) {
+  fs::path path = fs::temp_directory_path() /
+                  ("core_tests_" + std::to_string(Platform::GetProcessId()) +
+                   "_" + name);
+  std::error_code ec;
+  fs::remove_all(path, ec);
+  return path;
+}
+
+// --- IniFile ---------------------------------------------------------------
+
+static void TestIniFile() {
+  fs::path path = ScratchPath("config.ini");
+  {
+    std::ofstream out(path);
+    out << "; Written by hand\n"
+        << "[Addons]\n"
+        << "LS_Addon_A=1\n"
+        << "ls_addon_b = 0\n"
+        << "\n"
+        << "[TransformOrder]\n"
+        << "LS_Addon_A=25 (first)\n"
+        << "Unknown=kept\n";
+  }
+
+  IniFile ini;
+  CHECK(ini.Load(path));
+  CHECK(ini.Get("Addons", "LS_Addon_A", "") == "1");
+  // Section and key names match case-insensitively
+  CHECK(ini.Get("addons", "LS_ADDON_B", "") == "0");
+  CHECK(ini.Get("Addons", "LS_Addon_C", "default") == "default");
+  CHECK(ini.Get("Missing", "LS_Addon_A", "none") == "none");
+  // Leading digits only, as GetPrivateProfileInt
+  CHECK(ini.GetInt("TransformOrder", "LS_Addon_A", 100) == 25);
+  CHECK(ini.GetInt("TransformOrder", "Unknown", 100) == 0);
+  CHECK(ini.GetInt("TransformOrder", "Absent", 100) == 100);
+
+  ini.Set("Addons", "LS_Addon_B", "1");
+  ini.Set("Addons", "LS_Addon_C", "0");
+  ini.Set("ResourceOverlay", "PollMs", "250");
+  CHECK(ini.Save(path));
+
+  IniFile reloaded;
+  CHECK(reloaded.Load(path));
+  CHECK(reloaded.Get("Addons", "LS_Addon_B", "") == "1");
+  CHECK(reloaded.Get("Addons", "LS_Addon_C", "") == "0");
+  CHECK(reloaded.GetInt("ResourceOverlay", "PollMs", 0) == 250);
+  CHECK(reloaded.Get("TransformOrder", "Unknown", "") == "kept");
+
+  // Comments and unknown keys survive the round trip
+  std::ifstream in(path);
+  std::string text((std::istreambuf_iterator<char>(in)),
+                   std::istreambuf_iterator<char>());
+  CHECK(text.find("; Written by hand") != std::string::npos);
+  CHECK(text.find("Unknown=kept") != std::string::npos);
+  in.close();
+
+  fs::remove(path);
+  IniFile missing;
+  CHECK(!missing.Load(path));
+  CHECK(missing.Get("Addons", "LS_Addon_A", "default") == "default");
+}
+
+// --- PeImage ---------------------------------------------------------------
+
+// A PE32+ image importing kernel32!FindResourceW and user32!MessageBoxW,
+// with its section at file offset == RVA so the same bytes parse both as a
+// mapped module and as a file
+static std::vector<uint8_t> BuildImage() {
+  std::vector<uint8_t> image(0x3000, 0);
+  auto put16 = [&](size_t at, uint16_t v) { std::memcpy(&image[at], &v, 2); };
+  auto put32 = [&](size_t at, uint32_t v) { std::memcpy(&image[at], &v, 4); };
+  auto put64 = [&](size_t at, uint64_t v) { std::memcpy(&image[at], &v, 8); };
+  auto putString = [&](size_t at, const char *s) {
+    std::memcpy(&image[at], s, std::strlen(s) + 1);
+  };
+
+  put16(0, 0x5A4D);
+  put32(0x3C, 0x80);
+  put32(0x80, 0x4550);
+  const size_t fileHeader = 0x84, optional = fileHeader + 20;
+  put16(fileHeader + 0, 0x8664);
+  put16(fileHeader + 2, 1);          // NumberOfSections
+  put16(fileHeader + 16, 112 + 128); // SizeOfOptionalHeader
+  put16(optional, 0x20B);
+  put32(optional + 56, (uint32_t)image.size()); // SizeOfImage
+  put32(optional + 108, 16);                    // NumberOfRvaAndSizes
+  put32(optional + 112 + 8, 0x1000);            // Import directory
+  put32(optional + 112 + 12, 3 * 20);
+
+  const size_t section = optional + 240;
+  put32(section + 8, 0x2000);  // VirtualSize
+  put32(section + 12, 0x1000); // VirtualAddress
+  put32(section + 16, 0x2000); // SizeOfRawData
+  put32(section + 20, 0x1000); // PointerToRawData
+
+  const char *dlls[2] = {"USER32.dll", "KERNEL32.dll"};
+  const char *functions[2] = {"MessageBoxW", "FindResourceW"};
+  for (int d = 0; d < 2; ++d) {
+    size_t descriptor = 0x1000 + d * 20;
+    size_t lookup = 0x1800 + d * 0x40, iat = 0x1A00 + d * 0x40;
+    size_t dllName = 0x1100 + d * 0x20, hintName = 0x1200 + d * 0x20;
+    put32(descriptor + 0, (uint32_t)lookup);
+    put32(descriptor + 12, (uint32_t)dllName);
+    put32(descriptor + 16, (uint32_t)iat);
+    putString(dllName, dlls[d]);
+    putString(hintName + 2, functions[d]);
+    put64(lookup, hintName);
+    put64(iat, 0x7FF000000000ull + d); // As the loader would fill it
+  }
+  return image;
+}
+
+static void TestPeImage() {
+  std::vector<uint8_t> image = BuildImage();
+
+  PeImage mapped;
+  CHECK(mapped.Parse(image.data(), 0, true));
+  CHECK(mapped.IsValid() && mapped.Is64Bit());
+  CHECK(mapped.GetThunkSize() == 8);
+  void *slot = mapped.FindImportSlot("kernel32.dll", "FindResourceW");
+  CHECK(slot == image.data() + 0x1A40);
+  // DLL names match case-insensitively, function names exactly
+  CHECK(mapped.FindImportSlot("KERNEL32.DLL", "FindResourceW") == slot);
+  CHECK(!mapped.FindImportSlot("kernel32.dll", "findresourcew"));
+  CHECK(!mapped.FindImportSlot("kernel32.dll", "MessageBoxW"));
+  CHECK(mapped.FindImportSlot("user32.dll", "MessageBoxW") ==
+        image.data() + 0x1A00);
+  CHECK(!mapped.FindImportSlot("gdi32.dll", "FindResourceW"));
+
+  PeImage file;
+  CHECK(file.Parse(image.data(), image.size(), false));
+  CHECK(file.FindImportSlot("kernel32.dll", "FindResourceW") == slot);
+  CHECK(file.ListResources().empty());
+  uint32_t rva = 0, size = 0;
+  CHECK(file.GetDirectory(1, &rva, &size) && rva == 0x1000);
+  CHECK(!file.RvaToPointer(0x3000));
+
+  // Not an image, or cut off inside the headers
+  std::vector<uint8_t> garbage(512, 0xCC);
+  PeImage bad;
+  CHECK(!bad.Parse(garbage.data(), garbage.size(), false));
+  CHECK(!bad.Parse(image.data(), 0x100, false));
+  CHECK(!bad.FindImportSlot("kernel32.dll", "FindResourceW"));
+}
+
+// --- ShaderCache -----------------------------------------------------------
+
+// Compressible, but not trivially: a few repeated instruction-like words
+static std::vector<uint8_t> ShaderLikeBytes(size_t size, uint32_t seed) {
+  std::vector<uint8_t> bytes(size);
+  std::mt19937 rng(seed);
+  for (size_t i = 0; i < size; i += 4) {
+    uint32_t word = 0x01000000u | (rng() % 16) << 8 | (rng() % 4);
+    std::memcpy(&bytes[i], &word, std::min<size_t>(4, size - i));
+  }
+  return bytes;
+}
+
+static HRSRC Handle(uintptr_t id) { return (HRSRC)(0x10000 + id); }
+
+static void TestShaderCache() {
+  using ShaderHook::ShaderCache;
+  std::vector<uint8_t> a = ShaderLikeBytes(4096, 1);
+  std::vector<uint8_t> b = ShaderLikeBytes(4096, 2);
+
+  {
+    ShaderCache cache;
+    cache.Store(Handle(1), a.data(), (uint32_t)a.size());
+    CHECK(cache.Contains(Handle(1)));
+    CHECK(!cache.Contains(Handle(2)));
+    CHECK(cache.GetSize(Handle(1)) == a.size());
+    CHECK(cache.GetSize(Handle(2)) == 0);
+    CHECK(!cache.Lock(Handle(2)));
+
+    cache.AddRef(Handle(1));
+    const void *locked = cache.Lock(Handle(1));
+    CHECK(locked && std::memcmp(locked, a.data(), a.size()) == 0);
+    CHECK(cache.GetStats().held == 1);
+    CHECK(cache.Lock(Handle(1)) == locked);
+
+    // Stored again while held: the old pointer stays readable until the
+    // last FreeResource
+    cache.Store(Handle(1), b.data(), (uint32_t)b.size());
+    CHECK(std::memcmp(locked, a.data(), a.size()) == 0);
+    CHECK(cache.GetStats().hotBytes == a.size() + b.size());
+    const void *replaced = cache.Lock(Handle(1));
+    CHECK(replaced && std::memcmp(replaced, b.data(), b.size()) == 0);
+    CHECK(std::memcmp(locked, a.data(), a.size()) == 0);
+    cache.Release(Handle(1));
+    CHECK(cache.GetStats().held == 0);
+    CHECK(cache.GetStats().hotBytes == b.size());
+    cache.Release(Handle(1)); // One too many: ignored
+
+    cache.Clear();
+    CHECK(cache.GetCount() == 0);
+    CHECK(cache.GetStats().hotBytes == 0);
+  }
+
+  {
+    // Room for one entry hot: older ones without holds go cold
+    ShaderCache cache;
+    cache.SetBudget(6000);
+    cache.Store(Handle(1), a.data(), (uint32_t)a.size());
+    cache.Store(Handle(2), b.data(), (uint32_t)b.size());
+    ShaderCache::Stats stats = cache.GetStats();
+    CHECK(stats.evictions == 1);
+    CHECK(stats.hotBytes == b.size());
+    CHECK(stats.coldRawBytes == a.size());
+    CHECK(stats.coldBytes > 0 && stats.coldBytes < a.size());
+    CHECK(cache.GetSize(Handle(1)) == a.size());
+
+    // Lock brings it back, and the other one goes cold in its place
+    const void *restored = cache.Lock(Handle(1));
+    CHECK(restored && std::memcmp(restored, a.data(), a.size()) == 0);
+    stats = cache.GetStats();
+    CHECK(stats.restores == 1);
+    CHECK(stats.evictions == 2);
+    CHECK(stats.hotBytes == a.size());
+    CHECK(stats.held == 1);
+
+    // Held entries stay hot, over budget or not
+    CHECK(cache.Lock(Handle(2)) != nullptr);
+    CHECK(cache.GetStats().hotBytes == a.size() + b.size());
+    CHECK(std::memcmp(restored, a.data(), a.size()) == 0);
+
+    // Released, they are candidates again
+    cache.Release(Handle(1));
+    stats = cache.GetStats();
+    CHECK(stats.evictions == 3);
+    CHECK(stats.hotBytes == b.size());
+    cache.Release(Handle(2));
+    CHECK(cache.GetStats().held == 0);
+    CHECK(cache.GetStats().evictions == 3);
+  }
+
+  {
+    // Load -> Lock -> pressure -> Free: the bytes stay put while held, then
+    // age like any other entry
+    ShaderCache cache;
+    cache.SetBudget(6000);
+    cache.Store(Handle(1), a.data(), (uint32_t)a.size());
+    cache.AddRef(Handle(1));
+    const void *locked = cache.Lock(Handle(1));
+    for (uintptr_t id = 2; id < 10; ++id) {
+      std::vector<uint8_t> other = ShaderLikeBytes(4096, (uint32_t)id + 10);
+      cache.Store(Handle(id), other.data(), (uint32_t)other.size());
+    }
+    CHECK(locked && std::memcmp(locked, a.data(), a.size()) == 0);
+    ShaderCache::Stats stats = cache.GetStats();
+    CHECK(stats.evictions == 7); // All but the held one and the newest
+    CHECK(stats.hotBytes == 2 * a.size());
+
+    cache.Release(Handle(1)); // Now the most recent: the newest goes cold
+    stats = cache.GetStats();
+    CHECK(stats.evictions == 8);
+    CHECK(stats.hotBytes == a.size());
+    cache.Store(Handle(10), b.data(), (uint32_t)b.size());
+    CHECK(cache.GetStats().evictions == 9);
+    CHECK(cache.GetStats().coldRawBytes == 9 * a.size());
+    const void *restored = cache.Lock(Handle(1));
+    CHECK(cache.GetStats().restores == 1);
+    CHECK(restored && std::memcmp(restored, a.data(), a.size()) == 0);
+    cache.Release(Handle(1));
+
+    // Loaded and freed without a Lock in between: never restored
+    cache.AddRef(Handle(2));
+    cache.Release(Handle(2));
+    CHECK(cache.GetStats().restores == 1);
+  }
+
+  {
+    // Incompressible entries are kept hot rather than grown
+    std::vector<uint8_t> noise(4096);
+    std::mt19937 rng(3);
+    for (uint8_t &byte : noise)
+      byte = (uint8_t)rng();
+    ShaderCache cache;
+    cache.SetBudget(1);
+    cache.Store(Handle(1), noise.data(), (uint32_t)noise.size());
+    cache.Store(Handle(2), a.data(), (uint32_t)a.size());
+    CHECK(cache.GetStats().coldRawBytes == 0);
+    cache.Store(Handle(3), b.data(), (uint32_t)b.size());
+    CHECK(cache.GetStats().coldRawBytes == a.size());
+  }
+}
+
+// --- AddonManager::InterceptResource ---------------------------------------
+
+static void TestInterceptResource() {
+  fs::path root = ScratchPath("addons");
+  if (!BenchSupport::CreateAddonCopies(CORE_BENCH_ADDON_PATH, root, 2)) {
+    std::printf("bench_addon not found: %s\n", CORE_BENCH_ADDON_PATH);
+    g_failures++;
+    return;
+  }
+
+  const LPCWSTR kRcData = BenchSupport::kRcData;
+  const void *data = nullptr;
+  uint32_t size = 0;
+  {
+    AddonManager manager(root);
+    CHECK(manager.GetAddons().size() == 2);
+    manager.LoadAddons();
+    // Loaded but not initialized: out of the hooks' reach
+    CHECK(!manager.InterceptResource(MAKEINTRESOURCEW(1), kRcData, &data,
+                                     &size));
+
+    manager.InitializeAddons(nullptr, nullptr, nullptr, nullptr);
+    CHECK(manager.InterceptResource(MAKEINTRESOURCEW(1), kRcData, &data,
+                                    &size));
+    CHECK(data && size == 64 * 1024);
+    CHECK(!manager.InterceptResource(MAKEINTRESOURCEW(2), kRcData, &data,
+                                     &size));
+    CHECK(!manager.InterceptResource(MAKEINTRESOURCEW(1), MAKEINTRESOURCEW(3),
+                                     &data, &size));
+
+    // Either copy answers; with both disabled nothing does
+    manager.ToggleAddon(0, false);
+    CHECK(manager.InterceptResource(MAKEINTRESOURCEW(1), kRcData, &data,
+                                    &size));
+    manager.ToggleAddon(1, false);
+    CHECK(!manager.InterceptResource(MAKEINTRESOURCEW(1), kRcData, &data,
+                                     &size));
+    manager.UnloadAddons();
+  }
+
+  {
+    // The same answers from a batch asked for at initialization
+    AddonManager manager(root);
+    CHECK(!manager.GetAddons()[0].enabled); // Saved by ToggleAddon
+    manager.ToggleAddon(0, true);
+    manager.SetResourceDirectory(
+        {{{10, L""}, {1, L""}}, {{10, L""}, {2, L""}}});
+    manager.InitializeAddons(nullptr, nullptr, nullptr, nullptr);
+    CHECK(manager.GetAddons()[0].batchAnswers != nullptr);
+    CHECK(manager.InterceptResource(MAKEINTRESOURCEW(1), kRcData, &data,
+                                    &size));
+    CHECK(data && size == 64 * 1024);
+    CHECK(!manager.InterceptResource(MAKEINTRESOURCEW(2), kRcData, &data,
+                                     &size));
+
+    // The prefetch log is a plain file: ids no resource can have are
+    // dropped, not thrown on
+    fs::path log;
+    {
+      ResourcePrefetcher prefetcher;
+      prefetcher.Start(&manager);
+      prefetcher.NoteIntercept(MAKEINTRESOURCEW(1), kRcData, false);
+      prefetcher.Stop();
+    }
+    for (const fs::directory_entry &entry :
+         fs::directory_iterator(root / "prefetch"))
+      log = entry.path();
+    std::ofstream(log, std::ios::app)
+        << "#10\t#99999999999\n#10\t#65536\n#0\t#1\n#10\t#0\n";
+    auto warm = [&](ResourcePrefetcher &prefetcher) {
+      prefetcher.Start(&manager);
+      auto deadline =
+          std::chrono::steady_clock::now() + std::chrono::seconds(5);
+      while (prefetcher.GetStats().running &&
+             std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    };
+    std::vector<uint8_t> warmed;
+    {
+      ResourcePrefetcher prefetcher;
+      warm(prefetcher);
+      CHECK(prefetcher.GetStats().logged == 1);
+      CHECK(prefetcher.GetStats().warmed == 1);
+      AddonManager::DispatchScope scope(manager);
+      CHECK(prefetcher.Take(MAKEINTRESOURCEW(1), kRcData, scope, &warmed));
+      CHECK(warmed.size() == 64 * 1024);
+      CHECK(!prefetcher.Take(MAKEINTRESOURCEW(1), kRcData, scope, &warmed));
+    }
+
+    // Produced by an addon that has been disabled since: not served
+    {
+      ResourcePrefetcher prefetcher;
+      warm(prefetcher);
+      CHECK(prefetcher.GetStats().warmed == 1);
+      manager.ToggleAddon(0, false);
+      AddonManager::DispatchScope scope(manager);
+      CHECK(!prefetcher.Take(MAKEINTRESOURCEW(1), kRcData, scope, &warmed));
+      CHECK(prefetcher.GetStats().stale == 1);
+      CHECK(prefetcher.GetStats().hits == 0);
+    }
+    manager.UnloadAddons();
+  }
+
+  std::error_code ec;
+  fs::remove_all(root, ec);
+}
+
+// --- AddonInterface --------------------------------------------------------
+
+// The stand-in addon's path under root, as CreateAddonCopies names it
+static fs::path BenchAddonPath(const fs::path &root, int index) {
+  char folder[32];
+  std::snprintf(folder, sizeof(folder), "BenchAddon%04d", index);
+  fs::path path = root / folder / folder;
+  path += Platform::kModuleExtension;
+  return path;
+}
+
+static void TestAddonInterface() {
+  fs::path root = ScratchPath("interface");
+  if (!BenchSupport::CreateAddonCopies(CORE_BENCH_ADDON_PATH, root, 1)) {
+    std::printf("bench_addon not found: %s\n", CORE_BENCH_ADDON_PATH);
+    g_failures++;
+    return;
+  }
+  // Held across the managers below, so the mode sticks
+  HMODULE module = Platform::LoadModule(BenchAddonPath(root, 0));
+  CHECK(module != nullptr);
+  if (!module)
+    return;
+  auto setInterface = (void (*)(int))Platform::GetModuleSymbol(
+      module, "BenchAddonSetInterface");
+  CHECK(setInterface != nullptr);
+
+  // Mode (see bench_addon.cpp) -> the version string the manager read:
+  // "table" only from a table it accepted, "" from the named exports
+  const struct {
+    int mode;
+    const char *version;
+  } kCases[] = {{0, ""}, {1, "table"}, {2, ""}, {3, ""}};
+  for (const auto &test : kCases) {
+    setInterface(test.mode);
+    AddonManager manager(root);
+    manager.LoadAddons();
+    CHECK(manager.GetAddons()[0].hModule == module);
+    CHECK(manager.GetAddons()[0].version == test.version);
+    // Either way the intercept is found
+    manager.InitializeAddons(nullptr, nullptr, nullptr, nullptr);
+    const void *data = nullptr;
+    uint32_t size = 0;
+    CHECK(manager.InterceptResource(MAKEINTRESOURCEW(1),
+                                    BenchSupport::kRcData, &data, &size));
+    CHECK(size == 64 * 1024);
+    manager.UnloadAddons();
+  }
+
+  // An asynchronous initialize: nothing of the addon is live until it
+  // completes, and a failed one is shut down and unloaded
+  auto completeInit = (void (*)(bool))Platform::GetModuleSymbol(
+      module, "BenchAddonCompleteInit");
+  auto getCalls = (void (*)(int *, int *))Platform::GetModuleSymbol(
+      module, "BenchAddonCalls");
+  CHECK(completeInit && getCalls);
+  setInterface(4);
+  for (bool succeeded : {true, false}) {
+    AddonManager manager(root);
+    manager.LoadAddons();
+    manager.BeginStagedLoad(nullptr, nullptr, nullptr, nullptr);
+    CHECK(!manager.PumpStagedLoad());
+    AddonInfo &addon = manager.GetAddons()[0];
+    CHECK(addon.loadState == AddonLoadState::Initializing);
+
+    int renders, shutdowns, renders0, shutdowns0;
+    getCalls(&renders0, &shutdowns0);
+    const void *data = nullptr;
+    uint32_t size = 0;
+    CHECK(!manager.InterceptResource(MAKEINTRESOURCEW(1),
+                                     BenchSupport::kRcData, &data, &size));
+    manager.RenderAddonSettings(0);
+    getCalls(&renders, &shutdowns);
+    CHECK(renders == renders0);
+
+    completeInit(succeeded);
+    CHECK(manager.PumpStagedLoad());
+    manager.RenderAddonSettings(0);
+    getCalls(&renders, &shutdowns);
+    bool intercepted = manager.InterceptResource(
+        MAKEINTRESOURCEW(1), BenchSupport::kRcData, &data, &size);
+    if (succeeded) {
+      CHECK(addon.loadState == AddonLoadState::Ready);
+      CHECK(intercepted && size == 64 * 1024);
+      CHECK(renders == renders0 + 1);
+      CHECK(shutdowns == shutdowns0);
+    } else {
+      CHECK(addon.loadState == AddonLoadState::Failed);
+      CHECK(addon.hModule == nullptr);
+      CHECK(!intercepted);
+      CHECK(renders == renders0);
+      CHECK(shutdowns == shutdowns0 + 1);
+    }
+    manager.UnloadAddons();
+  }
+
+  setInterface(0);
+  Platform::FreeModule(module);
+  std::error_code ec;
+  fs::remove_all(root, ec);
+}
+
+// --- InterceptBatch --------------------------------------------------------
+
+// Replaces RCDATA #2 with "two", answers #3 with zero bytes (a decline)
+static void BatchTwo(const ResourceRequest *requests, uint32_t count,
+                     ResourceResponse *responses) {
+  static const char kTwo[] = "two";
+  for (uint32_t i = 0; i < count; ++i) {
+    if (requests[i].name == MAKEINTRESOURCEW(2))
+      responses[i] = {kTwo, 3};
+    else if (requests[i].name == MAKEINTRESOURCEW(3))
+      responses[i] = {kTwo, 0};
+  }
+}
+
+static void TestInterceptBatch() {
+  typedef InterceptBatch::Answers Answers;
+  const LPCWSTR kRcData = BenchSupport::kRcData;
+  auto bytes = [](const char *text) {
+    return std::vector<uint8_t>(text, text + std::strlen(text));
+  };
+  std::vector<PeImage::Resource> directory = {{{10, L""}, {1, L""}},
+                                              {{10, L""}, {2, L""}},
+                                              {{10, L""}, {3, L""}},
+                                              {{0, L"SHADER"}, {0, L"Blur"}}};
+
+  auto asked = InterceptBatch::Ask(BatchTwo, directory);
+  CHECK(asked->size() == 1);
+  CHECK(asked->count("#10\t#2") && asked->at("#10\t#2") == bytes("two"));
+
+  auto first = std::make_shared<Answers>();
+  (*first)["#10\t#1"] = bytes("one from 1");
+  (*first)["SHADER\tBlur"] = bytes("blur");
+  auto second = std::make_shared<Answers>();
+  (*second)["#10\t#1"] = bytes("one from 2");
+  (*second)["#10\t#2"] = bytes("two from 2");
+
+  size_t servedBy;
+  const std::vector<uint8_t> *data;
+  bool askFirst;
+  {
+    // Addons 0 and 3 are asked per call; 1 and 2 answered
+    InterceptBatch batch(directory, {nullptr, first, second, nullptr},
+                         {true, false, false, true});
+    CHECK(!batch.Answered(0) && batch.Answered(1) && batch.Answered(2));
+    CHECK(!batch.Answered(3) && !batch.Answered(4));
+
+    // The first addon that answered wins, after the per-call one before it
+    CHECK(batch.Find(MAKEINTRESOURCEW(1), kRcData, &servedBy, &data,
+                     &askFirst));
+    CHECK(servedBy == 1 && *data == bytes("one from 1") && askFirst);
+    CHECK(batch.Find(MAKEINTRESOURCEW(2), kRcData, &servedBy, &data,
+                     &askFirst));
+    CHECK(servedBy == 2 && *data == bytes("two from 2") && askFirst);
+    // Nobody answered: served by "addon count", every per-call addon first
+    CHECK(batch.Find(MAKEINTRESOURCEW(3), kRcData, &servedBy, &data,
+                     &askFirst));
+    CHECK(servedBy == 4 && data == nullptr && askFirst);
+
+    // Not in the directory: every addon must be asked
+    CHECK(!batch.Find(MAKEINTRESOURCEW(4), kRcData, &servedBy, &data,
+                      &askFirst));
+    CHECK(!batch.Find(MAKEINTRESOURCEW(1), MAKEINTRESOURCEW(3), &servedBy,
+                      &data, &askFirst));
+
+    // String names go by their text
+    std::wstring name = L"Blur", type = L"SHADER";
+    CHECK(batch.Find(name.c_str(), type.c_str(), &servedBy, &data,
+                     &askFirst));
+    CHECK(servedBy == 1 && *data == bytes("blur") && askFirst);
+    CHECK(!batch.Find(L"Blur2", L"SHADER", &servedBy, &data, &askFirst));
+    CHECK(!batch.Find(L"Blur", kRcData, &servedBy, &data, &askFirst));
+    // "#1" as text is a string name, not id 1
+    CHECK(!batch.Find(L"#1", kRcData, &servedBy, &data, &askFirst));
+  }
+
+  {
+    // With no per-call addon ahead of it, the answer stands alone
+    InterceptBatch batch(directory, {first, nullptr, second},
+                         {false, true, false});
+    CHECK(batch.Find(MAKEINTRESOURCEW(1), kRcData, &servedBy, &data,
+                     &askFirst));
+    CHECK(servedBy == 0 && *data == bytes("one from 1") && !askFirst);
+    CHECK(batch.Find(MAKEINTRESOURCEW(2), kRcData, &servedBy, &data,
+                     &askFirst));
+    CHECK(servedBy == 2 && *data == bytes("two from 2") && askFirst);
+  }
+}
+
+// --- TransformChain --------------------------------------------------------
+
+// Stages over a 4-byte input. Mark writes its setting into byte 0; Clear
+// zeroes byte 0 and writes its setting into byte 1, so its output doesn't
+// depend on Mark's; Stamp writes its setting and the resource id into bytes
+// 2 and 3. Each counts its calls.
+static uint64_t g_markSetting, g_clearSetting, g_stampSetting;
+static int g_markCalls, g_clearCalls, g_stampCalls;
+static std::vector<uint8_t> g_markOut, g_clearOut, g_stampOut;
+
+static bool Rewrite(std::vector<uint8_t> &output, const void *input,
+                    uint32_t size, int index, uint8_t value,
+                    const void **out, uint32_t *outSize) {
+  output.assign((const uint8_t *)input, (const uint8_t *)input + size);
+  output[index] = value;
+  *out = output.data();
+  *outSize = size;
+  return true;
+}
+
+static bool MarkStage(const wchar_t *, const wchar_t *, const void *input,
+                      uint32_t size, const void **out, uint32_t *outSize) {
+  g_markCalls++;
+  return Rewrite(g_markOut, input, size, 0, (uint8_t)g_markSetting, out,
+                 outSize);
+}
+
+static bool ClearStage(const wchar_t *, const wchar_t *, const void *input,
+                       uint32_t size, const void **out, uint32_t *outSize) {
+  g_clearCalls++;
+  Rewrite(g_clearOut, input, size, 0, 0, out, outSize);
+  g_clearOut[1] = (uint8_t)g_clearSetting;
+  return true;
+}
+
+static bool StampStage(const wchar_t *name, const wchar_t *, const void *input,
+                       uint32_t size, const void **out, uint32_t *outSize) {
+  g_stampCalls++;
+  Rewrite(g_stampOut, input, size, 2, (uint8_t)g_stampSetting, out, outSize);
+  g_stampOut[3] = IS_INTRESOURCE(name) ? (uint8_t)(uintptr_t)name : 0xFF;
+  return true;
+}
+
+static void TestTransformChain() {
+  const LPCWSTR kRcData = BenchSupport::kRcData;
+  const LPCWSTR kFirst = MAKEINTRESOURCEW(1), kSecond = MAKEINTRESOURCEW(2);
+  const std::vector<uint8_t> input = {0xA0, 0xA1, 0xA2, 0xA3};
+  std::vector<uint8_t> output;
+  auto run = [&](TransformChain &chain, LPCWSTR name) {
+    output.clear();
+    return chain.Run(name, kRcData, input.data(), (uint32_t)input.size(),
+                     &output);
+  };
+  auto calls = [](int mark, int clear, int stamp) {
+    bool same = g_markCalls == mark && g_clearCalls == clear &&
+                g_stampCalls == stamp;
+    g_markCalls = g_clearCalls = g_stampCalls = 0;
+    return same;
+  };
+  g_markSetting = g_clearSetting = g_stampSetting = 1;
+  calls(0, 0, 0);
+
+  {
+    TransformChain chain;
+    chain.SetStages(
+        {{"Mark", "1.0", MarkStage, []() { return g_markSetting; }},
+         {"Clear", "1.0", ClearStage, []() { return g_clearSetting; }},
+         {"Stamp", "1.0", StampStage, []() { return g_stampSetting; }}});
+    CHECK(run(chain, kFirst));
+    CHECK(calls(1, 1, 1));
+    CHECK((output == std::vector<uint8_t>{0, 1, 1, 1}));
+    CHECK(run(chain, kFirst));
+    CHECK(calls(0, 0, 0));
+    CHECK((output == std::vector<uint8_t>{0, 1, 1, 1}));
+    CHECK(chain.GetStats().memoHits == 3);
+
+    // Mark reruns and so does Clear, whose input changed; Clear's output
+    // didn't, so Stamp is reused
+    g_markSetting = 2;
+    CHECK(run(chain, kFirst));
+    CHECK(calls(1, 1, 0));
+    CHECK((output == std::vector<uint8_t>{0, 1, 1, 1}));
+
+    // A later stage's change leaves the ones before it alone
+    g_clearSetting = 2;
+    CHECK(run(chain, kFirst));
+    CHECK(calls(0, 1, 1));
+    CHECK((output == std::vector<uint8_t>{0, 2, 1, 1}));
+    g_stampSetting = 2;
+    CHECK(run(chain, kFirst));
+    CHECK(calls(0, 0, 1));
+    CHECK((output == std::vector<uint8_t>{0, 2, 2, 1}));
+
+    // Going back to earlier settings finds their results
+    g_markSetting = g_clearSetting = g_stampSetting = 1;
+    CHECK(run(chain, kFirst));
+    CHECK(calls(0, 0, 0));
+    CHECK((output == std::vector<uint8_t>{0, 1, 1, 1}));
+
+    // Same bytes under another name: nothing carries over, and Stamp sees
+    // its own resource
+    CHECK(run(chain, kSecond));
+    CHECK(calls(1, 1, 1));
+    CHECK((output == std::vector<uint8_t>{0, 1, 1, 2}));
+    CHECK(run(chain, kFirst));
+    CHECK(calls(0, 0, 0));
+    CHECK((output == std::vector<uint8_t>{0, 1, 1, 1}));
+    output.clear();
+    CHECK(chain.Run(kFirst, MAKEINTRESOURCEW(3), input.data(),
+                    (uint32_t)input.size(), &output));
+    CHECK(calls(1, 1, 1));
+  }
+
+  {
+    // Without AddonGetSettingsHash a stage runs every time, even on input
+    // it has seen; the memoized stage after it is still reused
+    TransformChain chain;
+    chain.SetStages(
+        {{"Mark", "1.0", MarkStage, nullptr},
+         {"Stamp", "1.0", StampStage, []() { return g_stampSetting; }}});
+    for (int i = 0; i < 3; ++i) {
+      CHECK(run(chain, kFirst));
+      CHECK(calls(1, 0, i == 0 ? 1 : 0));
+      CHECK((output == std::vector<uint8_t>{1, 0xA1, 1, 1}));
+    }
+    CHECK(chain.GetStats().memoHits == 2);
+    CHECK(chain.GetStats().stageCalls == 4);
+  }
+}
+
+// --- Lz4Block --------------------------------------------------------------
+
+static bool RoundTrips(const std::vector<uint8_t> &input) {
+  std::vector<uint8_t> block;
+  Lz4Block::Compress(input.data(), input.size(), &block);
+  if (block.size() > input.size() + input.size() / 255 + 16)
+    return false;
+  std::vector<uint8_t> output(input.size());
+  return Lz4Block::Decompress(block.data(), block.size(), output.data(),
+                              output.size()) &&
+         output == input;
+}
+
+static void TestLz4Block() {
+  CHECK(RoundTrips({}));
+  CHECK(RoundTrips({42}));
+  CHECK(RoundTrips(std::vector<uint8_t>(13, 7)));
+  CHECK(RoundTrips(std::vector<uint8_t>(100000, 0)));
+  CHECK(RoundTrips(ShaderLikeBytes(65536, 4)));
+
+  std::mt19937 rng(5);
+  for (size_t size : {1u, 5u, 12u, 13u, 64u, 255u, 256u, 4096u, 70000u}) {
+    std::vector<uint8_t> noise(size);
+    for (uint8_t &byte : noise)
+      byte = (uint8_t)rng();
+    CHECK(RoundTrips(noise));
+    // Noise with repeats at every distance up to half its size
+    std::vector<uint8_t> mixed = noise;
+    for (size_t i = size / 2; i < size && size >= 2; ++i)
+      mixed[i] = mixed[i - (rng() % (size / 2) + 1)];
+    CHECK(RoundTrips(mixed));
+  }
+
+  // Malformed or mismatched blocks are refused, not overrun
+  std::vector<uint8_t> input = ShaderLikeBytes(4096, 6), block;
+  Lz4Block::Compress(input.data(), input.size(), &block);
+  std::vector<uint8_t> output(input.size() + 1);
+  CHECK(!Lz4Block::Decompress(block.data(), block.size(), output.data(),
+                              input.size() - 1));
+  CHECK(!Lz4Block::Decompress(block.data(), block.size(), output.data(),
+                              input.size() + 1));
+  CHECK(!Lz4Block::Decompress(block.data(), block.size() / 2, output.data(),
+                              input.size()));
+  std::vector<uint8_t> badOffset = {0x0F, 0x00, 0x00}; // Match before start
+  CHECK(!Lz4Block::Decompress(badOffset.data(), badOffset.size(),
+                              output.data(), 19));
+}
+
+// --- Dxbc ------------------------------------------------------------------
+
+// A container shaped like the D3D compiler's output: header, offset table,
+// then the chunks in the order fxc writes them
+static std::vector<uint8_t>
+BuildContainer(const std::vector<std::pair<uint32_t, std::vector<uint8_t>>>
+                   &chunks) {
+  size_t size = 32 + chunks.size() * 4;
+  for (const auto &chunk : chunks)
+    size += 8 + chunk.second.size();
+  std::vector<uint8_t> bytes(size, 0);
+  auto put32 = [&](size_t at, uint32_t v) { std::memcpy(&bytes[at], &v, 4); };
+  put32(0, Dxbc::kMagic);
+  put32(20, 1);
+  put32(24, (uint32_t)size);
+  put32(28, (uint32_t)chunks.size());
+  size_t offset = 32 + chunks.size() * 4;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    put32(32 + i * 4, (uint32_t)offset);
+    put32(offset, chunks[i].first);
+    put32(offset + 4, (uint32_t)chunks[i].second.size());
+    std::memcpy(&bytes[offset + 8], chunks[i].second.data(),
+                chunks[i].second.size());
+    offset += 8 + chunks[i].second.size();
+  }
+  Dxbc::UpdateChecksum(bytes.data(), bytes.size());
+  return bytes;
+}
+
+static std::vector<uint8_t> ChunkBytes(size_t size, uint8_t seed) {
+  std::vector<uint8_t> bytes(size);
+  for (size_t i = 0; i < size; ++i)
+    bytes[i] = (uint8_t)(seed + i * 13);
+  return bytes;
+}
+
+static void TestDxbc() {
+  // Known answers from an independent implementation of vkd3d-shader's
+  // checksum (its MD5 core checked against a stock MD5), across every way
+  // the message can end relative to the 56-byte padding boundary
+  struct KnownAnswer {
+    size_t length; // Past the 20 skipped header bytes
+    uint32_t checksum[4];
+  };
+  static const KnownAnswer kAnswers[] = {
+      {0, {0xf6600d14, 0xbae275b7, 0xd4be4a4e, 0xa1e9b201}},
+      {1, {0xb24cf906, 0x1a98d181, 0x1ba9f9f4, 0x08e30a37}},
+      {55, {0x9235b69a, 0xcb163f76, 0xc1adfaf9, 0xdcb37108}},
+      {56, {0x75e53196, 0xec7f9c80, 0x9ca7e127, 0x0407bf6d}},
+      {59, {0x447b1e00, 0xb7f61f84, 0xb8c2b55c, 0x4c8e4734}},
+      {60, {0x6d34a3a8, 0xeb39f7f1, 0xe88b3688, 0x4d3c7721}},
+      {63, {0x3870c869, 0xae066b08, 0x55446a03, 0x0028d580}},
+      {64, {0x63252b70, 0x91962d30, 0xda4ca4ed, 0x684bef5f}},
+      {100, {0xd94a433c, 0xb572d6be, 0x5744543f, 0xb41a8617}},
+      {130, {0x0901f83e, 0xd73252cf, 0x0fef6e93, 0xcc6219e5}},
+  };
+  for (const KnownAnswer &answer : kAnswers) {
+    std::vector<uint8_t> data(Dxbc::kChecksumSkip + answer.length, 0);
+    for (size_t i = 0; i < answer.length; ++i)
+      data[Dxbc::kChecksumSkip + i] = (uint8_t)(i * 7 + 3);
+    uint32_t checksum[4];
+    Dxbc::ComputeChecksum(data.data(), data.size(), checksum);
+    CHECK(std::memcmp(checksum, answer.checksum, sizeof(checksum)) == 0);
+  }
+
+  const uint32_t kShex = Dxbc::kShaderSM5;
+  std::vector<uint8_t> shader = BuildContainer({
+      {Dxbc::kResourceDef, ChunkBytes(60, 1)},
+      {Dxbc::kInputSignature, ChunkBytes(44, 2)},
+      {Dxbc::kOutputSignature, ChunkBytes(44, 3)},
+      {kShex, ChunkBytes(212, 4)},
+      {Dxbc::kStatistics, ChunkBytes(148, 5)},
+  });
+  CHECK(Dxbc::VerifyChecksum(shader.data(), shader.size()));
+  Dxbc::Container container;
+  CHECK(container.Parse(shader.data(), shader.size()));
+  CHECK(container.GetChunks().size() == 5);
+  const Dxbc::Chunk *code = container.FindShaderChunk();
+  CHECK(code && code->fourCC == kShex && code->size == 212);
+
+  // Any edit in the checksummed region is caught; the magic is not in it
+  std::vector<uint8_t> edited = shader;
+  edited[code->offset + 17] ^= 1;
+  CHECK(!Dxbc::VerifyChecksum(edited.data(), edited.size()));
+  Dxbc::UpdateChecksum(edited.data(), edited.size());
+  CHECK(Dxbc::VerifyChecksum(edited.data(), edited.size()));
+
+  // Grown, shrunk and emptied chunks: sizes and offsets follow, the other
+  // chunks come along unchanged, and the checksum is valid again
+  for (size_t size : {212u, 300u, 16u, 0u}) {
+    std::vector<uint8_t> replacement = ChunkBytes(size, 9);
+    std::vector<uint8_t> rebuilt;
+    CHECK(Dxbc::ReplaceChunk(shader.data(), shader.size(), kShex,
+                             replacement.data(), replacement.size(),
+                             &rebuilt));
+    CHECK(Dxbc::VerifyChecksum(rebuilt.data(), rebuilt.size()));
+    Dxbc::Container parsed;
+    CHECK(parsed.Parse(rebuilt.data(), rebuilt.size()));
+    CHECK(parsed.GetChunks().size() == 5);
+    const Dxbc::Chunk *replaced = parsed.FindChunk(kShex);
+    CHECK(replaced && replaced->size == size);
+    CHECK(replaced && (size == 0 || std::memcmp(parsed.GetChunkData(*replaced),
+                                                replacement.data(), size) == 0));
+    const Dxbc::Chunk *stat = parsed.FindChunk(Dxbc::kStatistics);
+    const Dxbc::Chunk *oldStat = container.FindChunk(Dxbc::kStatistics);
+    CHECK(stat && std::memcmp(parsed.GetChunkData(*stat),
+                              container.GetChunkData(*oldStat), 148) == 0);
+  }
+  std::vector<uint8_t> unused;
+  CHECK(!Dxbc::ReplaceChunk(shader.data(), shader.size(),
+                            Dxbc::FourCC('S', 'F', 'I', '0'), nullptr, 0,
+                            &unused));
+  CHECK(!Dxbc::ReplaceChunk(shader.data(), shader.size() - 1, kShex, nullptr,
+                            0, &unused));
+
+  // ShaderPatcher: byte patches refresh the checksum, a patch whose
+  // expected bytes differ is skipped without touching anything
+  const LPCWSTR kRcData = BenchSupport::kRcData;
+  const uint8_t *codeBytes = container.GetChunkData(*code);
+  uint8_t patchBytes[4] = {0xDE, 0xAD, 0xBE, 0xEF};
+  uint8_t wrongBytes[4] = {0, 0, 0, 0};
+  {
+    ShaderPatcher patcher;
+    ShaderPatch patch = {MAKEINTRESOURCEW(1), kRcData, SHADER_PATCH_BYTES,
+                         kShex, 8, patchBytes, 4, codeBytes + 8};
+    CHECK(patcher.Register(patch, nullptr) != 0);
+    std::vector<uint8_t> out;
+    CHECK(patcher.Apply(MAKEINTRESOURCEW(1), kRcData, shader.data(),
+                        (uint32_t)shader.size(), &out));
+    CHECK(out.size() == shader.size());
+    CHECK(std::memcmp(&out[code->offset + 8], patchBytes, 4) == 0);
+    CHECK(Dxbc::VerifyChecksum(out.data(), out.size()));
+    // Served again from the result cache, still valid
+    std::vector<uint8_t> again;
+    CHECK(patcher.Apply(MAKEINTRESOURCEW(1), kRcData, shader.data(),
+                        (uint32_t)shader.size(), &again));
+    CHECK(again == out && patcher.GetStats().cached == 1);
+  }
+  {
+    ShaderPatcher patcher;
+    ShaderPatch rejected = {MAKEINTRESOURCEW(1), kRcData, SHADER_PATCH_BYTES,
+                            kShex, 8, patchBytes, 4, wrongBytes};
+    CHECK(patcher.Register(rejected, nullptr) != 0);
+    std::vector<uint8_t> out = {42};
+    CHECK(!patcher.Apply(MAKEINTRESOURCEW(1), kRcData, shader.data(),
+                         (uint32_t)shader.size(), &out));
+    CHECK(out.size() == 1 && out[0] == 42);
+    CHECK(patcher.GetStats().skipped == 1);
+
+    // Next to a chunk patch and a byte patch that do apply
+    std::vector<uint8_t> newCode = ChunkBytes(240, 7);
+    ShaderPatch chunkPatch = {MAKEINTRESOURCEW(1), kRcData, SHADER_PATCH_CHUNK,
+                              kShex, 0, newCode.data(),
+                              (uint32_t)newCode.size(), nullptr};
+    ShaderPatch statPatch = {MAKEINTRESOURCEW(1), kRcData, SHADER_PATCH_BYTES,
+                             Dxbc::kStatistics, 0, patchBytes, 4, nullptr};
+    CHECK(patcher.Register(chunkPatch, nullptr) != 0);
+    CHECK(patcher.Register(statPatch, nullptr) != 0);
+    CHECK(patcher.Apply(MAKEINTRESOURCEW(1), kRcData, shader.data(),
+                        (uint32_t)shader.size(), &out));
+    CHECK(Dxbc::VerifyChecksum(out.data(), out.size()));
+    Dxbc::Container parsed;
+    CHECK(parsed.Parse(out.data(), out.size()));
+    const Dxbc::Chunk *replaced = parsed.FindChunk(kShex);
+    CHECK(replaced && replaced->size == newCode.size());
+    const Dxbc::Chunk *stat = parsed.FindChunk(Dxbc::kStatistics);
+    CHECK(stat && std::memcmp(parsed.GetChunkData(*stat), patchBytes, 4) == 0);
+  }
+}
+
+// --- Rcu -------------------------------------------------------------------
+
+// Readers check an invariant the writer breaks just before freeing. Under
+// -DLOSSLESS_SANITIZE=thread a reader still inside its scope at that point
+// is also reported as a race.
+struct RcuVersion {
+  uint64_t value;
+  uint64_t copy; // == value while published
+};
+
+static void TestRcu() {
+  {
+    RcuDomain domain;
+    std::atomic<const RcuVersion *> current{new RcuVersion{0, 0}};
+    std::atomic<bool> stop{false};
+    std::atomic<int> torn{0};
+    std::atomic<uint64_t> reads{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+      readers.emplace_back([&]() {
+        while (!stop.load(std::memory_order_relaxed)) {
+          RcuDomain::ReadScope scope(domain);
+          const RcuVersion *version = current.load(std::memory_order_acquire);
+          if (version->value != version->copy)
+            torn.fetch_add(1);
+          reads.fetch_add(1, std::memory_order_relaxed);
+        }
+      });
+    }
+    while (reads.load() == 0)
+      std::this_thread::yield();
+    for (uint64_t i = 1; i <= 2000; ++i) {
+      RcuVersion *previous = (RcuVersion *)current.exchange(
+          new RcuVersion{i, i}, std::memory_order_acq_rel);
+      CHECK(domain.Synchronize());
+      previous->copy = ~previous->value; // No reader may see this
+      delete previous;
+    }
+    stop.store(true);
+    for (std::thread &reader : readers)
+      reader.join();
+    delete current.load();
+    CHECK(torn.load() == 0);
+  }
+
+  {
+    // Synchronize waits for a reader that was already inside
+    RcuDomain domain;
+    std::atomic<bool> entered{false}, leave{false}, synchronized{false};
+    std::thread reader([&]() {
+      RcuDomain::ReadScope scope(domain);
+      entered.store(true);
+      while (!leave.load())
+        std::this_thread::yield();
+    });
+    while (!entered.load())
+      std::this_thread::yield();
+    std::thread writer([&]() {
+      domain.Synchronize();
+      synchronized.store(true);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(!synchronized.load());
+    // Readers arriving after the flip don't hold it up
+    {
+      RcuDomain::ReadScope late(domain);
+      leave.store(true);
+      reader.join();
+      writer.join();
+    }
+    CHECK(synchronized.load());
+
+    // At process exit a reader that never leaves no longer blocks it
+    entered.store(false);
+    leave.store(false);
+    std::thread stuck([&]() {
+      RcuDomain::ReadScope scope(domain);
+      entered.store(true);
+      while (!leave.load())
+        std::this_thread::yield();
+    });
+    while (!entered.load())
+      std::this_thread::yield();
+    ProcessExit::SetExiting();
+    auto started = std::chrono::steady_clock::now();
+    CHECK(!domain.Synchronize());
+    CHECK(std::chrono::steady_clock::now() - started <
+          std::chrono::milliseconds(500));
+    ProcessExit::SetExiting(false);
+    leave.store(true);
+    stuck.join();
+    CHECK(domain.Synchronize());
+  }
+
+  // AddonManager: hook threads inside DispatchScope calling into addons
+  // while the GUI side republishes (and frees) the dispatch table
+  fs::path root = ScratchPath("rcu_addons");
+  if (!BenchSupport::CreateAddonCopies(CORE_BENCH_ADDON_PATH, root, 3)) {
+    std::printf("bench_addon not found: %s\n", CORE_BENCH_ADDON_PATH);
+    g_failures++;
+    return;
+  }
+  {
+    AddonManager manager(root);
+    manager.LoadAddons();
+    manager.InitializeAddons(nullptr, nullptr, nullptr, nullptr);
+    std::atomic<bool> stop{false};
+    std::atomic<int> wrong{0}, answered{0};
+    std::vector<std::thread> hooks;
+    for (int i = 0; i < 4; ++i) {
+      hooks.emplace_back([&]() {
+        while (!stop.load(std::memory_order_relaxed)) {
+          AddonManager::DispatchScope scope(manager);
+          const AddonDispatch *dispatch = scope.Get();
+          if (!dispatch)
+            continue;
+          for (AddonInterceptResource_t intercept : dispatch->intercepts) {
+            const void *data = nullptr;
+            uint32_t size = 0;
+            if (intercept && intercept(MAKEINTRESOURCEW(1),
+                                       BenchSupport::kRcData, &data, &size)) {
+              // The addon's bytes stay readable inside the scope
+              if (size != 64 * 1024 || ((const uint8_t *)data)[size - 1])
+                wrong.fetch_add(1);
+              answered.fetch_add(1, std::memory_order_relaxed);
+            }
+          }
+        }
+      });
+    }
+    while (answered.load() == 0)
+      std::this_thread::yield();
+    for (int i = 0; i < 300; ++i)
+      manager.ToggleAddon(i % 3, (i / 3) % 2 != 0);
+    stop.store(true);
+    for (std::thread &hook : hooks)
+      hook.join();
+    CHECK(wrong.load() == 0);
+    manager.UnloadAddons();
+  }
+  std::error_code ec;
+  fs::remove_all(root, ec);
+}
+
+// --- ControlProtocol -------------------------------------------------------
+
+// Reads one whole response: "ok <n>" and n lines, or one "err" line
+static std::string ReadResponse(Platform::LocalConnection *connection) {
+  std::string response;
+  size_t lines = 1;
+  char byte;
+  while (lines > 0 && Platform::ReadLocal(connection, &byte, 1) == 1) {
+    response += byte;
+    if (byte != '\n')
+      continue;
+    if (lines == 1 && response.compare(0, 3, "ok ") == 0 &&
+        response.find('\n') == response.size() - 1)
+      lines += std::strtoul(response.c_str() + 3, nullptr, 10);
+    lines--;
+  }
+  return response;
+}
+
+static std::string Exchange(Platform::LocalConnection *connection,
+                            const std::string &request) {
+  std::string line = request + "\n";
+  if (!Platform::WriteLocal(connection, line.data(), line.size()))
+    return std::string();
+  return ReadResponse(connection);
+}
+
+static void TestControlProtocol() {
+  fs::path root = ScratchPath("control_addons");
+  if (!BenchSupport::CreateAddonCopies(CORE_BENCH_ADDON_PATH, root, 2)) {
+    std::printf("bench_addon not found: %s\n", CORE_BENCH_ADDON_PATH);
+    g_failures++;
+    return;
+  }
+
+  {
+    AddonManager manager(root);
+    manager.LoadAddons();
+    manager.InitializeAddons(nullptr, nullptr, nullptr, nullptr);
+    using ControlProtocol::Execute;
+
+    CHECK(Execute(manager, "ping") == "ok 0\n");
+    // Rows in the manager's order, which follows the directory listing
+    int first = fs::path(manager.GetAddons()[0].name).u8string() ==
+                        "BenchAddon0000"
+                    ? 0
+                    : 1;
+    int second = 1 - first;
+    auto row = [&](int index, const char *state) {
+      return std::to_string(index) + " " + state + " BenchAddon000" +
+             (index == first ? "0" : "1") + "\n";
+    };
+    CHECK(Execute(manager, "list") ==
+          "ok 2\n" + row(0, "1 ready") + row(1, "1 ready"));
+
+    // By name, then by index; saved as the window would
+    CHECK(Execute(manager, "disable BenchAddon0001") == "ok 0\n");
+    CHECK(!manager.GetAddons()[second].enabled &&
+          !manager.GetAddons()[second].hModule);
+    CHECK(manager.GetAddons()[first].hModule != nullptr);
+    CHECK(Execute(manager, "disable " + std::to_string(first)) == "ok 0\n");
+    CHECK(!manager.GetAddons()[first].enabled);
+    CHECK(Execute(manager, "list") ==
+          "ok 2\n" + row(0, "0 unloaded") + row(1, "0 unloaded"));
+    CHECK(Execute(manager, "enable " + std::to_string(second)) == "ok 0\n");
+    CHECK(manager.GetAddons()[second].enabled &&
+          manager.GetAddons()[second].hModule);
+    {
+      AddonManager reloaded(root);
+      for (const AddonInfo &addon : reloaded.GetAddons())
+        CHECK(addon.enabled ==
+              (fs::path(addon.name).u8string() == "BenchAddon0001"));
+    }
+
+    // Unknown addons, indexes and verbs are refused, and change nothing
+    uint64_t revision = manager.GetRevision();
+    CHECK(Execute(manager, "enable BenchAddon9999") ==
+          "err no addon BenchAddon9999\n");
+    CHECK(Execute(manager, "enable 2") == "err no addon 2\n");
+    CHECK(Execute(manager, "enable -1") == "err no addon -1\n");
+    CHECK(Execute(manager, "enable") == "err no addon \n");
+    CHECK(Execute(manager, "frobnicate 1") == "err unknown request frobnicate\n");
+    CHECK(Execute(manager, "") == "err unknown request \n");
+    CHECK(manager.GetRevision() == revision);
+
+    std::string status = Execute(manager, "status");
+    CHECK(status.compare(0, 3, "ok ") == 0);
+    CHECK(status.find("\naddons 2\n") != std::string::npos);
+    CHECK(status.find("\nenabled 1\n") != std::string::npos);
+    manager.UnloadAddons();
+  }
+
+  {
+    // The whole path over the POSIX socket stand-in: HeadlessHost owns the
+    // manager, requests come in on its ControlServer
+    AddonManager manager(root);
+    HeadlessHost host;
+    std::string channel =
+        "core_tests_" + std::to_string(Platform::GetProcessId());
+    CHECK(host.Start(&manager, channel.c_str()));
+
+    Platform::LocalConnection connection;
+    CHECK(Platform::ConnectLocal(channel.c_str(), &connection));
+    CHECK(Exchange(&connection, "ping") == "ok 0\n");
+    CHECK(Exchange(&connection, "enable BenchAddon0000") == "ok 0\n");
+    std::string list = Exchange(&connection, "list");
+    CHECK(list.compare(0, 5, "ok 2\n") == 0);
+    // Both enabled; each may still be loading in the background
+    CHECK(list.find(" 1 ") != list.rfind(" 1 "));
+    CHECK(list.find(" BenchAddon0000\n") != std::string::npos);
+    CHECK(Exchange(&connection, "bogus") == "err unknown request bogus\n");
+
+    // An over-long line is refused and the client dropped
+    std::string tooLong(ControlProtocol::kMaxRequest + 1, 'x');
+    CHECK(Exchange(&connection, tooLong) == "err request too long\n");
+    char byte;
+    CHECK(Platform::ReadLocal(&connection, &byte, 1) == 0);
+    Platform::CloseLocal(&connection);
+
+    // The next client is served again
+    CHECK(Platform::ConnectLocal(channel.c_str(), &connection));
+    CHECK(Exchange(&connection, "ping") == "ok 0\n");
+    Platform::CloseLocal(&connection);
+
+    host.Stop();
+    CHECK(!Platform::ConnectLocal(channel.c_str(), &connection));
+    manager.UnloadAddons();
+  }
+
+  std::error_code ec;
+  fs::remove_all(root, ec);
+}
+
+// --- SharedStats -----------------------------------------------------------
+
+static std::string SegmentName(const char *suffix) {
+  return "core_tests_" + std::to_string(Platform::GetProcessId()) + "_" +
+         suffix;
+}
+
+static void TestSharedStats() {
+  using namespace SharedStats;
+  std::string name = SegmentName("stats");
+  {
+    Writer writer;
+    CHECK(writer.Open(name.c_str(), 250000));
+    Reader reader;
+    CHECK(reader.Open(name.c_str()));
+    Snapshot snapshot;
+    CHECK(!reader.Read(&snapshot)); // Nothing published yet
+
+    writer.SetCounter("hooks/find", 7);
+    writer.SetGauge("cache/hot_bytes", 4096.0);
+    writer.Publish(1234);
+    CHECK(reader.Read(&snapshot));
+    CHECK(snapshot.processId == Platform::GetProcessId());
+    CHECK(snapshot.publishCount == 1 && snapshot.publishMicros == 1234);
+    CHECK(snapshot.intervalMicros == 250000);
+    CHECK(snapshot.metrics.size() == 2);
+    CHECK(std::strcmp(snapshot.metrics[0].name, "hooks/find") == 0);
+    CHECK(snapshot.metrics[0].kind == kCounter &&
+          snapshot.metrics[0].count == 7);
+    CHECK(snapshot.metrics[1].kind == kGauge &&
+          snapshot.metrics[1].value == 4096.0);
+
+    // Names are cut at kNameLength - 1 bytes; past that they are one metric
+    std::string longName(kNameLength + 10, 'n');
+    std::string otherTail = longName.substr(0, kNameLength - 1) + "other";
+    writer.SetGauge(longName.c_str(), 1.0);
+    writer.SetGauge(otherTail.c_str(), 2.0);
+    writer.Publish(1235);
+    CHECK(reader.Read(&snapshot));
+    CHECK(snapshot.metrics.size() == 3);
+    CHECK(std::strlen(snapshot.metrics[2].name) == kNameLength - 1);
+    CHECK(std::string(snapshot.metrics[2].name) ==
+          longName.substr(0, kNameLength - 1));
+    CHECK(snapshot.metrics[2].value == 2.0);
+  }
+
+  {
+    // Torn reads: the writer publishes every metric with the same value
+    // nonstop, so a snapshot mixing two publishes shows up as a mismatch
+    Writer writer;
+    CHECK(writer.Open(name.c_str(), 0));
+    Reader reader;
+    CHECK(reader.Open(name.c_str()));
+    std::atomic<bool> stop{false};
+    std::thread publisher([&]() {
+      char metric[16];
+      for (uint64_t round = 1; !stop.load(std::memory_order_relaxed);
+           ++round) {
+        for (int i = 0; i < 64; ++i) {
+          std::snprintf(metric, sizeof(metric), "m%d", i);
+          writer.SetCounter(metric, round);
+        }
+        writer.Publish(round);
+        std::this_thread::yield();
+      }
+    });
+    int consistent = 0;
+    uint32_t retries = 0;
+    uint64_t lastRound = 0;
+    Snapshot snapshot;
+    auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+    while (std::chrono::steady_clock::now() < deadline &&
+           (consistent < 1000 || retries == 0)) {
+      bool read = reader.Read(&snapshot, 1000);
+      retries += snapshot.retries;
+      if (!read)
+        continue; // Every attempt landed mid-publish
+      if (snapshot.metrics.empty())
+        continue;
+      bool same = snapshot.metrics.size() == 64 &&
+                  snapshot.publishMicros >= lastRound;
+      for (const Metric &metric : snapshot.metrics)
+        same = same && metric.count == snapshot.publishMicros;
+      CHECK(same);
+      lastRound = snapshot.publishMicros;
+      consistent++;
+    }
+    stop.store(true);
+    publisher.join();
+    CHECK(consistent > 0);
+    // The writer was caught mid-publish at least once
+    CHECK(retries > 0);
+  }
+
+  {
+    // Segments this build can't read are refused: wrong magic, a newer
+    // version, metrics smaller than ours, or a table past the segment end
+    std::string foreign = SegmentName("foreign");
+    Platform::SharedMemory memory;
+    CHECK(Platform::CreateSharedMemory(foreign.c_str(), 4096, &memory));
+    Header *header = (Header *)memory.data;
+    auto valid = [&]() {
+      header->magic = kMagic;
+      header->version = kVersion;
+      header->headerSize = sizeof(Header);
+      header->metricSize = sizeof(Metric);
+      header->maxMetrics = (4096 - sizeof(Header)) / sizeof(Metric);
+    };
+    Reader reader;
+    valid();
+    CHECK(reader.Open(foreign.c_str()));
+    reader.Close();
+    valid();
+    header->magic = 0x12345678;
+    CHECK(!reader.Open(foreign.c_str()) && !reader.IsOpen());
+    valid();
+    header->version = kVersion + 1;
+    CHECK(!reader.Open(foreign.c_str()));
+    valid();
+    header->metricSize = sizeof(Metric) - 8;
+    CHECK(!reader.Open(foreign.c_str()));
+    valid();
+    header->maxMetrics = kMaxMetrics;
+    CHECK(!reader.Open(foreign.c_str()));
+    Platform::CloseSharedMemory(&memory);
+    CHECK(!reader.Open(foreign.c_str()));
+  }
+}
+
+// --- AllocPool -------------------------------------------------------------
+
+static void TestAllocPool() {
+  AllocPool::Tag *tag = AllocPool::GetTag("core_tests");
+  CHECK(tag != nullptr && AllocPool::GetTag("core_tests") == tag);
+  int index = 0;
+  while (std::strcmp(AllocPool::GetTagName(index), "core_tests") != 0)
+    index++;
+  AllocPool::TagStats stats;
+
+  // A freed block is the next one handed out for its class
+  void *first = AllocPool::Alloc(100, tag);
+  CHECK(first && ((uintptr_t)first & 15) == 0);
+  std::memset(first, 0xAB, 100);
+  CHECK(AllocPool::ReadTag(index, &stats) && stats.liveBytes == 100);
+  AllocPool::Free(first, nullptr);
+  CHECK(AllocPool::Alloc(110, tag) == first); // Same 112-byte class
+  AllocPool::Free(first, nullptr);
+  CHECK(AllocPool::ReadTag(index, &stats) && stats.liveBytes == 0);
+  CHECK(stats.allocations == 2 && stats.frees == 2);
+
+  // Past kMaxPooledSize: malloc, counted apart
+  uint64_t large = AllocPool::GetPoolStats().largeBytes;
+  void *big = AllocPool::Alloc(AllocPool::kMaxPooledSize + 1, tag);
+  CHECK(AllocPool::GetPoolStats().largeBytes > large);
+  AllocPool::Free(big, nullptr);
+  CHECK(AllocPool::GetPoolStats().largeBytes == large);
+
+  // Allocated on one thread, freed on another, round after round: the
+  // blocks come back through the shared lists instead of piling up on the
+  // freeing thread, so the slabs stop growing
+  const int kBlocks = 2000; // 2000 x 64 B: about 2.5 slabs a round
+  uint64_t slabs = AllocPool::GetPoolStats().slabBytes;
+  for (int round = 0; round < 50; ++round) {
+    std::vector<void *> blocks(kBlocks);
+    for (void *&block : blocks)
+      block = AllocPool::Alloc(64, tag);
+    std::thread freer([&]() {
+      for (void *block : blocks)
+        AllocPool::Free(block, nullptr);
+    });
+    freer.join();
+  }
+  uint64_t grown = AllocPool::GetPoolStats().slabBytes - slabs;
+  CHECK(grown <= 8 * 64 * 1024);
+
+  // Short-lived threads hand their cached blocks back when they exit
+  slabs = AllocPool::GetPoolStats().slabBytes;
+  for (int round = 0; round < 100; ++round) {
+    std::thread worker([&]() {
+      std::vector<void *> blocks(200);
+      for (void *&block : blocks)
+        block = AllocPool::Alloc(256, tag);
+      for (void *block : blocks)
+        AllocPool::Free(block, nullptr);
+    });
+    worker.join();
+  }
+  grown = AllocPool::GetPoolStats().slabBytes - slabs;
+  CHECK(grown <= 4 * 64 * 1024);
+  CHECK(AllocPool::ReadTag(index, &stats) && stats.liveBytes == 0);
+}
+
+// --- ImportHook ------------------------------------------------------------
+
+static std::atomic<int> g_importOriginals{0};
+static int WINAPI TestImportAdd(int a, int b) {
+  g_importOriginals++;
+  return a + b;
+}
+LS_IMPORT_HOOK(g_testImportHook, "test.dll", "Add", int(WINAPI *)(int, int));
+
+// Callbacks append their letter to the std::string passed as user
+static void ImportPreDouble(ImportCall *call, void *user) {
+  *(std::string *)user += 'd';
+  *(int *)call->args[0] *= 2;
+}
+static void ImportPostAdd(ImportCall *call, void *user) {
+  *(std::string *)user += 'p';
+  *(int *)call->result += 100;
+}
+static void ImportPreSkip(ImportCall *call, void *user) {
+  *(std::string *)user += 's';
+  call->skipOriginal = true;
+  *(int *)call->result = -1;
+}
+// Adds a post callback from inside the call, then removes itself
+static uint32_t g_importSelfId = 0;
+static void ImportPreChange(ImportCall *, void *user) {
+  *(std::string *)user += 'c';
+  g_testImportHook.AddCallback(nullptr, ImportPostAdd, user, nullptr);
+  CHECK(g_testImportHook.RemoveCallbacks(g_importSelfId, nullptr));
+}
+// user is std::atomic<int>[2]: calls seen before and after the original
+static void ImportCountPre(ImportCall *, void *user) {
+  ((std::atomic<int> *)user)[0]++;
+}
+static void ImportCountPost(ImportCall *, void *user) {
+  ((std::atomic<int> *)user)[1]++;
+}
+
+static void TestImportHook() {
+  typedef int(WINAPI * Add)(int, int);
+  Add add = (Add)g_testImportHook.GetDispatch();
+  std::string order;
+
+  CHECK(ImportHooks::Find("TEST.DLL", "Add") == &g_testImportHook);
+  CHECK(ImportHooks::Find("test.dll", "add") == nullptr);
+  CHECK(!g_testImportHook.IsInstalled());
+  CHECK(g_testImportHook.AddCallback(ImportPreDouble, nullptr, &order,
+                                     nullptr) == 0);
+  g_testImportHook.Install((void *)&TestImportAdd);
+  CHECK(g_testImportHook.AddCallback(nullptr, nullptr, &order, nullptr) == 0);
+
+  // Without callbacks the dispatcher only forwards
+  CHECK(add(2, 3) == 5);
+  CHECK(g_importOriginals == 1);
+
+  // Pre callbacks see and change the arguments, post ones the result, in
+  // the order they were added
+  int owner = 0;
+  uint32_t doubleId = g_testImportHook.AddCallback(ImportPreDouble, nullptr,
+                                                   &order, nullptr);
+  uint32_t postId = g_testImportHook.AddCallback(nullptr, ImportPostAdd,
+                                                 &order, &owner);
+  CHECK(doubleId && postId && doubleId != postId);
+  CHECK(add(2, 3) == 107);
+  CHECK(order == "dp");
+  uint32_t skipId = g_testImportHook.AddCallback(ImportPreSkip, nullptr,
+                                                 &order, nullptr);
+  order.clear();
+  CHECK(add(2, 3) == 99); // -1 from the skip, then the post's +100
+  CHECK(order == "dsp");
+  CHECK(g_importOriginals == 2);
+
+  // Removal by id and by owner
+  ImportHooks::RemoveCallback(skipId);
+  ImportHooks::RemoveOwner(&owner);
+  CHECK(!g_testImportHook.RemoveCallbacks(postId, nullptr));
+  order.clear();
+  CHECK(add(2, 3) == 7);
+  CHECK(order == "d");
+  ImportHooks::RemoveCallback(doubleId);
+  CHECK(add(2, 3) == 5);
+
+  // A callback changing its own hook's list: what it adds waits for the
+  // next call, and removing itself doesn't wait on its own dispatch
+  g_importSelfId = g_testImportHook.AddCallback(ImportPreChange, nullptr,
+                                                &order, nullptr);
+  order.clear();
+  CHECK(add(2, 3) == 5);
+  CHECK(order == "c");
+  order.clear();
+  CHECK(add(2, 3) == 105);
+  CHECK(order == "p");
+  ImportHooks::RemoveCallback(g_importSelfId + 1);
+  CHECK(add(2, 3) == 5);
+
+  // Callbacks come and go while other threads call the import
+  std::atomic<bool> stop{false};
+  std::atomic<int> wrong{0}, counted[2] = {{0}, {0}};
+  std::vector<std::thread> callers;
+  for (int t = 0; t < 4; ++t) {
+    callers.emplace_back([&]() {
+      while (!stop.load()) {
+        if (add(20, 22) != 42)
+          wrong++;
+      }
+    });
+  }
+  for (int i = 0; i < 200; ++i) {
+    uint32_t id = g_testImportHook.AddCallback(
+        ImportCountPre, ImportCountPost, counted, nullptr);
+    std::this_thread::yield();
+    CHECK(g_testImportHook.RemoveCallbacks(id, nullptr));
+  }
+  stop = true;
+  for (std::thread &caller : callers)
+    caller.join();
+  CHECK(wrong == 0);
+  // A callback added mid-call never runs its post without its pre
+  CHECK(counted[1] <= counted[0]);
+}
+
+// --- ResourceTrace ---------------------------------------------------------
+
+static void TestResourceTrace() {
+  using namespace ResourceTrace;
+  fs::path path = ScratchPath("trace.bin");
+  {
+    Writer writer;
+    CHECK(writer.Open(path));
+    CHECK(!writer.Open(path)); // Already recording
+    Record record = {};
+    record.op = (uint8_t)Op::FindResource;
+    record.flags = kIntercepted;
+    record.timestampNanos = 5;
+    record.durationNanos = 7;
+    record.name = 1;
+    record.type = 10;
+    record.result = 0x1234;
+    writer.Write(record, nullptr, nullptr);
+    record.op = (uint8_t)Op::FindResource;
+    record.flags = kNameIsString;
+    writer.Write(record, L"SHADER", nullptr);
+    record.flags = kNameIsString | kTypeIsString;
+    writer.Write(record, L"A", L"CUSTOM");
+    // Threads share the file; their records arrive whole
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([&writer]() {
+        Record own = {};
+        own.op = (uint8_t)Op::LockResource;
+        own.flags = kTypeIsString;
+        for (int i = 0; i < 1000; ++i) {
+          own.handle = (uint64_t)i;
+          writer.Write(own, nullptr, L"TEXT");
+        }
+      });
+    }
+    for (std::thread &thread : threads)
+      thread.join();
+    writer.Close();
+    writer.Write(record, L"late", L"late"); // Closed: dropped
+  }
+
+  std::vector<Event> events;
+  std::string error;
+  CHECK(ReadFile(path, &events, &error));
+  CHECK(error.empty());
+  CHECK(events.size() == 3 + 4 * 1000);
+  if (events.size() == 3 + 4 * 1000) {
+    CHECK(events[0].record.op == (uint8_t)Op::FindResource);
+    CHECK(events[0].record.flags == kIntercepted);
+    CHECK(events[0].record.name == 1 && events[0].record.type == 10);
+    CHECK(events[0].record.timestampNanos == 5);
+    CHECK(events[0].record.durationNanos == 7);
+    CHECK(events[0].record.result == 0x1234);
+    CHECK(events[0].name.empty() && events[0].type.empty());
+    CHECK(events[1].name == L"SHADER" && events[1].type.empty());
+    CHECK(events[1].record.type == 10);
+    CHECK(events[2].name == L"A" && events[2].type == L"CUSTOM");
+    // Each thread's records come whole and in its own order
+    std::map<uint16_t, uint64_t> nextHandle;
+    bool whole = true;
+    for (size_t i = 3; i < events.size(); ++i) {
+      const Event &event = events[i];
+      uint64_t &next = nextHandle[event.record.thread];
+      whole = whole && event.record.op == (uint8_t)Op::LockResource &&
+              event.type == L"TEXT" && event.record.handle == next++;
+    }
+    CHECK(whole);
+    CHECK(nextHandle.size() == 4);
+  }
+
+  // A recording cut mid-string keeps the records before it
+  uintmax_t size = fs::file_size(path);
+  fs::resize_file(path, size - 2);
+  CHECK(ReadFile(path, &events, &error));
+  CHECK(!error.empty());
+  CHECK(events.size() == 3 + 4 * 1000 - 1);
+
+  // Anything else is refused
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << "not a trace, just some text";
+  }
+  CHECK(!ReadFile(path, &events, &error));
+  fs::remove(path);
+  CHECK(!ReadFile(path, &events, &error));
+}
+
+// --- ResourceOverlay -------------------------------------------------------
+
+// Writes a new file and renames it over path, as the overlay requires
+static void ReplaceFile(const fs::path &path, const std::string &bytes) {
+  fs::create_directories(path.parent_path());
+  fs::path temp = path;
+  temp += ".tmp";
+  {
+    std::ofstream out(temp, std::ios::binary);
+    out << bytes;
+  }
+  fs::rename(temp, path);
+}
+
+static std::string OverlayBytes(ResourceOverlay &overlay, LPCWSTR name,
+                                uint32_t *slot = nullptr) {
+  const void *data = nullptr;
+  uint32_t size = 0;
+  uint32_t found = overlay.Find(name, BenchSupport::kRcData, &data, &size);
+  if (slot)
+    *slot = found;
+  return found ? std::string((const char *)data, size) : std::string();
+}
+
+static void TestResourceOverlay() {
+  fs::path root = ScratchPath("overlay");
+  fs::path config = root / "addons_config.ini";
+  ReplaceFile(root / "A" / "resources" / "10" / "1.bin", "A one");
+  ReplaceFile(root / "A" / "resources" / "10" / "Named.bin", "A named");
+  ReplaceFile(root / "B" / "resources" / "10" / "1.bin", "B one");
+  ReplaceFile(root / "B" / "resources" / "10" / "2.bin", "B two");
+  ReplaceFile(root / "B" / "resources" / "10" / "3.txt", "not a resource");
+
+  {
+    ResourceOverlay overlay;
+    overlay.Start(root, config, 0);
+    CHECK(overlay.GetStats().files == 3);
+    // The first folder by name wins
+    uint32_t slot = 0;
+    CHECK(OverlayBytes(overlay, MAKEINTRESOURCEW(1), &slot) == "A one");
+    CHECK(OverlayBytes(overlay, MAKEINTRESOURCEW(2)) == "B two");
+    CHECK(OverlayBytes(overlay, L"Named") == "A named");
+    CHECK(OverlayBytes(overlay, MAKEINTRESOURCEW(3)).empty());
+    CHECK(OverlayBytes(overlay, L"Other").empty());
+    CHECK(overlay.GetStats().mapped == 3);
+    CHECK(!overlay.Refresh());
+
+    // A renamed-over file gets a new slot; the old mapping stays readable
+    ReplaceFile(root / "A" / "resources" / "10" / "1.bin", "A one, again");
+    CHECK(overlay.Refresh());
+    uint32_t newSlot = 0;
+    CHECK(OverlayBytes(overlay, MAKEINTRESOURCEW(1), &newSlot) ==
+          "A one, again");
+    CHECK(newSlot != slot);
+    const void *data = nullptr;
+    uint32_t size = 0;
+    CHECK(overlay.Get(slot, &data, &size));
+    CHECK(std::string((const char *)data, size) == "A one");
+
+    // A folder disabled in the config drops out of the index
+    {
+      std::ofstream out(config);
+      out << "[Addons]\nA=0\n";
+    }
+    CHECK(overlay.Refresh());
+    CHECK(OverlayBytes(overlay, MAKEINTRESOURCEW(1)) == "B one");
+    CHECK(OverlayBytes(overlay, L"Named").empty());
+    CHECK(overlay.GetStats().files == 2);
+    overlay.Stop();
+    CHECK(OverlayBytes(overlay, MAKEINTRESOURCEW(1)).empty());
+  }
+
+  {
+    // Hook threads keep finding the resource while the index is swapped
+    // under them: every answer is a whole version, never a missing one
+    fs::remove(config);
+    ResourceOverlay overlay;
+    overlay.Start(root, config, 0);
+    std::atomic<bool> stop{false};
+    std::atomic<int> bad{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+      readers.emplace_back([&]() {
+        while (!stop.load()) {
+          std::string bytes = OverlayBytes(overlay, MAKEINTRESOURCEW(2));
+          if (bytes.compare(0, 5, "B two") != 0)
+            bad++;
+        }
+      });
+    }
+    const int kVersions = 50;
+    int refreshed = 0;
+    for (int i = 1; i <= kVersions; ++i) {
+      // Sizes differ, so a rescan sees every version
+      ReplaceFile(root / "B" / "resources" / "10" / "2.bin",
+                  "B two" + std::string(i, '+'));
+      refreshed += overlay.Refresh();
+    }
+    stop = true;
+    for (std::thread &reader : readers)
+      reader.join();
+    CHECK(bad == 0);
+    CHECK(refreshed == kVersions);
+    CHECK(OverlayBytes(overlay, MAKEINTRESOURCEW(2)) ==
+          "B two" + std::string(kVersions, '+'));
+    CHECK(overlay.GetStats().files == 3);
+  }
+
+  std::error_code ec;
+  fs::remove_all(root, ec);
+}
+
+// --- Telemetry -------------------------------------------------------------
+
+static void TestTelemetry() {
+  int ownerA = 0, ownerB = 0;
+  {
+    // One producer per channel: a name in use is refused, whoever asks
+    TelemetryHub hub;
+    TelemetryChannel *gpu = hub.CreateChannel("A/GPU ms", &ownerA);
+    CHECK(gpu != nullptr);
+    CHECK(hub.CreateChannel("A/GPU ms", &ownerA) == nullptr);
+    CHECK(hub.CreateChannel("A/GPU ms", &ownerB) == nullptr);
+    CHECK(hub.CreateChannel(nullptr, &ownerA) == nullptr);
+    TelemetryChannel *host = hub.CreateChannel("Host/frame ms", nullptr);
+    CHECK(host != nullptr && host != gpu);
+    CHECK(hub.GetChannelCount() == 2);
+
+    // Unloading the owner frees its names, and the same ring comes back
+    hub.ReleaseOwner(&ownerB);
+    CHECK(hub.CreateChannel("A/GPU ms", &ownerB) == nullptr);
+    hub.ReleaseOwner(&ownerA);
+    CHECK(hub.CreateChannel("A/GPU ms", &ownerB) == gpu);
+    CHECK(hub.CreateChannel("A/GPU ms", &ownerA) == nullptr);
+    CHECK(hub.GetChannelCount() == 2);
+    // Without an owner, a channel is never released
+    hub.ReleaseOwner(nullptr);
+    CHECK(hub.CreateChannel("Host/frame ms", nullptr) == nullptr);
+  }
+  {
+    // Nothing drains a hub that never started its aggregator: the ring
+    // takes kRingCapacity samples and counts the rest as dropped
+    TelemetryHub hub;
+    hub.Shutdown();
+    TelemetryChannel *channel = hub.CreateChannel("Full", nullptr);
+    CHECK(channel != nullptr);
+    for (uint32_t i = 0; i < TelemetryHub::kRingCapacity + 100; ++i)
+      TelemetryPush(channel, 1.0f);
+    CHECK(channel->dropped.load() == 100);
+    CHECK(channel->writeIndex.load() - channel->readIndex.load() ==
+          TelemetryHub::kRingCapacity);
+  }
+  {
+    // A producer outruns the aggregator while the GUI side reads: every
+    // published snapshot is whole, and every sample is either aggregated
+    // or counted as dropped
+    TelemetryHub hub;
+    TelemetryChannel *channel = hub.CreateChannel("Fast", nullptr);
+    const uint32_t kPushes = TelemetryHub::kRingCapacity * 8;
+    std::atomic<bool> done{false};
+    std::thread producer([&]() {
+      for (uint32_t i = 0; i < kPushes; ++i) {
+        TelemetryPush(channel, (float)(i % 1000));
+        if (i % 1024 == 0)
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      done = true;
+    });
+    uint64_t total = 0;
+    bool consistent = true;
+    auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    TelemetryStats stats;
+    while (std::chrono::steady_clock::now() < deadline) {
+      CHECK(hub.ReadStats(0, &stats));
+      consistent = consistent && stats.totalSamples >= total &&
+                   stats.windowSamples <= TelemetryHub::kWindowSize &&
+                   stats.windowSamples <= stats.totalSamples;
+      if (stats.windowSamples) {
+        consistent = consistent && stats.min >= 0.0f &&
+                     stats.min <= stats.p50 && stats.p50 <= stats.p95 &&
+                     stats.p95 <= stats.p99 && stats.p99 <= stats.max &&
+                     stats.max <= 999.0f;
+      }
+      total = stats.totalSamples;
+      // Once the ring is empty, a last sample makes the aggregator
+      // publish the final dropped count
+      if (done && channel->readIndex.load() == channel->writeIndex.load()) {
+        TelemetryPush(channel, 0.0f);
+        break;
+      }
+      std::this_thread::yield();
+    }
+    producer.join();
+    while (std::chrono::steady_clock::now() < deadline &&
+           hub.ReadStats(0, &stats) &&
+           stats.totalSamples + stats.dropped < kPushes + 1)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CHECK(consistent);
+    CHECK(stats.totalSamples + stats.dropped == kPushes + 1);
+    CHECK(stats.windowSamples == TelemetryHub::kWindowSize);
+    CHECK(stats.historyCount == TelemetryStats::kHistoryLength);
+  }
+}
+
+// --- FrameScheduler --------------------------------------------------------
+
+class FakeClock : public IFrameClock {
+public:
+  uint64_t NowMicros() override { return now; }
+  uint64_t now = 1000000;
+};
+
+// Replays scripted results; a wait that times out advances the clock
+class FakeEvents : public IFrameEventSource {
+public:
+  explicit FakeEvents(FakeClock *clock) : clock(clock) {}
+
+  WaitResult WaitAndDispatch(uint64_t timeoutMicros) override {
+    waits.push_back(timeoutMicros);
+    if (!script.empty()) {
+      WaitResult result = script.front();
+      script.pop_front();
+      return result;
+    }
+    if (timeoutMicros == FrameScheduler::kWaitForever)
+      return WaitResult::Quit; // Nothing would ever wake it
+    clock->now += timeoutMicros;
+    return WaitResult::Timeout;
+  }
+
+  FakeClock *clock;
+  std::deque<WaitResult> script;
+  std::vector<uint64_t> waits;
+};
+
+static void TestFrameScheduler() {
+  typedef FrameScheduler::Action Action;
+  typedef IFrameEventSource::WaitResult WaitResult;
+  {
+    FakeClock clock;
+    FakeEvents events(&clock);
+    FrameScheduler scheduler(&clock, &events);
+
+    // A few settle frames at startup, then idle until an event
+    for (uint32_t i = 0; i < FrameScheduler::kSettleFrames; ++i) {
+      CHECK(scheduler.WaitForNextFrame() == Action::Render);
+      scheduler.OnFrameRendered();
+    }
+    CHECK(events.waits.empty());
+    CHECK(scheduler.NextDeadline(clock.now) == FrameScheduler::kWaitForever);
+    events.script.push_back(WaitResult::Events);
+    CHECK(scheduler.WaitForNextFrame() == Action::Render);
+    CHECK(events.waits.size() == 1 &&
+          events.waits[0] == FrameScheduler::kWaitForever);
+    for (uint32_t i = 0; i < FrameScheduler::kSettleFrames; ++i)
+      scheduler.OnFrameRendered();
+    CHECK(scheduler.WaitForNextFrame() == Action::Quit);
+  }
+
+  {
+    // Animation: frames at the requested rate until the duration ends
+    FakeClock clock;
+    FakeEvents events(&clock);
+    FrameScheduler scheduler(&clock, &events);
+    for (uint32_t i = 0; i < FrameScheduler::kSettleFrames; ++i)
+      scheduler.OnFrameRendered();
+    uint64_t start = clock.now;
+    scheduler.RequestAnimation(10.0f, 350000);
+    scheduler.OnFrameRendered();
+    int frames = 0;
+    while (scheduler.WaitForNextFrame() == Action::Render) {
+      frames++;
+      scheduler.OnFrameRendered();
+    }
+    CHECK(frames == 3);
+    CHECK(clock.now - start == 400000);
+    for (size_t i = 0; i + 1 < events.waits.size(); ++i)
+      CHECK(events.waits[i] == 100000);
+
+    // Overlapping requests: the faster rate and the later end win
+    events.waits.clear();
+    scheduler.RequestAnimation(10.0f, 200000);
+    scheduler.RequestAnimation(20.0f, 100000);
+    scheduler.OnFrameRendered();
+    CHECK(scheduler.NextDeadline(clock.now) == clock.now + 50000);
+    frames = 0;
+    while (scheduler.WaitForNextFrame() == Action::Render) {
+      frames++;
+      scheduler.OnFrameRendered();
+    }
+    CHECK(frames == 3); // At 50, 100 and 150 ms; none is due at the end
+  }
+
+  {
+    // An animation request made during every frame wakes the wait after it;
+    // the wake only sets the rate, so frames stay 100 ms apart
+    struct Waker {
+      FrameScheduler *scheduler;
+      int wakes = 0;
+    };
+    FakeClock clock;
+    FakeEvents events(&clock);
+    FrameScheduler scheduler(&clock, &events);
+    Waker waker = {&scheduler};
+    scheduler.SetWakeHandler(
+        [](void *user) {
+          Waker *waker = (Waker *)user;
+          waker->wakes++;
+          waker->scheduler->RequestAnimation(10.0f, 200000);
+        },
+        &waker);
+    for (uint32_t i = 0; i < FrameScheduler::kSettleFrames; ++i)
+      scheduler.OnFrameRendered();
+
+    std::vector<uint64_t> frameTimes;
+    scheduler.RequestAnimation(10.0f, 200000);
+    scheduler.OnFrameRendered();
+    for (int i = 0; i < 20; ++i) {
+      events.script.push_back(WaitResult::Wake);
+      CHECK(scheduler.WaitForNextFrame() == Action::Render);
+      frameTimes.push_back(clock.now);
+      scheduler.OnFrameRendered();
+    }
+    CHECK(waker.wakes == 20);
+    for (size_t i = 1; i < frameTimes.size(); ++i)
+      CHECK(frameTimes[i] - frameTimes[i - 1] == 100000);
+
+    // With no handler a wake is treated as input
+    FrameScheduler plain(&clock, &events);
+    for (uint32_t i = 0; i < FrameScheduler::kSettleFrames; ++i)
+      plain.OnFrameRendered();
+    events.script.push_back(WaitResult::Wake);
+    uint64_t before = clock.now;
+    CHECK(plain.WaitForNextFrame() == Action::Render);
+    CHECK(clock.now == before);
+  }
+
+  {
+    // Occluded: probes every kOcclusionProbeMicros instead of rendering
+    FakeClock clock;
+    FakeEvents events(&clock);
+    FrameScheduler scheduler(&clock, &events);
+    scheduler.SetOccluded(true);
+    CHECK(scheduler.IsOccluded());
+    uint64_t occludedAt = clock.now;
+    CHECK(scheduler.WaitForNextFrame() == Action::ProbeOcclusion);
+    CHECK(clock.now - occludedAt == FrameScheduler::kOcclusionProbeMicros);
+    scheduler.OnOcclusionProbed(true);
+    CHECK(scheduler.WaitForNextFrame() == Action::ProbeOcclusion);
+    CHECK(clock.now - occludedAt == 2 * FrameScheduler::kOcclusionProbeMicros);
+    // Visible again: back to rendering at once
+    scheduler.OnOcclusionProbed(false);
+    CHECK(!scheduler.IsOccluded());
+    CHECK(scheduler.WaitForNextFrame() == Action::Render);
+
+    // Minimized: no deadline at all until restored
+    scheduler.SetMinimized(true);
+    CHECK(scheduler.NextDeadline(clock.now) == FrameScheduler::kWaitForever);
+    scheduler.Invalidate();
+    CHECK(scheduler.NextDeadline(clock.now) == FrameScheduler::kWaitForever);
+    scheduler.SetMinimized(false);
+    CHECK(scheduler.NextDeadline(clock.now) == clock.now);
+  }
+}
+
+struct Suite {
+  const char *name;
+  void (*run)();
+};
+
+static const Suite kSuites[] = {
+    {"IniFile", TestIniFile},
+    {"PeImage", TestPeImage},
+    {"ShaderCache", TestShaderCache},
+    {"InterceptResource", TestInterceptResource},
+    {"InterceptBatch", TestInterceptBatch},
+    {"AddonInterface", TestAddonInterface},
+    {"TransformChain", TestTransformChain},
+    {"Lz4Block", TestLz4Block},
+    {"FrameScheduler", TestFrameScheduler},
+    {"Dxbc", TestDxbc},
+    {"Rcu", TestRcu},
+    {"ControlProtocol", TestControlProtocol},
+    {"SharedStats", TestSharedStats},
+    {"Telemetry", TestTelemetry},
+    {"AllocPool", TestAllocPool},
+    {"ImportHook", TestImportHook},
+    {"ResourceOverlay", TestResourceOverlay},
+    {"ResourceTrace", TestResourceTrace},
+};
+
+int main(int argc, char **argv) {
+  BenchSupport::InstallShimResourceApi();
+  int ran = 0;
+  for (const Suite &suite : kSuites) {
+    bool selected = argc < 2;
+    for (int i = 1; i < argc; ++i)
+      selected = selected || std::strcmp(argv[i], suite.name) == 0;
+    if (!selected)
+      continue;
+    int before = g_failures;
+    suite.run();
+    std::printf("%-20s %s\n", suite.name,
+                g_failures == before ? "ok" : "FAILED");
+    std::fflush(stdout);
+    ran++;
+  }
+  if (ran == 0) {
+    std::fprintf(stderr, "usage: %s [suite...]\n", argv[0]);
+    return 1;
+  }
+  return g_failures;
+}
@@ -0,0 +1,94 @@
+// Minimal addon used by core_bench: replaces RCDATA resource #1 with a fixed
+// 64 KB blob and passes on everything else, per call or in a batch.
+// core_tests can also switch a loaded copy to a GetAddonInterface table,
+// including a malformed one or one with an asynchronous initialize.
+
+#include "addon_api.hpp"
+
+#ifdef _WIN32
+#define BENCH_EXPORT extern "C" __declspec(dllexport)
+#else
+#define BENCH_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+static uint8_t g_blob[64 * 1024];
+
+BENCH_EXPORT uint32_t GetAddonCapabilities() { return ADDON_CAP_NONE; }
+
+BENCH_EXPORT bool AddonInterceptResource(const wchar_t *name,
+                                         const wchar_t *type,
+                                         const void **outData,
+                                         uint32_t *outSize) {
+  if ((uintptr_t)type != 10 || (uintptr_t)name != 1)
+    return false;
+  *outData = g_blob;
+  *outSize = sizeof(g_blob);
+  return true;
+}
+
+BENCH_EXPORT void AddonInterceptResourceBatch(const ResourceRequest *requests,
+                                              uint32_t count,
+                                              ResourceResponse *responses) {
+  for (uint32_t i = 0; i < count; ++i) {
+    AddonInterceptResource(requests[i].name, requests[i].type,
+                           &responses[i].data, &responses[i].size);
+  }
+}
+
+// BenchAddonSetInterface modes. Copies loaded from one path share them.
+enum BenchInterface {
+  kNamedExports, // GetAddonInterface returns nullptr
+  kTableV1,
+  kTableTruncated, // size stops short of version 1's members
+  kTableVersion0,
+  kTableAsync, // initializeAsync, completed by BenchAddonCompleteInit
+};
+
+static int g_interface = kNamedExports;
+static IHost *g_host = nullptr;
+static AddonInitTask *g_initTask = nullptr;
+static int g_settingsRenders = 0;
+static int g_shutdowns = 0;
+
+static void TableInitializeAsync(IHost *host, ImGuiContext *, void *, void *,
+                                 void *, AddonInitTask *task) {
+  g_host = host;
+  g_initTask = task;
+}
+
+static void TableShutdown() { g_shutdowns++; }
+
+static void TableRenderSettings() { g_settingsRenders++; }
+
+BENCH_EXPORT void BenchAddonSetInterface(int mode) { g_interface = mode; }
+
+BENCH_EXPORT void BenchAddonCompleteInit(bool succeeded) {
+  if (g_host && g_initTask)
+    g_host->CompleteInitialize(g_initTask, succeeded);
+  g_initTask = nullptr;
+}
+
+BENCH_EXPORT void BenchAddonCalls(int *settingsRenders, int *shutdowns) {
+  *settingsRenders = g_settingsRenders;
+  *shutdowns = g_shutdowns;
+}
+
+BENCH_EXPORT const AddonInterface *GetAddonInterface(uint32_t) {
+  static AddonInterface table;
+  if (g_interface == kNamedExports)
+    return nullptr;
+  table = {};
+  table.size = sizeof(AddonInterface);
+  table.version = ADDON_INTERFACE_VERSION;
+  table.addonVersion = "table";
+  table.shutdown = TableShutdown;
+  table.renderSettings = TableRenderSettings;
+  table.interceptResource = AddonInterceptResource;
+  if (g_interface == kTableTruncated)
+    table.size = offsetof(AddonInterface, transformResource);
+  if (g_interface == kTableVersion0)
+    table.version = 0;
+  if (g_interface == kTableAsync)
+    table.initializeAsync = TableInitializeAsync;
+  return &table;
+}
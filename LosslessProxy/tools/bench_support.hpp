@@ -0,0 +1,59 @@
+#pragma once
+// Shared pieces for the core tools: a stand-in kernel32 resource API and an
+// addons folder populated with copies of bench_addon.
+
+#include "shader_hook.hpp"
+#include <cstdio>
+#include <filesystem>
+
+#ifndef CORE_BENCH_ADDON_PATH
+#define CORE_BENCH_ADDON_PATH ""
+#endif
+
+namespace BenchSupport {
+
+inline const LPCWSTR kRcData = MAKEINTRESOURCEW(10);
+
+// Shim "kernel32": every resource exists and is 256 bytes of zeros
+inline uint8_t g_shimResource[256];
+inline HRSRC WINAPI ShimFindResourceW(HMODULE, LPCWSTR, LPCWSTR) {
+  return (HRSRC)(uintptr_t)0x1000;
+}
+inline HGLOBAL WINAPI ShimLoadResource(HMODULE, HRSRC) {
+  return (HGLOBAL)g_shimResource;
+}
+inline DWORD WINAPI ShimSizeofResource(HMODULE, HRSRC) {
+  return sizeof(g_shimResource);
+}
+inline LPVOID WINAPI ShimLockResource(HGLOBAL data) { return data; }
+inline BOOL WINAPI ShimFreeResource(HGLOBAL) { return TRUE; }
+
+inline void InstallShimResourceApi() {
+  ShaderHook::ResourceApi shim = {ShimFindResourceW, ShimLoadResource,
+                                  ShimSizeofResource, ShimLockResource,
+                                  ShimFreeResource};
+  ShaderHook::SetResourceApi(shim);
+}
+
+// Fresh <root>/BenchAddonNNNN/BenchAddonNNNN.<ext> copies of the module
+inline bool CreateAddonCopies(const std::filesystem::path &module,
+                              const std::filesystem::path &root, int count) {
+  namespace fs = std::filesystem;
+  std::error_code ec;
+  fs::remove_all(root, ec);
+  fs::create_directories(root);
+  if (module.empty() || !fs::exists(module))
+    return false;
+  for (int i = 0; i < count; ++i) {
+    char folder[32];
+    std::snprintf(folder, sizeof(folder), "BenchAddon%04d", i);
+    fs::path dir = root / folder;
+    fs::create_directories(dir);
+    fs::path target = dir / folder;
+    target += Platform::kModuleExtension;
+    fs::copy_file(module, target);
+  }
+  return true;
+}
+
+} // namespace BenchSupport
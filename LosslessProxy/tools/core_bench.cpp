@@ -0,0 +1,573 @@
+// Micro-benchmarks for the LosslessCore hot paths: addon intercept dispatch,
+// the hooked resource functions, the shader cache and its LZ4 cold tier,
+// DXBC checksums, shader patches and the transform chain, batched
+// intercepts, instrumented export bookkeeping, import hook dispatch, INI
+// config and PE import lookup. Runs without Windows; the hooks fall through to a shim
+// ResourceApi.
+//
+//   core_bench [--iterations N] [--addons N[,N...]] [--addon-module PATH]
+
+#include "addon_manager.hpp"
+#include "bench_support.hpp"
+#include "dxbc.hpp"
+#include "export_profile.hpp"
+#include "import_hook.hpp"
+#include "ini_file.hpp"
+#include "lz4_block.hpp"
+#include "pe_image.hpp"
+#include "shader_patch.hpp"
+#include "transform_chain.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using BenchSupport::kRcData;
+
+// Keeps the optimizer from discarding benchmarked results
+static volatile uintptr_t g_sink;
+
+// Median ns per call over several rounds
+template <typename Fn> static double NanosPerOp(int iterations, Fn &&fn) {
+  std::vector<double> rounds;
+  for (int round = 0; round < 7; ++round) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+      fn();
+    auto end = std::chrono::steady_clock::now();
+    rounds.push_back(
+        std::chrono::duration<double, std::nano>(end - start).count() /
+        iterations);
+  }
+  std::sort(rounds.begin(), rounds.end());
+  return rounds[rounds.size() / 2];
+}
+
+static void Report(const char *name, double nanos) {
+  std::printf("%-44s %12.1f\n", name, nanos);
+}
+
+// What the game does for every shader it loads
+static uintptr_t LoadResourceThroughHooks(LPCWSTR name) {
+  HRSRC info = ShaderHook::HookedFindResourceW(nullptr, name, kRcData);
+  HGLOBAL data = ShaderHook::HookedLoadResource(nullptr, info);
+  DWORD size = ShaderHook::HookedSizeofResource(nullptr, info);
+  LPVOID bytes = ShaderHook::HookedLockResource(data);
+  ShaderHook::HookedFreeResource(data);
+  return (uintptr_t)bytes + size;
+}
+
+static void BenchDispatch(const fs::path &addonModule,
+                          const std::vector<int> &addonCounts,
+                          int iterations) {
+  BenchSupport::InstallShimResourceApi();
+
+  fs::path root = fs::temp_directory_path() / "core_bench_addons";
+  for (int count : addonCounts) {
+    if (!BenchSupport::CreateAddonCopies(addonModule, root, count)) {
+      std::printf("(dispatch benchmarks skipped: bench_addon not found)\n");
+      break;
+    }
+
+    char label[64];
+    // The directory scan and INI parsing DllMain used to do under the
+    // loader lock, now on DeferredInit's thread
+    std::snprintf(label, sizeof(label), "AddonManager construction, %d addons",
+                  count);
+    Report(label, NanosPerOp(std::max(1, iterations / 1000), [&]() {
+             AddonManager scanned(root);
+             g_sink = scanned.GetAddons().size();
+           }));
+
+    AddonManager manager(root);
+    manager.LoadAddons();
+    manager.InitializeAddons(nullptr, nullptr, nullptr, nullptr);
+    ShaderHook::Initialize(&manager);
+
+    const void *data;
+    uint32_t size;
+    std::snprintf(label, sizeof(label), "InterceptResource miss, %d addons",
+                  count);
+    Report(label, NanosPerOp(iterations, [&]() {
+             g_sink = manager.InterceptResource(MAKEINTRESOURCEW(2), kRcData,
+                                                &data, &size);
+           }));
+    std::snprintf(label, sizeof(label), "InterceptResource hit, %d addons",
+                  count);
+    Report(label, NanosPerOp(iterations, [&]() {
+             g_sink = manager.InterceptResource(MAKEINTRESOURCEW(1), kRcData,
+                                                &data, &size);
+           }));
+    std::snprintf(label, sizeof(label), "Hooked load passthrough, %d addons",
+                  count);
+    Report(label, NanosPerOp(iterations, [&]() {
+             g_sink = LoadResourceThroughHooks(MAKEINTRESOURCEW(2));
+           }));
+    // Intercepts copy 64 KB and append to ShaderHook.log; keep the count low
+    std::snprintf(label, sizeof(label), "Hooked load intercepted, %d addons",
+                  count);
+    Report(label, NanosPerOp(std::max(1, iterations / 100), [&]() {
+             g_sink = LoadResourceThroughHooks(MAKEINTRESOURCEW(1));
+           }));
+
+    // The same lookups once every addon has answered in a batch, which
+    // initialization asks for: reloaded with the directory set
+    manager.SetResourceDirectory(
+        {{{10, L""}, {1, L""}}, {{10, L""}, {2, L""}}});
+    manager.UnloadAddons();
+    manager.LoadAddons();
+    manager.InitializeAddons(nullptr, nullptr, nullptr, nullptr);
+    std::snprintf(label, sizeof(label),
+                  "InterceptResource miss, %d addons, batched", count);
+    Report(label, NanosPerOp(iterations, [&]() {
+             g_sink = manager.InterceptResource(MAKEINTRESOURCEW(2), kRcData,
+                                                &data, &size);
+           }));
+    std::snprintf(label, sizeof(label),
+                  "InterceptResource hit, %d addons, batched", count);
+    Report(label, NanosPerOp(iterations, [&]() {
+             g_sink = manager.InterceptResource(MAKEINTRESOURCEW(1), kRcData,
+                                                &data, &size);
+           }));
+
+    ShaderHook::Shutdown();
+    manager.UnloadAddons();
+  }
+  fs::remove_all(root);
+}
+
+// Bytecode-like data: a small instruction vocabulary with varying operands,
+// so it compresses about as well as real DXBC rather than trivially
+static std::vector<uint8_t> MakeShaderLikeBytes(size_t size, uint32_t seed) {
+  std::vector<uint8_t> bytes(size);
+  uint32_t state = seed;
+  for (size_t i = 0; i + 4 <= size; i += 4) {
+    state = state * 1664525u + 1013904223u;
+    uint32_t token = (state >> 28) < 10 ? 0x00100000u | ((state >> 24) & 7)
+                                        : state & 0x0000FFFFu;
+    std::memcpy(bytes.data() + i, &token, sizeof(token));
+  }
+  return bytes;
+}
+
+static void BenchShaderCache(int iterations) {
+  ShaderHook::ShaderCache cache;
+  std::vector<uint8_t> bytecode(4096, 0xCC);
+  for (uintptr_t id = 1; id <= 256; ++id)
+    cache.Store((HRSRC)id, bytecode.data(), (uint32_t)bytecode.size());
+
+  uintptr_t id = 0;
+  Report("ShaderCache::GetSize, 256 entries", NanosPerOp(iterations, [&]() {
+           id = (id % 256) + 1;
+           g_sink = cache.GetSize((HRSRC)id);
+         }));
+  Report("ShaderCache::Store 4 KB", NanosPerOp(iterations / 10, [&]() {
+           id = (id % 256) + 1;
+           cache.Store((HRSRC)id, bytecode.data(), (uint32_t)bytecode.size());
+         }));
+
+  // 64 x 64 KB under a 1 MB budget: most of them go cold
+  std::vector<uint8_t> shader = MakeShaderLikeBytes(64 * 1024, 1);
+  ShaderHook::ShaderCache budgeted;
+  budgeted.SetBudget(1024 * 1024);
+  for (uintptr_t i = 1; i <= 64; ++i)
+    budgeted.Store((HRSRC)i, shader.data(), (uint32_t)shader.size());
+  Report("ShaderCache::Lock hot 64 KB", NanosPerOp(iterations / 10, [&]() {
+           g_sink = (uintptr_t)budgeted.Lock((HRSRC)64);
+           budgeted.Release((HRSRC)64);
+         }));
+  Report("ShaderCache::Lock cold 64 KB", NanosPerOp(iterations / 100, [&]() {
+           id = (id % 64) + 1;
+           g_sink = (uintptr_t)budgeted.Lock((HRSRC)id);
+           budgeted.Release((HRSRC)id);
+         }));
+  ShaderHook::ShaderCache::Stats stats = budgeted.GetStats();
+  std::printf("  (budget 1 MB: %llu KB hot, %llu KB cold in %llu KB)\n",
+              (unsigned long long)stats.hotBytes / 1024,
+              (unsigned long long)stats.coldRawBytes / 1024,
+              (unsigned long long)stats.coldBytes / 1024);
+}
+
+static void BenchLz4(int iterations) {
+  std::vector<uint8_t> shader = MakeShaderLikeBytes(64 * 1024, 2);
+  std::vector<uint8_t> block, restored(shader.size());
+  Report("Lz4Block::Compress 64 KB", NanosPerOp(iterations / 100, [&]() {
+           Lz4Block::Compress(shader.data(), shader.size(), &block);
+         }));
+  Report("Lz4Block::Decompress 64 KB", NanosPerOp(iterations / 100, [&]() {
+           g_sink = Lz4Block::Decompress(block.data(), block.size(),
+                                         restored.data(), restored.size());
+         }));
+  std::printf("  (ratio %.2f, round trip %s)\n",
+              (double)shader.size() / block.size(),
+              restored == shader ? "ok" : "FAILED");
+}
+
+// RDEF/ISGN/OSGN/SHEX/STAT container around shaderSize bytes of program
+static std::vector<uint8_t> BuildSyntheticContainer(size_t shaderSize) {
+  const uint32_t fourCCs[] = {Dxbc::kResourceDef, Dxbc::kInputSignature,
+                              Dxbc::kOutputSignature, Dxbc::kShaderSM5,
+                              Dxbc::kStatistics};
+  std::vector<uint8_t> chunkData[] = {
+      MakeShaderLikeBytes(512, 3), MakeShaderLikeBytes(64, 4),
+      MakeShaderLikeBytes(64, 5), MakeShaderLikeBytes(shaderSize, 6),
+      std::vector<uint8_t>(148, 0)};
+  const uint32_t count = 5;
+
+  std::vector<uint8_t> container(32 + count * 4);
+  auto put32 = [&](size_t offset, uint32_t value) {
+    std::memcpy(container.data() + offset, &value, sizeof(value));
+  };
+  for (uint32_t i = 0; i < count; ++i) {
+    put32(32 + i * 4, (uint32_t)container.size());
+    uint32_t header[2] = {fourCCs[i], (uint32_t)chunkData[i].size()};
+    const uint8_t *bytes = (const uint8_t *)header;
+    container.insert(container.end(), bytes, bytes + sizeof(header));
+    container.insert(container.end(), chunkData[i].begin(),
+                     chunkData[i].end());
+  }
+  put32(0, Dxbc::kMagic);
+  put32(20, 1);
+  put32(24, (uint32_t)container.size());
+  put32(28, count);
+  Dxbc::UpdateChecksum(container.data(), container.size());
+  return container;
+}
+
+static void BenchDxbc(int iterations) {
+  for (size_t shaderSize : {4096, 65536}) {
+    std::vector<uint8_t> container = BuildSyntheticContainer(shaderSize);
+    char label[64];
+    std::snprintf(label, sizeof(label), "Dxbc::ComputeChecksum %zu KB",
+                  container.size() / 1024);
+    uint32_t checksum[4];
+    Report(label, NanosPerOp(iterations / 100, [&]() {
+             Dxbc::ComputeChecksum(container.data(), container.size(),
+                                   checksum);
+             g_sink = checksum[0];
+           }));
+  }
+
+  std::vector<uint8_t> container = BuildSyntheticContainer(16384);
+  Report("Dxbc::Container::Parse, 5 chunks", NanosPerOp(iterations, [&]() {
+           Dxbc::Container parsed;
+           parsed.Parse(container.data(), container.size());
+           g_sink = (uintptr_t)parsed.FindShaderChunk();
+         }));
+
+  // One instruction token in SHEX, and a whole new RDEF
+  uint32_t token = 0x00100001;
+  ShaderPatch bytePatch = {MAKEINTRESOURCEW(3), kRcData, SHADER_PATCH_BYTES,
+                           Dxbc::kShaderSM5,   64,      &token,
+                           sizeof(token),      nullptr};
+  std::vector<uint8_t> resourceDef = MakeShaderLikeBytes(768, 7);
+  ShaderPatch chunkPatch = {MAKEINTRESOURCEW(4),
+                            kRcData,
+                            SHADER_PATCH_CHUNK,
+                            Dxbc::kResourceDef,
+                            0,
+                            resourceDef.data(),
+                            (uint32_t)resourceDef.size(),
+                            nullptr};
+  ShaderPatcher patcher;
+  patcher.Register(bytePatch, nullptr);
+  patcher.Register(chunkPatch, nullptr);
+
+  std::vector<uint8_t> patched;
+  std::vector<uint8_t> original = container;
+  uint32_t variant = 0;
+  // A different stored checksum per call defeats the result cache
+  Report("ShaderPatcher byte patch 16 KB, uncached",
+         NanosPerOp(iterations / 100, [&]() {
+           variant++;
+           std::memcpy(original.data() + 4, &variant, sizeof(variant));
+           g_sink = patcher.Apply(MAKEINTRESOURCEW(3), kRcData,
+                                  original.data(),
+                                  (uint32_t)original.size(), &patched);
+         }));
+  bool byteOk = Dxbc::VerifyChecksum(patched.data(), patched.size());
+  Report("ShaderPatcher chunk patch 16 KB, uncached",
+         NanosPerOp(iterations / 100, [&]() {
+           variant++;
+           std::memcpy(original.data() + 4, &variant, sizeof(variant));
+           g_sink = patcher.Apply(MAKEINTRESOURCEW(4), kRcData,
+                                  original.data(),
+                                  (uint32_t)original.size(), &patched);
+         }));
+  bool chunkOk = Dxbc::VerifyChecksum(patched.data(), patched.size());
+  Report("ShaderPatcher byte patch 16 KB, cached",
+         NanosPerOp(iterations / 10, [&]() {
+           g_sink = patcher.Apply(MAKEINTRESOURCEW(3), kRcData,
+                                  container.data(),
+                                  (uint32_t)container.size(), &patched);
+         }));
+  Report("ShaderPatcher::HasPatches miss", NanosPerOp(iterations, [&]() {
+           g_sink = patcher.HasPatches(MAKEINTRESOURCEW(9), kRcData);
+         }));
+  std::printf("  (patched checksums %s)\n",
+              byteOk && chunkOk ? "verify" : "FAILED to verify");
+}
+
+// Three in-process chain stages over 16 KB: tint (rewrites one word),
+// passthrough and a full rewrite. The settings counters stand in for the
+// addons' AddonGetSettingsHash.
+static uint64_t g_tintSettings = 1, g_rewriteSettings = 1;
+static std::vector<uint8_t> g_stageOutput[2];
+
+static bool TintStage(const wchar_t *, const wchar_t *, const void *input,
+                      uint32_t size, const void **out, uint32_t *outSize) {
+  std::vector<uint8_t> &output = g_stageOutput[0];
+  output.assign((const uint8_t *)input, (const uint8_t *)input + size);
+  std::memcpy(output.data(), &g_tintSettings, sizeof(g_tintSettings));
+  *out = output.data();
+  *outSize = size;
+  return true;
+}
+
+static bool PassStage(const wchar_t *, const wchar_t *, const void *,
+                      uint32_t, const void **, uint32_t *) {
+  return false;
+}
+
+static bool RewriteStage(const wchar_t *, const wchar_t *, const void *input,
+                         uint32_t size, const void **out, uint32_t *outSize) {
+  std::vector<uint8_t> &output = g_stageOutput[1];
+  output.resize(size);
+  const uint8_t *bytes = (const uint8_t *)input;
+  for (uint32_t i = 0; i < size; ++i)
+    output[i] = bytes[i] ^ (uint8_t)g_rewriteSettings;
+  *out = output.data();
+  *outSize = size;
+  return true;
+}
+
+static void BenchTransforms(int iterations) {
+  TransformChain chain;
+  chain.SetStages({{"Tint", "1.0", TintStage, []() { return g_tintSettings; }},
+                   {"Pass", "1.0", PassStage, []() { return (uint64_t)0; }},
+                   {"Rewrite", "1.0", RewriteStage,
+                    []() { return g_rewriteSettings; }}});
+  std::vector<uint8_t> input = MakeShaderLikeBytes(16384, 8), output;
+  LPCWSTR name = MAKEINTRESOURCEW(1);
+
+  Report("TransformChain 3 stages, memoized",
+         NanosPerOp(iterations / 10, [&]() {
+           g_sink = chain.Run(name, kRcData, input.data(),
+                              (uint32_t)input.size(), &output);
+         }));
+  Report("TransformChain, last stage settings changed",
+         NanosPerOp(iterations / 100, [&]() {
+           g_rewriteSettings++;
+           g_sink = chain.Run(name, kRcData, input.data(),
+                              (uint32_t)input.size(), &output);
+         }));
+  Report("TransformChain, first stage settings changed",
+         NanosPerOp(iterations / 100, [&]() {
+           g_tintSettings++;
+           g_sink = chain.Run(name, kRcData, input.data(),
+                              (uint32_t)input.size(), &output);
+         }));
+  TransformChain::Stats stats = chain.GetStats();
+  std::printf("  (%llu runs, %llu stage calls, %llu memo hits)\n",
+              (unsigned long long)stats.runs,
+              (unsigned long long)stats.stageCalls,
+              (unsigned long long)stats.memoHits);
+}
+
+static void BenchIni(int iterations) {
+  fs::path path = fs::temp_directory_path() / "core_bench_addons_config.ini";
+  {
+    std::ofstream out(path);
+    out << "; generated by core_bench\n[Addons]\n";
+    for (int i = 0; i < 64; ++i)
+      out << "LS_Addon_" << i << "=" << (i % 2) << "\n";
+  }
+
+  IniFile ini;
+  ini.Load(path);
+  int key = 0;
+  std::string name;
+  Report("IniFile::GetInt, 64 keys", NanosPerOp(iterations / 10, [&]() {
+           name = "LS_Addon_" + std::to_string(key++ % 64);
+           g_sink = (uintptr_t)ini.GetInt("Addons", name, 1);
+         }));
+  Report("IniFile::Load, 64 keys", NanosPerOp(iterations / 100, [&]() {
+           g_sink = ini.Load(path);
+         }));
+  fs::remove(path);
+}
+
+// A PE32+ image whose sections sit at file offset == RVA, so the same bytes
+// parse both as a mapped module and as a file
+static std::vector<uint8_t> BuildSyntheticImage(const char *lastImport) {
+  std::vector<uint8_t> image(0x4000, 0);
+  auto put16 = [&](size_t at, uint16_t v) { std::memcpy(&image[at], &v, 2); };
+  auto put32 = [&](size_t at, uint32_t v) { std::memcpy(&image[at], &v, 4); };
+  auto put64 = [&](size_t at, uint64_t v) { std::memcpy(&image[at], &v, 8); };
+  auto putString = [&](size_t at, const std::string &s) {
+    std::memcpy(&image[at], s.c_str(), s.size() + 1);
+  };
+
+  put16(0, 0x5A4D);
+  put32(0x3C, 0x80);
+  put32(0x80, 0x4550);
+  const size_t fileHeader = 0x84, optional = fileHeader + 20;
+  put16(fileHeader + 0, 0x8664);
+  put16(fileHeader + 2, 1);         // NumberOfSections
+  put16(fileHeader + 16, 112 + 128); // SizeOfOptionalHeader
+  put16(optional, 0x20B);
+  put32(optional + 56, (uint32_t)image.size()); // SizeOfImage
+  put32(optional + 108, 16);                    // NumberOfRvaAndSizes
+  put32(optional + 112 + 8, 0x1000);            // Import directory
+  put32(optional + 112 + 12, 3 * 20);
+
+  const size_t section = optional + 240;
+  put32(section + 8, 0x3000);  // VirtualSize
+  put32(section + 12, 0x1000); // VirtualAddress
+  put32(section + 16, 0x3000); // SizeOfRawData
+  put32(section + 20, 0x1000); // PointerToRawData
+
+  // Two DLLs with 48 named imports each; the target is last in kernel32
+  const char *dlls[2] = {"USER32.dll", "KERNEL32.dll"};
+  size_t strings = 0x1100, lookup = 0x2000, iat = 0x2800;
+  for (int d = 0; d < 2; ++d) {
+    size_t descriptor = 0x1000 + d * 20;
+    put32(descriptor + 0, (uint32_t)lookup);
+    put32(descriptor + 12, (uint32_t)strings);
+    put32(descriptor + 16, (uint32_t)iat);
+    putString(strings, dlls[d]);
+    strings += 16;
+    for (int i = 0; i < 48; ++i) {
+      std::string name = (d == 1 && i == 47)
+                             ? std::string(lastImport)
+                             : "Import" + std::to_string(d * 100 + i);
+      put16(strings, 0); // Hint
+      putString(strings + 2, name);
+      put64(lookup, strings);
+      put64(iat, 0x7FF000000000ull + i);
+      strings += (2 + name.size() + 2) & ~size_t(1);
+      lookup += 8;
+      iat += 8;
+    }
+    lookup += 8; // Null terminators
+    iat += 8;
+  }
+  return image;
+}
+
+static void BenchPe(int iterations) {
+  std::vector<uint8_t> image = BuildSyntheticImage("FreeResource");
+  PeImage pe;
+  if (!pe.Parse(image.data(), 0, true) ||
+      !pe.FindImportSlot("kernel32.dll", "FreeResource")) {
+    std::printf("(PE benchmarks skipped: synthetic image did not parse)\n");
+    return;
+  }
+
+  Report("PeImage Parse+FindImportSlot, mapped",
+         NanosPerOp(iterations / 10, [&]() {
+           PeImage mappedImage;
+           mappedImage.Parse(image.data(), 0, true);
+           g_sink = (uintptr_t)mappedImage.FindImportSlot("kernel32.dll",
+                                                          "FreeResource");
+         }));
+  Report("PeImage Parse+FindImportSlot, file",
+         NanosPerOp(iterations / 10, [&]() {
+           PeImage fileImage;
+           fileImage.Parse(image.data(), image.size(), false);
+           g_sink = (uintptr_t)fileImage.FindImportSlot("kernel32.dll",
+                                                        "FreeResource");
+         }));
+}
+
+// What a LOSSLESS_INSTRUMENT_EXPORTS thunk adds around each export call,
+// minus the thunk's own register saves
+static void ExportStandIn() {}
+static void CountCall(const ExportCallInfo *call, void *) {
+  g_sink += call->phase;
+}
+
+static void BenchExports(int iterations) {
+  ExportProfile::SetTarget(ExportProfile::kInit, (void *)&ExportStandIn);
+  void *returnSlot = nullptr;
+  auto call = [&]() {
+    g_sink = (uintptr_t)ExportProfileEnter(ExportProfile::kInit, &returnSlot,
+                                           (void *)&ExportStandIn);
+    g_sink = (uintptr_t)ExportProfileLeave();
+  };
+  Report("Export thunk enter+leave", NanosPerOp(iterations, call));
+  uint32_t id = ExportProfile::Subscribe(CountCall, nullptr, nullptr);
+  Report("Export thunk enter+leave, 1 subscriber",
+         NanosPerOp(iterations, call));
+  ExportProfile::Unsubscribe(id);
+}
+
+// An import as the IAT would see it, with and without callbacks
+static uint32_t WINAPI BenchImport(uint32_t value) { return value * 3 + 1; }
+LS_IMPORT_HOOK(g_benchImportHook, "bench.dll", "BenchImport",
+               uint32_t(WINAPI *)(uint32_t));
+static void BenchImportPre(ImportCall *call, void *) {
+  g_sink += *(uint32_t *)call->args[0];
+}
+
+static void BenchImportHooks(int iterations) {
+  typedef uint32_t(WINAPI * Import)(uint32_t);
+  g_benchImportHook.Install((void *)&BenchImport);
+  // Through volatile pointers, as calls through an IAT slot are
+  Import volatile direct = &BenchImport;
+  Import volatile hooked = (Import)g_benchImportHook.GetDispatch();
+  uint32_t value = 0;
+  Report("Import call, direct", NanosPerOp(iterations * 10, [&]() {
+           g_sink = direct(value++);
+         }));
+  Report("Import call, hooked, no callbacks",
+         NanosPerOp(iterations * 10, [&]() { g_sink = hooked(value++); }));
+  uint32_t id =
+      g_benchImportHook.AddCallback(BenchImportPre, nullptr, nullptr, nullptr);
+  Report("Import call, hooked, 1 callback",
+         NanosPerOp(iterations, [&]() { g_sink = hooked(value++); }));
+  ImportHooks::RemoveCallback(id);
+}
+
+int main(int argc, char **argv) {
+  int iterations = 200000;
+  std::vector<int> addonCounts = {1, 8, 32};
+  fs::path addonModule = CORE_BENCH_ADDON_PATH;
+
+  for (int i = 1; i < argc; ++i) {
+    if (!std::strcmp(argv[i], "--iterations") && i + 1 < argc) {
+      iterations = std::max(100, std::atoi(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--addons") && i + 1 < argc) {
+      addonCounts.clear();
+      for (char *tok = std::strtok(argv[++i], ","); tok;
+           tok = std::strtok(nullptr, ","))
+        addonCounts.push_back(std::max(0, std::atoi(tok)));
+    } else if (!std::strcmp(argv[i], "--addon-module") && i + 1 < argc) {
+      addonModule = argv[++i];
+    } else {
+      std::fprintf(stderr,
+                   "usage: %s [--iterations N] [--addons N[,N...]] "
+                   "[--addon-module PATH]\n",
+                   argv[0]);
+      return 1;
+    }
+  }
+
+  std::printf("%-44s %12s\n", "case", "ns/op");
+  BenchDispatch(addonModule, addonCounts, iterations);
+  BenchShaderCache(iterations);
+  BenchLz4(iterations);
+  BenchDxbc(iterations);
+  BenchTransforms(iterations);
+  BenchExports(iterations);
+  BenchImportHooks(iterations);
+  BenchIni(iterations);
+  BenchPe(iterations);
+  return 0;
+}
@@ -0,0 +1,258 @@
+// Builds manager UI frames against a null ImGui backend (no window, no GPU)
+// and reports per-frame CPU time and allocation counts.
+//
+//   gui_bench [--frames N] [--addons N[,N...]] [--settings] [--config]
+//             [--pool]
+//
+// --pool routes ImGui through the host's pooled allocator (alloc_pool.hpp),
+// as the proxy does, instead of malloc.
+
+#include "alloc_pool.hpp"
+#include "gui_frame.hpp"
+#include "imgui.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::atomic<uint64_t> g_newCount{0};
+static std::atomic<uint64_t> g_newBytes{0};
+static std::atomic<uint64_t> g_imguiAllocCount{0};
+static std::atomic<uint64_t> g_imguiAllocBytes{0};
+
+void *operator new(size_t size) {
+  g_newCount.fetch_add(1, std::memory_order_relaxed);
+  g_newBytes.fetch_add(size, std::memory_order_relaxed);
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+static bool g_usePool = false;
+
+static void *CountingImGuiAlloc(size_t size, void *user) {
+  g_imguiAllocCount.fetch_add(1, std::memory_order_relaxed);
+  g_imguiAllocBytes.fetch_add(size, std::memory_order_relaxed);
+  return g_usePool ? AllocPool::Alloc(size, user) : std::malloc(size);
+}
+static void CountingImGuiFree(void *p, void *user) {
+  if (g_usePool)
+    AllocPool::Free(p, user);
+  else
+    std::free(p);
+}
+
+struct SyntheticAddon {
+  std::string name;
+  std::filesystem::path configPath;
+  bool enabled = true;
+  bool loaded = true;
+  bool hasSettings = false;
+  bool showSettings = false;
+  bool overlay = false;
+  float value = 0.5f;
+};
+
+class SyntheticGuiHost : public IGuiHost {
+public:
+  SyntheticGuiHost(int count, bool openSettings,
+                   const std::filesystem::path &configPath) {
+    // Revisions must not repeat across hosts or the UI keeps stale rows
+    static uint64_t s_hostRevision = 0;
+    revision = (s_hostRevision += 1000000);
+    addons.resize(count);
+    for (int i = 0; i < count; ++i) {
+      char name[64];
+      std::snprintf(name, sizeof(name), "LS_SyntheticAddon_%04d", i);
+      addons[i].name = name;
+      addons[i].enabled = (i % 5) != 0;
+      addons[i].loaded = addons[i].enabled;
+      addons[i].hasSettings = (i % 2) == 0;
+      addons[i].showSettings = openSettings && addons[i].hasSettings && i < 8;
+      if (i % 3 == 0)
+        addons[i].configPath = configPath;
+    }
+  }
+
+  uint64_t GetRevision() override { return revision; }
+  int GetAddonCount() override { return (int)addons.size(); }
+  std::string GetAddonName(int index) override { return addons[index].name; }
+  bool IsAddonEnabled(int index) override { return addons[index].enabled; }
+  bool IsAddonLoaded(int index) override { return addons[index].loaded; }
+  const char *GetAddonStatus(int index) override {
+    return addons[index].loaded ? "Loaded" : "Unloaded";
+  }
+  bool GetLoadProgress(int *, int *) override { return false; }
+  bool HasAddonSettings(int index) override {
+    return addons[index].hasSettings;
+  }
+  bool *GetShowSettingsFlag(int index) override {
+    return &addons[index].showSettings;
+  }
+  std::filesystem::path GetAddonConfigPath(int index) override {
+    return addons[index].configPath;
+  }
+
+  void ToggleAddon(int index, bool enable) override {
+    addons[index].enabled = enable;
+    addons[index].loaded = enable;
+    revision++;
+  }
+  void ReloadAddons() override {}
+  void RequestRedraw() override { redrawRequested = true; }
+  void RequestAnimation(float, uint32_t) override {}
+  const TelemetryHub *GetTelemetry() override { return nullptr; }
+  void RenderAddonSettings(int index) override {
+    // Roughly what a typical addon settings page draws
+    ImGui::Text("Settings for %s", addons[index].name.c_str());
+    ImGui::SliderFloat("Strength", &addons[index].value, 0.0f, 1.0f);
+    ImGui::Checkbox("Show overlay", &addons[index].overlay);
+    ImGui::Separator();
+    for (int row = 0; row < 8; ++row) {
+      ImGui::Text("Row %d: %.3f", row, addons[index].value * row);
+    }
+  }
+
+  std::atomic<bool> redrawRequested{false};
+
+private:
+  std::vector<SyntheticAddon> addons;
+  uint64_t revision;
+};
+
+struct Result {
+  double meanMicros;
+  double p50Micros;
+  double p99Micros;
+  double newPerFrame;
+  double newBytesPerFrame;
+  double imguiAllocPerFrame;
+};
+
+static Result RunBenchmark(int addonCount, int frames, bool openSettings,
+                           bool openConfig,
+                           const std::filesystem::path &configPath) {
+  ImGui::SetAllocatorFunctions(CountingImGuiAlloc, CountingImGuiFree,
+                               g_usePool ? AllocPool::GetTag("Host")
+                                         : nullptr);
+  ImGui::CreateContext();
+  ImGuiIO &io = ImGui::GetIO();
+  io.IniFilename = nullptr;
+  io.DisplaySize = ImVec2(1000, 700);
+  io.DeltaTime = 1.0f / 60.0f;
+  unsigned char *pixels;
+  int width, height;
+  io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+  GuiFrame::SetupStyle();
+
+  SyntheticGuiHost host(addonCount, openSettings, configPath);
+  if (openConfig)
+    GuiFrame::OpenConfigEditor(&host, configPath);
+
+  // Warm up: first frames create windows and fill ImGui's internal pools.
+  // The config file loads on a worker; keep going until it has arrived.
+  for (int i = 0; i < 11; ++i) {
+    while (openConfig && i == 10 && !host.redrawRequested) {
+      std::this_thread::yield();
+    }
+    ImGui::NewFrame();
+    GuiFrame::Build(&host);
+    ImGui::Render();
+  }
+
+  std::vector<double> samples;
+  samples.reserve(frames);
+  uint64_t newCount = g_newCount.load();
+  uint64_t newBytes = g_newBytes.load();
+  uint64_t imguiAllocs = g_imguiAllocCount.load();
+
+  for (int i = 0; i < frames; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    ImGui::NewFrame();
+    GuiFrame::Build(&host);
+    ImGui::Render();
+    auto end = std::chrono::steady_clock::now();
+    samples.push_back(
+        std::chrono::duration<double, std::micro>(end - start).count());
+  }
+
+  Result result;
+  result.newPerFrame = double(g_newCount.load() - newCount) / frames;
+  result.newBytesPerFrame = double(g_newBytes.load() - newBytes) / frames;
+  result.imguiAllocPerFrame =
+      double(g_imguiAllocCount.load() - imguiAllocs) / frames;
+
+  GuiFrame::Shutdown();
+  ImGui::DestroyContext();
+
+  double total = 0;
+  for (double s : samples)
+    total += s;
+  std::sort(samples.begin(), samples.end());
+  result.meanMicros = total / frames;
+  result.p50Micros = samples[frames / 2];
+  result.p99Micros = samples[std::min(frames - 1, frames * 99 / 100)];
+  return result;
+}
+
+int main(int argc, char **argv) {
+  int frames = 2000;
+  std::vector<int> addonCounts = {1, 10, 100, 1000};
+  bool openSettings = false;
+  bool openConfig = false;
+
+  for (int i = 1; i < argc; ++i) {
+    if (!std::strcmp(argv[i], "--frames") && i + 1 < argc) {
+      frames = std::max(1, std::atoi(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--addons") && i + 1 < argc) {
+      addonCounts.clear();
+      for (char *tok = std::strtok(argv[++i], ","); tok;
+           tok = std::strtok(nullptr, ","))
+        addonCounts.push_back(std::max(0, std::atoi(tok)));
+    } else if (!std::strcmp(argv[i], "--settings")) {
+      openSettings = true;
+    } else if (!std::strcmp(argv[i], "--config")) {
+      openConfig = true;
+    } else if (!std::strcmp(argv[i], "--pool")) {
+      g_usePool = true;
+    } else {
+      std::fprintf(stderr,
+                   "usage: %s [--frames N] [--addons N[,N...]] [--settings] "
+                   "[--config] [--pool]\n",
+                   argv[0]);
+      return 1;
+    }
+  }
+
+  // A plausible addon ini for the config editor
+  std::filesystem::path configPath =
+      std::filesystem::temp_directory_path() / "gui_bench_addon.ini";
+  {
+    std::ofstream config(configPath);
+    config << "[Settings]\n";
+    for (int i = 0; i < 200; ++i)
+      config << "Key" << i << "=" << i * 3 << "\n";
+  }
+
+  std::printf("%8s %10s %10s %10s %10s %12s %10s\n", "addons", "mean_us",
+              "p50_us", "p99_us", "new/frm", "newB/frm", "imgui/frm");
+  for (int count : addonCounts) {
+    Result r =
+        RunBenchmark(count, frames, openSettings, openConfig, configPath);
+    std::printf("%8d %10.1f %10.1f %10.1f %10.1f %12.0f %10.1f\n", count,
+                r.meanMicros, r.p50Micros, r.p99Micros, r.newPerFrame,
+                r.newBytesPerFrame, r.imguiAllocPerFrame);
+  }
+
+  std::filesystem::remove(configPath);
+  return 0;
+}
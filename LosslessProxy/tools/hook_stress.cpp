@@ -0,0 +1,248 @@
+// Drives the Hooked* resource functions from many threads, the way Lossless
+// does during startup and mode switches, while a "GUI" thread toggles and
+// reloads addons. Reports throughput, per-sequence latency and shader cache
+// lock contention. Build with -DLOSSLESS_SANITIZE=thread (or address) to
+// have the races between dispatch and addon state changes reported.
+//
+//   hook_stress [--threads N] [--seconds S] [--addons N] [--toggle-hz F]
+//               [--reload-hz F] [--intercept-ratio R] [--seed N]
+//               [--addon-module PATH]
+
+#include "addon_manager.hpp"
+#include "bench_support.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using BenchSupport::kRcData;
+using Clock = std::chrono::steady_clock;
+
+struct WorkerStats {
+  uint64_t sequences = 0;
+  uint64_t intercepted = 0;
+  uint64_t failures = 0; // Inconsistent size/pointer across one sequence
+  std::vector<uint32_t> latencyNanos;
+};
+
+struct Options {
+  int threads = 8;
+  double seconds = 3.0;
+  int addons = 8;
+  double toggleHz = 200.0;
+  double reloadHz = 5.0;
+  double interceptRatio = 0.1;
+  uint32_t seed = 1;
+  fs::path addonModule = CORE_BENCH_ADDON_PATH;
+};
+
+static std::atomic<bool> g_stop{false};
+
+static void Worker(const Options &options, uint32_t seed, WorkerStats *out) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> coin(0.0, 1.0);
+  std::uniform_int_distribution<int> passthroughId(2, 64);
+  out->latencyNanos.reserve(1 << 20);
+
+  while (!g_stop.load(std::memory_order_relaxed)) {
+    bool wantIntercept = coin(rng) < options.interceptRatio;
+    LPCWSTR name = MAKEINTRESOURCEW(wantIntercept ? 1 : passthroughId(rng));
+
+    auto start = Clock::now();
+    HRSRC info = ShaderHook::HookedFindResourceW(nullptr, name, kRcData);
+    HGLOBAL data = ShaderHook::HookedLoadResource(nullptr, info);
+    DWORD size = ShaderHook::HookedSizeofResource(nullptr, info);
+    const uint8_t *bytes =
+        (const uint8_t *)ShaderHook::HookedLockResource(data);
+    // Touch both ends so a sanitizer sees any read of freed bytecode
+    volatile uint8_t first = 0, last = 0;
+    if (bytes && size) {
+      first = bytes[0];
+      last = bytes[size - 1];
+    }
+    (void)first;
+    (void)last;
+    ShaderHook::HookedFreeResource(data);
+    auto end = Clock::now();
+
+    bool custom = ShaderHook::IsOurShaderHandle(info);
+    if (custom)
+      out->intercepted++;
+    if (!bytes || size == 0 ||
+        (custom ? size != 64 * 1024
+                : size != sizeof(BenchSupport::g_shimResource)))
+      out->failures++;
+
+    // Sample every 4th sequence; the reserved buffer caps memory
+    if ((out->sequences & 3) == 0 &&
+        out->latencyNanos.size() < out->latencyNanos.capacity()) {
+      uint64_t nanos =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+              .count();
+      out->latencyNanos.push_back(
+          (uint32_t)std::min<uint64_t>(nanos, UINT32_MAX));
+    }
+    out->sequences++;
+  }
+}
+
+// Stands in for GuiThread: ToggleAddon and ReloadAddons at random intervals
+static void Events(const Options &options, AddonManager *manager,
+                   uint64_t *toggles, uint64_t *reloads) {
+  std::mt19937 rng(options.seed ^ 0x9E3779B9u);
+  std::exponential_distribution<double> toggleGap(
+      std::max(options.toggleHz, 1e-6));
+  std::exponential_distribution<double> reloadGap(
+      std::max(options.reloadHz, 1e-6));
+
+  auto nextToggle = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                       std::chrono::duration<double>(
+                                           toggleGap(rng)));
+  auto nextReload = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                       std::chrono::duration<double>(
+                                           reloadGap(rng)));
+  while (!g_stop.load(std::memory_order_relaxed)) {
+    auto now = Clock::now();
+    if (options.toggleHz > 0 && now >= nextToggle) {
+      int count = (int)manager->GetAddons().size();
+      if (count > 0) {
+        int index = std::uniform_int_distribution<int>(0, count - 1)(rng);
+        manager->ToggleAddon(index, !manager->GetAddons()[index].enabled);
+        (*toggles)++;
+      }
+      nextToggle = now + std::chrono::duration_cast<Clock::duration>(
+                             std::chrono::duration<double>(toggleGap(rng)));
+    }
+    if (options.reloadHz > 0 && now >= nextReload) {
+      manager->ReloadAddons();
+      (*reloads)++;
+      nextReload = now + std::chrono::duration_cast<Clock::duration>(
+                             std::chrono::duration<double>(reloadGap(rng)));
+    }
+    // As a frame would: initializes what toggles and reloads attached
+    manager->PumpStagedLoad();
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+}
+
+static double Percentile(const std::vector<uint32_t> &sorted, double p) {
+  if (sorted.empty())
+    return 0.0;
+  size_t index = (size_t)(p * (sorted.size() - 1));
+  return sorted[index];
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    bool hasValue = i + 1 < argc;
+    if (!std::strcmp(argv[i], "--threads") && hasValue) {
+      options.threads = std::max(1, std::atoi(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--seconds") && hasValue) {
+      options.seconds = std::max(0.1, std::atof(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--addons") && hasValue) {
+      options.addons = std::max(0, std::atoi(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--toggle-hz") && hasValue) {
+      options.toggleHz = std::max(0.0, std::atof(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--reload-hz") && hasValue) {
+      options.reloadHz = std::max(0.0, std::atof(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--intercept-ratio") && hasValue) {
+      options.interceptRatio = std::clamp(std::atof(argv[++i]), 0.0, 1.0);
+    } else if (!std::strcmp(argv[i], "--seed") && hasValue) {
+      options.seed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+    } else if (!std::strcmp(argv[i], "--addon-module") && hasValue) {
+      options.addonModule = argv[++i];
+    } else {
+      std::fprintf(stderr,
+                   "usage: %s [--threads N] [--seconds S] [--addons N] "
+                   "[--toggle-hz F] [--reload-hz F] [--intercept-ratio R] "
+                   "[--seed N] [--addon-module PATH]\n",
+                   argv[0]);
+      return 1;
+    }
+  }
+
+  fs::path root = fs::temp_directory_path() / "hook_stress_addons";
+  if (!BenchSupport::CreateAddonCopies(options.addonModule, root,
+                                       options.addons)) {
+    std::fprintf(stderr, "bench_addon module not found: %s\n",
+                 options.addonModule.u8string().c_str());
+    return 1;
+  }
+
+  BenchSupport::InstallShimResourceApi();
+  AddonManager manager(root);
+  manager.LoadAddons();
+  manager.InitializeAddons(nullptr, nullptr, nullptr, nullptr); // No UI here
+  ShaderHook::Initialize(&manager);
+
+  std::vector<WorkerStats> stats(options.threads);
+  std::vector<std::thread> workers;
+  uint64_t toggles = 0, reloads = 0;
+  auto start = Clock::now();
+  for (int i = 0; i < options.threads; ++i) {
+    workers.emplace_back(Worker, std::cref(options), options.seed + i + 1,
+                         &stats[i]);
+  }
+  std::thread events(Events, std::cref(options), &manager, &toggles,
+                     &reloads);
+
+  std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+  g_stop.store(true);
+  for (std::thread &worker : workers)
+    worker.join();
+  events.join();
+  double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+  uint64_t sequences = 0, intercepted = 0, failures = 0;
+  std::vector<uint32_t> latency;
+  for (const WorkerStats &s : stats) {
+    sequences += s.sequences;
+    intercepted += s.intercepted;
+    failures += s.failures;
+    latency.insert(latency.end(), s.latencyNanos.begin(),
+                   s.latencyNanos.end());
+  }
+  std::sort(latency.begin(), latency.end());
+  ShaderHook::ShaderCache::Stats cache = ShaderHook::GetCacheStats();
+
+  std::printf("threads %d, addons %d, %.1f s\n", options.threads,
+              options.addons, elapsed);
+  std::printf("  sequences    %12llu  (%.0f/s, %.1f%% intercepted)\n",
+              (unsigned long long)sequences, sequences / elapsed,
+              sequences ? 100.0 * intercepted / sequences : 0.0);
+  std::printf("  latency ns   p50 %.0f  p99 %.0f  p99.9 %.0f  max %.0f\n",
+              Percentile(latency, 0.50), Percentile(latency, 0.99),
+              Percentile(latency, 0.999),
+              latency.empty() ? 0.0 : (double)latency.back());
+  std::printf("  cache lock   %llu finds, %llu stores, %llu contended "
+              "(%.2f%%)\n",
+              (unsigned long long)cache.finds,
+              (unsigned long long)cache.stores,
+              (unsigned long long)cache.contended,
+              cache.finds + cache.stores
+                  ? 100.0 * cache.contended / (cache.finds + cache.stores)
+                  : 0.0);
+  std::printf("  cache memory %llu KB hot, %llu KB cold in %llu KB, %llu "
+              "evictions, %llu restores\n",
+              (unsigned long long)cache.hotBytes / 1024,
+              (unsigned long long)cache.coldRawBytes / 1024,
+              (unsigned long long)cache.coldBytes / 1024,
+              (unsigned long long)cache.evictions,
+              (unsigned long long)cache.restores);
+  std::printf("  events       %llu toggles, %llu reloads\n",
+              (unsigned long long)toggles, (unsigned long long)reloads);
+  std::printf("  failures     %llu\n", (unsigned long long)failures);
+
+  ShaderHook::Shutdown();
+  manager.UnloadAddons();
+  std::error_code ec;
+  fs::remove_all(root, ec);
+  return failures ? 2 : 0;
+}
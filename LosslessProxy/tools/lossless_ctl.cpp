@@ -0,0 +1,156 @@
+// Both ends of the headless control channel (LOSSLESS_HEADLESS) without
+// Windows or Lossless:
+//
+//   lossless_ctl serve [--seconds S] [--addons N] [--channel NAME]
+//                      [--addon-module PATH]
+//     Runs the proxy's HeadlessHost over copies of bench_addon, as the DLL
+//     does when headless, and serves the channel for S seconds.
+//
+//   lossless_ctl [--channel NAME] [--repeat N] <request...>
+//     Sends one request (see control_protocol.hpp), prints the response
+//     and, with --repeat, the mean round trip over N sends.
+
+#include "addon_manager.hpp"
+#include "bench_support.hpp"
+#include "control_protocol.hpp"
+#include "headless_host.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  double seconds = 60.0;
+  int addons = 4;
+  int repeat = 1;
+  std::string channel = HeadlessHost::kDefaultChannel;
+  fs::path addonModule = CORE_BENCH_ADDON_PATH;
+  std::string request;
+};
+
+static int Serve(const Options &options) {
+  BenchSupport::InstallShimResourceApi();
+  fs::path root = fs::temp_directory_path() / "lossless_ctl_addons";
+  if (!BenchSupport::CreateAddonCopies(options.addonModule, root,
+                                       options.addons))
+    std::printf("(bench_addon not found: serving without addons)\n");
+
+  AddonManager manager(root);
+  ShaderHook::Initialize(&manager);
+  HeadlessHost host;
+  if (!host.Start(&manager, options.channel.c_str())) {
+    std::fprintf(stderr, "Could not open channel %s\n",
+                 options.channel.c_str());
+    host.Stop();
+    return 1;
+  }
+  std::printf("Serving %s for %.0f s\n", options.channel.c_str(),
+              options.seconds);
+  std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+  host.Stop();
+  ShaderHook::Shutdown();
+  manager.UnloadAddons();
+  return 0;
+}
+
+// Reads one whole response: "ok <n>" and n lines, or one "err" line
+static bool ReadResponse(Platform::LocalConnection *connection,
+                         std::string *pending, std::string *response) {
+  response->clear();
+  size_t lines = 1;
+  for (;;) {
+    size_t newline;
+    while (lines > 0 && (newline = pending->find('\n')) != std::string::npos) {
+      std::string line = pending->substr(0, newline + 1);
+      pending->erase(0, newline + 1);
+      if (response->empty() && line.compare(0, 3, "ok ") == 0)
+        lines += std::strtoul(line.c_str() + 3, nullptr, 10);
+      *response += line;
+      lines--;
+    }
+    if (lines == 0)
+      return true;
+    char buffer[4096];
+    size_t read = Platform::ReadLocal(connection, buffer, sizeof(buffer));
+    if (!read)
+      return false;
+    pending->append(buffer, read);
+  }
+}
+
+static int Request(const Options &options) {
+  Platform::LocalConnection connection;
+  if (!Platform::ConnectLocal(options.channel.c_str(), &connection)) {
+    std::fprintf(stderr, "Nothing is serving %s\n", options.channel.c_str());
+    return 1;
+  }
+  std::string line = options.request + "\n";
+  std::string pending, response;
+  auto start = Clock::now();
+  for (int i = 0; i < options.repeat; ++i) {
+    if (!Platform::WriteLocal(&connection, line.data(), line.size()) ||
+        !ReadResponse(&connection, &pending, &response)) {
+      std::fprintf(stderr, "Connection lost\n");
+      Platform::CloseLocal(&connection);
+      return 1;
+    }
+  }
+  double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  Platform::CloseLocal(&connection);
+
+  std::fputs(response.c_str(), stdout);
+  if (options.repeat > 1)
+    std::printf("%d round trips, %.1f us each\n", options.repeat,
+                elapsed * 1e6 / options.repeat);
+  return response.compare(0, 3, "ok ") == 0 ? 0 : 2;
+}
+
+static int Usage(const char *program) {
+  std::fprintf(stderr,
+               "usage: %s serve [--seconds S] [--addons N] [--channel NAME] "
+               "[--addon-module PATH]\n"
+               "       %s [--channel NAME] [--repeat N] <request...>\n",
+               program, program);
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2)
+    return Usage(argv[0]);
+  bool serve = !std::strcmp(argv[1], "serve");
+
+  Options options;
+  for (int i = serve ? 2 : 1; i < argc; ++i) {
+    bool hasValue = i + 1 < argc;
+    if (!std::strcmp(argv[i], "--seconds") && hasValue) {
+      options.seconds = std::max(0.1, std::atof(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--addons") && hasValue) {
+      options.addons = std::max(0, std::atoi(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--repeat") && hasValue) {
+      options.repeat = std::max(1, std::atoi(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--channel") && hasValue) {
+      options.channel = argv[++i];
+    } else if (!std::strcmp(argv[i], "--addon-module") && hasValue) {
+      options.addonModule = argv[++i];
+    } else if (!serve && std::strncmp(argv[i], "--", 2) != 0) {
+      // The rest is the request, words joined by spaces
+      for (; i < argc; ++i)
+        options.request += std::string(options.request.empty() ? "" : " ") +
+                           argv[i];
+    } else {
+      return Usage(argv[0]);
+    }
+  }
+  if (serve)
+    return Serve(options);
+  if (options.request.empty() ||
+      options.request.size() > ControlProtocol::kMaxRequest)
+    return Usage(argv[0]);
+  return Request(options);
+}
@@ -0,0 +1,328 @@
+// Replays a resource trace recorded with LOSSLESS_RECORD_RESOURCES through
+// the hooked resource functions and addon intercept pipeline. Resources the
+// game loaded from its own DLL come from a stand-in kernel32 with the
+// recorded sizes. Addons are either a real addons folder or N copies of
+// bench_addon. Each recorded thread is replayed on its own thread.
+//
+//   resource_replay TRACE [--pace original|fast] [--addons-dir DIR]
+//                   [--stand-in N] [--addon-module PATH] [--repeat N]
+
+#include "addon_manager.hpp"
+#include "bench_support.hpp"
+#include "resource_trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+using ResourceTrace::Event;
+using ResourceTrace::Op;
+using Clock = std::chrono::steady_clock;
+
+// Resources that were not intercepted at record time, keyed by (name, type)
+struct ShimBlob {
+  std::vector<uint8_t> data;
+};
+typedef std::pair<std::wstring, std::wstring> ResourceKey;
+static std::map<ResourceKey, ShimBlob> g_blobs; // Read-only during replay
+
+static std::wstring KeyPart(LPCWSTR value) {
+  if (IS_INTRESOURCE(value))
+    return L"#" + std::to_wstring((uintptr_t)value);
+  return value;
+}
+
+static std::wstring KeyPart(uint64_t id, bool isString,
+                            const std::wstring &text) {
+  return isString ? text : L"#" + std::to_wstring(id);
+}
+
+static HRSRC WINAPI ReplayFindResourceW(HMODULE, LPCWSTR name, LPCWSTR type) {
+  auto it = g_blobs.find(ResourceKey(KeyPart(name), KeyPart(type)));
+  return it != g_blobs.end() ? (HRSRC)&it->second : nullptr;
+}
+static HGLOBAL WINAPI ReplayLoadResource(HMODULE, HRSRC info) {
+  return info ? (HGLOBAL)((ShimBlob *)info)->data.data() : nullptr;
+}
+static DWORD WINAPI ReplaySizeofResource(HMODULE, HRSRC info) {
+  return info ? (DWORD)((ShimBlob *)info)->data.size() : 0;
+}
+static LPVOID WINAPI ReplayLockResource(HGLOBAL data) { return data; }
+static BOOL WINAPI ReplayFreeResource(HGLOBAL) { return TRUE; }
+
+// Recorded handle values to the ones this replay produced
+class HandleMap {
+public:
+  void Set(uint64_t recorded, uint64_t replayed) {
+    std::lock_guard<std::mutex> guard(lock);
+    values[recorded] = replayed;
+  }
+  bool Get(uint64_t recorded, uint64_t *replayed) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = values.find(recorded);
+    if (it == values.end())
+      return false;
+    *replayed = it->second;
+    return true;
+  }
+  void Clear() {
+    std::lock_guard<std::mutex> guard(lock);
+    values.clear();
+  }
+
+private:
+  std::mutex lock;
+  std::unordered_map<uint64_t, uint64_t> values;
+};
+
+static HandleMap g_handles;
+
+struct ThreadResult {
+  std::vector<uint32_t> nanos[6]; // Indexed by Op
+  uint64_t intercepted = 0;
+  uint64_t unmapped = 0; // Handle from before the recording started
+  uint64_t mismatched = 0; // Different interception outcome than recorded
+};
+
+static void BuildBlobs(const std::vector<Event> &events) {
+  // Find result -> key, then the size SizeofResource reported for it
+  std::unordered_map<uint64_t, ResourceKey> handleKeys;
+  for (const Event &event : events) {
+    const ResourceTrace::Record &r = event.record;
+    if (r.flags & ResourceTrace::kIntercepted)
+      continue;
+    if ((Op)r.op == Op::FindResource && r.result) {
+      ResourceKey key(
+          KeyPart(r.name, r.flags & ResourceTrace::kNameIsString, event.name),
+          KeyPart(r.type, r.flags & ResourceTrace::kTypeIsString, event.type));
+      handleKeys[r.result] = key;
+      g_blobs[key]; // Size filled in below; empty until then
+    } else if ((Op)r.op == Op::SizeofResource) {
+      auto it = handleKeys.find(r.handle);
+      if (it != handleKeys.end())
+        g_blobs[it->second].data.resize((size_t)r.result, 0xAB);
+    }
+  }
+}
+
+static void ReplayThread(const std::vector<const Event *> &events,
+                         bool originalPace, Clock::time_point start,
+                         ThreadResult *out) {
+  for (const Event *event : events) {
+    const ResourceTrace::Record &r = event->record;
+    if (originalPace)
+      std::this_thread::sleep_until(start +
+                                    std::chrono::nanoseconds(r.timestampNanos));
+
+    LPCWSTR name = (r.flags & ResourceTrace::kNameIsString)
+                       ? event->name.c_str()
+                       : (LPCWSTR)(uintptr_t)r.name;
+    LPCWSTR type = (r.flags & ResourceTrace::kTypeIsString)
+                       ? event->type.c_str()
+                       : (LPCWSTR)(uintptr_t)r.type;
+    uint64_t handle = 0;
+    if ((Op)r.op != Op::FindResource && !g_handles.Get(r.handle, &handle)) {
+      out->unmapped++;
+      continue;
+    }
+
+    uint64_t result = 0;
+    bool intercepted = false;
+    auto callStart = Clock::now();
+    switch ((Op)r.op) {
+    case Op::FindResource: {
+      HRSRC info = ShaderHook::HookedFindResourceW(nullptr, name, type);
+      result = (uintptr_t)info;
+      intercepted = ShaderHook::IsOurShaderHandle(info);
+      break;
+    }
+    case Op::LoadResource:
+      result = (uintptr_t)ShaderHook::HookedLoadResource(nullptr,
+                                                         (HRSRC)handle);
+      break;
+    case Op::SizeofResource:
+      result = ShaderHook::HookedSizeofResource(nullptr, (HRSRC)handle);
+      break;
+    case Op::LockResource:
+      result = (uintptr_t)ShaderHook::HookedLockResource((HGLOBAL)handle);
+      break;
+    case Op::FreeResource:
+      result = ShaderHook::HookedFreeResource((HGLOBAL)handle);
+      break;
+    default:
+      continue;
+    }
+    auto callEnd = Clock::now();
+    out->nanos[r.op].push_back((uint32_t)std::min<int64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(callEnd -
+                                                             callStart)
+            .count(),
+        UINT32_MAX));
+
+    if ((Op)r.op == Op::FindResource) {
+      if (intercepted)
+        out->intercepted++;
+      if (intercepted != ((r.flags & ResourceTrace::kIntercepted) != 0))
+        out->mismatched++;
+    }
+    if ((Op)r.op == Op::FindResource || (Op)r.op == Op::LoadResource)
+      g_handles.Set(r.result, result);
+  }
+}
+
+static double Percentile(std::vector<uint32_t> &values, double p) {
+  if (values.empty())
+    return 0.0;
+  std::sort(values.begin(), values.end());
+  return values[(size_t)(p * (values.size() - 1))];
+}
+
+int main(int argc, char **argv) {
+  fs::path tracePath;
+  fs::path addonsDir;
+  fs::path addonModule = CORE_BENCH_ADDON_PATH;
+  int standIns = 1;
+  int repeat = 1;
+  bool originalPace = false;
+
+  for (int i = 1; i < argc; ++i) {
+    bool hasValue = i + 1 < argc;
+    if (!std::strcmp(argv[i], "--pace") && hasValue) {
+      originalPace = !std::strcmp(argv[++i], "original");
+    } else if (!std::strcmp(argv[i], "--addons-dir") && hasValue) {
+      addonsDir = argv[++i];
+    } else if (!std::strcmp(argv[i], "--stand-in") && hasValue) {
+      standIns = std::max(0, std::atoi(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--addon-module") && hasValue) {
+      addonModule = argv[++i];
+    } else if (!std::strcmp(argv[i], "--repeat") && hasValue) {
+      repeat = std::max(1, std::atoi(argv[++i]));
+    } else if (argv[i][0] != '-' && tracePath.empty()) {
+      tracePath = argv[i];
+    } else {
+      tracePath.clear();
+      break;
+    }
+  }
+  if (tracePath.empty()) {
+    std::fprintf(stderr,
+                 "usage: %s TRACE [--pace original|fast] [--addons-dir DIR] "
+                 "[--stand-in N] [--addon-module PATH] [--repeat N]\n",
+                 argv[0]);
+    return 1;
+  }
+
+  std::vector<Event> events;
+  std::string error;
+  if (!ResourceTrace::ReadFile(tracePath, &events, &error)) {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  if (!error.empty())
+    std::fprintf(stderr, "warning: %s\n", error.c_str());
+  if (events.empty()) {
+    std::fprintf(stderr, "trace is empty\n");
+    return 1;
+  }
+
+  // Recorded per-op durations and per-thread event lists
+  std::vector<uint32_t> recordedNanos[6];
+  std::map<uint16_t, std::vector<const Event *>> threads;
+  uint64_t recordedIntercepts = 0;
+  for (const Event &event : events) {
+    if (event.record.op >= 1 && event.record.op <= 5)
+      recordedNanos[event.record.op].push_back(event.record.durationNanos);
+    if ((Op)event.record.op == Op::FindResource &&
+        (event.record.flags & ResourceTrace::kIntercepted))
+      recordedIntercepts++;
+    threads[event.record.thread].push_back(&event);
+  }
+  double recordedSpan = events.back().record.timestampNanos * 1e-9;
+
+  BuildBlobs(events);
+  ShaderHook::ResourceApi api = {ReplayFindResourceW, ReplayLoadResource,
+                                 ReplaySizeofResource, ReplayLockResource,
+                                 ReplayFreeResource};
+  ShaderHook::SetResourceApi(api);
+
+  fs::path standInRoot = fs::temp_directory_path() / "resource_replay_addons";
+  if (addonsDir.empty()) {
+    if (standIns > 0 &&
+        !BenchSupport::CreateAddonCopies(addonModule, standInRoot, standIns)) {
+      std::fprintf(stderr, "bench_addon module not found: %s\n",
+                   addonModule.u8string().c_str());
+      return 1;
+    }
+    addonsDir = standInRoot;
+  }
+  AddonManager manager(addonsDir);
+  manager.LoadAddons();
+  manager.InitializeAddons(nullptr, nullptr, nullptr, nullptr); // No UI here
+  ShaderHook::Initialize(&manager);
+
+  std::printf("trace: %zu calls on %zu threads over %.3f s, %llu intercepted "
+              "FindResourceW\n",
+              events.size(), threads.size(), recordedSpan,
+              (unsigned long long)recordedIntercepts);
+  std::printf("replay: %s pace, %zu addons from %s\n",
+              originalPace ? "original" : "fast", manager.GetAddons().size(),
+              addonsDir.u8string().c_str());
+
+  std::vector<ThreadResult> results;
+  double wallSeconds = 0.0;
+  for (int pass = 0; pass < repeat; ++pass) {
+    g_handles.Clear();
+    std::vector<ThreadResult> passResults(threads.size());
+    std::vector<std::thread> workers;
+    auto start = Clock::now();
+    size_t index = 0;
+    for (auto &thread : threads) {
+      workers.emplace_back(ReplayThread, std::cref(thread.second),
+                           originalPace, start, &passResults[index++]);
+    }
+    for (std::thread &worker : workers)
+      worker.join();
+    wallSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+    results.insert(results.end(), passResults.begin(), passResults.end());
+  }
+
+  ThreadResult total;
+  for (ThreadResult &result : results) {
+    for (int op = 1; op <= 5; ++op)
+      total.nanos[op].insert(total.nanos[op].end(), result.nanos[op].begin(),
+                             result.nanos[op].end());
+    total.intercepted += result.intercepted;
+    total.unmapped += result.unmapped;
+    total.mismatched += result.mismatched;
+  }
+
+  std::printf("\n%-16s %10s %12s %12s %12s %12s\n", "call", "count",
+              "rec_p50_ns", "rec_p99_ns", "p50_ns", "p99_ns");
+  for (int op = 1; op <= 5; ++op) {
+    std::printf("%-16s %10zu %12.0f %12.0f %12.0f %12.0f\n",
+                ResourceTrace::OpName((Op)op), total.nanos[op].size(),
+                Percentile(recordedNanos[op], 0.50),
+                Percentile(recordedNanos[op], 0.99),
+                Percentile(total.nanos[op], 0.50),
+                Percentile(total.nanos[op], 0.99));
+  }
+  std::printf("\nwall %.3f s per pass, %llu intercepted per pass, %llu "
+              "outcome mismatches, %llu unmapped handles\n",
+              wallSeconds / repeat,
+              (unsigned long long)(total.intercepted / repeat),
+              (unsigned long long)total.mismatched,
+              (unsigned long long)total.unmapped);
+
+  ShaderHook::Shutdown();
+  manager.UnloadAddons();
+  std::error_code ec;
+  fs::remove_all(standInRoot, ec);
+  return 0;
+}
@@ -0,0 +1,216 @@
+// Both ends of the shared stats segment (LOSSLESS_PUBLISH_STATS) without
+// Windows or Lossless:
+//
+//   stats_monitor publish [--seconds S] [--interval-ms N] [--addons N]
+//                         [--segment NAME] [--addon-module PATH]
+//     Loads copies of bench_addon, drives the hooked resource functions and
+//     a telemetry channel from a worker thread, and publishes through the
+//     proxy's own StatsPublisher.
+//
+//   stats_monitor watch [--seconds S] [--hz F] [--segment NAME]
+//     Samples the segment the way a dashboard would (--hz 0 spins), prints
+//     the metrics once a second, then reports snapshot rate and cost, copies
+//     retried because the writer was mid-publish, and how stale the data was.
+
+#include "addon_manager.hpp"
+#include "bench_support.hpp"
+#include "shared_stats.hpp"
+#include "stats_publisher.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using BenchSupport::kRcData;
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  double seconds = 10.0;
+  uint32_t intervalMs = StatsPublisher::kDefaultIntervalMs;
+  int addons = 4;
+  double hz = 1000.0;
+  std::string segment = SharedStats::kSegmentName;
+  fs::path addonModule = CORE_BENCH_ADDON_PATH;
+};
+
+static int Publish(const Options &options) {
+  BenchSupport::InstallShimResourceApi();
+  fs::path root = fs::temp_directory_path() / "stats_monitor_addons";
+  if (!BenchSupport::CreateAddonCopies(options.addonModule, root,
+                                       options.addons))
+    std::printf("(bench_addon not found: publishing without addons)\n");
+
+  AddonManager manager(root);
+  manager.LoadAddons();
+  manager.InitializeAddons(nullptr, nullptr, nullptr, nullptr);
+  ShaderHook::Initialize(&manager);
+
+  StatsPublisher publisher;
+  if (!publisher.Start(&manager, options.segment.c_str(),
+                       options.intervalMs)) {
+    std::fprintf(stderr, "Could not create segment %s\n",
+                 options.segment.c_str());
+    return 1;
+  }
+  std::printf("Publishing %s every %u ms for %.0f s\n",
+              options.segment.c_str(), options.intervalMs, options.seconds);
+
+  // The load a dashboard would watch: resource lookups, some intercepted,
+  // and a frame-time-like telemetry channel
+  std::atomic<bool> stop{false};
+  std::thread worker([&]() {
+    TelemetryChannel *frames =
+        manager.TelemetryCreateChannel("stats_monitor/frame ms");
+    uint32_t i = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+      LPCWSTR name = MAKEINTRESOURCEW(i % 8 == 0 ? 1 : 2 + i % 32);
+      HRSRC info = ShaderHook::HookedFindResourceW(nullptr, name, kRcData);
+      HGLOBAL data = ShaderHook::HookedLoadResource(nullptr, info);
+      ShaderHook::HookedLockResource(data);
+      ShaderHook::HookedFreeResource(data);
+      TelemetryPush(frames, 16.6f + 2.0f * (float)std::sin(i * 0.01));
+      if (++i % 64 == 0)
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+  });
+
+  std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+  stop.store(true);
+  worker.join();
+  publisher.Stop();
+  ShaderHook::Shutdown();
+  manager.UnloadAddons();
+  return 0;
+}
+
+static void PrintSnapshot(const SharedStats::Snapshot &snapshot) {
+  std::printf("\npid %u, publish #%llu, %zu metrics\n", snapshot.processId,
+              (unsigned long long)snapshot.publishCount,
+              snapshot.metrics.size());
+  for (const SharedStats::Metric &metric : snapshot.metrics) {
+    switch (metric.kind) {
+    case SharedStats::kCounter:
+      std::printf("  %-44s %14llu\n", metric.name,
+                  (unsigned long long)metric.count);
+      break;
+    case SharedStats::kGauge:
+      std::printf("  %-44s %14.0f\n", metric.name, metric.value);
+      break;
+    case SharedStats::kHistogram:
+      std::printf("  %-44s n=%llu mean %.2f p50 %.2f p95 %.2f p99 %.2f\n",
+                  metric.name, (unsigned long long)metric.count, metric.value,
+                  metric.p50, metric.p95, metric.p99);
+      break;
+    }
+  }
+}
+
+static int Watch(const Options &options) {
+  SharedStats::Reader reader;
+  auto giveUp = Clock::now() + std::chrono::seconds(5);
+  while (!reader.Open(options.segment.c_str())) {
+    if (Clock::now() > giveUp) {
+      std::fprintf(stderr, "No readable segment %s\n",
+                   options.segment.c_str());
+      return 1;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+
+  SharedStats::Snapshot snapshot;
+  uint64_t snapshots = 0, failed = 0, retries = 0, readNanos = 0;
+  uint64_t publishes = 0, lastPublish = 0, maxAgeMicros = 0;
+  auto start = Clock::now();
+  auto end = start + std::chrono::duration<double>(options.seconds);
+  auto nextPrint = start;
+  auto period = std::chrono::duration<double>(
+      options.hz > 0 ? 1.0 / options.hz : 0.0);
+  auto next = start;
+
+  while (Clock::now() < end) {
+    auto before = Clock::now();
+    bool ok = reader.Read(&snapshot);
+    readNanos += (uint64_t)std::chrono::duration_cast<
+                     std::chrono::nanoseconds>(Clock::now() - before)
+                     .count();
+    retries += snapshot.retries;
+    if (!ok) {
+      failed++;
+    } else {
+      snapshots++;
+      if (snapshot.publishCount != lastPublish) {
+        publishes++;
+        lastPublish = snapshot.publishCount;
+      }
+      // Same steady clock in both processes on Linux (and on Windows)
+      uint64_t now = Trace::NowMicros();
+      if (now > snapshot.publishMicros)
+        maxAgeMicros = std::max(maxAgeMicros, now - snapshot.publishMicros);
+      if (before >= nextPrint) {
+        PrintSnapshot(snapshot);
+        nextPrint = before + std::chrono::seconds(1);
+      }
+    }
+    if (options.hz > 0) {
+      next += std::chrono::duration_cast<Clock::duration>(period);
+      std::this_thread::sleep_until(next);
+    }
+  }
+
+  double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  uint64_t reads = snapshots + failed;
+  std::printf("\n%llu snapshots in %.1f s (%.0f/s), %.0f ns per read, "
+              "%llu retried copies, %llu failed reads\n",
+              (unsigned long long)snapshots, elapsed, snapshots / elapsed,
+              reads ? (double)readNanos / reads : 0.0,
+              (unsigned long long)retries, (unsigned long long)failed);
+  std::printf("%llu distinct publishes seen, oldest data %.1f ms\n",
+              (unsigned long long)publishes, maxAgeMicros / 1000.0);
+  return 0;
+}
+
+static int Usage(const char *program) {
+  std::fprintf(stderr,
+               "usage: %s publish [--seconds S] [--interval-ms N] "
+               "[--addons N] [--segment NAME] [--addon-module PATH]\n"
+               "       %s watch [--seconds S] [--hz F] [--segment NAME]\n",
+               program, program);
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2)
+    return Usage(argv[0]);
+  bool publish = !std::strcmp(argv[1], "publish");
+  if (!publish && std::strcmp(argv[1], "watch") != 0)
+    return Usage(argv[0]);
+
+  Options options;
+  for (int i = 2; i < argc; ++i) {
+    bool hasValue = i + 1 < argc;
+    if (!std::strcmp(argv[i], "--seconds") && hasValue) {
+      options.seconds = std::max(0.1, std::atof(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--interval-ms") && hasValue) {
+      options.intervalMs = (uint32_t)std::max(1, std::atoi(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--addons") && hasValue) {
+      options.addons = std::max(0, std::atoi(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--hz") && hasValue) {
+      options.hz = std::max(0.0, std::atof(argv[++i]));
+    } else if (!std::strcmp(argv[i], "--segment") && hasValue) {
+      options.segment = argv[++i];
+    } else if (!std::strcmp(argv[i], "--addon-module") && hasValue) {
+      options.addonModule = argv[++i];
+    } else {
+      return Usage(argv[0]);
+    }
+  }
+  return publish ? Publish(options) : Watch(options);
+}